@@ -7,81 +7,97 @@
 #include "symtab.h"
 #include "analyze.h"
 
-static int globalMemLoc = 0;  // Contador para variaveis globais
-static int localMemLoc = 0;   // Contador para variaveis locais
-
-
 /**
  * @brief Travessia da AST para construir a tabela de simbolos
+ * @param ctx Contexto da compilacao
  * @param t No da arvore
  * @param preProc Funcao executada antes de processar filhos
  * @param postProc Funcao executada apos processar filhos
  */
-static void traverse(TreeNode* t,
-                    void (*preProc)(TreeNode*),
-                    void (*postProc)(TreeNode*)) {
+static void traverse(CompilerContext* ctx, TreeNode* t,
+                    void (*preProc)(CompilerContext*, TreeNode*),
+                    void (*postProc)(CompilerContext*, TreeNode*)) {
     if (t != NULL) {
-        preProc(t);
+        preProc(ctx, t);
         int i;
         for (i = 0; i < MAXCHILDREN; i++)
-            traverse(t->child[i], preProc, postProc);
-        postProc(t);
-        traverse(t->sibling, preProc, postProc);
+            traverse(ctx, t->child[i], preProc, postProc);
+        postProc(ctx, t);
+        traverse(ctx, t->sibling, preProc, postProc);
     }
 }
 
 /**
  * @brief Funcao vazia para travessia
+ * @param ctx Contexto da compilacao
  * @param t No da arvore
  */
-static void nullProc(TreeNode* t) {
+static void nullProc(CompilerContext* ctx, TreeNode* t) {
     if (t == NULL)
         return;
 }
 
+/**
+ * @brief Celulas ocupadas por uma variavel no registro de ativacao
+ * @param t Declaracao (VarK ou ArrayK)
+ * @return Numero de elementos do array ou 1
+ */
+static int declCells(TreeNode* t) {
+    if (t->kind.decl == ArrayK && t->child[0] != NULL)
+        return t->child[0]->attr.val;
+    return 1;
+}
+
 /**
  * @brief Insere identificador na tabela de simbolos
+ * @param ctx Contexto da compilacao
  * @param t No da arvore
  */
-static void insertNode(TreeNode* t) {
+static void insertNode(CompilerContext* ctx, TreeNode* t) {
     BucketList l;
+    int local;
     switch (t->nodekind) {
         case DeclK:
             switch (t->kind.decl) {
                 case VarK:
                 case ArrayK:
-                    if (st_lookup_top(t->attr.name) != NULL) {
-                        fprintf(stderr, "ERRO SEMANTICO: Variavel '%s' ja foi declarada neste escopo. Linha: %d\n",
+                    // locais: offset no registro da funcao, depois dos parametros
+                    local = ctx->scopeStack != NULL && ctx->scopeStack->nestedLevel > 0;
+                    if (st_lookup_top(ctx, t->attr.name) != NULL) {
+                        fprintf(ctx->errors, "ERRO SEMANTICO: Variavel '%s' ja foi declarada neste escopo. Linha: %d\n",
                                 t->attr.name, t->lineno);
-                        Error = TRUE;
+                        ctx->error = TRUE;
                     } else {
                         if (t->type == Void) {
-                            fprintf(stderr, "ERRO SEMANTICO: Variavel '%s' declarada com tipo void. Linha: %d\n",
+                            fprintf(ctx->errors, "ERRO SEMANTICO: Variavel '%s' declarada com tipo void. Linha: %d\n",
                                     t->attr.name, t->lineno);
-                            Error = TRUE;
+                            ctx->error = TRUE;
                         } else {
-                            st_insert(t->attr.name, t->type, t->lineno, globalMemLoc++);
+                            st_insert(ctx, t->attr.name, t->type, t->lineno,
+                                      local ? ctx->localMemLoc : ctx->globalMemLoc++);
                         }
                     }
+                    if (local)
+                        ctx->localMemLoc += declCells(t);
                     break;
                 case FunK:
-                    if (st_lookup(t->attr.name) != NULL) {
-                        fprintf(stderr, "ERRO SEMANTICO: Funcao '%s' ja foi declarada. Linha: %d\n",
+                    if (st_lookup(ctx, t->attr.name) != NULL) {
+                        fprintf(ctx->errors, "ERRO SEMANTICO: Funcao '%s' ja foi declarada. Linha: %d\n",
                                 t->attr.name, t->lineno);
-                        Error = TRUE;
+                        ctx->error = TRUE;
                     } else {
-                        st_insert(t->attr.name, t->type, t->lineno, globalMemLoc++);
-                        st_push_scope(t->attr.name);
-                        localMemLoc = 0;
+                        st_insert(ctx, t->attr.name, t->type, t->lineno, ctx->globalMemLoc++);
+                        st_push_scope(ctx, t->attr.name);
+                        ctx->localMemLoc = 0;
                     }
                     break;
                 case ParamK:
-                    if (st_lookup_top(t->attr.name) != NULL) {
-                        fprintf(stderr, "ERRO SEMANTICO: Parametro '%s' ja foi declarado nesta funcao. Linha: %d\n",
+                    if (st_lookup_top(ctx, t->attr.name) != NULL) {
+                        fprintf(ctx->errors, "ERRO SEMANTICO: Parametro '%s' ja foi declarado nesta funcao. Linha: %d\n",
                                 t->attr.name, t->lineno);
-                        Error = TRUE;
+                        ctx->error = TRUE;
                     } else {
-                        st_insert(t->attr.name, t->type, t->lineno, localMemLoc++);
+                        st_insert(ctx, t->attr.name, t->type, t->lineno, ctx->localMemLoc++);
                     }
                     break;
                 default:
@@ -102,18 +118,17 @@ static void insertNode(TreeNode* t) {
             switch (t->kind.exp) {
                 case IdK:
                 case CallK:
-                    l = st_lookup(t->attr.name);
+                    l = st_lookup(ctx, t->attr.name);
                     if (l == NULL) {
-                        fprintf(stderr, "ERRO SEMANTICO: Identificador '%s' nao foi declarado no escopo atual. Linha: %d\n",
+                        fprintf(ctx->errors, "ERRO SEMANTICO: Identificador '%s' nao foi declarado no escopo atual. Linha: %d\n",
                                 t->attr.name, t->lineno);
-                        Error = TRUE;
+                        ctx->error = TRUE;
                     } else {
-                        LineList ll = l->lines;
-                        while (ll->next != NULL)
-                            ll = ll->next;
+                        LineList ll = l->lastLine;
                         ll->next = (LineList)malloc(sizeof(struct LineListRec));
                         ll->next->lineno = t->lineno;
                         ll->next->next = NULL;
+                        l->lastLine = ll->next;
                     }
                     break;
                 default:
@@ -126,37 +141,65 @@ static void insertNode(TreeNode* t) {
 }
 
 /**
- * @brief Remove escopo apos processar funcao
+ * @brief Remove escopo apos processar funcao e libera as celulas de um bloco
+ * @param ctx Contexto da compilacao
  * @param t No da arvore
  */
-static void afterInsertNode(TreeNode* t) {
+static void afterInsertNode(CompilerContext* ctx, TreeNode* t) {
+    TreeNode* d;
     if (t->nodekind == DeclK && t->kind.decl == FunK) {
-        st_pop_scope();
+        st_pop_scope(ctx);
     }
+    // fim de um bloco: as celulas das suas variaveis voltam para o proximo bloco irmao
+    if (t->nodekind == StmtK && t->kind.stmt == CompoundK) {
+        for (d = t->child[0]; d != NULL; d = d->sibling)
+            ctx->localMemLoc -= declCells(d);
+    }
+}
+
+/**
+ * @brief Cria o escopo global com as funcoes predefinidas
+ * @param ctx Contexto da compilacao
+ */
+static void initGlobalScope(CompilerContext* ctx) {
+    st_push_scope(ctx, "global");
+    st_insert(ctx, "input", Integer, 0, ctx->globalMemLoc++);
+    st_insert(ctx, "output", Void, 0, ctx->globalMemLoc++);
 }
 
 /**
  * @brief Constroi a tabela de simbolos atraves de travessia da AST
+ * @param ctx Contexto da compilacao
  * @param syntaxTree Raiz da arvore sintatica
  */
-void buildSymtab(TreeNode* syntaxTree) {
-    st_push_scope("global");
-    st_insert("input", Integer, 0, globalMemLoc++);
-    st_insert("output", Void, 0, globalMemLoc++);
-    traverse(syntaxTree, insertNode, afterInsertNode);
+void buildSymtab(CompilerContext* ctx, TreeNode* syntaxTree) {
+    initGlobalScope(ctx);
+    traverse(ctx, syntaxTree, insertNode, afterInsertNode);
+}
+
+/**
+ * @brief Insere na tabela de simbolos uma unica declaracao global
+ * @param ctx Contexto da compilacao
+ * @param decl Declaracao (sem irmaos)
+ */
+void buildSymtabDecl(CompilerContext* ctx, TreeNode* decl) {
+    if (ctx->allScopes == NULL)
+        initGlobalScope(ctx);
+    traverse(ctx, decl, insertNode, afterInsertNode);
 }
 
 /**
  * @brief Define tipos dos nos antes de verificacao
+ * @param ctx Contexto da compilacao
  * @param t No da arvore
  */
-static void setNodeTypes(TreeNode* t) {
+static void setNodeTypes(CompilerContext* ctx, TreeNode* t) {
     if (t == NULL)
         return;
     
     // Entra no escopo existente ao processar funcao
     if (t->nodekind == DeclK && t->kind.decl == FunK) {
-        st_enter_scope(t->attr.name);
+        st_enter_scope(ctx, t->attr.name);
     }
     
     switch (t->nodekind) {
@@ -167,7 +210,7 @@ static void setNodeTypes(TreeNode* t) {
                     break;
                 case IdK:
                     {
-                        BucketList l = st_lookup(t->attr.name);
+                        BucketList l = st_lookup(ctx, t->attr.name);
                         if (l != NULL) {
                             t->type = l->type;
                             if (t->child[0] != NULL && l->type == IntegerArray) {
@@ -181,7 +224,7 @@ static void setNodeTypes(TreeNode* t) {
                     break;
                 case CallK:
                     {
-                        BucketList l = st_lookup(t->attr.name);
+                        BucketList l = st_lookup(ctx, t->attr.name);
                         if (l != NULL) {
                             t->type = l->type;
                         } else {
@@ -200,9 +243,10 @@ static void setNodeTypes(TreeNode* t) {
 
 /**
  * @brief Verifica tipos e desempilha escopos
+ * @param ctx Contexto da compilacao
  * @param t No da arvore
  */
-static void checkNode(TreeNode* t) {
+static void checkNode(CompilerContext* ctx, TreeNode* t) {
     if (t == NULL)
         return;
     
@@ -213,15 +257,15 @@ static void checkNode(TreeNode* t) {
                     if (t->child[0] != NULL && t->child[1] != NULL) {
                         if (t->child[0]->type == IntegerArray) {
                             if (t->child[0]->child[0] == NULL) {
-                                fprintf(stderr, "ERRO SEMANTICO: Atribuicao invalida para array '%s' sem indice. Linha: %d\n",
+                                fprintf(ctx->errors, "ERRO SEMANTICO: Atribuicao invalida para array '%s' sem indice. Linha: %d\n",
                                         t->child[0]->attr.name, t->lineno);
-                                Error = TRUE;
+                                ctx->error = TRUE;
                             }
                         }
                         if (t->child[1]->type == Void) {
-                            fprintf(stderr, "ERRO SEMANTICO: Atribuicao invalida, expressao do lado direito retorna void. Linha: %d\n",
+                            fprintf(ctx->errors, "ERRO SEMANTICO: Atribuicao invalida, expressao do lado direito retorna void. Linha: %d\n",
                                     t->lineno);
-                            Error = TRUE;
+                            ctx->error = TRUE;
                         }
                     }
                     break;
@@ -235,14 +279,14 @@ static void checkNode(TreeNode* t) {
             switch (t->kind.exp) {
                 case OpK:
                     if (t->child[0] != NULL && t->child[0]->type == Void) {
-                        fprintf(stderr, "ERRO SEMANTICO: Operando esquerdo do operador tem tipo void. Linha: %d\n",
+                        fprintf(ctx->errors, "ERRO SEMANTICO: Operando esquerdo do operador tem tipo void. Linha: %d\n",
                                 t->lineno);
-                        Error = TRUE;
+                        ctx->error = TRUE;
                     }
                     if (t->child[1] != NULL && t->child[1]->type == Void) {
-                        fprintf(stderr, "ERRO SEMANTICO: Operando direito do operador tem tipo void. Linha: %d\n",
+                        fprintf(ctx->errors, "ERRO SEMANTICO: Operando direito do operador tem tipo void. Linha: %d\n",
                                 t->lineno);
-                        Error = TRUE;
+                        ctx->error = TRUE;
                     }
                     t->type = Integer;
                     break;
@@ -251,14 +295,14 @@ static void checkNode(TreeNode* t) {
                     break;
                 case IdK:
                     {
-                        BucketList l = st_lookup(t->attr.name);
+                        BucketList l = st_lookup(ctx, t->attr.name);
                         if (l != NULL) {
                             t->type = l->type;
                             if (t->child[0] != NULL) {
                                 if (l->type != IntegerArray) {
-                                    fprintf(stderr, "ERRO SEMANTICO: Identificador '%s' nao e um array. Linha: %d\n",
+                                    fprintf(ctx->errors, "ERRO SEMANTICO: Identificador '%s' nao e um array. Linha: %d\n",
                                             t->attr.name, t->lineno);
-                                    Error = TRUE;
+                                    ctx->error = TRUE;
                                 } else {
                                     t->type = Integer;
                                 }
@@ -268,7 +312,7 @@ static void checkNode(TreeNode* t) {
                     break;
                 case CallK:
                     {
-                        BucketList l = st_lookup(t->attr.name);
+                        BucketList l = st_lookup(ctx, t->attr.name);
                         if (l != NULL) {
                             t->type = l->type;
                         } else {
@@ -300,19 +344,37 @@ static void checkNode(TreeNode* t) {
     
     // Desempilha escopo ao sair de funcao
     if (t->nodekind == DeclK && t->kind.decl == FunK) {
-        st_pop_scope();
+        st_pop_scope(ctx);
     }
 }
 
 /**
  * @brief Realiza verificacao de tipos atraves de travessia da AST
+ * @param ctx Contexto da compilacao
  * @param syntaxTree Raiz da arvore sintatica
  */
-void typeCheck(TreeNode* syntaxTree) {
-    traverse(syntaxTree, setNodeTypes, checkNode);
-    BucketList mainFunc = st_lookup("main");
+void typeCheck(CompilerContext* ctx, TreeNode* syntaxTree) {
+    traverse(ctx, syntaxTree, setNodeTypes, checkNode);
+    checkMain(ctx);
+}
+
+/**
+ * @brief Verifica os tipos de uma unica declaracao global
+ * @param ctx Contexto da compilacao
+ * @param decl Declaracao (sem irmaos, ja inserida com buildSymtabDecl)
+ */
+void typeCheckDecl(CompilerContext* ctx, TreeNode* decl) {
+    traverse(ctx, decl, setNodeTypes, checkNode);
+}
+
+/**
+ * @brief Verifica se o programa declarou a funcao main
+ * @param ctx Contexto da compilacao
+ */
+void checkMain(CompilerContext* ctx) {
+    BucketList mainFunc = st_lookup(ctx, "main");
     if (mainFunc == NULL) {
-        fprintf(stderr, "ERRO SEMANTICO: Funcao 'main' nao foi declarada no programa.\n");
-        Error = TRUE;
+        fprintf(ctx->errors, "ERRO SEMANTICO: Funcao 'main' nao foi declarada no programa.\n");
+        ctx->error = TRUE;
     }
 }
@@ -10,14 +10,36 @@
 
 /**
  * @brief Constroi a tabela de simbolos atraves de travessia da AST
+ * @param ctx Contexto da compilacao
  * @param syntaxTree Raiz da arvore sintatica
  */
-void buildSymtab(TreeNode* syntaxTree);
+void buildSymtab(CompilerContext* ctx, TreeNode* syntaxTree);
 
 /**
  * @brief Realiza verificacao de tipos atraves de travessia da AST
+ * @param ctx Contexto da compilacao
  * @param syntaxTree Raiz da arvore sintatica
  */
-void typeCheck(TreeNode* syntaxTree);
+void typeCheck(CompilerContext* ctx, TreeNode* syntaxTree);
+
+/**
+ * @brief Insere na tabela de simbolos uma unica declaracao global (modo streaming)
+ * @param ctx Contexto da compilacao
+ * @param decl Declaracao (sem irmaos)
+ */
+void buildSymtabDecl(CompilerContext* ctx, TreeNode* decl);
+
+/**
+ * @brief Verifica os tipos de uma unica declaracao global (modo streaming)
+ * @param ctx Contexto da compilacao
+ * @param decl Declaracao (sem irmaos, ja inserida com buildSymtabDecl)
+ */
+void typeCheckDecl(CompilerContext* ctx, TreeNode* decl);
+
+/**
+ * @brief Verifica se o programa declarou a funcao main
+ * @param ctx Contexto da compilacao
+ */
+void checkMain(CompilerContext* ctx);
 
 #endif
@@ -0,0 +1,274 @@
+/**
+ * @file ast.c
+ * @brief Implementacao da AST compacta
+ */
+
+#include "ast.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Nos visitados em cada medida de tempo do relatorio
+#define AST_REPORT_VISITS 20000000
+
+/**
+ * @brief Verifica se o no guarda um nome em attr
+ * @param nodekind Categoria do no
+ * @param kind Tipo especifico do no
+ * @return TRUE se o atributo e um nome
+ */
+static int hasName(int nodekind, int kind) {
+    return nodekind == DeclK || (nodekind == ExpK && (kind == IdK || kind == CallK));
+}
+
+/**
+ * @brief Acrescenta um no ao vetor
+ * @param ast AST compacta
+ * @param t No da AST de ponteiros
+ * @return Indice do novo no ou AST_NONE se erro
+ */
+static AstId pushNode(Ast* ast, TreeNode* t) {
+    AstNode* n;
+    int kind = t->nodekind == StmtK ? (int)t->kind.stmt
+             : t->nodekind == ExpK ? (int)t->kind.exp : (int)t->kind.decl;
+    int i;
+    if (ast->count == ast->cap) {
+        uint32_t cap = ast->cap ? ast->cap * 2 : 256;
+        AstNode* nodes = (AstNode*)realloc(ast->nodes, cap * sizeof(AstNode));
+        if (nodes == NULL || cap >= AST_NONE)
+            return AST_NONE;
+        ast->nodes = nodes;
+        ast->cap = cap;
+    }
+    n = &ast->nodes[ast->count];
+    n->end = 0;
+    n->lineno = t->lineno;
+    n->nodekind = (uint8_t)t->nodekind;
+    n->kind = (uint8_t)kind;
+    n->type = (uint8_t)t->type;
+    n->flags = 0;
+    for (i = 0; i < MAXCHILDREN; i++)
+        if (t->child[i] != NULL)
+            n->flags |= (uint8_t)(1 << i);
+    if (hasName(t->nodekind, kind))
+        n->attr = t->attr.name != NULL ? ir_intern(&ast->names, t->attr.name) : AST_NONE;
+    else
+        n->attr = (uint32_t)t->attr.val;
+    return ast->count++;
+}
+
+/**
+ * @brief Converte uma lista de irmaos e as subarvores, em pre-ordem
+ * @param ast AST compacta
+ * @param t Primeiro no da lista
+ * @return 0 se sucesso, -1 se erro
+ */
+static int buildList(Ast* ast, TreeNode* t) {
+    for (; t != NULL; t = t->sibling) {
+        AstId id = pushNode(ast, t);
+        int i;
+        if (id == AST_NONE)
+            return -1;
+        for (i = 0; i < MAXCHILDREN; i++)
+            if (t->child[i] != NULL && buildList(ast, t->child[i]) != 0)
+                return -1;
+        // o vetor pode ter sido realocado pelos filhos
+        ast->nodes[id].end = ast->count;
+        if (t->sibling != NULL)
+            ast->nodes[id].flags |= AST_SIBLING;
+    }
+    return 0;
+}
+
+int ast_build(Ast* ast, TreeNode* tree) {
+    memset(ast, 0, sizeof(*ast));
+    if (buildList(ast, tree) != 0) {
+        fprintf(stderr, "Erro de alocacao de memoria na AST compacta\n");
+        ast_free(ast);
+        return -1;
+    }
+    return 0;
+}
+
+void ast_free(Ast* ast) {
+    free(ast->nodes);
+    free(ast->names.data);
+    free(ast->names.hash);
+    memset(ast, 0, sizeof(*ast));
+}
+
+AstId ast_child(const Ast* ast, AstId id, int i) {
+    const AstNode* n = &ast->nodes[id];
+    AstId c = id + 1;
+    int j;
+    if (!(n->flags & (1 << i)))
+        return AST_NONE;
+    // pula as listas das posicoes anteriores
+    for (j = 0; j < i; j++) {
+        if (n->flags & (1 << j)) {
+            while (ast->nodes[c].flags & AST_SIBLING)
+                c = ast->nodes[c].end;
+            c = ast->nodes[c].end;
+        }
+    }
+    return c;
+}
+
+AstId ast_sibling(const Ast* ast, AstId id) {
+    const AstNode* n = &ast->nodes[id];
+    return (n->flags & AST_SIBLING) ? n->end : AST_NONE;
+}
+
+const char* ast_name(const Ast* ast, AstId id) {
+    const AstNode* n = &ast->nodes[id];
+    if (!hasName(n->nodekind, n->kind) || n->attr == AST_NONE)
+        return NULL;
+    return ast->names.data + n->attr;
+}
+
+int ast_val(const Ast* ast, AstId id) {
+    return (int)ast->nodes[id].attr;
+}
+
+/**
+ * @brief Percorre uma lista de irmaos
+ * @param ast AST
+ * @param id Primeiro no da lista
+ * @param preProc Chamada antes dos filhos (ou NULL)
+ * @param postProc Chamada depois dos filhos (ou NULL)
+ * @param arg Argumento repassado as funcoes
+ * @return Indice depois do ultimo no da lista
+ */
+static AstId walkList(Ast* ast, AstId id, AstVisit preProc, AstVisit postProc, void* arg) {
+    for (;;) {
+        AstId end = ast->nodes[id].end;
+        AstId c = id + 1;
+        if (preProc != NULL)
+            preProc(ast, id, arg);
+        // os filhos ocupam [id + 1, end), uma lista depois da outra
+        while (c < end)
+            c = walkList(ast, c, preProc, postProc, arg);
+        if (postProc != NULL)
+            postProc(ast, id, arg);
+        if (!(ast->nodes[id].flags & AST_SIBLING))
+            return end;
+        id = end;
+    }
+}
+
+void ast_traverse(Ast* ast, AstId id, AstVisit preProc, AstVisit postProc, void* arg) {
+    if (id != AST_NONE && id < ast->count)
+        walkList(ast, id, preProc, postProc, arg);
+}
+
+/**
+ * @brief Tempo monotonico em segundos
+ * @return Segundos
+ */
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Conta os nos e os bytes dos nomes da AST de ponteiros
+ * @param t Primeiro no da lista
+ * @param names Bytes dos nomes (acumulado)
+ * @return Numero de nos
+ */
+static size_t countTree(TreeNode* t, size_t* names) {
+    size_t n = 0;
+    for (; t != NULL; t = t->sibling) {
+        int i;
+        int kind = t->nodekind == ExpK ? (int)t->kind.exp : (int)t->kind.decl;
+        n++;
+        if (hasName(t->nodekind, kind) && t->attr.name != NULL)
+            *names += strlen(t->attr.name) + 1;
+        for (i = 0; i < MAXCHILDREN; i++)
+            n += countTree(t->child[i], names);
+    }
+    return n;
+}
+
+/**
+ * @brief Percurso da AST de ponteiros, como o traverse de analyze.c
+ * @param t Primeiro no da lista
+ * @param visit Chamada antes dos filhos
+ * @param arg Argumento repassado a visit
+ */
+static void walkTree(TreeNode* t, void (*visit)(TreeNode*, void*), void* arg) {
+    for (; t != NULL; t = t->sibling) {
+        int i;
+        visit(t, arg);
+        for (i = 0; i < MAXCHILDREN; i++)
+            walkTree(t->child[i], visit, arg);
+    }
+}
+
+/**
+ * @brief Visita da AST de ponteiros usada na medida de tempo
+ * @param t No
+ * @param arg Soma das linhas (impede que o percurso seja eliminado)
+ */
+static void sumTreeLines(TreeNode* t, void* arg) {
+    *(long*)arg += t->lineno;
+}
+
+/**
+ * @brief Visita da AST compacta usada na medida de tempo
+ * @param ast AST
+ * @param id No
+ * @param arg Soma das linhas
+ */
+static void sumLines(Ast* ast, AstId id, void* arg) {
+    *(long*)arg += ast->nodes[id].lineno;
+}
+
+int ast_report(TreeNode* tree, long lines, FILE* out) {
+    Ast ast;
+    size_t names = 0;
+    size_t nodes = countTree(tree, &names);
+    size_t treeBytes, astBytes;
+    long sumTree = 0, sumAst = 0;
+    int reps, r;
+    double t0, tTree, tAst;
+
+    t0 = now();
+    if (ast_build(&ast, tree) != 0)
+        return -1;
+    t0 = now() - t0;
+
+    reps = nodes > 0 ? (int)(AST_REPORT_VISITS / nodes) : 1;
+    if (reps < 1)
+        reps = 1;
+    tTree = now();
+    for (r = 0; r < reps; r++)
+        walkTree(tree, sumTreeLines, &sumTree);
+    tTree = (now() - tTree) / reps;
+    tAst = now();
+    for (r = 0; r < reps; r++)
+        ast_traverse(&ast, 0, sumLines, NULL, &sumAst);
+    tAst = (now() - tAst) / reps;
+    if (sumTree != sumAst) {
+        fprintf(stderr, "AST compacta difere da AST de ponteiros\n");
+        ast_free(&ast);
+        return -1;
+    }
+
+    treeBytes = nodes * sizeof(TreeNode) + names;
+    astBytes = (size_t)ast.count * sizeof(AstNode) + ast.names.size + (size_t)ast.names.hashCap * sizeof(uint32_t);
+    if (lines < 1)
+        lines = 1;
+    fprintf(out, "Linhas: %ld  Nos: %zu  Nomes distintos: %u\n", lines, nodes, ast.names.count);
+    fprintf(out, "%-10s %10s %12s %12s %14s\n", "AST", "bytes/no", "bytes", "bytes/linha", "percurso (us)");
+    fprintf(out, "%-10s %10zu %12zu %12.1f %14.1f\n", "ponteiros", sizeof(TreeNode),
+            treeBytes, (double)treeBytes / lines, tTree * 1e6);
+    fprintf(out, "%-10s %10zu %12zu %12.1f %14.1f\n", "compacta", sizeof(AstNode),
+            astBytes, (double)astBytes / lines, tAst * 1e6);
+    fprintf(out, "Conversao: %.3f ms  Memoria: %.2fx menor  Percurso: %.2fx\n",
+            t0 * 1e3, astBytes ? (double)treeBytes / astBytes : 0.0,
+            tAst > 0 ? tTree / tAst : 0.0);
+    ast_free(&ast);
+    return 0;
+}
@@ -0,0 +1,124 @@
+/**
+ * @file ast.h
+ * @brief AST compacta: nos contiguos enderecados por indices de 32 bits
+ *
+ * Os nos ficam em um unico vetor, em pre-ordem. O primeiro filho de um no
+ * e sempre o no seguinte do vetor e o campo 'end' (um depois da subarvore)
+ * e tambem o proximo irmao quando o no tem irmao, de forma que as ligacoes
+ * primeiro filho / proximo irmao nao ocupam espaco proprio. Os bits 'slots'
+ * dizem quais das posicoes child[0..2] do TreeNode estao presentes, e os
+ * nomes ficam em uma tabela de strings com interning. Cada no ocupa 16
+ * bytes, contra os 64 (mais o cabecalho do malloc) do TreeNode.
+ */
+
+#ifndef _AST_H_
+#define _AST_H_
+
+#include "globals.h"
+#include "ir.h"
+#include <stdint.h>
+
+typedef uint32_t AstId;
+
+// Indice ausente (filho ou irmao inexistente)
+#define AST_NONE UINT32_MAX
+
+// Bits de AstNode.flags
+#define AST_SLOTS   0x07      // child[i] presente no bit i
+#define AST_SIBLING 0x08      // o no tem irmao (em 'end')
+
+/**
+ * @brief No da AST compacta (16 bytes)
+ */
+typedef struct {
+    uint32_t end;             // indice depois da subarvore (e do irmao, se houver)
+    uint32_t attr;            // op, val ou offset do nome em names (AST_NONE sem nome)
+    int32_t lineno;
+    uint8_t nodekind;         // NodeKind
+    uint8_t kind;             // StmtKind, ExpKind ou DeclKind
+    uint8_t type;             // ExpType
+    uint8_t flags;            // AST_SLOTS e AST_SIBLING
+} AstNode;
+
+/**
+ * @brief AST compacta
+ */
+typedef struct {
+    AstNode* nodes;
+    uint32_t count;
+    uint32_t cap;
+    IrStrTab names;           // nomes de declaracoes, identificadores e chamadas
+} Ast;
+
+/**
+ * @brief Funcao chamada em cada no por ast_traverse
+ */
+typedef void (*AstVisit)(Ast* ast, AstId id, void* arg);
+
+/**
+ * @brief Converte uma AST de ponteiros para a forma compacta
+ * @param ast AST compacta a preencher
+ * @param tree Raiz da AST de ponteiros (lista de declaracoes)
+ * @return 0 se sucesso, -1 se erro (falta de memoria)
+ */
+int ast_build(Ast* ast, TreeNode* tree);
+
+/**
+ * @brief Libera uma AST compacta
+ * @param ast AST
+ */
+void ast_free(Ast* ast);
+
+/**
+ * @brief Filho em uma posicao (equivale a TreeNode.child[i])
+ * @param ast AST
+ * @param id No
+ * @param i Posicao (0 a MAXCHILDREN - 1)
+ * @return Primeiro no da lista de filhos ou AST_NONE
+ */
+AstId ast_child(const Ast* ast, AstId id, int i);
+
+/**
+ * @brief Proximo irmao (equivale a TreeNode.sibling)
+ * @param ast AST
+ * @param id No
+ * @return Irmao ou AST_NONE
+ */
+AstId ast_sibling(const Ast* ast, AstId id);
+
+/**
+ * @brief Nome de uma declaracao, identificador ou chamada
+ * @param ast AST
+ * @param id No
+ * @return Nome ou NULL
+ */
+const char* ast_name(const Ast* ast, AstId id);
+
+/**
+ * @brief Operador (OpK) ou valor (ConstK e tamanho de ArrayK)
+ * @param ast AST
+ * @param id No
+ * @return Atributo do no
+ */
+int ast_val(const Ast* ast, AstId id);
+
+/**
+ * @brief Percorre uma lista de irmaos e as subarvores, como o traverse de analyze.c
+ * @param ast AST
+ * @param id Primeiro no da lista (AST_NONE nao faz nada)
+ * @param preProc Chamada antes dos filhos (ou NULL)
+ * @param postProc Chamada depois dos filhos (ou NULL)
+ * @param arg Argumento repassado as funcoes
+ */
+void ast_traverse(Ast* ast, AstId id, AstVisit preProc, AstVisit postProc, void* arg);
+
+/**
+ * @brief Compara memoria e tempo de percurso das duas representacoes
+ * @param tree AST de ponteiros
+ * @param lines Linhas do fonte
+ * @param out Saida do relatorio
+ * @return 0 se sucesso, -1 se erro
+ */
+int ast_report(TreeNode* tree, long lines, FILE* out);
+
+#endif
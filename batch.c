@@ -0,0 +1,530 @@
+/**
+ * @file batch.c
+ * @brief Implementacao da compilacao de varios arquivos em paralelo
+ */
+
+#include "globals.h"
+#include "batch.h"
+#include "compiler.h"
+#include "util.h"
+#include "irfile.h"
+#include "incr.h"
+#include "pool.h"
+#include "source.h"
+#include <dirent.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <time.h>
+#ifdef _WIN32
+#include <direct.h>
+#define lstat stat
+#endif
+
+/**
+ * @brief Texto acumulado em memoria por um FILE*
+ */
+typedef struct {
+    FILE* f;
+    char* data;
+    size_t size;
+} MemOut;
+
+struct Batch;
+
+/**
+ * @brief Compilacao de um arquivo
+ */
+typedef struct {
+    struct Batch* batch;
+    char* path;              // caminho do arquivo
+    char* rel;               // caminho relativo usado em outDir
+    char* listing;           // listagem das fases
+    size_t listingSize;
+    char* errors;            // mensagens de erro
+    size_t errorsSize;
+    char* binPath;           // .cmir gravado (NULL se nao gravou)
+    long lines;
+    int status;
+    int reused;
+    int rebuilt;
+    int done;
+} BatchJob;
+
+/**
+ * @brief Estado da compilacao em lote
+ */
+typedef struct Batch {
+    const BatchOptions* opts;
+    Pool* pool;              // tambem gera as funcoes de cada arquivo
+    BatchJob* jobs;
+    int njobs;
+    int cap;
+    pthread_mutex_t lock;    // protege 'done' dos jobs
+    pthread_cond_t cond;     // um job terminou
+} Batch;
+
+/**
+ * @brief Abre um FILE* que acumula o texto em memoria
+ * @param m Saida em memoria
+ * @return 0 se sucesso, -1 se erro
+ */
+static int memOpen(MemOut* m) {
+    m->data = NULL;
+    m->size = 0;
+#ifdef _WIN32
+    m->f = tmpfile();
+#else
+    m->f = open_memstream(&m->data, &m->size);
+#endif
+    return m->f != NULL ? 0 : -1;
+}
+
+/**
+ * @brief Fecha a saida em memoria e devolve o texto acumulado
+ * @param m Saida em memoria
+ * @param size Tamanho do texto
+ * @return Texto alocado (liberar com free) ou NULL
+ */
+static char* memClose(MemOut* m, size_t* size) {
+#ifdef _WIN32
+    long n;
+    fflush(m->f);
+    n = ftell(m->f);
+    rewind(m->f);
+    m->data = (char*)malloc(n > 0 ? (size_t)n : 1);
+    m->size = m->data != NULL && n > 0 ? fread(m->data, 1, (size_t)n, m->f) : 0;
+#endif
+    fclose(m->f);
+    *size = m->size;
+    return m->data;
+}
+
+/**
+ * @brief Concatena dois caminhos
+ * @param a Primeiro caminho
+ * @param b Segundo caminho
+ * @return "a/b" alocado
+ */
+static char* joinPath(const char* a, const char* b) {
+    size_t n = strlen(a) + strlen(b) + 2;
+    char* p = (char*)malloc(n);
+    if (p != NULL)
+        snprintf(p, n, "%s/%s", a, b);
+    return p;
+}
+
+/**
+ * @brief Acrescenta um arquivo a lista de jobs
+ * @param b Lote
+ * @param path Caminho do arquivo
+ * @param rel Caminho relativo (usado em outDir)
+ * @return 0 se sucesso, -1 se erro
+ */
+static int addJob(Batch* b, const char* path, const char* rel) {
+    BatchJob* j;
+    if (b->njobs == b->cap) {
+        int cap = b->cap ? b->cap * 2 : 64;
+        BatchJob* jobs = (BatchJob*)realloc(b->jobs, cap * sizeof(BatchJob));
+        if (jobs == NULL)
+            return -1;
+        b->jobs = jobs;
+        b->cap = cap;
+    }
+    j = &b->jobs[b->njobs];
+    memset(j, 0, sizeof(*j));
+    j->batch = b;
+    j->path = copyString((char*)path);
+    j->rel = copyString((char*)rel);
+    if (j->path == NULL || j->rel == NULL) {
+        free(j->path);
+        free(j->rel);
+        return -1;
+    }
+    b->njobs++;
+    return 0;
+}
+
+/**
+ * @brief Compara nomes para ordenar as entradas de um diretorio
+ */
+static int compareNames(const void* a, const void* b) {
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+/**
+ * @brief Verifica se um nome termina em ".cm"
+ * @param name Nome
+ * @return TRUE se e um fonte C-
+ */
+static int isSource(const char* name) {
+    size_t n = strlen(name);
+    return n > 3 && strcmp(name + n - 3, ".cm") == 0;
+}
+
+/**
+ * @brief Acrescenta os fontes .cm de um diretorio (recursivo, em ordem alfabetica)
+ *
+ * Links simbolicos para diretorios nao sao seguidos (um link para '.' ou
+ * para um ancestral faria a busca nunca terminar); links para arquivos .cm
+ * sao compilados normalmente.
+ * @param b Lote
+ * @param dir Diretorio
+ * @param rel Caminho relativo do diretorio ("" na raiz)
+ * @return 0 se sucesso, -1 se erro
+ */
+static int addDir(Batch* b, const char* dir, const char* rel) {
+    DIR* d = opendir(dir);
+    struct dirent* e;
+    char** names = NULL;
+    int n = 0, cap = 0, i, status = 0;
+    if (d == NULL) {
+        fprintf(stderr, "Erro: nao foi possivel abrir o diretorio '%s'\n", dir);
+        return -1;
+    }
+    while ((e = readdir(d)) != NULL) {
+        if (e->d_name[0] == '.')
+            continue;
+        if (n == cap) {
+            cap = cap ? cap * 2 : 64;
+            names = (char**)realloc(names, cap * sizeof(char*));
+        }
+        names[n++] = copyString(e->d_name);
+    }
+    closedir(d);
+    qsort(names, n, sizeof(char*), compareNames);
+    for (i = 0; i < n && status == 0; i++) {
+        char* path = joinPath(dir, names[i]);
+        char* sub = rel[0] != '\0' ? joinPath(rel, names[i]) : copyString(names[i]);
+        struct stat st;
+        if (path != NULL && sub != NULL && lstat(path, &st) == 0) {
+            if (S_ISDIR(st.st_mode))
+                status = addDir(b, path, sub);
+            else if (isSource(names[i]) && (S_ISREG(st.st_mode) ||
+                                            (stat(path, &st) == 0 && S_ISREG(st.st_mode))))
+                status = addJob(b, path, sub);
+        }
+        free(path);
+        free(sub);
+    }
+    for (i = 0; i < n; i++)
+        free(names[i]);
+    free(names);
+    return status;
+}
+
+/**
+ * @brief Compara os caminhos relativos sem a extensao .cm (o nome do .cmir gravado)
+ */
+static int compareOutputs(const void* a, const void* b) {
+    const char* x = (*(BatchJob* const*)a)->rel;
+    const char* y = (*(BatchJob* const*)b)->rel;
+    size_t nx = strlen(x) - (isSource(x) ? 3 : 0);
+    size_t ny = strlen(y) - (isSource(y) ? 3 : 0);
+    int c = strncmp(x, y, nx < ny ? nx : ny);
+    if (c != 0)
+        return c;
+    return nx < ny ? -1 : nx > ny;
+}
+
+/**
+ * @brief Verifica se dois jobs gravariam o mesmo .cmir em outDir
+ * @param b Lote
+ * @return 0 se os caminhos sao distintos, -1 se ha conflito (ja relatado)
+ */
+static int checkOutputs(Batch* b) {
+    BatchJob** order = (BatchJob**)malloc(b->njobs * sizeof(BatchJob*));
+    int i, status = 0;
+    if (order == NULL)
+        return -1;
+    for (i = 0; i < b->njobs; i++)
+        order[i] = &b->jobs[i];
+    qsort(order, b->njobs, sizeof(BatchJob*), compareOutputs);
+    for (i = 1; i < b->njobs; i++) {
+        if (compareOutputs(&order[i - 1], &order[i]) == 0) {
+            fprintf(stderr, "Erro: '%s' e '%s' gravariam o mesmo arquivo em '%s'\n",
+                    order[i - 1]->path, order[i]->path, b->opts->outDir);
+            status = -1;
+        }
+    }
+    free(order);
+    return status;
+}
+
+/**
+ * @brief Cria os diretorios intermediarios de um caminho de arquivo
+ * @param path Caminho do arquivo
+ */
+static void makeParents(char* path) {
+    char* p;
+    for (p = path + 1; *p != '\0'; p++) {
+        if (*p == '/') {
+            *p = '\0';
+#ifdef _WIN32
+            mkdir(path);
+#else
+            mkdir(path, 0755);
+#endif
+            *p = '/';
+        }
+    }
+}
+
+/**
+ * @brief Grava o .cmir de um job em outDir (mesmo caminho relativo, extensao .cmir)
+ * @param j Job
+ * @param cmir Binario
+ * @param size Tamanho do binario
+ * @return 0 se sucesso, -1 se erro
+ */
+static int writeOutput(BatchJob* j, const void* cmir, size_t size) {
+    size_t n = strlen(j->batch->opts->outDir) + strlen(j->rel) + 8;
+    char* path = (char*)malloc(n);
+    FILE* f;
+    int ok;
+    if (path == NULL)
+        return -1;
+    snprintf(path, n, "%s/%s", j->batch->opts->outDir, j->rel);
+    if (isSource(path))
+        path[strlen(path) - 3] = '\0';
+    strcat(path, ".cmir");
+    makeParents(path);
+    f = fopen(path, "wb");
+    if (f == NULL) {
+        free(path);
+        return -1;
+    }
+    ok = fwrite(cmir, 1, size, f) == size;
+    if (fclose(f) != 0 || !ok) {
+        free(path);
+        return -1;
+    }
+    j->binPath = path;
+    return 0;
+}
+
+/**
+ * @brief Compila um arquivo (executada por uma thread do pool)
+ * @param arg Job
+ */
+static void runJob(void* arg) {
+    BatchJob* j = (BatchJob*)arg;
+    const BatchOptions* opts = j->batch->opts;
+    MemOut out, err;
+    CacheKey key;
+    CacheEntry entry;
+    SourceFile src;
+    char* text;
+    char* cmir = NULL;
+    size_t len, cmirSize = 0, i;
+    int loaded;
+    int hit = FALSE;
+
+    j->status = 1;
+    loaded = source_open(j->path, &src) == 0;
+    if (memOpen(&out) != 0 || memOpen(&err) != 0) {
+        if (loaded)
+            source_close(&src);
+        goto finish;
+    }
+    if (!loaded) {
+        fprintf(err.f, "Erro: nao foi possivel abrir o arquivo '%s'\n", j->path);
+    } else {
+        text = src.data;
+        len = src.size;
+        for (i = 0; i < len; i++)
+            if (text[i] == '\n')
+                j->lines++;
+        if (len > 0 && text[len - 1] != '\n')
+            j->lines++;
+        if (opts->cache != NULL) {
+            char options[32];
+            cache_key(&key, text, len, cminus_cache_options(options, sizeof(options), opts->stream, opts->optimize, opts->unroll));
+            if (cache_lookup(opts->cache, &key, &entry)) {
+                fwrite(entry.listing, 1, entry.listingSize, out.f);
+                cmir = (char*)malloc(entry.cmirSize ? entry.cmirSize : 1);
+                if (cmir != NULL) {
+                    memcpy(cmir, entry.cmir, entry.cmirSize);
+                    cmirSize = entry.cmirSize;
+                }
+                cache_entry_free(&entry);
+                hit = TRUE;
+                j->status = 0;
+            }
+        }
+        if (!hit) {
+            CompilerContext ctx;
+            IncrState incr;
+            IrProgram program;
+            cminus_init(&ctx, out.f, err.f);
+            ctx.scanInPlace = TRUE;
+            ctx.lexer = opts->lexer;
+            ctx.prelex = opts->prelex;
+            ctx.pool = j->batch->pool;
+            ctx.optimize = opts->optimize;
+            ctx.unroll = opts->unroll;
+            ctx.optStats = opts->optStats;
+            if (opts->cache != NULL && opts->incremental) {
+                incr_init(&incr, opts->cache);
+                ctx.incr = &incr;
+            }
+            ir_init(&program);
+            if (opts->stream)
+                j->status = cminus_compile_stream(&ctx, text, len, &program);
+            else
+                j->status = cminus_compile(&ctx, text, len, &program);
+            if (ctx.incr != NULL) {
+                j->reused = incr.reused;
+                j->rebuilt = incr.rebuilt;
+                incr_free(&incr);
+            }
+            cminus_free(&ctx);
+            if (j->status == 0) {
+                IrView view;
+                ir_flatten(&program, &view);
+                cmir = (char*)irfile_serialize(&view, &cmirSize);
+                ir_view_free(&view);
+            }
+            ir_free(&program);
+        }
+        source_close(&src);
+    }
+    if (j->status == 0 && opts->outDir != NULL) {
+        if (cmir == NULL || writeOutput(j, cmir, cmirSize) != 0) {
+            fprintf(err.f, "Erro: falha ao gravar o codigo binario de '%s'\n", j->path);
+            j->status = 1;
+        }
+    }
+    j->listing = memClose(&out, &j->listingSize);
+    j->errors = memClose(&err, &j->errorsSize);
+    if (!hit && j->status == 0 && opts->cache != NULL && j->listing != NULL && cmir != NULL)
+        cache_store(opts->cache, &key, j->listing, j->listingSize, cmir, cmirSize);
+    free(cmir);
+
+finish:
+    pthread_mutex_lock(&j->batch->lock);
+    j->done = TRUE;
+    pthread_cond_broadcast(&j->batch->cond);
+    pthread_mutex_unlock(&j->batch->lock);
+}
+
+/**
+ * @brief Imprime o resultado de um job (mesmo formato da compilacao de um arquivo)
+ * @param j Job concluido
+ * @param quiet TRUE para omitir a listagem
+ */
+static void printJob(BatchJob* j, int quiet) {
+    size_t i, start = 0;
+    if (!quiet) {
+        fprintf(stdout, "Arquivo de entrada: %s\n\n", j->path);
+        if (j->listing != NULL)
+            fwrite(j->listing, 1, j->listingSize, stdout);
+        if (j->binPath != NULL)
+            fprintf(stdout, "Codigo binario gravado em: %s\n", j->binPath);
+        if (j->status == 0)
+            fprintf(stdout, "\nCompilacao concluida com sucesso!\n\n");
+    }
+    // diagnosticos linha a linha, prefixados pelo arquivo
+    for (i = 0; i < j->errorsSize; i++) {
+        if (j->errors[i] == '\n') {
+            fprintf(stderr, "%s: %.*s\n", j->path, (int)(i - start), j->errors + start);
+            start = i + 1;
+        }
+    }
+    if (start < j->errorsSize)
+        fprintf(stderr, "%s: %.*s\n", j->path, (int)(j->errorsSize - start), j->errors + start);
+}
+
+/**
+ * @brief Tempo monotonico em segundos
+ * @return Segundos
+ */
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+int batch_run(const BatchOptions* opts) {
+    Batch b;
+    Pool pool;
+    double start, elapsed;
+    long lines = 0;
+    int failed = 0, reused = 0, rebuilt = 0;
+    int i, status = 0;
+
+    memset(&b, 0, sizeof(b));
+    b.opts = opts;
+    for (i = 0; i < opts->ninputs && status == 0; i++) {
+        struct stat st;
+        if (stat(opts->inputs[i], &st) == 0 && S_ISDIR(st.st_mode)) {
+            status = addDir(&b, opts->inputs[i], "");
+        } else {
+            const char* base = strrchr(opts->inputs[i], '/');
+            status = addJob(&b, opts->inputs[i], base != NULL ? base + 1 : opts->inputs[i]);
+        }
+    }
+    if (status == 0 && opts->outDir != NULL)
+        status = checkOutputs(&b);
+    if (status != 0 || b.njobs == 0) {
+        if (status == 0)
+            fprintf(stderr, "Erro: nenhum arquivo .cm encontrado\n");
+        for (i = 0; i < b.njobs; i++) {
+            free(b.jobs[i].path);
+            free(b.jobs[i].rel);
+        }
+        free(b.jobs);
+        return 1;
+    }
+
+    if (pool_create(&pool, opts->threads) != 0) {
+        fprintf(stderr, "Erro: nao foi possivel criar as threads de compilacao\n");
+        return 1;
+    }
+    b.pool = &pool;
+    pthread_mutex_init(&b.lock, NULL);
+    pthread_cond_init(&b.cond, NULL);
+
+    start = now();
+    for (i = 0; i < b.njobs; i++) {
+        if (pool_submit(&pool, NULL, runJob, &b.jobs[i]) != 0)
+            runJob(&b.jobs[i]);
+    }
+
+    // imprime na ordem das entradas assim que cada job termina
+    for (i = 0; i < b.njobs; i++) {
+        BatchJob* j = &b.jobs[i];
+        pthread_mutex_lock(&b.lock);
+        while (!j->done)
+            pthread_cond_wait(&b.cond, &b.lock);
+        pthread_mutex_unlock(&b.lock);
+        printJob(j, opts->quiet);
+        if (j->status != 0)
+            failed++;
+        lines += j->lines;
+        reused += j->reused;
+        rebuilt += j->rebuilt;
+        free(j->listing);
+        free(j->errors);
+        free(j->binPath);
+        free(j->path);
+        free(j->rel);
+    }
+    fflush(stdout);
+    pool_wait(&pool, NULL);
+    elapsed = now() - start;
+    if (elapsed <= 0.0)
+        elapsed = 1e-9;
+
+    fprintf(stderr, "Arquivos: %d (%d com erro), linhas: %ld, threads: %d\n",
+            b.njobs, failed, lines, pool.nthreads);
+    fprintf(stderr, "Tempo: %.3f s, %.1f arquivos/s, %.0f linhas/s\n",
+            elapsed, (double)b.njobs / elapsed, (double)lines / elapsed);
+    if (opts->cache != NULL && opts->incremental)
+        fprintf(stderr, "Funcoes reutilizadas: %d, regeneradas: %d\n", reused, rebuilt);
+
+    pool_destroy(&pool);
+    pthread_mutex_destroy(&b.lock);
+    pthread_cond_destroy(&b.cond);
+    free(b.jobs);
+    return failed > 0 ? 1 : 0;
+}
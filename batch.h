@@ -0,0 +1,43 @@
+/**
+ * @file batch.h
+ * @brief Compilacao de varios arquivos em paralelo
+ *
+ * Os arquivos (ou diretorios, percorridos recursivamente atras de .cm) sao
+ * compilados em um pool de threads, cada um com o seu CompilerContext. A
+ * listagem e as mensagens de erro de cada arquivo sao guardadas em memoria
+ * e impressas na ordem das entradas, de forma que a saida nao depende do
+ * escalonamento das threads.
+ */
+
+#ifndef _BATCH_H_
+#define _BATCH_H_
+
+#include "cache.h"
+
+/**
+ * @brief Opcoes da compilacao em lote
+ */
+typedef struct {
+    char** inputs;           // arquivos .cm e diretorios
+    int ninputs;
+    int threads;             // 0 = numero de processadores
+    int quiet;               // TRUE para nao imprimir as listagens
+    const char* outDir;      // diretorio dos .cmir gerados (NULL = nao grava)
+    Cache* cache;            // cache de compilacao (NULL = sem cache)
+    int incremental;         // reutiliza funcoes inalteradas (requer cache)
+    int stream;              // compila declaracao por declaracao (cminus_compile_stream)
+    int lexer;               // scanner (LEXER_FLEX ou LEXER_SIMD)
+    int prelex;              // le os tokens para um vetor antes do parser
+    int optimize;            // nivel de otimizacao (opt.h)
+    int unroll;              // fator de desenrolamento dos lacos (unroll.h)
+    struct OptStats* optStats; // aplicacoes das regras do peephole, somadas (NULL = nao conta)
+} BatchOptions;
+
+/**
+ * @brief Compila todos os arquivos e imprime o resumo de desempenho em stderr
+ * @param opts Opcoes
+ * @return 0 se todos compilaram, 1 se algum falhou
+ */
+int batch_run(const BatchOptions* opts);
+
+#endif
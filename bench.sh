@@ -0,0 +1,70 @@
+#!/bin/bash
+# Mede o compilador com programas gerados pelo cmgen em varios tamanhos e
+# formas. Imprime o tempo total e por fase, as linhas por segundo e o pico
+# de memoria, grava os resultados em $BENCH_DIR/results.json e acrescenta
+# uma linha por medida em $BENCH_DIR/history.jsonl (commit, data e o
+# relatorio de --time-report=json), para acompanhar regressoes entre commits.
+# Cada programa e compilado BENCH_RUNS vezes, e o tempo de cada fase em cada
+# execucao vai para $BENCH_DIR/samples.tsv (usado por benchgate.sh).
+#
+# Variaveis: BENCH_DIR (padrao bench), BENCH_SHAPES, BENCH_SIZES (linhas),
+# BENCH_RUNS (padrao 1)
+
+set -e
+
+DIR=${BENCH_DIR:-bench}
+SHAPES=${BENCH_SHAPES:-"funcoes aninhado blocos globais arrays recursao misto"}
+SIZES=${BENCH_SIZES:-"1000 4000 16000 64000"}
+RUNS=${BENCH_RUNS:-1}
+COMMIT=$(git rev-parse --short HEAD 2>/dev/null || echo desconhecido)
+DATE=$(date -u +%Y-%m-%dT%H:%M:%SZ)
+
+mkdir -p "$DIR"
+RESULTS="$DIR/results.json"
+SAMPLES="$DIR/samples.tsv"
+: > "$RESULTS.tmp"
+printf "forma\ttamanho\texecucao\tfase\ttempo_ms\n" > "$SAMPLES"
+
+# tempo_ms de uma fase do relatorio (uma fase por linha); 0 se ausente
+phase_ms() {
+    local v
+    v=$(sed -n "s/.*\"fase\": \"$1\", \"tempo_ms\": \([0-9.]*\).*/\1/p" "$2")
+    echo "${v:-0}"
+}
+
+printf "%-9s %7s %10s %11s %9s %9s %9s %9s %10s\n" \
+    forma linhas "total ms" "linhas/s" parser simbolos tipos codigo "RSS KiB"
+first=1
+for shape in $SHAPES; do
+    for size in $SIZES; do
+        src="$DIR/$shape-$size.cm"
+        report="$DIR/$shape-$size.json"
+        ./cmgen -s "$shape" -n "$size" > "$src"
+        lines=$(wc -l < "$src")
+        bytes=$(wc -c < "$src")
+        for run in $(seq 1 "$RUNS"); do
+            if ! ./cminus -j1 --time-report=json "$src" > /dev/null 2> "$report"; then
+                echo "Erro: $src nao compilou (veja $report)" >&2
+                exit 1
+            fi
+            total=$(sed -n 's/.*"total": {"tempo_ms": \([0-9.]*\).*/\1/p' "$report")
+            rss=$(sed -n 's/.*"total": {.*"pico_rss_kb": \(-\{0,1\}[0-9]*\).*/\1/p' "$report")
+            lps=$(awk -v l="$lines" -v t="$total" 'BEGIN { printf "%.0f", (t > 0 ? l * 1000 / t : 0) }')
+            printf "%-9s %7d %10.1f %11d %9.1f %9.1f %9.1f %9.1f %10d\n" "$shape" "$lines" "$total" "$lps" \
+                "$(phase_ms parser "$report")" "$(phase_ms simbolos "$report")" \
+                "$(phase_ms tipos "$report")" "$(phase_ms codigo "$report")" "$rss"
+
+            sed -n "s/.*\"fase\": \"\([a-z]*\)\", \"tempo_ms\": \([0-9.]*\).*/$shape\t$size\t$run\t\1\t\2/p" "$report" >> "$SAMPLES"
+            printf "%s\t%s\t%s\ttotal\t%s\n" "$shape" "$size" "$run" "$total" >> "$SAMPLES"
+
+            record="{\"commit\": \"$COMMIT\", \"data\": \"$DATE\", \"forma\": \"$shape\", \"execucao\": $run, \"linhas\": $lines, \"bytes\": $bytes, \"tempo_ms\": $total, \"linhas_por_s\": $lps, \"pico_rss_kb\": $rss, \"relatorio\": $(tr -d '\n' < "$report")}"
+            [ $first -eq 1 ] || echo "," >> "$RESULTS.tmp"
+            printf "%s" "$record" >> "$RESULTS.tmp"
+            echo "$record" >> "$DIR/history.jsonl"
+            first=0
+        done
+    done
+done
+{ echo "["; cat "$RESULTS.tmp"; echo; echo "]"; } > "$RESULTS"
+rm -f "$RESULTS.tmp"
+echo "Resultados gravados em $RESULTS (historico em $DIR/history.jsonl)"
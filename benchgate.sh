@@ -0,0 +1,113 @@
+#!/bin/bash
+# Portao de regressao de desempenho sobre o bench.sh.
+#
+#   ./benchgate.sh save    mede e grava a linha de base
+#   ./benchgate.sh check   mede e compara com a linha de base
+#
+# Cada programa e compilado BENCH_RUNS vezes. Para cada forma, tamanho e fase
+# (e o total) sao calculados a mediana e o intervalo de confianca de 95% da
+# mediana (por estatisticas de ordem, sem supor distribuicao normal). Uma
+# fase regride quando a mediana atual passa da mediana de base em mais de
+# BENCH_THRESHOLD por cento e os dois intervalos nao se sobrepoem; fases
+# abaixo de BENCH_MIN_MS na linha de base sao ignoradas (ruido). O check
+# termina com status 1 se alguma fase regrediu.
+#
+# Variaveis: BENCH_RUNS (padrao 5), BENCH_THRESHOLD (padrao 10),
+# BENCH_MIN_MS (padrao 1), BENCH_BASELINE (padrao $BENCH_DIR/baseline.tsv),
+# e as de bench.sh (BENCH_DIR, BENCH_SHAPES, BENCH_SIZES).
+
+set -e
+
+MODE=$1
+DIR=${BENCH_DIR:-bench}
+RUNS=${BENCH_RUNS:-5}
+THRESHOLD=${BENCH_THRESHOLD:-10}
+MIN_MS=${BENCH_MIN_MS:-1}
+BASELINE=${BENCH_BASELINE:-$DIR/baseline.tsv}
+SUMMARY="$DIR/summary.tsv"
+
+if [ "$MODE" != "save" ] && [ "$MODE" != "check" ]; then
+    echo "Uso: $0 save|check" >&2
+    exit 2
+fi
+if [ "$MODE" = "check" ] && [ ! -f "$BASELINE" ]; then
+    echo "Erro: linha de base $BASELINE nao existe (use 'make bench-baseline')" >&2
+    exit 2
+fi
+
+mkdir -p "$DIR"
+echo "Medindo ($RUNS execucoes por programa)..."
+if ! BENCH_DIR="$DIR" BENCH_RUNS="$RUNS" ./bench.sh > "$DIR/bench.log"; then
+    cat "$DIR/bench.log"
+    exit 2
+fi
+
+# mediana e intervalo de confianca de 95% por forma, tamanho e fase
+awk -F '\t' '
+    NR == 1 { next }
+    {
+        key = $1 "\t" $2 "\t" $4
+        if (!(key in n)) order[++nkeys] = key
+        v[key, ++n[key]] = $5 + 0
+    }
+    END {
+        print "forma\ttamanho\tfase\tn\tmediana\tic_inf\tic_sup"
+        for (k = 1; k <= nkeys; k++) {
+            key = order[k]
+            m = n[key]
+            for (i = 1; i <= m; i++) s[i] = v[key, i]
+            for (i = 2; i <= m; i++) {
+                x = s[i]
+                for (j = i - 1; j >= 1 && s[j] > x; j--) s[j + 1] = s[j]
+                s[j + 1] = x
+            }
+            med = (m % 2) ? s[(m + 1) / 2] : (s[m / 2] + s[m / 2 + 1]) / 2
+            # postos da ordem que limitam a mediana: n/2 -+ 1.96 sqrt(n)/2
+            lo = int(m / 2 - 0.98 * sqrt(m))
+            hi = int(1 + m / 2 + 0.98 * sqrt(m) + 0.999)
+            if (lo < 1) lo = 1
+            if (hi > m) hi = m
+            printf "%s\t%d\t%.3f\t%.3f\t%.3f\n", key, m, med, s[lo], s[hi]
+        }
+    }' "$DIR/samples.tsv" > "$SUMMARY"
+
+if [ "$MODE" = "save" ]; then
+    cp "$SUMMARY" "$BASELINE"
+    echo "Linha de base gravada em $BASELINE ($(($(wc -l < "$BASELINE") - 1)) medidas)"
+    exit 0
+fi
+
+awk -F '\t' -v limit="$THRESHOLD" -v minms="$MIN_MS" '
+    FNR == 1 { next }
+    NR == FNR { med[$1, $2, $3] = $5; sup[$1, $2, $3] = $7; next }
+    {
+        if (!(($1, $2, $3) in med)) { missing++; next }
+        base = med[$1, $2, $3]
+        if (base < minms) { skipped++; next }
+        compared++
+        change = 100 * ($5 - base) / base
+        status = ""
+        if (change > limit && $6 > sup[$1, $2, $3]) {
+            status = "REGRESSAO"
+            regressions++
+        } else if (change < -limit) {
+            status = "melhora"
+        }
+        if (status != "") {
+            if (!header++)
+                printf "%-9s %8s %-10s %12s %12s %22s %9s  %s\n", "forma", "tamanho", "fase",
+                       "base (ms)", "atual (ms)", "IC 95% atual", "variacao", "situacao"
+            printf "%-9s %8d %-10s %12.3f %12.3f %10.3f - %9.3f %+8.1f%%  %s\n",
+                   $1, $2, $3, base, $5, $6, $7, change, status
+        }
+    }
+    END {
+        printf "\n%d medidas comparadas, %d abaixo de %s ms ignoradas", compared, skipped, minms
+        if (missing) printf ", %d sem linha de base", missing
+        printf "\n"
+        if (regressions) {
+            printf "%d fase(s) regrediram mais de %s%% (intervalos de confianca sem sobreposicao)\n", regressions, limit
+            exit 1
+        }
+        printf "Nenhuma regressao acima de %s%%\n", limit
+    }' "$BASELINE" "$SUMMARY"
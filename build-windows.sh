@@ -57,6 +57,9 @@ CFLAGS="-Wall -Wno-unused-function -O2"
 echo "Compilando main.c..."
 $CC $CFLAGS -c main.c -o main.o
 
+echo "Compilando compiler.c..."
+$CC $CFLAGS -c compiler.c -o compiler.o
+
 echo "Compilando util.c..."
 $CC $CFLAGS -c util.c -o util.o
 
@@ -69,6 +72,78 @@ $CC $CFLAGS -c analyze.c -o analyze.o
 echo "Compilando cgen.c..."
 $CC $CFLAGS -c cgen.c -o cgen.o
 
+echo "Compilando ir.c..."
+$CC $CFLAGS -c ir.c -o ir.o
+
+echo "Compilando irfile.c..."
+$CC $CFLAGS -c irfile.c -o irfile.o
+
+echo "Compilando vm.c..."
+$CC $CFLAGS -c vm.c -o vm.o
+
+echo "Compilando cache.c..."
+$CC $CFLAGS -c cache.c -o cache.o
+
+echo "Compilando incr.c..."
+$CC $CFLAGS -c incr.c -o incr.o
+
+echo "Compilando pool.c..."
+$CC $CFLAGS -c pool.c -o pool.o
+
+echo "Compilando batch.c..."
+$CC $CFLAGS -c batch.c -o batch.o
+
+echo "Compilando source.c..."
+$CC $CFLAGS -c source.c -o source.o
+
+echo "Compilando lexer.c..."
+$CC $CFLAGS -c lexer.c -o lexer.o
+
+echo "Compilando tokens.c..."
+$CC $CFLAGS -c tokens.c -o tokens.o
+
+echo "Compilando ast.c..."
+$CC $CFLAGS -c ast.c -o ast.o
+
+echo "Compilando phase.c..."
+$CC $CFLAGS -c phase.c -o phase.o
+
+echo "Compilando opt.c..."
+$CC $CFLAGS -c opt.c -o opt.o
+
+echo "Compilando ssa.c..."
+$CC $CFLAGS -c ssa.c -o ssa.o
+
+echo "Compilando sccp.c..."
+$CC $CFLAGS -c sccp.c -o sccp.o
+
+echo "Compilando fold.c..."
+$CC $CFLAGS -c fold.c -o fold.o
+
+echo "Compilando unroll.c..."
+$CC $CFLAGS -c unroll.c -o unroll.o
+
+echo "Compilando frame.c..."
+$CC $CFLAGS -c frame.c -o frame.o
+
+echo "Compilando profile.c..."
+$CC $CFLAGS -c profile.c -o profile.o
+
+echo "Compilando pgo.c..."
+$CC $CFLAGS -c pgo.c -o pgo.o
+
+echo "Compilando rpc.c..."
+$CC $CFLAGS -c rpc.c -o rpc.o
+
+echo "Compilando server.c..."
+$CC $CFLAGS -c server.c -o server.o
+
+echo "Compilando watch.c..."
+$CC $CFLAGS -c watch.c -o watch.o
+
+echo "Compilando memcount.c..."
+$CC $CFLAGS -c memcount.c -o memcount.o
+
 echo "Compilando cminus.tab.c..."
 $CC $CFLAGS -c cminus.tab.c -o cminus.tab.o
 
@@ -77,7 +152,7 @@ $CC $CFLAGS -c lex.yy.c -o lex.yy.o
 
 # Linkar tudo
 echo -e "${YELLOW}Linkando executável...${NC}"
-$CC $CFLAGS -o cminus.exe main.o util.o symtab.o analyze.o cgen.o cminus.tab.o lex.yy.o
+$CC $CFLAGS -o cminus.exe main.o memcount.o compiler.o util.o symtab.o analyze.o cgen.o ir.o irfile.o vm.o cache.o incr.o pool.o batch.o source.o lexer.o tokens.o ast.o phase.o opt.o ssa.o sccp.o fold.o unroll.o frame.o profile.o pgo.o rpc.o server.o watch.o cminus.tab.o lex.yy.o -lpthread
 
 if [ $? -eq 0 ]; then
     echo -e "\n${GREEN} Compilação concluída com sucesso!${NC}"
@@ -0,0 +1,749 @@
+/**
+ * @file cache.c
+ * @brief Implementacao do cache persistente de compilacao
+ */
+
+#include "globals.h"
+#include "util.h"
+#include "cache.h"
+#include "irfile.h"
+#include <stdint.h>
+#include <errno.h>
+
+#ifndef _WIN32
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+#endif
+
+#define CACHE_MAGIC "CMCE"
+#define CACHE_FORMAT 1
+
+#ifndef _WIN32
+static unsigned long tmpSeq = 0;  // nomes unicos de temporarios entre threads
+#endif
+
+/**
+ * @brief Cabecalho de um arquivo de entrada do cache
+ */
+typedef struct {
+    char magic[4];
+    uint32_t format;
+    uint64_t key[2];
+    uint64_t listingSize;
+    uint64_t cmirSize;
+    uint64_t checksum;
+} CacheFileHeader;
+
+/**
+ * @brief Arquivo de entrada encontrado durante a remocao
+ */
+typedef struct {
+    char* path;
+    time_t mtime;
+    unsigned long long size;
+} CacheFileInfo;
+
+/**
+ * @brief Acumula bytes em um hash FNV-1a de 64 bits
+ * @param h Hash atual
+ * @param p Dados
+ * @param n Numero de bytes
+ * @return Hash atualizado
+ */
+static uint64_t fnv64(uint64_t h, const void* p, size_t n) {
+    const unsigned char* s = (const unsigned char*)p;
+    size_t i;
+    for (i = 0; i < n; i++) {
+        h ^= s[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+/**
+ * @brief Mistura final (splitmix64) para espalhar os bits do hash
+ * @param x Valor
+ * @return Valor misturado
+ */
+static uint64_t mix64(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    x ^= x >> 31;
+    return x;
+}
+
+/**
+ * @brief Identidade do executavel do compilador (versao, tamanho e data)
+ * @param buf Buffer de saida
+ * @param n Tamanho do buffer
+ */
+static void compilerIdentity(char* buf, size_t n) {
+#ifndef _WIN32
+    struct stat st;
+    if (stat("/proc/self/exe", &st) == 0) {
+        snprintf(buf, n, "cminus %s ir%d exe%lld.%lld", CMINUS_VERSION, IRFILE_VERSION,
+                 (long long)st.st_size, (long long)st.st_mtime);
+        return;
+    }
+#endif
+    snprintf(buf, n, "cminus %s ir%d", CMINUS_VERSION, IRFILE_VERSION);
+}
+
+void cache_key(CacheKey* key, const char* src, size_t len, const char* options) {
+    char ident[128];
+    uint64_t h0 = 14695981039346656037ull;
+    uint64_t h1 = 0x84222325cbf29ce4ull;
+    uint64_t n = len;
+    compilerIdentity(ident, sizeof(ident));
+    h0 = fnv64(h0, ident, strlen(ident) + 1);
+    h1 = fnv64(h1, ident, strlen(ident) + 1);
+    h0 = fnv64(h0, options, strlen(options) + 1);
+    h1 = fnv64(h1, options, strlen(options) + 1);
+    h0 = fnv64(h0, &n, sizeof(n));
+    h1 = fnv64(h1 ^ 0x9e3779b97f4a7c15ull, src, len);
+    h0 = fnv64(h0, src, len);
+    key->h[0] = mix64(h0 ^ (h1 >> 1));
+    key->h[1] = mix64(h1 + 0x9e3779b97f4a7c15ull * (h0 | 1));
+    snprintf(key->hex, sizeof(key->hex), "%016llx%016llx", key->h[0], key->h[1]);
+}
+
+/**
+ * @brief Blob de funcao guardado em memoria
+ */
+typedef struct CacheBlob {
+    unsigned long long key[2];
+    unsigned generation;     // ultima compilacao que usou o blob
+    size_t size;
+    char data[];
+} CacheBlob;
+
+int cache_open_memory(Cache* cache) {
+    memset(cache, 0, sizeof(*cache));
+    cache->blobCap = 256;
+    cache->blobs = (CacheBlob**)calloc(cache->blobCap, sizeof(CacheBlob*));
+    if (cache->blobs == NULL)
+        return -1;
+    cache->memory = TRUE;
+    cache->maxBytes = CACHE_DEFAULT_MAX;
+    pthread_mutex_init(&cache->lock, NULL);
+    return 0;
+}
+
+/**
+ * @brief Posicao de uma chave no hash aberto (livre ou ocupada por ela)
+ * @param cache Cache em memoria
+ * @param key Chave
+ * @return Indice em cache->blobs
+ */
+static size_t memSlot(Cache* cache, const unsigned long long key[2]) {
+    size_t mask = cache->blobCap - 1;
+    size_t i = (size_t)key[0] & mask;
+    while (cache->blobs[i] != NULL &&
+           (cache->blobs[i]->key[0] != key[0] || cache->blobs[i]->key[1] != key[1]))
+        i = (i + 1) & mask;
+    return i;
+}
+
+/**
+ * @brief Reconstroi o hash aberto com uma nova capacidade
+ * @param cache Cache em memoria
+ * @param cap Nova capacidade (potencia de 2, maior que o numero de blobs)
+ * @return 0 se sucesso, -1 se erro
+ */
+static int memRehash(Cache* cache, size_t cap) {
+    CacheBlob** old = cache->blobs;
+    size_t oldCap = cache->blobCap;
+    size_t i;
+    cache->blobs = (CacheBlob**)calloc(cap, sizeof(CacheBlob*));
+    if (cache->blobs == NULL) {
+        cache->blobs = old;
+        return -1;
+    }
+    cache->blobCap = cap;
+    for (i = 0; i < oldCap; i++)
+        if (old[i] != NULL)
+            cache->blobs[memSlot(cache, old[i]->key)] = old[i];
+    free(old);
+    return 0;
+}
+
+/**
+ * @brief Procura um blob no cache em memoria e o marca como usado
+ * @param cache Cache em memoria
+ * @param key Chave do blob
+ * @param data Copia do conteudo (liberar com free)
+ * @param size Tamanho do conteudo
+ * @return 1 se encontrou, 0 caso contrario
+ */
+static int memGetBlob(Cache* cache, const CacheKey* key, char** data, size_t* size) {
+    CacheBlob* b;
+    *data = NULL;
+    *size = 0;
+    pthread_mutex_lock(&cache->lock);
+    b = cache->blobs[memSlot(cache, key->h)];
+    if (b != NULL) {
+        b->generation = cache->generation;
+        *data = (char*)malloc(b->size + 1);
+        if (*data != NULL) {
+            memcpy(*data, b->data, b->size);
+            (*data)[b->size] = '\0';
+            *size = b->size;
+        }
+    }
+    pthread_mutex_unlock(&cache->lock);
+    return *data != NULL;
+}
+
+/**
+ * @brief Guarda (ou substitui) um blob no cache em memoria
+ * @param cache Cache em memoria
+ * @param key Chave do blob
+ * @param data Conteudo
+ * @param size Tamanho do conteudo
+ * @return 0 se sucesso, -1 se erro
+ */
+static int memPutBlob(Cache* cache, const CacheKey* key, const void* data, size_t size) {
+    CacheBlob* b = (CacheBlob*)malloc(sizeof(CacheBlob) + size);
+    size_t i;
+    if (b == NULL)
+        return -1;
+    b->key[0] = key->h[0];
+    b->key[1] = key->h[1];
+    b->size = size;
+    memcpy(b->data, data, size);
+    pthread_mutex_lock(&cache->lock);
+    b->generation = cache->generation;
+    // fator de carga de no maximo 1/2
+    if ((cache->nblobs + 1) * 2 > cache->blobCap && memRehash(cache, cache->blobCap * 2) != 0) {
+        pthread_mutex_unlock(&cache->lock);
+        free(b);
+        return -1;
+    }
+    i = memSlot(cache, b->key);
+    if (cache->blobs[i] != NULL) {
+        cache->blobBytes -= cache->blobs[i]->size;
+        free(cache->blobs[i]);
+    } else {
+        cache->nblobs++;
+    }
+    cache->blobs[i] = b;
+    cache->blobBytes += size;
+    cache->pendingStores++;
+    pthread_mutex_unlock(&cache->lock);
+    return 0;
+}
+
+/**
+ * @brief Estatisticas do cache em memoria
+ * @param cache Cache em memoria
+ * @param stats Estatisticas lidas
+ */
+static void memStats(Cache* cache, CacheStats* stats) {
+    memset(stats, 0, sizeof(*stats));
+    pthread_mutex_lock(&cache->lock);
+    stats->stores = cache->pendingStores;
+    stats->evictions = cache->swept;
+    stats->bytes = cache->blobBytes;
+    pthread_mutex_unlock(&cache->lock);
+}
+
+size_t cache_sweep(Cache* cache) {
+    size_t removed = 0;
+    size_t i;
+    if (!cache->memory)
+        return 0;
+    pthread_mutex_lock(&cache->lock);
+    for (i = 0; i < cache->blobCap; i++) {
+        CacheBlob* b = cache->blobs[i];
+        if (b != NULL && b->generation != cache->generation) {
+            cache->blobBytes -= b->size;
+            free(b);
+            cache->blobs[i] = NULL;
+            removed++;
+        }
+    }
+    cache->nblobs -= removed;
+    cache->swept += removed;
+    // as remocoes abrem buracos nas sequencias de sondagem: reinsere o resto
+    if (removed > 0)
+        memRehash(cache, cache->blobCap);
+    cache->generation++;
+    pthread_mutex_unlock(&cache->lock);
+    return removed;
+}
+
+#ifndef _WIN32
+
+/**
+ * @brief Monta o caminho de um arquivo dentro do cache
+ * @param cache Cache aberto
+ * @param name Nome relativo ao diretorio do cache
+ * @return Caminho alocado
+ */
+static char* cachePath(Cache* cache, const char* name) {
+    size_t n = strlen(cache->dir) + strlen(name) + 2;
+    char* p = (char*)malloc(n);
+    if (p != NULL)
+        snprintf(p, n, "%s/%s", cache->dir, name);
+    return p;
+}
+
+/**
+ * @brief Caminho da entrada de uma chave (subdiretorio pelos 2 primeiros digitos)
+ * @param cache Cache aberto
+ * @param key Chave
+ * @param ext Extensao do tipo de entrada ("ce" compilacao, "fn" funcao)
+ * @param buf Buffer de saida
+ * @param n Tamanho do buffer
+ */
+static void entryPath(Cache* cache, const CacheKey* key, const char* ext, char* buf, size_t n) {
+    snprintf(buf, n, "%s/%.2s/%s.%s", cache->dir, key->hex, key->hex, ext);
+}
+
+/**
+ * @brief Adquire o lock exclusivo do cache
+ * @param cache Cache aberto
+ * @return Descritor do lock ou -1
+ */
+static int lockCache(Cache* cache) {
+    char* p = cachePath(cache, "lock");
+    int fd;
+    if (p == NULL)
+        return -1;
+    fd = open(p, O_RDWR | O_CREAT, 0644);
+    free(p);
+    if (fd >= 0 && flock(fd, LOCK_EX) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * @brief Libera o lock do cache
+ * @param fd Descritor retornado por lockCache
+ */
+static void unlockCache(int fd) {
+    if (fd >= 0) {
+        flock(fd, LOCK_UN);
+        close(fd);
+    }
+}
+
+/**
+ * @brief Le o arquivo de estatisticas (chamar com o lock)
+ * @param cache Cache aberto
+ * @param st Estatisticas lidas (zeradas se o arquivo nao existe)
+ */
+static void readStats(Cache* cache, CacheStats* st) {
+    char* p = cachePath(cache, "stats");
+    FILE* f;
+    memset(st, 0, sizeof(*st));
+    if (p == NULL)
+        return;
+    f = fopen(p, "r");
+    free(p);
+    if (f == NULL)
+        return;
+    if (fscanf(f, "hits %llu\nmisses %llu\nstores %llu\nevictions %llu\nbytes %llu\n",
+               &st->hits, &st->misses, &st->stores, &st->evictions, &st->bytes) != 5)
+        memset(st, 0, sizeof(*st));
+    fclose(f);
+}
+
+/**
+ * @brief Grava o arquivo de estatisticas de forma atomica (chamar com o lock)
+ * @param cache Cache aberto
+ * @param st Estatisticas
+ */
+static void writeStats(Cache* cache, const CacheStats* st) {
+    char* p = cachePath(cache, "stats");
+    char* tmp = cachePath(cache, "stats.tmp");
+    FILE* f;
+    if (p != NULL && tmp != NULL && (f = fopen(tmp, "w")) != NULL) {
+        fprintf(f, "hits %llu\nmisses %llu\nstores %llu\nevictions %llu\nbytes %llu\n",
+                st->hits, st->misses, st->stores, st->evictions, st->bytes);
+        if (fclose(f) == 0)
+            rename(tmp, p);
+    }
+    free(p);
+    free(tmp);
+}
+
+/**
+ * @brief Soma deltas as estatisticas acumuladas
+ * @param cache Cache aberto
+ * @param hits Acertos
+ * @param misses Falhas
+ * @param stores Entradas gravadas
+ * @param bytes Bytes gravados
+ * @param total Recebe as estatisticas atualizadas (pode ser NULL)
+ */
+static void updateStats(Cache* cache, int hits, int misses, int stores,
+                        unsigned long long bytes, CacheStats* total) {
+    int fd = lockCache(cache);
+    CacheStats st;
+    readStats(cache, &st);
+    st.hits += hits;
+    st.misses += misses;
+    st.stores += stores;
+    st.bytes += bytes;
+    writeStats(cache, &st);
+    unlockCache(fd);
+    if (total != NULL)
+        *total = st;
+}
+
+/**
+ * @brief Ordena arquivos do mais antigo para o mais recente
+ */
+static int compareMtime(const void* a, const void* b) {
+    const CacheFileInfo* x = (const CacheFileInfo*)a;
+    const CacheFileInfo* y = (const CacheFileInfo*)b;
+    if (x->mtime != y->mtime)
+        return x->mtime < y->mtime ? -1 : 1;
+    return strcmp(x->path, y->path);
+}
+
+/**
+ * @brief Remove as entradas usadas ha mais tempo ate 90% do limite
+ *
+ * O tamanho total e recalculado a partir do disco, o que corrige qualquer
+ * divergencia do contador mantido em 'stats'.
+ *
+ * @param cache Cache aberto
+ */
+static void evict(Cache* cache) {
+    int fd = lockCache(cache);
+    CacheFileInfo* files = NULL;
+    size_t nfiles = 0, cap = 0, i;
+    unsigned long long total = 0, target = cache->maxBytes / 10 * 9;
+    unsigned long long removed = 0;
+    CacheStats st;
+    DIR* top = opendir(cache->dir);
+    struct dirent* d;
+    while (top != NULL && (d = readdir(top)) != NULL) {
+        char sub[2048];
+        DIR* dd;
+        struct dirent* e;
+        if (strlen(d->d_name) != 2 || d->d_name[0] == '.')
+            continue;
+        snprintf(sub, sizeof(sub), "%s/%s", cache->dir, d->d_name);
+        dd = opendir(sub);
+        while (dd != NULL && (e = readdir(dd)) != NULL) {
+            char path[4096];
+            struct stat sb;
+            size_t len = strlen(e->d_name);
+            if (len < 4 || e->d_name[0] == '.' ||
+                (strcmp(e->d_name + len - 3, ".ce") != 0 && strcmp(e->d_name + len - 3, ".fn") != 0))
+                continue;
+            snprintf(path, sizeof(path), "%s/%s", sub, e->d_name);
+            if (stat(path, &sb) != 0)
+                continue;
+            if (nfiles == cap) {
+                cap = cap ? cap * 2 : 64;
+                files = (CacheFileInfo*)realloc(files, cap * sizeof(CacheFileInfo));
+            }
+            files[nfiles].path = copyString(path);
+            files[nfiles].mtime = sb.st_mtime;
+            files[nfiles].size = (unsigned long long)sb.st_size;
+            total += files[nfiles].size;
+            nfiles++;
+        }
+        if (dd != NULL)
+            closedir(dd);
+    }
+    if (top != NULL)
+        closedir(top);
+    if (nfiles > 0)
+        qsort(files, nfiles, sizeof(CacheFileInfo), compareMtime);
+    for (i = 0; i < nfiles && total > target; i++) {
+        if (unlink(files[i].path) == 0) {
+            total -= files[i].size;
+            removed++;
+        }
+    }
+    for (i = 0; i < nfiles; i++)
+        free(files[i].path);
+    free(files);
+    readStats(cache, &st);
+    st.evictions += removed;
+    st.bytes = total;
+    writeStats(cache, &st);
+    unlockCache(fd);
+}
+
+int cache_open(Cache* cache, const char* dir, unsigned long long maxBytes) {
+    struct stat st;
+    memset(cache, 0, sizeof(*cache));
+    cache->maxBytes = maxBytes ? maxBytes : CACHE_DEFAULT_MAX;
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+        fprintf(stderr, "Erro: nao foi possivel criar o diretorio de cache '%s'\n", dir);
+        return -1;
+    }
+    if (stat(dir, &st) != 0 || !S_ISDIR(st.st_mode)) {
+        fprintf(stderr, "Erro: '%s' nao e um diretorio\n", dir);
+        return -1;
+    }
+    cache->dir = copyString((char*)dir);
+    if (cache->dir == NULL)
+        return -1;
+    pthread_mutex_init(&cache->lock, NULL);
+    return 0;
+}
+
+/**
+ * @brief Le e valida um arquivo de entrada
+ * @param cache Cache aberto
+ * @param key Chave
+ * @param ext Extensao do tipo de entrada
+ * @param h Cabecalho lido
+ * @param data Conteudo lido (alocado, terminado em '\0')
+ * @return 1 se a entrada existe e esta integra, 0 caso contrario
+ */
+static int readEntry(Cache* cache, const CacheKey* key, const char* ext,
+                     CacheFileHeader* h, char** data) {
+    char path[4096];
+    FILE* f;
+    size_t payload;
+    *data = NULL;
+    entryPath(cache, key, ext, path, sizeof(path));
+    f = fopen(path, "rb");
+    if (f == NULL)
+        return 0;
+    if (fread(h, sizeof(*h), 1, f) != 1 || memcmp(h->magic, CACHE_MAGIC, 4) != 0 ||
+        h->format != CACHE_FORMAT || h->key[0] != key->h[0] || h->key[1] != key->h[1]) {
+        fclose(f);
+        return 0;
+    }
+    payload = (size_t)(h->listingSize + h->cmirSize);
+    *data = (char*)malloc(payload + 1);
+    if (*data == NULL || fread(*data, 1, payload, f) != payload ||
+        fnv64(14695981039346656037ull, *data, payload) != h->checksum) {
+        // entrada truncada ou corrompida: tratada como falha e sobrescrita depois
+        fclose(f);
+        free(*data);
+        *data = NULL;
+        return 0;
+    }
+    fclose(f);
+    (*data)[payload] = '\0';
+    // marca a entrada como usada recentemente (LRU por data de modificacao)
+    utime(path, NULL);
+    return 1;
+}
+
+/**
+ * @brief Grava um arquivo de entrada com duas partes, de forma atomica
+ * @param cache Cache aberto
+ * @param key Chave
+ * @param ext Extensao do tipo de entrada
+ * @param a Primeira parte
+ * @param na Tamanho da primeira parte
+ * @param b Segunda parte
+ * @param nb Tamanho da segunda parte
+ * @return 0 se sucesso, -1 se erro
+ */
+static int writeEntry(Cache* cache, const CacheKey* key, const char* ext,
+                      const void* a, size_t na, const void* b, size_t nb) {
+    char path[4096];
+    char tmp[4096];
+    char sub[2048];
+    CacheFileHeader h;
+    FILE* f;
+    int ok;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, CACHE_MAGIC, 4);
+    h.format = CACHE_FORMAT;
+    h.key[0] = key->h[0];
+    h.key[1] = key->h[1];
+    h.listingSize = na;
+    h.cmirSize = nb;
+    h.checksum = fnv64(fnv64(14695981039346656037ull, a, na), b, nb);
+    snprintf(sub, sizeof(sub), "%s/%.2s", cache->dir, key->hex);
+    if (mkdir(sub, 0755) != 0 && errno != EEXIST)
+        return -1;
+    entryPath(cache, key, ext, path, sizeof(path));
+    snprintf(tmp, sizeof(tmp), "%s/.%s.%ld.%lu.tmp", sub, key->hex, (long)getpid(),
+             __atomic_fetch_add(&tmpSeq, 1, __ATOMIC_RELAXED));
+    f = fopen(tmp, "wb");
+    if (f == NULL)
+        return -1;
+    ok = fwrite(&h, sizeof(h), 1, f) == 1 &&
+         fwrite(a, 1, na, f) == na &&
+         fwrite(b, 1, nb, f) == nb;
+    if (fclose(f) != 0 || !ok || rename(tmp, path) != 0) {
+        unlink(tmp);
+        return -1;
+    }
+    pthread_mutex_lock(&cache->lock);
+    cache->pendingStores++;
+    cache->pendingBytes += sizeof(h) + na + nb;
+    pthread_mutex_unlock(&cache->lock);
+    return 0;
+}
+
+/**
+ * @brief Soma as gravacoes pendentes as estatisticas e aplica a remocao
+ * @param cache Cache aberto
+ */
+static void flushPending(Cache* cache) {
+    CacheStats st;
+    unsigned long long stores, bytes;
+    pthread_mutex_lock(&cache->lock);
+    stores = cache->pendingStores;
+    bytes = cache->pendingBytes;
+    cache->pendingStores = 0;
+    cache->pendingBytes = 0;
+    pthread_mutex_unlock(&cache->lock);
+    if (stores == 0)
+        return;
+    updateStats(cache, 0, 0, (int)stores, bytes, &st);
+    if (st.bytes > cache->maxBytes)
+        evict(cache);
+}
+
+int cache_lookup(Cache* cache, const CacheKey* key, CacheEntry* entry) {
+    CacheFileHeader h;
+    memset(entry, 0, sizeof(*entry));
+    if (cache->memory)
+        return 0;
+    if (!readEntry(cache, key, "ce", &h, &entry->data)) {
+        updateStats(cache, 0, 1, 0, 0, NULL);
+        return 0;
+    }
+    entry->listing = entry->data;
+    entry->listingSize = (size_t)h.listingSize;
+    entry->cmir = entry->data + h.listingSize;
+    entry->cmirSize = (size_t)h.cmirSize;
+    updateStats(cache, 1, 0, 0, 0, NULL);
+    return 1;
+}
+
+int cache_store(Cache* cache, const CacheKey* key, const char* listing, size_t listingSize,
+                const void* cmir, size_t cmirSize) {
+    int status;
+    if (cache->memory)
+        return -1;
+    status = writeEntry(cache, key, "ce", listing, listingSize, cmir, cmirSize);
+    flushPending(cache);
+    return status;
+}
+
+int cache_get_blob(Cache* cache, const CacheKey* key, char** data, size_t* size) {
+    CacheFileHeader h;
+    if (cache->memory)
+        return memGetBlob(cache, key, data, size);
+    if (!readEntry(cache, key, "fn", &h, data))
+        return 0;
+    *size = (size_t)h.listingSize;
+    return 1;
+}
+
+int cache_put_blob(Cache* cache, const CacheKey* key, const void* data, size_t size) {
+    if (cache->memory)
+        return memPutBlob(cache, key, data, size);
+    return writeEntry(cache, key, "fn", data, size, NULL, 0);
+}
+
+void cache_get_stats(Cache* cache, CacheStats* stats) {
+    int fd;
+    if (cache->memory) {
+        memStats(cache, stats);
+        return;
+    }
+    fd = lockCache(cache);
+    readStats(cache, stats);
+    unlockCache(fd);
+}
+
+#else
+
+int cache_open(Cache* cache, const char* dir, unsigned long long maxBytes) {
+    (void)maxBytes;
+    memset(cache, 0, sizeof(*cache));
+    fprintf(stderr, "Aviso: cache de compilacao indisponivel nesta plataforma ('%s' ignorado)\n", dir);
+    return -1;
+}
+
+int cache_lookup(Cache* cache, const CacheKey* key, CacheEntry* entry) {
+    (void)cache;
+    (void)key;
+    memset(entry, 0, sizeof(*entry));
+    return 0;
+}
+
+int cache_store(Cache* cache, const CacheKey* key, const char* listing, size_t listingSize,
+                const void* cmir, size_t cmirSize) {
+    (void)cache; (void)key; (void)listing; (void)listingSize; (void)cmir; (void)cmirSize;
+    return -1;
+}
+
+int cache_get_blob(Cache* cache, const CacheKey* key, char** data, size_t* size) {
+    if (cache->memory)
+        return memGetBlob(cache, key, data, size);
+    *data = NULL;
+    *size = 0;
+    return 0;
+}
+
+int cache_put_blob(Cache* cache, const CacheKey* key, const void* data, size_t size) {
+    if (cache->memory)
+        return memPutBlob(cache, key, data, size);
+    return -1;
+}
+
+void cache_get_stats(Cache* cache, CacheStats* stats) {
+    if (cache->memory)
+        memStats(cache, stats);
+    else
+        memset(stats, 0, sizeof(*stats));
+}
+
+static void flushPending(Cache* cache) {
+    (void)cache;
+}
+
+#endif
+
+void cache_close(Cache* cache) {
+    size_t i;
+    if (cache->memory) {
+        for (i = 0; i < cache->blobCap; i++)
+            free(cache->blobs[i]);
+        free(cache->blobs);
+        pthread_mutex_destroy(&cache->lock);
+        memset(cache, 0, sizeof(*cache));
+        return;
+    }
+    if (cache->dir == NULL)
+        return;
+    flushPending(cache);
+    pthread_mutex_destroy(&cache->lock);
+    free(cache->dir);
+    cache->dir = NULL;
+}
+
+void cache_entry_free(CacheEntry* entry) {
+    free(entry->data);
+    memset(entry, 0, sizeof(*entry));
+}
+
+void cache_print_stats(Cache* cache, FILE* out) {
+    CacheStats st;
+    unsigned long long lookups;
+    cache_get_stats(cache, &st);
+    lookups = st.hits + st.misses;
+    fprintf(out, "Cache: %s\n", cache->memory ? "(memoria)" : cache->dir);
+    fprintf(out, "  acertos: %llu  falhas: %llu  taxa de acerto: %.1f%%\n",
+            st.hits, st.misses, lookups ? 100.0 * (double)st.hits / (double)lookups : 0.0);
+    fprintf(out, "  entradas gravadas: %llu  removidas: %llu\n", st.stores, st.evictions);
+    fprintf(out, "  tamanho: %.1f KiB de %.1f KiB\n", (double)st.bytes / 1024.0,
+            (double)cache->maxBytes / 1024.0);
+}
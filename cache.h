@@ -0,0 +1,184 @@
+/**
+ * @file cache.h
+ * @brief Cache persistente de compilacao em disco
+ *
+ * Cada entrada guarda a listagem produzida pelas fases do compilador e o
+ * codigo intermediario binario (.cmir), indexada por um hash de 128 bits do
+ * codigo fonte, das opcoes que alteram a saida e da identidade do
+ * compilador. O mesmo diretorio guarda blobs por funcao usados na
+ * recompilacao incremental (ver incr.h). As entradas sao gravadas em
+ * arquivo temporario e renomeadas (escrita atomica); a remocao das entradas
+ * menos usadas acontece sob um lock quando o tamanho total passa do limite
+ * configurado.
+ *
+ * Um cache aberto com cache_open_memory guarda so os blobs de funcao, em
+ * memoria, enquanto o processo vive (modo --watch); cache_sweep descarta os
+ * blobs que a ultima compilacao nao usou.
+ */
+
+#ifndef _CACHE_H_
+#define _CACHE_H_
+
+#include <stdio.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#define CACHE_DEFAULT_MAX (256ull * 1024 * 1024)
+
+/**
+ * @brief Chave de uma entrada do cache
+ */
+typedef struct {
+    unsigned long long h[2];
+    char hex[33];
+} CacheKey;
+
+/**
+ * @brief Conteudo de uma entrada encontrada no cache
+ */
+typedef struct {
+    char* data;          // bloco unico com listagem e binario
+    char* listing;
+    size_t listingSize;
+    char* cmir;
+    size_t cmirSize;
+} CacheEntry;
+
+/**
+ * @brief Estatisticas acumuladas do cache
+ */
+typedef struct {
+    unsigned long long hits;
+    unsigned long long misses;
+    unsigned long long stores;
+    unsigned long long evictions;
+    unsigned long long bytes;     // tamanho total estimado das entradas
+} CacheStats;
+
+/**
+ * @brief Cache aberto (pode ser usado por varias threads ao mesmo tempo)
+ */
+typedef struct {
+    char* dir;
+    unsigned long long maxBytes;
+    pthread_mutex_t lock;              // protege os contadores pendentes
+    unsigned long long pendingStores;  // gravacoes ainda nao somadas em 'stats'
+    unsigned long long pendingBytes;
+    int memory;                        // blobs em memoria (cache_open_memory)
+    struct CacheBlob** blobs;          // hash aberto dos blobs em memoria
+    size_t blobCap;                    // potencia de 2
+    size_t nblobs;
+    size_t blobBytes;
+    size_t swept;                      // blobs descartados por cache_sweep
+    unsigned generation;               // compilacao atual (cache_sweep)
+} Cache;
+
+/**
+ * @brief Abre (e cria se necessario) um diretorio de cache
+ * @param cache Cache a inicializar
+ * @param dir Diretorio do cache
+ * @param maxBytes Tamanho maximo em bytes (0 = CACHE_DEFAULT_MAX)
+ * @return 0 se sucesso, -1 se erro
+ */
+int cache_open(Cache* cache, const char* dir, unsigned long long maxBytes);
+
+/**
+ * @brief Abre um cache de blobs de funcao em memoria
+ *
+ * Nao guarda compilacoes inteiras (cache_lookup sempre falha e
+ * cache_store nao grava); so os blobs da recompilacao incremental.
+ *
+ * @param cache Cache a inicializar
+ * @return 0 se sucesso, -1 se erro
+ */
+int cache_open_memory(Cache* cache);
+
+/**
+ * @brief Descarta os blobs em memoria nao usados desde o ultimo cache_sweep
+ *
+ * Chamado depois de cada compilacao bem sucedida: o que sobra sao as
+ * funcoes do programa atual, e a memoria nao cresce a cada edicao.
+ *
+ * @param cache Cache em memoria
+ * @return Numero de blobs descartados
+ */
+size_t cache_sweep(Cache* cache);
+
+/**
+ * @brief Fecha o cache (soma gravacoes pendentes e aplica a remocao)
+ * @param cache Cache aberto
+ */
+void cache_close(Cache* cache);
+
+/**
+ * @brief Calcula a chave de uma compilacao
+ * @param key Chave calculada
+ * @param src Codigo fonte
+ * @param len Tamanho do codigo fonte
+ * @param options Opcoes que alteram a saida do compilador
+ */
+void cache_key(CacheKey* key, const char* src, size_t len, const char* options);
+
+/**
+ * @brief Procura uma entrada; conta acerto ou falha nas estatisticas
+ * @param cache Cache aberto
+ * @param key Chave da compilacao
+ * @param entry Conteudo encontrado (liberar com cache_entry_free)
+ * @return 1 se encontrou, 0 caso contrario
+ */
+int cache_lookup(Cache* cache, const CacheKey* key, CacheEntry* entry);
+
+/**
+ * @brief Grava uma entrada e aplica a politica de remocao
+ * @param cache Cache aberto
+ * @param key Chave da compilacao
+ * @param listing Listagem das fases
+ * @param listingSize Tamanho da listagem
+ * @param cmir Codigo intermediario binario
+ * @param cmirSize Tamanho do binario
+ * @return 0 se sucesso, -1 se erro (o cache nunca impede a compilacao)
+ */
+int cache_store(Cache* cache, const CacheKey* key, const char* listing, size_t listingSize,
+                const void* cmir, size_t cmirSize);
+
+/**
+ * @brief Procura um blob de funcao (nao conta nas estatisticas de acerto)
+ * @param cache Cache aberto
+ * @param key Chave do blob
+ * @param data Conteudo lido (liberar com free)
+ * @param size Tamanho do conteudo
+ * @return 1 se encontrou, 0 caso contrario
+ */
+int cache_get_blob(Cache* cache, const CacheKey* key, char** data, size_t* size);
+
+/**
+ * @brief Grava um blob de funcao; o tamanho entra no limite do cache
+ * @param cache Cache aberto
+ * @param key Chave do blob
+ * @param data Conteudo
+ * @param size Tamanho do conteudo
+ * @return 0 se sucesso, -1 se erro
+ */
+int cache_put_blob(Cache* cache, const CacheKey* key, const void* data, size_t size);
+
+/**
+ * @brief Libera o conteudo de uma entrada
+ * @param entry Entrada
+ */
+void cache_entry_free(CacheEntry* entry);
+
+/**
+ * @brief Le as estatisticas acumuladas
+ * @param cache Cache aberto
+ * @param stats Estatisticas lidas
+ */
+void cache_get_stats(Cache* cache, CacheStats* stats);
+
+/**
+ * @brief Imprime as estatisticas acumuladas
+ * @param cache Cache aberto
+ * @param out Arquivo de saida
+ */
+void cache_print_stats(Cache* cache, FILE* out);
+
+#endif
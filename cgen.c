@@ -6,188 +6,862 @@
 #include "globals.h"
 #include "cgen.h"
 #include "cminus.tab.h"
+#include "pool.h"
+#include "opt.h"
+#include "ssa.h"
+#include "fold.h"
+#include "unroll.h"
+#include "frame.h"
+#include "pgo.h"
+#include "profile.h"
 #include <stdlib.h>
 
-static int tempCount = 0;
-static int labelCount = 0;
+// Nome visivel em um escopo: variavel local, global ou funcao
+typedef struct {
+    uint32_t name;   // offset na tabela de strings
+    uint8_t kind;    // IR_LOCAL, IR_GLOBAL ou IR_FUNC
+    int32_t index;
+} Binding;
 
-static char* cGenExp(TreeNode* tree);
-static void cGenStmt(TreeNode* tree);
-static void cGenExpStmt(TreeNode* tree);
+// Ramo frio de um if-else, gerado depois do fim da funcao (--profile-use)
+typedef struct {
+    TreeNode* stmt;           // ramo
+    IrInstr label;            // entrada do ramo (destino do if_false)
+    IrInstr back;             // label depois do if, para onde o ramo volta
+    Binding* locals;          // nomes locais visiveis no if (copia)
+    int nlocals;
+    uint32_t slotTop;         // celulas ocupadas no if
+    TreeNode* blockFirst;
+    int unrollCopy;
+    int32_t line;             // linha da condicao do if
+} ColdBlock;
+
+// Estado do gerador durante a traducao de um programa
+struct CodeGen {
+    IrProgram* prog;
+    IrUnit* unit;             // funcao atual
+
+    Binding* locals;          // pilha de nomes locais da funcao atual
+    int nlocals;
+    int localCap;
+
+    Binding* globalMap;       // hash aberto de globais e funcoes
+    uint32_t globalMapCap;
+    uint32_t globalMapCount;
+
+    IncrState* incr;          // recompilacao incremental (opcional)
+    int optimize;             // nivel de otimizacao (ctx->optimize)
+    OptStats* optStats;       // contadores do peephole (opcional)
+    int unroll;               // fator de desenrolamento dos lacos com contador (1 = desligado)
+    TreeNode* blockFirst;     // primeiro statement do bloco atual (valor inicial do contador)
+    int unrollCopy;           // > 0 nas copias extras de um corpo desenrolado (nao repete o relatorio)
+    int profileGen;           // --profile-generate: emite IR_COUNT nos pontos de contagem (pgo.h)
+    const Profile* profile;   // --profile-use (NULL = sem perfil)
+    PgoSites sites;           // pontos de contagem da funcao atual
+    uint64_t* counts;         // contagens da funcao atual no perfil (NULL = sem dados)
+    ColdBlock* cold;          // ramos frios a gerar no fim da funcao
+    int ncold;
+    int coldCap;
+    int packLater;            // buildIR junta os temporarios depois dos passes sobre o programa inteiro
+};
+
+// Funcao a gerar depois que todas as globais e funcoes foram registradas
+typedef struct {
+    CodeGen* cg;              // estado compartilhado (somente leitura)
+    TreeNode* tree;           // no FunK
+    uint32_t unit;            // indice da unidade no programa
+    CacheKey key;             // impressao digital (recompilacao incremental)
+} FunJob;
+
+static IrInstr cGenExp(CodeGen* cg, TreeNode* tree);
+static void cGenStmt(CodeGen* cg, TreeNode* tree);
+static void cGenExpStmt(CodeGen* cg, TreeNode* tree);
+
+/**
+ * @brief Monta um operando
+ * @param kind Tipo do operando
+ * @param val Valor do operando
+ * @return Instrucao com o operando no campo 'a'
+ */
+static IrInstr opnd(int kind, int32_t val) {
+    IrInstr o;
+    memset(&o, 0, sizeof(o));
+    o.ka = (uint8_t)kind;
+    o.a = val;
+    return o;
+}
+
+/**
+ * @brief Monta uma instrucao a partir de operandos
+ * @param op Operacao
+ * @param d Destino (operando em 'a')
+ * @param a Primeiro operando (em 'a')
+ * @param b Segundo operando (em 'a')
+ * @return Instrucao montada
+ */
+static IrInstr instr(IrOp op, IrInstr d, IrInstr a, IrInstr b) {
+    IrInstr in;
+    in.op = (uint8_t)op;
+    in.kd = d.ka;
+    in.d = d.a;
+    in.ka = a.ka;
+    in.a = a.a;
+    in.kb = b.ka;
+    in.b = b.a;
+    in.line = 0; // ir_emit usa a linha do comando atual
+    return in;
+}
+
+/**
+ * @brief Define a linha do fonte das proximas instrucoes da funcao atual
+ * @param cg Estado do gerador
+ * @param tree No que gera as instrucoes
+ */
+static void setLine(CodeGen* cg, TreeNode* tree) {
+    if (tree != NULL && tree->lineno > 0)
+        cg->unit->line = tree->lineno;
+}
+
+/**
+ * @brief Gera um novo temporario na funcao atual
+ * @param cg Estado do gerador
+ * @return Operando do temporario
+ */
+static IrInstr newTemp(CodeGen* cg) {
+    return opnd(IR_TEMP, (int32_t)cg->unit->rec.ntemps++);
+}
+
+/**
+ * @brief Gera um novo label na funcao atual
+ * @param cg Estado do gerador
+ * @return Operando do label
+ */
+static IrInstr newLabel(CodeGen* cg) {
+    return opnd(IR_LABEL, (int32_t)cg->unit->rec.nlabels++);
+}
+
+/**
+ * @brief Registra um nome global ou de funcao
+ * @param cg Estado do gerador
+ * @param name Nome
+ * @param kind IR_GLOBAL ou IR_FUNC
+ * @param index Indice da global ou da funcao
+ */
+static void bindGlobal(CodeGen* cg, char* name, int kind, int32_t index) {
+    uint32_t off = ir_intern(&cg->prog->strs, name);
+    uint32_t j;
+    if ((cg->globalMapCount + 1) * 2 > cg->globalMapCap) {
+        Binding* old = cg->globalMap;
+        uint32_t oldCap = cg->globalMapCap;
+        uint32_t i;
+        cg->globalMapCap = cg->globalMapCap ? cg->globalMapCap * 2 : 64;
+        cg->globalMap = (Binding*)malloc(cg->globalMapCap * sizeof(Binding));
+        for (i = 0; i < cg->globalMapCap; i++)
+            cg->globalMap[i].name = UINT32_MAX;
+        for (i = 0; i < oldCap; i++) {
+            if (old[i].name != UINT32_MAX) {
+                j = old[i].name & (cg->globalMapCap - 1);
+                while (cg->globalMap[j].name != UINT32_MAX)
+                    j = (j + 1) & (cg->globalMapCap - 1);
+                cg->globalMap[j] = old[i];
+            }
+        }
+        free(old);
+    }
+    j = off & (cg->globalMapCap - 1);
+    while (cg->globalMap[j].name != UINT32_MAX && cg->globalMap[j].name != off)
+        j = (j + 1) & (cg->globalMapCap - 1);
+    if (cg->globalMap[j].name == UINT32_MAX)
+        cg->globalMapCount++;
+    cg->globalMap[j].name = off;
+    cg->globalMap[j].kind = (uint8_t)kind;
+    cg->globalMap[j].index = index;
+}
+
+/**
+ * @brief Empilha um nome local da funcao atual
+ * @param cg Estado do gerador
+ * @param name Nome
+ * @param size IR_SCALAR, IR_ARRAYREF ou numero de elementos
+ */
+static void bindLocal(CodeGen* cg, char* name, int size) {
+    if (cg->nlocals == cg->localCap) {
+        cg->localCap = cg->localCap ? cg->localCap * 2 : 16;
+        cg->locals = (Binding*)realloc(cg->locals, cg->localCap * sizeof(Binding));
+    }
+    cg->locals[cg->nlocals].index = ir_add_slot(cg->prog, cg->unit, name, size);
+    cg->locals[cg->nlocals].name = cg->unit->slots[cg->locals[cg->nlocals].index].name;
+    cg->locals[cg->nlocals].kind = IR_LOCAL;
+    cg->nlocals++;
+}
 
 /**
- * @brief Gera um novo nome de variavel temporaria
- * @return Nome da variavel temporaria
+ * @brief Resolve um nome: locais do mais interno ao externo, depois globais
+ * @param cg Estado do gerador
+ * @param name Nome
+ * @return Operando do nome
  */
-static char* newTemp(void) {
-    char* tempName = (char*)malloc(10 * sizeof(char));
-    sprintf(tempName, "t%d", tempCount++);
-    return tempName;
+static IrInstr lookupName(CodeGen* cg, char* name) {
+    uint32_t off = ir_strtab_find(&cg->prog->strs, name);
+    int i;
+    if (off != UINT32_MAX) {
+        for (i = cg->nlocals - 1; i >= 0; i--)
+            if (cg->locals[i].name == off)
+                return opnd(IR_LOCAL, cg->locals[i].index);
+        if (cg->globalMapCap > 0) {
+            uint32_t j = off & (cg->globalMapCap - 1);
+            while (cg->globalMap[j].name != UINT32_MAX) {
+                if (cg->globalMap[j].name == off)
+                    return opnd(cg->globalMap[j].kind, cg->globalMap[j].index);
+                j = (j + 1) & (cg->globalMapCap - 1);
+            }
+        }
+    }
+    if (strcmp(name, "input") == 0)
+        return opnd(IR_FUNC, IR_BUILTIN_INPUT);
+    if (strcmp(name, "output") == 0)
+        return opnd(IR_FUNC, IR_BUILTIN_OUTPUT);
+    return opnd(IR_NONE, 0);
 }
 
 /**
- * @brief Gera um novo label
- * @return Nome do label
+ * @brief Resolve um nome global para a recompilacao incremental
+ * @param arg Estado do gerador
+ * @param name Nome
+ * @return Operando do nome
  */
-static char* newLabel(void) {
-    char* labelName = (char*)malloc(10 * sizeof(char));
-    sprintf(labelName, "L%d", labelCount++);
-    return labelName;
+static IrInstr resolveName(void* arg, char* name) {
+    return lookupName((CodeGen*)arg, name);
+}
+
+/**
+ * @brief Converte o token de um operador na operacao do codigo intermediario
+ * @param op Token do operador
+ * @return Operacao correspondente
+ */
+static IrOp opFromToken(TokenType op) {
+    switch (op) {
+        case MAIS:       return IR_ADD;
+        case MENOS:      return IR_SUB;
+        case VEZES:      return IR_MUL;
+        case SOBRE:      return IR_DIV;
+        case MENOR:      return IR_LT;
+        case MENORIGUAL: return IR_LE;
+        case MAIOR:      return IR_GT;
+        case MAIORIGUAL: return IR_GE;
+        case IGUAL:      return IR_EQ;
+        case DIFERENTE:  return IR_NE;
+        default:         return IR_NOP;
+    }
+}
+
+/**
+ * @brief Verifica se uma condicao e uma comparacao (pode ser negada sem instrucao a mais)
+ * @param cond Expressao
+ * @return TRUE se e um OpK relacional
+ */
+static int isRelational(TreeNode* cond) {
+    IrOp op;
+    if (cond == NULL || cond->nodekind != ExpK || cond->kind.exp != OpK)
+        return FALSE;
+    op = opFromToken(cond->attr.op);
+    return op >= IR_LT && op <= IR_NE;
+}
+
+/**
+ * @brief Comparacao com o resultado invertido
+ * @param op IR_LT a IR_NE
+ * @return Comparacao que da o valor oposto
+ */
+static IrOp negateOp(IrOp op) {
+    switch (op) {
+        case IR_LT: return IR_GE;
+        case IR_LE: return IR_GT;
+        case IR_GT: return IR_LE;
+        case IR_GE: return IR_LT;
+        case IR_EQ: return IR_NE;
+        default:    return IR_EQ;
+    }
+}
+
+/**
+ * @brief Emite a contagem de um ponto (--profile-generate)
+ * @param cg Estado do gerador
+ * @param counter Contador (negativo = nada)
+ */
+static void emitCount(CodeGen* cg, int32_t counter) {
+    if (counter >= 0)
+        ir_emit(cg->unit, instr(IR_COUNT, opnd(IR_NONE, 0), opnd(IR_CONST, counter),
+                                opnd(IR_CONST, (int32_t)cg->sites.checksum)));
+}
+
+/**
+ * @brief Primeiro contador de um while ou if no --profile-generate
+ * @return Contador ou -1 sem instrumentacao
+ */
+static int32_t genCounter(CodeGen* cg, TreeNode* tree) {
+    return cg->profileGen ? pgo_counter(&cg->sites, tree) : -1;
+}
+
+/**
+ * @brief Contagens de um while (entradas, iteracoes) ou if (then, else) no perfil
+ * @param cg Estado do gerador
+ * @param tree No WhileK ou IfK
+ * @param first Primeiro contador
+ * @param second Segundo contador
+ * @return TRUE se a funcao tem contagens validas no perfil
+ */
+static int siteCounts(CodeGen* cg, TreeNode* tree, uint64_t* first, uint64_t* second) {
+    int32_t c;
+    if (cg->counts == NULL || (c = pgo_counter(&cg->sites, tree)) < 0)
+        return FALSE;
+    *first = cg->counts[c];
+    *second = cg->counts[c + 1];
+    return TRUE;
+}
+
+/**
+ * @brief Gera codigo para os argumentos e a chamada de uma funcao
+ * @param cg Estado do gerador
+ * @param tree No CallK
+ * @param useValue TRUE se o retorno e usado (cria temporario de destino)
+ * @return Temporario com o retorno ou operando vazio
+ */
+static IrInstr cGenCall(CodeGen* cg, TreeNode* tree, Boolean useValue) {
+    TreeNode* arg = tree->child[0];
+    IrInstr dest = opnd(IR_NONE, 0);
+    int argCount = 0;
+    while (arg != NULL) {
+        IrInstr argTemp = cGenExp(cg, arg);
+        ir_emit(cg->unit, instr(IR_PARAM, opnd(IR_NONE, 0), argTemp, opnd(IR_NONE, 0)));
+        argCount++;
+        arg = arg->sibling;
+    }
+    if (useValue)
+        dest = newTemp(cg);
+    ir_emit(cg->unit, instr(IR_CALL, dest, lookupName(cg, tree->attr.name), opnd(IR_CONST, argCount)));
+    return dest;
 }
 
 /**
  * @brief Gera codigo para expressoes
+ * @param cg Estado do gerador
  * @param tree No da arvore
- * @return Nome da variavel temporaria com o resultado
+ * @return Operando com o resultado
  */
-static char* cGenExp(TreeNode* tree) {
-    char* temp;
-    char* left;
-    char* right;
-    char* opStr;
+static IrInstr cGenExp(CodeGen* cg, TreeNode* tree) {
+    IrInstr temp;
+    IrInstr left;
+    IrInstr right;
     if (tree == NULL)
-        return NULL;
+        return opnd(IR_NONE, 0);
     switch (tree->kind.exp) {
         case ConstK: // constante numerica
-            temp = newTemp();
-            printf("%s = %d\n", temp, tree->attr.val);
+            temp = newTemp(cg);
+            ir_emit(cg->unit, instr(IR_COPY, temp, opnd(IR_CONST, tree->attr.val), opnd(IR_NONE, 0)));
             return temp;
         case IdK: // identificador
             if (tree->child[0] != NULL) {
-                char* index = cGenExp(tree->child[0]);
-                temp = newTemp();
-                printf("%s = %s[%s]\n", temp, tree->attr.name, index);
+                IrInstr index = cGenExp(cg, tree->child[0]);
+                temp = newTemp(cg);
+                ir_emit(cg->unit, instr(IR_LOAD, temp, lookupName(cg, tree->attr.name), index));
                 return temp;
             }
-            return tree->attr.name;
+            return lookupName(cg, tree->attr.name);
         case OpK: // operador
-            left = cGenExp(tree->child[0]);
-            right = cGenExp(tree->child[1]);
-            temp = newTemp();
-            switch (tree->attr.op) {
-                case MAIS:
-                    opStr = "+";
-                    break;
-                case MENOS:
-                    opStr = "-";
-                    break;
-                case VEZES:
-                    opStr = "*";
-                    break;
-                case SOBRE:
-                    opStr = "/";
-                    break;
-                case MENOR:
-                    opStr = "<";
-                    break;
-                case MENORIGUAL:
-                    opStr = "<=";
-                    break;
-                case MAIOR:
-                    opStr = ">";
-                    break;
-                case MAIORIGUAL:
-                    opStr = ">=";
-                    break;
-                case IGUAL:
-                    opStr = "==";
-                    break;
-                case DIFERENTE:
-                    opStr = "!=";
-                    break;
-                default:
-                    opStr = "?";
-                    break;
-            }
-            printf("%s = %s %s %s\n", temp, left, opStr, right);
+            left = cGenExp(cg, tree->child[0]);
+            right = cGenExp(cg, tree->child[1]);
+            temp = newTemp(cg);
+            ir_emit(cg->unit, instr(opFromToken(tree->attr.op), temp, left, right));
             return temp;
         case CallK: // chamada de funcao
-            {
-                TreeNode* arg = tree->child[0];
-                int argCount = 0;
-                while (arg != NULL) {
-                    char* argTemp = cGenExp(arg);
-                    printf("param %s\n", argTemp);
-                    argCount++;
-                    arg = arg->sibling;
-                }
-                temp = newTemp();
-                printf("%s = call %s, %d\n", temp, tree->attr.name, argCount);
-                return temp;
-            }
+            return cGenCall(cg, tree, TRUE);
         default:
-            return NULL;
+            return opnd(IR_NONE, 0);
     }
 }
 
+/**
+ * @brief Registra as declaracoes locais de um bloco
+ * @param cg Estado do gerador
+ * @param decl Lista de declaracoes (child[0] do CompoundK)
+ */
+static void cGenLocalDecls(CodeGen* cg, TreeNode* decl) {
+    while (decl != NULL) {
+        if (decl->kind.decl == ArrayK && decl->child[0] != NULL)
+            bindLocal(cg, decl->attr.name, decl->child[0]->attr.val);
+        else
+            bindLocal(cg, decl->attr.name, IR_SCALAR);
+        decl = decl->sibling;
+    }
+}
+
+/**
+ * @brief Gera um while quente com o teste no fim (--profile-use)
+ *
+ *     goto Lteste
+ *     Lcorpo: CORPO
+ *     Lteste: t = a !op b
+ *     if_false t goto Lcorpo
+ *
+ * Cada iteracao executa um desvio a menos que o while sem transformacao;
+ * a entrada paga um goto a mais.
+ *
+ * @param cg Estado do gerador
+ * @param tree No WhileK (condicao relacional)
+ */
+static void cGenRotated(CodeGen* cg, TreeNode* tree) {
+    IrInstr none = opnd(IR_NONE, 0);
+    IrInstr labelBody = newLabel(cg);
+    IrInstr labelTest = newLabel(cg);
+    IrInstr left, right, test;
+    ir_emit(cg->unit, instr(IR_GOTO, none, labelTest, none));
+    ir_emit(cg->unit, instr(IR_LABEL_DEF, none, labelBody, none));
+    cGenStmt(cg, tree->child[1]);
+    setLine(cg, tree->child[0]);
+    ir_emit(cg->unit, instr(IR_LABEL_DEF, none, labelTest, none));
+    left = cGenExp(cg, tree->child[0]->child[0]);
+    right = cGenExp(cg, tree->child[0]->child[1]);
+    test = newTemp(cg);
+    ir_emit(cg->unit, instr(negateOp(opFromToken(tree->child[0]->attr.op)), test, left, right));
+    ir_emit(cg->unit, instr(IR_IFFALSE, none, test, labelBody));
+    if (cg->optStats != NULL)
+        __atomic_add_fetch(&cg->optStats->pgoRotated, 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Gera um while sem transformacao
+ * @param cg Estado do gerador
+ * @param tree No WhileK
+ * @param remainder TRUE no laco de resto de um laco desenrolado (poucas iteracoes: nao roda)
+ */
+static void cGenWhile(CodeGen* cg, TreeNode* tree, int remainder) {
+    IrInstr none = opnd(IR_NONE, 0);
+    IrInstr labelStart;
+    IrInstr labelEnd;
+    IrInstr test;
+    int32_t counter = genCounter(cg, tree);
+    uint64_t entries, iters;
+    if (!remainder && isRelational(tree->child[0]) && siteCounts(cg, tree, &entries, &iters) &&
+        profile_hot(cg->profile, iters) && iters >= 2 * entries) {
+        cGenRotated(cg, tree);
+        return;
+    }
+    labelStart = newLabel(cg);
+    labelEnd = newLabel(cg);
+    emitCount(cg, counter);
+    ir_emit(cg->unit, instr(IR_LABEL_DEF, none, labelStart, none));
+    test = cGenExp(cg, tree->child[0]);
+    ir_emit(cg->unit, instr(IR_IFFALSE, none, test, labelEnd));
+    emitCount(cg, counter >= 0 ? counter + 1 : -1);
+    cGenStmt(cg, tree->child[1]);
+    setLine(cg, tree->child[0]);
+    ir_emit(cg->unit, instr(IR_GOTO, none, labelStart, none));
+    ir_emit(cg->unit, instr(IR_LABEL_DEF, none, labelEnd, none));
+}
+
+/**
+ * @brief Verifica um operando de um laco vetorizado
+ * @param cg Estado do gerador
+ * @param leaf a[i], escalar ou constante
+ * @param out Operando (o array, para a[i])
+ * @return TRUE se os nomes indexados sao arrays e os demais, escalares
+ */
+static int vectorOpnd(CodeGen* cg, TreeNode* leaf, IrInstr* out) {
+    int isArray;
+    if (leaf->kind.exp == ConstK) {
+        *out = opnd(IR_CONST, leaf->attr.val);
+        return TRUE;
+    }
+    *out = lookupName(cg, leaf->attr.name);
+    if (out->ka == IR_LOCAL)
+        isArray = cg->unit->slots[out->a].size != IR_SCALAR;
+    else if (out->ka == IR_GLOBAL)
+        isArray = cg->prog->globals[out->a].size > 0;
+    else
+        return FALSE;
+    return isArray == (leaf->child[0] != NULL);
+}
+
+/**
+ * @brief Operandos do contador e do limite de um laco com contador
+ *
+ * O contador precisa ser local (uma chamada nao o altera); o limite pode
+ * ser constante, local ou global, se o corpo nao chama funcoes.
+ *
+ * @param cg Estado do gerador
+ * @param loop Laco reconhecido
+ * @param counter Operando do contador
+ * @param limit Operando do limite
+ * @return TRUE se os dois sao escalares validos
+ */
+static int counterOpnds(CodeGen* cg, const UnrollLoop* loop, IrInstr* counter, IrInstr* limit) {
+    *counter = lookupName(cg, loop->counter->attr.name);
+    if (counter->ka != IR_LOCAL || cg->unit->slots[counter->a].size != IR_SCALAR)
+        return FALSE;
+    if (loop->limit->kind.exp == ConstK) {
+        *limit = opnd(IR_CONST, loop->limit->attr.val);
+        return TRUE;
+    }
+    *limit = lookupName(cg, loop->limit->attr.name);
+    if (limit->ka == IR_LOCAL)
+        return cg->unit->slots[limit->a].size == IR_SCALAR;
+    return limit->ka == IR_GLOBAL && !loop->hasCalls && cg->prog->globals[limit->a].size == IR_SCALAR;
+}
+
+/**
+ * @brief Gera um laco elemento a elemento como uma operacao vetorial (-O3)
+ *
+ * while (i < n) { c[i] = a[i] op b[i]; i = i + 1; } vira
+ *
+ *     vspan i, n
+ *     c[] = a[] op b[]
+ *     if (i < n) i = n
+ *
+ * e a maquina virtual processa os elementos em blocos SIMD.
+ *
+ * @param cg Estado do gerador
+ * @param tree No WhileK
+ * @return TRUE se gerou o laco; FALSE se ele nao se qualifica
+ */
+static int cGenVector(CodeGen* cg, TreeNode* tree) {
+    UnrollLoop loop;
+    UnrollVector vec;
+    IrInstr counter;
+    IrInstr limit;
+    IrInstr dest;
+    IrInstr src[2];
+    IrInstr test;
+    IrInstr labelDone;
+    IrInstr none = opnd(IR_NONE, 0);
+    IrOp op = IR_COPY;
+    if (!unroll_match(tree, cg->blockFirst, &loop) || !unroll_vector_match(&loop, &vec) ||
+        !counterOpnds(cg, &loop, &counter, &limit))
+        return FALSE;
+    src[1] = none;
+    if (!vectorOpnd(cg, vec.dest, &dest) || dest.ka == IR_CONST || !vectorOpnd(cg, vec.src[0], &src[0]) ||
+        (vec.src[1] != NULL && !vectorOpnd(cg, vec.src[1], &src[1])))
+        return FALSE;
+    if (vec.op != 0)
+        op = opFromToken(vec.op);
+    setLine(cg, vec.dest);
+    ir_emit(cg->unit, instr(IR_VSPAN, none, counter, limit));
+    ir_emit(cg->unit, instr(ir_vector_op(op), dest, src[0], src[1]));
+    setLine(cg, tree->child[0]);
+    labelDone = newLabel(cg);
+    test = newTemp(cg);
+    ir_emit(cg->unit, instr(IR_LT, test, counter, limit));
+    ir_emit(cg->unit, instr(IR_IFFALSE, none, test, labelDone));
+    ir_emit(cg->unit, instr(IR_COPY, counter, limit, none));
+    ir_emit(cg->unit, instr(IR_LABEL_DEF, none, labelDone, none));
+    if (cg->unrollCopy == 0)
+        opt_note_loop(cg->optStats, cg->prog->strs.data + cg->unit->rec.name, tree->child[0]->lineno,
+                      -1, (long)loop.trips, FALSE);
+    return TRUE;
+}
+
+/**
+ * @brief Gera uma copia do corpo de um laco desenrolado
+ *
+ * Os lacos internos sao desenrolados em todas as copias, mas so a
+ * primeira os registra no relatorio.
+ *
+ * @param cg Estado do gerador
+ * @param body Corpo
+ * @param k Numero da copia
+ */
+static void cGenCopy(CodeGen* cg, TreeNode* body, long long k) {
+    if (k > 0)
+        cg->unrollCopy++;
+    cGenStmt(cg, body);
+    if (k > 0)
+        cg->unrollCopy--;
+}
+
+/**
+ * @brief Gera um laco com contador desenrolado (unroll.h)
+ *
+ * Com poucas iteracoes conhecidas, o corpo (que termina no incremento) e
+ * repetido sem teste nenhum. Senao, cada teste de i < n - (fator - 1) e
+ * seguido de 'fator' copias do corpo, e o while original faz as iteracoes
+ * que sobram. O incremento fica em cada copia, entao os indices de array
+ * calculados a partir do contador continuam corretos; o SCCP e o peephole
+ * juntam as somas depois.
+ *
+ * @param cg Estado do gerador
+ * @param tree No WhileK
+ * @return TRUE se gerou o laco; FALSE se ele nao se qualifica
+ */
+static int cGenUnrolled(CodeGen* cg, TreeNode* tree) {
+    UnrollLoop loop;
+    IrInstr counter;
+    IrInstr limit;
+    IrInstr bound;
+    IrInstr test;
+    IrInstr labelMain;
+    IrInstr labelRest;
+    IrInstr none = opnd(IR_NONE, 0);
+    const char* func = cg->prog->strs.data + cg->unit->rec.name;
+    int line = tree->child[0]->lineno; // o WhileK recebe a linha do fim do corpo
+    int factor = cg->unroll;
+    int remainder = TRUE;
+    uint64_t entries, iters;
+    long long k;
+    if (!unroll_match(tree, cg->blockFirst, &loop) || !counterOpnds(cg, &loop, &counter, &limit))
+        return FALSE;
+    if (loop.trips >= 0 && loop.trips <= UNROLL_FULL_TRIPS && loop.trips * loop.nodes <= UNROLL_MAX_NODES) {
+        for (k = 0; k < loop.trips; k++)
+            cGenCopy(cg, loop.body, k);
+        if (cg->unrollCopy == 0)
+            opt_note_loop(cg->optStats, func, line, 0, (long)loop.trips, FALSE);
+        return TRUE;
+    }
+    if (siteCounts(cg, tree, &entries, &iters)) {
+        // o perfil diz quantas iteracoes o laco faz por entrada
+        if (iters == 0 || iters < entries * (uint64_t)factor) {
+            if (cg->unrollCopy == 0 && cg->optStats != NULL)
+                __atomic_add_fetch(&cg->optStats->pgoNoUnroll, 1, __ATOMIC_RELAXED);
+            return FALSE;
+        }
+        if (profile_hot(cg->profile, iters) && iters >= entries * PGO_HOT_TRIPS && factor * 2 <= UNROLL_MAX)
+            factor *= 2;
+    }
+    while (factor > 1 && factor * loop.nodes > UNROLL_MAX_NODES)
+        factor--;
+    if (factor < 2 || (loop.trips >= 0 && loop.trips < factor))
+        return FALSE;
+    if (limit.ka == IR_CONST && (long long)limit.a - (factor - 1) < INT32_MIN)
+        return FALSE;
+    // iteracoes conhecidas e multiplas do fator: o laco de resto nunca rodaria
+    if (loop.trips >= 0 && loop.trips % factor == 0)
+        remainder = FALSE;
+    labelMain = newLabel(cg);
+    labelRest = newLabel(cg);
+    if (limit.ka == IR_CONST) {
+        bound = opnd(IR_CONST, limit.a - (factor - 1));
+    } else {
+        // n - (fator - 1) estouraria perto de INT_MIN: so o laco de resto roda
+        test = newTemp(cg);
+        ir_emit(cg->unit, instr(IR_GT, test, limit, opnd(IR_CONST, INT32_MIN + factor - 2)));
+        ir_emit(cg->unit, instr(IR_IFFALSE, none, test, labelRest));
+        bound = newTemp(cg);
+        ir_emit(cg->unit, instr(IR_SUB, bound, limit, opnd(IR_CONST, factor - 1)));
+    }
+    ir_emit(cg->unit, instr(IR_LABEL_DEF, none, labelMain, none));
+    test = newTemp(cg);
+    ir_emit(cg->unit, instr(IR_LT, test, counter, bound));
+    ir_emit(cg->unit, instr(IR_IFFALSE, none, test, labelRest));
+    for (k = 0; k < factor; k++)
+        cGenCopy(cg, loop.body, k);
+    setLine(cg, tree->child[0]);
+    ir_emit(cg->unit, instr(IR_GOTO, none, labelMain, none));
+    ir_emit(cg->unit, instr(IR_LABEL_DEF, none, labelRest, none));
+    if (remainder) {
+        cg->unrollCopy++;
+        cGenWhile(cg, tree, TRUE);
+        cg->unrollCopy--;
+    }
+    if (cg->unrollCopy == 0)
+        opt_note_loop(cg->optStats, func, line, factor, (long)loop.trips, remainder);
+    return TRUE;
+}
+
+/**
+ * @brief Gera um if-else com o ramo frio fora do caminho (--profile-use)
+ *
+ * O ramo quente fica logo depois do if_false, sem o goto para o fim; o
+ * frio e gerado depois do fim da funcao (cGenColdBlocks) e volta com um
+ * goto. Se o ramo frio e o then, a comparacao e negada.
+ *
+ * @param cg Estado do gerador
+ * @param tree No IfK com else
+ * @return TRUE se gerou o if; FALSE se o if nao e quente ou nao tem um ramo frio
+ */
+static int cGenIfCold(CodeGen* cg, TreeNode* tree) {
+    IrInstr none = opnd(IR_NONE, 0);
+    IrInstr test;
+    ColdBlock* cold;
+    uint64_t taken, other;
+    int coldThen;
+    if (!siteCounts(cg, tree, &taken, &other) || !profile_hot(cg->profile, taken + other))
+        return FALSE;
+    if (other * PGO_COLD_RATIO <= taken)
+        coldThen = FALSE;
+    else if (taken * PGO_COLD_RATIO <= other && isRelational(tree->child[0]))
+        coldThen = TRUE;
+    else
+        return FALSE;
+    if (cg->ncold == cg->coldCap) {
+        cg->coldCap = cg->coldCap ? cg->coldCap * 2 : 8;
+        cg->cold = (ColdBlock*)realloc(cg->cold, cg->coldCap * sizeof(ColdBlock));
+    }
+    cold = &cg->cold[cg->ncold++];
+    cold->stmt = tree->child[coldThen ? 1 : 2];
+    cold->label = newLabel(cg);
+    cold->back = newLabel(cg);
+    cold->locals = (Binding*)malloc((cg->nlocals + 1) * sizeof(Binding));
+    if (cg->nlocals > 0)
+        memcpy(cold->locals, cg->locals, cg->nlocals * sizeof(Binding));
+    cold->nlocals = cg->nlocals;
+    cold->slotTop = cg->unit->slotTop;
+    cold->blockFirst = cg->blockFirst;
+    cold->unrollCopy = cg->unrollCopy;
+    cold->line = cg->unit->line;
+    if (coldThen) {
+        IrInstr left = cGenExp(cg, tree->child[0]->child[0]);
+        IrInstr right = cGenExp(cg, tree->child[0]->child[1]);
+        test = newTemp(cg);
+        ir_emit(cg->unit, instr(negateOp(opFromToken(tree->child[0]->attr.op)), test, left, right));
+    } else {
+        test = cGenExp(cg, tree->child[0]);
+    }
+    // 'cold' pode mudar de lugar: os ramos aninhados tambem acrescentam ramos frios
+    ir_emit(cg->unit, instr(IR_IFFALSE, none, test, cg->cold[cg->ncold - 1].label));
+    {
+        IrInstr back = cg->cold[cg->ncold - 1].back;
+        cGenStmt(cg, tree->child[coldThen ? 2 : 1]);
+        setLine(cg, tree->child[0]);
+        ir_emit(cg->unit, instr(IR_LABEL_DEF, none, back, none));
+    }
+    if (cg->optStats != NULL)
+        __atomic_add_fetch(&cg->optStats->pgoColdBlocks, 1, __ATOMIC_RELAXED);
+    return TRUE;
+}
+
+/**
+ * @brief Gera os ramos frios depois do fim da funcao
+ *
+ * Um return separa o fim da funcao dos ramos. Cada ramo e gerado com os
+ * nomes locais e as celulas ocupadas no ponto do if; os ramos frios
+ * dentro dele entram no fim da mesma lista.
+ *
+ * @param cg Estado do gerador
+ */
+static void cGenColdBlocks(CodeGen* cg) {
+    IrInstr none = opnd(IR_NONE, 0);
+    int i;
+    if (cg->ncold == 0)
+        return;
+    ir_emit(cg->unit, instr(IR_RETURN, none, none, none));
+    for (i = 0; i < cg->ncold; i++) {
+        ColdBlock cold = cg->cold[i];
+        if (cold.nlocals > cg->localCap) {
+            cg->localCap = cold.nlocals;
+            cg->locals = (Binding*)realloc(cg->locals, cg->localCap * sizeof(Binding));
+        }
+        if (cold.nlocals > 0)
+            memcpy(cg->locals, cold.locals, cold.nlocals * sizeof(Binding));
+        cg->nlocals = cold.nlocals;
+        cg->unit->slotTop = cold.slotTop;
+        cg->blockFirst = cold.blockFirst;
+        cg->unrollCopy = cold.unrollCopy;
+        cg->unit->line = cold.line;
+        ir_emit(cg->unit, instr(IR_LABEL_DEF, none, cold.label, none));
+        cGenStmt(cg, cold.stmt);
+        cg->unit->line = cold.line;
+        ir_emit(cg->unit, instr(IR_GOTO, none, cold.back, none));
+        free(cold.locals);
+    }
+    cg->ncold = 0;
+    cg->nlocals = 0;
+    cg->blockFirst = NULL;
+    cg->unrollCopy = 0;
+}
+
 /**
  * @brief Gera codigo para statements
+ * @param cg Estado do gerador
  * @param tree No da arvore
  */
-static void cGenStmt(TreeNode* tree) {
-    char* test;
-    char* labelFalse;
-    char* labelEnd;
-    char* labelStart;
-    char* value;
+static void cGenStmt(CodeGen* cg, TreeNode* tree) {
+    IrInstr test;
+    IrInstr labelFalse;
+    IrInstr labelEnd;
+    IrInstr value;
+    IrInstr none = opnd(IR_NONE, 0);
+    int32_t counter;
     if (tree == NULL)
         return;
+    // corpo de if/while sem chaves pode ser uma expressao (ex.: uma chamada)
+    if (tree->nodekind == ExpK) {
+        setLine(cg, tree);
+        cGenExpStmt(cg, tree);
+        return;
+    }
+    // o if e o while recebem a linha do fim do corpo: a condicao marca a linha deles
+    if (tree->kind.stmt == IfK || tree->kind.stmt == WhileK)
+        setLine(cg, tree->child[0]);
+    else if (tree->kind.stmt != CompoundK)
+        setLine(cg, tree);
     switch (tree->kind.stmt) {
         case AssignK: // atribuicao
             if (tree->child[0] != NULL && tree->child[1] != NULL) {
-                value = cGenExp(tree->child[1]);
+                value = cGenExp(cg, tree->child[1]);
                 if (tree->child[0]->child[0] != NULL) {
-                    char* index = cGenExp(tree->child[0]->child[0]);
-                    printf("%s[%s] = %s\n", tree->child[0]->attr.name, index, value);
+                    IrInstr index = cGenExp(cg, tree->child[0]->child[0]);
+                    ir_emit(cg->unit, instr(IR_STORE, lookupName(cg, tree->child[0]->attr.name), index, value));
                 } else {
-                    printf("%s = %s\n", tree->child[0]->attr.name, value);
+                    ir_emit(cg->unit, instr(IR_COPY, lookupName(cg, tree->child[0]->attr.name), value, none));
                 }
             }
             break;
         case IfK: // if/if-else
-            test = cGenExp(tree->child[0]);
-            labelFalse = newLabel();
-            labelEnd = newLabel();
-            printf("if_false %s goto %s\n", test, labelFalse);
-            cGenStmt(tree->child[1]);
+            if (tree->child[2] != NULL && cg->counts != NULL && cGenIfCold(cg, tree))
+                break;
+            counter = genCounter(cg, tree);
+            test = cGenExp(cg, tree->child[0]);
+            labelFalse = newLabel(cg);
+            labelEnd = newLabel(cg);
+            ir_emit(cg->unit, instr(IR_IFFALSE, none, test, labelFalse));
+            emitCount(cg, counter);
+            cGenStmt(cg, tree->child[1]);
+            setLine(cg, tree->child[0]);
             if (tree->child[2] != NULL) {
-                printf("goto %s\n", labelEnd);
-                printf("%s:\n", labelFalse);
-                cGenStmt(tree->child[2]);
-                printf("%s:\n", labelEnd);
+                ir_emit(cg->unit, instr(IR_GOTO, none, labelEnd, none));
+                ir_emit(cg->unit, instr(IR_LABEL_DEF, none, labelFalse, none));
+                emitCount(cg, counter >= 0 ? counter + 1 : -1);
+                cGenStmt(cg, tree->child[2]);
+                setLine(cg, tree->child[0]);
+                ir_emit(cg->unit, instr(IR_LABEL_DEF, none, labelEnd, none));
             } else {
-                printf("%s:\n", labelFalse);
+                ir_emit(cg->unit, instr(IR_LABEL_DEF, none, labelFalse, none));
             }
             break;
         case WhileK: // while loop
-            labelStart = newLabel();
-            labelEnd = newLabel();
-            printf("%s:\n", labelStart);
-            test = cGenExp(tree->child[0]);
-            printf("if_false %s goto %s\n", test, labelEnd);
-            cGenStmt(tree->child[1]);
-            printf("goto %s\n", labelStart);
-            printf("%s:\n", labelEnd);
+            // --profile-generate conta cada laco como esta no fonte
+            if ((cg->optimize < 3 || cg->profileGen || !cGenVector(cg, tree)) && (cg->unroll < 2 || !cGenUnrolled(cg, tree)))
+                cGenWhile(cg, tree, FALSE);
             break;
         case ReturnK: // return
             if (tree->child[0] != NULL) {
-                value = cGenExp(tree->child[0]);
-                printf("return %s\n", value);
+                value = cGenExp(cg, tree->child[0]);
+                ir_emit(cg->unit, instr(IR_RETURN, none, value, none));
             } else {
-                printf("return\n");
+                ir_emit(cg->unit, instr(IR_RETURN, none, none, none));
             }
             break;
         case CompoundK: // bloco composto { ... }
-            if (tree->child[1] != NULL) {
-                TreeNode* stmt = tree->child[1];
-                while (stmt != NULL) {
-                    if (stmt->nodekind == StmtK) {
-                        cGenStmt(stmt);
-                    } else if (stmt->nodekind == ExpK) {
-                        cGenExpStmt(stmt);
+            {
+                int mark = cg->nlocals;
+                uint32_t top = cg->unit->slotTop;
+                cGenLocalDecls(cg, tree->child[0]);
+                if (tree->child[1] != NULL) {
+                    TreeNode* stmt = tree->child[1];
+                    TreeNode* outer = cg->blockFirst;
+                    cg->blockFirst = tree->child[1];
+                    while (stmt != NULL) {
+                        if (stmt->nodekind == StmtK) {
+                            cGenStmt(cg, stmt);
+                        } else if (stmt->nodekind == ExpK) {
+                            cGenExpStmt(cg, stmt);
+                        }
+                        stmt = stmt->sibling;
                     }
-                    stmt = stmt->sibling;
+                    cg->blockFirst = outer;
                 }
+                // as variaveis do bloco morrem aqui: o proximo bloco reusa as celulas
+                cg->nlocals = mark;
+                cg->unit->slotTop = top;
             }
             break;
         default:
@@ -195,33 +869,169 @@ static void cGenStmt(TreeNode* tree) {
     }
 }
 
+/**
+ * @brief Gera parametros e corpo de uma funcao na unidade atual
+ * @param cg Estado do gerador
+ * @param tree No FunK
+ */
+static void cGenFun(CodeGen* cg, TreeNode* tree) {
+    memset(&cg->sites, 0, sizeof(cg->sites));
+    cg->counts = NULL;
+    if ((cg->profileGen || cg->profile != NULL) && pgo_sites(&cg->sites, tree) != 0)
+        memset(&cg->sites, 0, sizeof(cg->sites));
+    if (cg->profile != NULL && cg->sites.ncounts > 0) {
+        const ProfFunc* f = profile_func(cg->profile, tree->attr.name);
+        // o cmvm so conhece os contadores que aparecem no codigo (um if sem else
+        // nao tem o segundo): os que faltam no fim ficam zerados
+        if (f != NULL && f->checksum == cg->sites.checksum && f->ncounts <= cg->sites.ncounts) {
+            cg->counts = (uint64_t*)calloc(cg->sites.ncounts, sizeof(uint64_t));
+            if (cg->counts != NULL)
+                memcpy(cg->counts, f->counts, f->ncounts * sizeof(uint64_t));
+        } else if (f != NULL) {
+            fprintf(stderr, "Aviso: perfil da funcao '%s' desatualizado (ignorado)\n", tree->attr.name);
+            if (cg->optStats != NULL)
+                __atomic_add_fetch(&cg->optStats->pgoStale, 1, __ATOMIC_RELAXED);
+        }
+    }
+    if (tree->child[0] != NULL) {
+        TreeNode* param = tree->child[0];
+        while (param != NULL) {
+            bindLocal(cg, param->attr.name, param->type == IntegerArray ? IR_ARRAYREF : IR_SCALAR);
+            cg->unit->rec.nparams++;
+            param = param->sibling;
+        }
+    }
+    setLine(cg, tree);
+    if (cg->profileGen && cg->sites.ncounts > 0)
+        emitCount(cg, 0);
+    if (tree->child[1] != NULL) {
+        cGenStmt(cg, tree->child[1]);
+    }
+    // a funcao recebe a linha do fim do corpo, onde fica o return implicito
+    setLine(cg, tree);
+    cGenColdBlocks(cg);
+    cg->unit->line = 0;
+    pgo_sites_free(&cg->sites);
+    free(cg->counts);
+    cg->counts = NULL;
+}
+
+/**
+ * @brief Otimiza o codigo recem gerado de uma funcao conforme o nivel
+ *
+ * -O2 passa pela SSA (propagacao condicional de constantes) antes do
+ * peephole, que limpa as copias e os labels que ela deixa para tras. Por
+ * ultimo, os temporarios que nao vivem ao mesmo tempo passam a dividir as
+ * celulas do registro de ativacao; com cg->packLater isso fica para
+ * packUnits, depois da expansao de chamadas e da avaliacao das chamadas
+ * puras, que repassam o SCCP e o peephole e precisam de um temporario por
+ * valor.
+ *
+ * @param cg Estado do gerador (cg->unit)
+ */
+static void optimizeFun(CodeGen* cg) {
+    if (cg->optimize >= 2)
+        ssa_sccp(cg->unit, cg->optStats);
+    if (cg->optimize >= 1) {
+        opt_peephole(cg->unit, cg->optStats);
+        if (!cg->packLater)
+            frame_pack_temps(cg->unit, cg->optStats);
+    }
+}
+
+/**
+ * @brief Gera (ou reaproveita do cache) o codigo de uma funcao
+ *
+ * Roda em qualquer thread: o estado compartilhado so e lido, e cada
+ * funcao tem os seus proprios temporarios, labels e pilha de locais.
+ *
+ * @param arg FunJob
+ */
+static void cGenFunJob(void* arg) {
+    FunJob* job = (FunJob*)arg;
+    CodeGen cg = *job->cg;
+    cg.unit = &cg.prog->units[job->unit];
+    cg.locals = NULL;
+    cg.nlocals = 0;
+    cg.localCap = 0;
+    cg.cold = NULL;
+    cg.ncold = 0;
+    cg.coldCap = 0;
+    if (cg.incr != NULL) {
+        // o blob guarda o codigo ja otimizado (o nivel faz parte da impressao digital)
+        if (!incr_load(cg.incr, &job->key, job->tree->lineno, cg.prog, cg.unit, resolveName, &cg)) {
+            cGenFun(&cg, job->tree);
+            optimizeFun(&cg);
+            incr_save(cg.incr, &job->key, job->tree->lineno, cg.prog, cg.unit);
+        }
+    } else {
+        cGenFun(&cg, job->tree);
+        optimizeFun(&cg);
+    }
+    free(cg.locals);
+    free(cg.cold);
+}
+
+/**
+ * @brief Insere na tabela de strings os nomes locais de uma funcao
+ *
+ * Segue a mesma ordem de bindLocal (parametros e depois os blocos em
+ * pre-ordem), de forma que a tabela fica igual a da geracao serial e as
+ * threads so precisam consulta-la.
+ *
+ * @param cg Estado do gerador
+ * @param tree Subarvore
+ */
+static void internLocals(CodeGen* cg, TreeNode* tree) {
+    int i;
+    while (tree != NULL) {
+        if (tree->nodekind == DeclK && tree->attr.name != NULL)
+            ir_intern(&cg->prog->strs, tree->attr.name);
+        for (i = 0; i < MAXCHILDREN; i++)
+            internLocals(cg, tree->child[i]);
+        tree = tree->sibling;
+    }
+}
+
 /**
  * @brief Gera codigo para declaracoes
+ *
+ * Funcoes so sao registradas aqui; o corpo e gerado depois por cGenFunJob.
+ *
+ * @param cg Estado do gerador
  * @param tree No da arvore
+ * @param jobs Funcoes a gerar (atualizado)
+ * @param njobs Numero de funcoes (atualizado)
+ * @param jobCap Capacidade de 'jobs' (atualizado)
  */
-static void cGenDecl(TreeNode* tree) {
+static void cGenDecl(CodeGen* cg, TreeNode* tree, FunJob** jobs, int* njobs, int* jobCap) {
+    FunJob* job;
     if (tree == NULL)
         return;
     switch (tree->kind.decl) {
         case FunK: // funcao
-            printf("\nfunc %s:\n", tree->attr.name);
-            if (tree->child[0] != NULL) {
-                TreeNode* param = tree->child[0];
-                while (param != NULL) {
-                    printf("param %s\n", param->attr.name);
-                    param = param->sibling;
-                }
-            }
-            if (tree->child[1] != NULL) {
-                cGenStmt(tree->child[1]);
+            if (*njobs == *jobCap) {
+                *jobCap = *jobCap ? *jobCap * 2 : 16;
+                *jobs = (FunJob*)realloc(*jobs, *jobCap * sizeof(FunJob));
             }
-            printf("endfunc\n");
+            job = &(*jobs)[(*njobs)++];
+            job->cg = cg;
+            job->tree = tree;
+            job->unit = cg->prog->nunits;
+            bindGlobal(cg, tree->attr.name, IR_FUNC, (int32_t)cg->prog->nunits);
+            ir_add_unit(cg->prog, tree->attr.name);
+            internLocals(cg, tree->child[0]);
+            internLocals(cg, tree->child[1]);
+            if (cg->incr != NULL)
+                incr_fingerprint(cg->incr, tree, &job->key);
             break;
         case VarK: // variavel
+            bindGlobal(cg, tree->attr.name, IR_GLOBAL, ir_add_global(cg->prog, tree->attr.name, IR_SCALAR));
             break;
         case ArrayK: // array
             if (tree->child[0] != NULL) {
-                printf("array %s[%d]\n", tree->attr.name, tree->child[0]->attr.val);
+                bindGlobal(cg, tree->attr.name, IR_GLOBAL,
+                           ir_add_global(cg->prog, tree->attr.name, tree->child[0]->attr.val));
             }
             break;
         default:
@@ -231,53 +1041,208 @@ static void cGenDecl(TreeNode* tree) {
 
 /**
  * @brief Gera codigo para expressoes usadas como statements
+ * @param cg Estado do gerador
  * @param tree No da arvore
  */
-static void cGenExpStmt(TreeNode* tree) {
+static void cGenExpStmt(CodeGen* cg, TreeNode* tree) {
     if (tree == NULL)
         return;
-    if (tree->kind.exp == CallK) {
-        TreeNode* arg = tree->child[0];
-        int argCount = 0;
-        while (arg != NULL) {
-            char* argTemp = cGenExp(arg);
-            printf("param %s\n", argTemp);
-            argCount++;
-            arg = arg->sibling;
-        }
-        printf("call %s, %d\n", tree->attr.name, argCount);
-    }
+    if (tree->kind.exp == CallK)
+        cGenCall(cg, tree, FALSE);
 }
 
 /**
  * @brief Percorre a AST gerando codigo intermediario
+ *
+ * Primeiro registra, na ordem do fonte, todas as globais e funcoes; depois
+ * gera o corpo de cada funcao, em paralelo se houver um pool. Como a
+ * numeracao de temporarios e labels e local a funcao e cada uma escreve
+ * apenas na sua unidade, o resultado nao depende da ordem de execucao.
+ *
+ * @param cg Estado do gerador
  * @param tree No da arvore
+ * @param pool Pool de threads (NULL gera em serie)
  */
-static void cGenTree(TreeNode* tree) {
-    if (tree != NULL) {
-        switch (tree->nodekind) {
-            case StmtK: // statement
-                cGenStmt(tree);
-                break;
-            case ExpK: // expressao
-                cGenExpStmt(tree);
-                break;
-            case DeclK: // declaracao
-                cGenDecl(tree);
-                break;
-            default:
-                break;
-        }
-        cGenTree(tree->sibling); // processa irmaos
+static void cGenTree(CodeGen* cg, TreeNode* tree, Pool* pool) {
+    FunJob* jobs = NULL;
+    int njobs = 0, jobCap = 0, i;
+    PoolGroup group;
+    while (tree != NULL) {
+        if (tree->nodekind == DeclK)
+            cGenDecl(cg, tree, &jobs, &njobs, &jobCap);
+        tree = tree->sibling; // processa irmaos
+    }
+    memset(&group, 0, sizeof(group));
+    for (i = 0; i < njobs; i++) {
+        if (pool == NULL || njobs < 2 || pool_submit(pool, &group, cGenFunJob, &jobs[i]) != 0)
+            cGenFunJob(&jobs[i]);
     }
+    if (pool != NULL)
+        pool_wait(pool, &group);
+    free(jobs);
+}
+
+// Funcao cujos temporarios sao juntados no fim de buildIR
+typedef struct {
+    IrUnit* unit;
+    OptStats* stats;
+} PackJob;
+
+/**
+ * @brief Junta os temporarios de uma funcao (tarefa do pool)
+ * @param arg PackJob
+ */
+static void packJob(void* arg) {
+    PackJob* job = (PackJob*)arg;
+    frame_pack_temps(job->unit, job->stats);
+}
+
+/**
+ * @brief Junta os temporarios de todas as funcoes, em paralelo se houver um pool
+ * @param prog Programa
+ * @param stats Contadores (NULL = nao conta)
+ * @param pool Pool de threads (NULL junta em serie)
+ */
+static void packUnits(IrProgram* prog, OptStats* stats, Pool* pool) {
+    PackJob* jobs = NULL;
+    PoolGroup group;
+    uint32_t i;
+    if (pool != NULL && prog->nunits >= 2)
+        jobs = (PackJob*)malloc(prog->nunits * sizeof(PackJob));
+    if (jobs == NULL) {
+        for (i = 0; i < prog->nunits; i++)
+            frame_pack_temps(&prog->units[i], stats);
+        return;
+    }
+    memset(&group, 0, sizeof(group));
+    for (i = 0; i < prog->nunits; i++) {
+        jobs[i].unit = &prog->units[i];
+        jobs[i].stats = stats;
+        if (pool_submit(pool, &group, packJob, &jobs[i]) != 0)
+            packJob(&jobs[i]);
+    }
+    pool_wait(pool, &group);
+    free(jobs);
+}
+
+/**
+ * @brief Traduz a AST para o codigo intermediario em memoria
+ * @param ctx Contexto da compilacao (ctx->incr ativa a reutilizacao de funcoes,
+ *            ctx->pool gera as funcoes em paralelo)
+ * @param syntaxTree Raiz da arvore sintatica
+ * @param program Programa de saida (inicializado com ir_init)
+ */
+void buildIR(CompilerContext* ctx, TreeNode* syntaxTree, IrProgram* program) {
+    CodeGen cg;
+    memset(&cg, 0, sizeof(cg));
+    cg.prog = program;
+    cg.incr = ctx->incr;
+    cg.optimize = ctx->optimize;
+    cg.optStats = ctx->optStats;
+    cg.unroll = ctx->profileGen ? 1 : ctx->unroll;
+    cg.profileGen = ctx->profileGen;
+    cg.profile = ctx->profile;
+    cg.packLater = cg.optimize >= 2;
+    if (cg.incr != NULL) {
+        cg.incr->optimize = ctx->optimize;
+        cg.incr->unroll = cg.unroll;
+        cg.incr->profileGen = ctx->profileGen;
+        cg.incr->profile = ctx->profile != NULL ? ctx->profile->hash : 0;
+        incr_begin(cg.incr, syntaxTree);
+    }
+    cGenTree(&cg, syntaxTree, ctx->pool);
+    // depois do cache incremental: o resultado depende do corpo das chamadas
+    if (cg.optimize >= 2 && cg.profile != NULL)
+        pgo_inline(program, cg.profile, cg.optStats);
+    if (cg.optimize >= 2) {
+        fold_pure_calls(program, cg.optStats);
+        packUnits(program, cg.optStats, ctx->pool);
+    }
+    free(cg.globalMap);
+    free(cg.locals);
 }
 
 /**
  * @brief Gera codigo intermediario de tres enderecos a partir da AST
+ * @param ctx Contexto da compilacao
  * @param syntaxTree Raiz da arvore sintatica
+ * @param program Programa de saida (inicializado com ir_init)
+ */
+void codeGen(CompilerContext* ctx, TreeNode* syntaxTree, IrProgram* program) {
+    buildIR(ctx, syntaxTree, program);
+    printIR(ctx, program);
+}
+
+/**
+ * @brief Imprime o codigo intermediario de um programa na listagem
+ * @param ctx Contexto da compilacao
+ * @param program Programa gerado
+ */
+void printIR(CompilerContext* ctx, IrProgram* program) {
+    IrView view;
+    ir_flatten(program, &view);
+    fprintf(ctx->listing, "\n*** CODIGO INTERMEDIARIO (3 ENDERECOS) ***\n\n");
+    ir_print(&view, ctx->listing);
+    fprintf(ctx->listing, "\n******************************************\n\n");
+    ir_view_free(&view);
+}
+
+/**
+ * @brief Inicia a geracao declaracao por declaracao (modo streaming)
+ * @param ctx Contexto da compilacao (ctx->incr ativa a reutilizacao de funcoes)
+ * @param program Programa de saida (inicializado com ir_init)
+ * @return Estado do gerador (liberar com codeGenEnd)
+ */
+CodeGen* codeGenBegin(CompilerContext* ctx, IrProgram* program) {
+    CodeGen* cg = (CodeGen*)calloc(1, sizeof(CodeGen));
+    if (cg == NULL)
+        return NULL;
+    cg->prog = program;
+    cg->incr = ctx->incr;
+    cg->optimize = ctx->optimize;
+    cg->optStats = ctx->optStats;
+    cg->unroll = ctx->profileGen ? 1 : ctx->unroll;
+    cg->profileGen = ctx->profileGen;
+    cg->profile = ctx->profile;
+    if (cg->incr != NULL) {
+        cg->incr->optimize = ctx->optimize;
+        cg->incr->unroll = cg->unroll;
+        cg->incr->profileGen = ctx->profileGen;
+        cg->incr->profile = ctx->profile != NULL ? ctx->profile->hash : 0;
+    }
+    return cg;
+}
+
+/**
+ * @brief Gera o codigo de uma declaracao global assim que ela e analisada
+ *
+ * As funcoes sao geradas na hora, em serie, para que a AST do corpo possa
+ * ser liberada logo em seguida.
+ *
+ * @param cg Estado do gerador
+ * @param decl Declaracao global (sem irmaos)
  */
-void codeGen(TreeNode* syntaxTree) {
-    printf("\n*** CODIGO INTERMEDIARIO (3 ENDERECOS) ***\n\n");
-    cGenTree(syntaxTree);
-    printf("\n******************************************\n\n");
+void codeGenDecl(CodeGen* cg, TreeNode* decl) {
+    FunJob* jobs = NULL;
+    int njobs = 0, jobCap = 0, i;
+    if (decl->nodekind != DeclK)
+        return;
+    if (cg->incr != NULL)
+        incr_declare(cg->incr, decl);
+    cGenDecl(cg, decl, &jobs, &njobs, &jobCap);
+    for (i = 0; i < njobs; i++)
+        cGenFunJob(&jobs[i]);
+    free(jobs);
+}
+
+/**
+ * @brief Termina a geracao declaracao por declaracao
+ * @param cg Estado do gerador
+ */
+void codeGenEnd(CodeGen* cg) {
+    if (cg == NULL)
+        return;
+    free(cg->globalMap);
+    free(cg->locals);
+    free(cg);
 }
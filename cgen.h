@@ -7,11 +7,57 @@
 #define _CGEN_H_
 
 #include "globals.h"
+#include "ir.h"
+#include "incr.h"
 
 /**
- * @brief Gera codigo intermediario de tres enderecos a partir da AST
+ * @brief Estado do gerador (modo streaming)
+ */
+typedef struct CodeGen CodeGen;
+
+/**
+ * @brief Traduz a AST para o codigo intermediario em memoria
+ * @param ctx Contexto da compilacao (ctx->incr ativa a reutilizacao de funcoes,
+ *            ctx->pool gera as funcoes em paralelo)
+ * @param syntaxTree Raiz da arvore sintatica
+ * @param program Programa de saida (inicializado com ir_init)
+ */
+void buildIR(CompilerContext* ctx, TreeNode* syntaxTree, IrProgram* program);
+
+/**
+ * @brief Gera e imprime o codigo intermediario de tres enderecos a partir da AST
+ * @param ctx Contexto da compilacao
  * @param syntaxTree Raiz da arvore sintatica
+ * @param program Programa de saida (inicializado com ir_init)
+ */
+void codeGen(CompilerContext* ctx, TreeNode* syntaxTree, IrProgram* program);
+
+/**
+ * @brief Imprime o codigo intermediario de um programa na listagem
+ * @param ctx Contexto da compilacao
+ * @param program Programa gerado
+ */
+void printIR(CompilerContext* ctx, IrProgram* program);
+
+/**
+ * @brief Inicia a geracao declaracao por declaracao (modo streaming)
+ * @param ctx Contexto da compilacao (ctx->incr ativa a reutilizacao de funcoes)
+ * @param program Programa de saida (inicializado com ir_init)
+ * @return Estado do gerador (liberar com codeGenEnd)
+ */
+CodeGen* codeGenBegin(CompilerContext* ctx, IrProgram* program);
+
+/**
+ * @brief Gera o codigo de uma declaracao global assim que ela e analisada
+ * @param cg Estado do gerador
+ * @param decl Declaracao global (sem irmaos)
+ */
+void codeGenDecl(CodeGen* cg, TreeNode* decl);
+
+/**
+ * @brief Termina a geracao declaracao por declaracao
+ * @param cg Estado do gerador
  */
-void codeGen(TreeNode* syntaxTree);
+void codeGenEnd(CodeGen* cg);
 
 #endif
@@ -0,0 +1,384 @@
+/**
+ * @file cmgen.c
+ * @brief Gerador de programas C- sinteticos para medidas de desempenho
+ *
+ * Gera em stdout um programa C- valido (sem erros lexicos, sintaticos ou
+ * semanticos) com aproximadamente o numero de linhas pedido e com uma das
+ * formas abaixo. Todas as funcoes tem a assinatura int f(int a, int b) e
+ * chamam no maximo uma funcao anterior sorteada, de forma que o programa
+ * tambem termina rapido quando executado no cmvm.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+// Tamanho maximo de um nome gerado
+#define GEN_NAME 32
+
+/**
+ * @brief Formas de programa
+ */
+typedef enum {
+    ShapeFuncs,      // muitas funcoes pequenas
+    ShapeNested,     // blocos e comandos profundamente aninhados
+    ShapeBlocks,     // funcoes com blocos muito longos
+    ShapeGlobals,    // muitas variaveis globais
+    ShapeArrays,     // vetores grandes, globais e locais
+    ShapeRecursion,  // funcoes recursivas
+    ShapeMixed       // todas as formas anteriores, alternadas
+} Shape;
+
+static const char* shapeNames[] = {
+    "funcoes", "aninhado", "blocos", "globais", "arrays", "recursao", "misto"
+};
+
+/**
+ * @brief Estado do gerador
+ */
+typedef struct {
+    FILE* out;
+    long lines;              // linhas ja escritas
+    unsigned seed;           // estado do gerador pseudoaleatorio
+    long nfuncs;             // funcoes int f(int a, int b) ja definidas
+    long nglobals;           // variaveis globais escalares
+    long narrays;            // vetores globais
+    int depth;               // profundidade do aninhamento (ShapeNested)
+    int blockLen;            // comandos por bloco (ShapeBlocks)
+    int arraySize;           // tamanho dos vetores (ShapeArrays)
+} Gen;
+
+/**
+ * @brief Proximo numero pseudoaleatorio (xorshift)
+ * @param g Gerador
+ * @param n Limite
+ * @return Numero em [0, n)
+ */
+static long rnd(Gen* g, long n) {
+    g->seed ^= g->seed << 13;
+    g->seed ^= g->seed >> 17;
+    g->seed ^= g->seed << 5;
+    return n > 0 ? (long)(g->seed % (unsigned long)n) : 0;
+}
+
+/**
+ * @brief Monta um nome so de letras (identificadores de C- nao tem digitos)
+ * @param buf Destino (GEN_NAME bytes)
+ * @param prefix Prefixo (duas letras, distinto das palavras reservadas)
+ * @param i Numero codificado em letras
+ * @return buf
+ */
+static char* name(char* buf, const char* prefix, long i) {
+    size_t n = strlen(prefix);
+    memcpy(buf, prefix, n);
+    do {
+        buf[n++] = (char)('a' + i % 26);
+        i /= 26;
+    } while (i > 0 && n < GEN_NAME - 1);
+    buf[n] = '\0';
+    return buf;
+}
+
+/**
+ * @brief Escreve uma linha indentada
+ * @param g Gerador
+ * @param indent Nivel de indentacao
+ * @param fmt Formato (printf)
+ */
+static void line(Gen* g, int indent, const char* fmt, ...) {
+    va_list ap;
+    fprintf(g->out, "%*s", indent * 4, "");
+    va_start(ap, fmt);
+    vfprintf(g->out, fmt, ap);
+    va_end(ap);
+    fputc('\n', g->out);
+    g->lines++;
+}
+
+/**
+ * @brief Cabecalho de uma nova funcao int f(int a, int b)
+ * @param g Gerador
+ * @param buf Nome da funcao (GEN_NAME bytes)
+ * @return Nome da funcao
+ */
+static char* beginFunc(Gen* g, char* buf) {
+    name(buf, "fn", g->nfuncs);
+    line(g, 0, "int %s(int a, int b) {", buf);
+    return buf;
+}
+
+/**
+ * @brief Fecha a funcao atual e a registra para chamadas futuras
+ * @param g Gerador
+ */
+static void endFunc(Gen* g) {
+    line(g, 0, "}");
+    g->nfuncs++;
+}
+
+/**
+ * @brief Atribui a 'x' a chamada de uma funcao anterior sorteada (se houver)
+ * @param g Gerador
+ * @param indent Nivel de indentacao
+ */
+static void callEarlier(Gen* g, int indent) {
+    char f[GEN_NAME];
+    if (g->nfuncs == 0)
+        return;
+    // um sorteio uniforme entre as anteriores deixa a cadeia de chamadas
+    // com profundidade logaritmica
+    line(g, indent, "x = x + %s(a / 2, b + %ld);", name(f, "fn", rnd(g, g->nfuncs)), rnd(g, 10));
+}
+
+/**
+ * @brief Funcao pequena com laco limitado (ShapeFuncs)
+ * @param g Gerador
+ */
+static void emitSmall(Gen* g) {
+    char f[GEN_NAME];
+    beginFunc(g, f);
+    line(g, 1, "int x; int y;");
+    line(g, 1, "x = a + b * %ld;", rnd(g, 100));
+    line(g, 1, "y = 0;");
+    line(g, 1, "while (y < 4) { x = x + y * %ld; y = y + 1; }", 1 + rnd(g, 9));
+    callEarlier(g, 1);
+    line(g, 1, "if (x > %ld) { return x - b; } else { return x + a; }", rnd(g, 1000));
+    endFunc(g);
+}
+
+/**
+ * @brief Um nivel de aninhamento, alternando if/else, while e blocos
+ * @param g Gerador
+ * @param level Nivel atual
+ * @param indent Nivel de indentacao
+ */
+static void emitNest(Gen* g, int level, int indent) {
+    char v[GEN_NAME];
+    if (level == g->depth) {
+        line(g, indent, "x = x + a * %ld - b;", rnd(g, 10));
+        return;
+    }
+    name(v, "lc", level);
+    switch (level % 3) {
+        case 0:
+            line(g, indent, "if (x < %ld) {", 1000 + rnd(g, 1000));
+            emitNest(g, level + 1, indent + 1);
+            line(g, indent, "} else {");
+            line(g, indent + 1, "x = x - %ld;", rnd(g, 10));
+            line(g, indent, "}");
+            break;
+        case 1:
+            // executa uma unica vez: o custo de execucao nao cresce com a profundidade
+            line(g, indent, "y = 0;");
+            line(g, indent, "while (y < 1) {");
+            line(g, indent + 1, "y = y + 1;");
+            emitNest(g, level + 1, indent + 1);
+            line(g, indent, "}");
+            break;
+        default:
+            line(g, indent, "{");
+            line(g, indent + 1, "int %s;", v);
+            line(g, indent + 1, "%s = x * 2;", v);
+            emitNest(g, level + 1, indent + 1);
+            line(g, indent + 1, "x = x + %s;", v);
+            line(g, indent, "}");
+            break;
+    }
+}
+
+/**
+ * @brief Funcao com aninhamento profundo (ShapeNested)
+ * @param g Gerador
+ */
+static void emitNested(Gen* g) {
+    char f[GEN_NAME];
+    beginFunc(g, f);
+    line(g, 1, "int x; int y;");
+    line(g, 1, "x = a;");
+    emitNest(g, 0, 1);
+    callEarlier(g, 1);
+    line(g, 1, "return x;");
+    endFunc(g);
+}
+
+/**
+ * @brief Funcao com um bloco longo de expressoes (ShapeBlocks)
+ * @param g Gerador
+ */
+static void emitBlock(Gen* g) {
+    char f[GEN_NAME];
+    int i;
+    beginFunc(g, f);
+    line(g, 1, "int x; int y; int z;");
+    line(g, 1, "x = a; y = b; z = 0;");
+    for (i = 0; i < g->blockLen; i++) {
+        switch (rnd(g, 4)) {
+            case 0:
+                line(g, 1, "x = x + y * %ld - z;", rnd(g, 100));
+                break;
+            case 1:
+                line(g, 1, "y = (x + z) / %ld;", 1 + rnd(g, 9));
+                break;
+            case 2:
+                line(g, 1, "z = x - y + %ld * (a - b);", rnd(g, 100));
+                break;
+            default:
+                line(g, 1, "if (x > y) z = z + 1; else z = z - 1;");
+                break;
+        }
+    }
+    callEarlier(g, 1);
+    line(g, 1, "return x + y + z;");
+    endFunc(g);
+}
+
+/**
+ * @brief Lote de variaveis globais e uma funcao que as usa (ShapeGlobals)
+ * @param g Gerador
+ */
+static void emitGlobals(Gen* g) {
+    char f[GEN_NAME], v[GEN_NAME], w[GEN_NAME];
+    int i;
+    for (i = 0; i < 32; i++)
+        line(g, 0, "int %s;", name(v, "gv", g->nglobals++));
+    beginFunc(g, f);
+    line(g, 1, "int x;");
+    line(g, 1, "x = a;");
+    for (i = 0; i < 8; i++) {
+        name(v, "gv", rnd(g, g->nglobals));
+        name(w, "gv", rnd(g, g->nglobals));
+        line(g, 1, "%s = %s + x * %ld;", v, w, rnd(g, 10));
+        line(g, 1, "x = x + %s;", v);
+    }
+    callEarlier(g, 1);
+    line(g, 1, "return x + b;");
+    endFunc(g);
+}
+
+/**
+ * @brief Vetor global grande e uma funcao com vetor local (ShapeArrays)
+ * @param g Gerador
+ */
+static void emitArrays(Gen* g) {
+    char f[GEN_NAME], v[GEN_NAME];
+    name(v, "ar", g->narrays++);
+    line(g, 0, "int %s[%d];", v, g->arraySize);
+    beginFunc(g, f);
+    line(g, 1, "int x; int i; int loc[%d];", g->arraySize);
+    line(g, 1, "x = 0; i = 0;");
+    // percorre so o inicio dos vetores: o tamanho pesa na memoria, nao no tempo
+    line(g, 1, "while (i < 64) {");
+    line(g, 2, "%s[i] = a + i * %ld;", v, 1 + rnd(g, 9));
+    line(g, 2, "loc[i] = %s[i] - b;", v);
+    line(g, 2, "x = x + loc[i];");
+    line(g, 2, "i = i + 1;");
+    line(g, 1, "}");
+    callEarlier(g, 1);
+    line(g, 1, "return x;");
+    endFunc(g);
+}
+
+/**
+ * @brief Funcao recursiva com profundidade limitada (ShapeRecursion)
+ * @param g Gerador
+ */
+static void emitRecursive(Gen* g) {
+    char f[GEN_NAME];
+    beginFunc(g, f);
+    line(g, 1, "if (a > 6) a = 6;");
+    line(g, 1, "if (a < 1) { return b + %ld; }", rnd(g, 10));
+    line(g, 1, "return %s(a - 1, b + 1) + %s(a - 2, b * %ld);", f, f, 1 + rnd(g, 3));
+    endFunc(g);
+}
+
+/**
+ * @brief Gera um programa completo
+ * @param g Gerador
+ * @param shape Forma do programa
+ * @param target Numero aproximado de linhas
+ */
+static void generate(Gen* g, Shape shape, long target) {
+    char f[GEN_NAME];
+    long i = 0;
+    line(g, 0, "/* programa gerado por cmgen: forma %s, %ld linhas */", shapeNames[shape], target);
+    do {
+        Shape s = shape == ShapeMixed ? (Shape)(i % ShapeMixed) : shape;
+        switch (s) {
+            case ShapeFuncs: emitSmall(g); break;
+            case ShapeNested: emitNested(g); break;
+            case ShapeBlocks: emitBlock(g); break;
+            case ShapeGlobals: emitGlobals(g); break;
+            case ShapeArrays: emitArrays(g); break;
+            default: emitRecursive(g); break;
+        }
+        i++;
+    } while (g->lines + 5 < target);
+    line(g, 0, "void main(void) {");
+    line(g, 1, "int r;");
+    line(g, 1, "r = %s(5, 3);", name(f, "fn", g->nfuncs - 1));
+    line(g, 1, "output(r);");
+    line(g, 0, "}");
+}
+
+/**
+ * @brief Funcao principal do gerador
+ * @param argc Numero de argumentos
+ * @param argv Vetor de argumentos
+ * @return 0 se sucesso, 1 se erro
+ */
+int main(int argc, char* argv[]) {
+    Gen g;
+    Shape shape = ShapeMixed;
+    long target = 1000;
+    int ok = TRUE;
+    int i, s;
+
+    memset(&g, 0, sizeof(g));
+    g.out = stdout;
+    g.seed = 12345;
+    g.depth = 24;
+    g.blockLen = 200;
+    g.arraySize = 10000;
+    for (i = 1; i < argc && ok; i++) {
+        if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            i++;
+            for (s = 0; s <= ShapeMixed && strcmp(argv[i], shapeNames[s]) != 0; s++)
+                ;
+            if (s > ShapeMixed)
+                ok = FALSE;
+            shape = (Shape)s;
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            target = atol(argv[++i]);
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            g.seed = (unsigned)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--depth") == 0 && i + 1 < argc) {
+            g.depth = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--block") == 0 && i + 1 < argc) {
+            g.blockLen = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--array") == 0 && i + 1 < argc) {
+            g.arraySize = atoi(argv[++i]);
+        } else {
+            ok = FALSE;
+        }
+    }
+    if (!ok || target < 1 || g.depth < 0 || g.blockLen < 0 || g.arraySize < 64 || g.seed == 0) {
+        fprintf(stderr, "Uso: %s [-s forma] [-n linhas] [-r semente] [--depth n] [--block n] [--array n]\n", argv[0]);
+        fprintf(stderr, "  -s <forma>     funcoes, aninhado, blocos, globais, arrays, recursao ou misto (padrao)\n");
+        fprintf(stderr, "  -n <linhas>    tamanho aproximado do programa (padrao 1000)\n");
+        fprintf(stderr, "  -r <semente>   semente do gerador (diferente de 0, padrao 12345)\n");
+        fprintf(stderr, "  --depth <n>    profundidade do aninhamento (padrao 24)\n");
+        fprintf(stderr, "  --block <n>    comandos por bloco longo (padrao 200)\n");
+        fprintf(stderr, "  --array <n>    tamanho dos vetores, no minimo 64 (padrao 10000)\n");
+        return 1;
+    }
+    generate(&g, shape, target);
+    return 0;
+}
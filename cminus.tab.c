@@ -0,0 +1,2083 @@
+/* A Bison parser, made by GNU Bison 3.8.2.  */
+
+/* Bison implementation for Yacc-like parsers in C
+
+   Copyright (C) 1984, 1989-1990, 2000-2015, 2018-2021 Free Software Foundation,
+   Inc.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+/* As a special exception, you may create a larger work that contains
+   part or all of the Bison parser skeleton and distribute that work
+   under terms of your choice, so long as that work isn't itself a
+   parser generator using the skeleton or a modified version thereof
+   as a parser skeleton.  Alternatively, if you modify or redistribute
+   the parser skeleton itself, you may (at your option) remove this
+   special exception, which will cause the skeleton and the resulting
+   Bison output files to be licensed under the GNU General Public
+   License without this special exception.
+
+   This special exception was added by the Free Software Foundation in
+   version 2.2 of Bison.  */
+
+/* C LALR(1) parser skeleton written by Richard Stallman, by
+   simplifying the original so-called "semantic" parser.  */
+
+/* DO NOT RELY ON FEATURES THAT ARE NOT DOCUMENTED in the manual,
+   especially those whose name start with YY_ or yy_.  They are
+   private implementation details that can be changed or removed.  */
+
+/* All symbols defined below should begin with yy or YY, to avoid
+   infringing on user name space.  This should be done even for local
+   variables, as they might otherwise be expanded by user macros.
+   There are some unavoidable exceptions within include files to
+   define necessary library symbols; they are noted "INFRINGES ON
+   USER NAME SPACE" below.  */
+
+/* Identify Bison output, and Bison version.  */
+#define YYBISON 30802
+
+/* Bison version string.  */
+#define YYBISON_VERSION "3.8.2"
+
+/* Skeleton name.  */
+#define YYSKELETON_NAME "yacc.c"
+
+/* Pure parsers.  */
+#define YYPURE 2
+
+/* Push parsers.  */
+#define YYPUSH 0
+
+/* Pull parsers.  */
+#define YYPULL 1
+
+
+
+
+/* First part of user prologue.  */
+#line 10 "cminus.y"
+
+#include "util.h"
+
+#line 75 "cminus.tab.c"
+
+# ifndef YY_CAST
+#  ifdef __cplusplus
+#   define YY_CAST(Type, Val) static_cast<Type> (Val)
+#   define YY_REINTERPRET_CAST(Type, Val) reinterpret_cast<Type> (Val)
+#  else
+#   define YY_CAST(Type, Val) ((Type) (Val))
+#   define YY_REINTERPRET_CAST(Type, Val) ((Type) (Val))
+#  endif
+# endif
+# ifndef YY_NULLPTR
+#  if defined __cplusplus
+#   if 201103L <= __cplusplus
+#    define YY_NULLPTR nullptr
+#   else
+#    define YY_NULLPTR 0
+#   endif
+#  else
+#   define YY_NULLPTR ((void*)0)
+#  endif
+# endif
+
+#include "cminus.tab.h"
+/* Symbol kind.  */
+enum yysymbol_kind_t
+{
+  YYSYMBOL_YYEMPTY = -2,
+  YYSYMBOL_YYEOF = 0,                      /* "end of file"  */
+  YYSYMBOL_YYerror = 1,                    /* error  */
+  YYSYMBOL_YYUNDEF = 2,                    /* "invalid token"  */
+  YYSYMBOL_ID = 3,                         /* ID  */
+  YYSYMBOL_NUM = 4,                        /* NUM  */
+  YYSYMBOL_ELSE = 5,                       /* ELSE  */
+  YYSYMBOL_IF = 6,                         /* IF  */
+  YYSYMBOL_INT = 7,                        /* INT  */
+  YYSYMBOL_RETURN = 8,                     /* RETURN  */
+  YYSYMBOL_VOID = 9,                       /* VOID  */
+  YYSYMBOL_WHILE = 10,                     /* WHILE  */
+  YYSYMBOL_ATRIBUICAO = 11,                /* ATRIBUICAO  */
+  YYSYMBOL_IGUAL = 12,                     /* IGUAL  */
+  YYSYMBOL_MENOR = 13,                     /* MENOR  */
+  YYSYMBOL_MENORIGUAL = 14,                /* MENORIGUAL  */
+  YYSYMBOL_MAIOR = 15,                     /* MAIOR  */
+  YYSYMBOL_MAIORIGUAL = 16,                /* MAIORIGUAL  */
+  YYSYMBOL_DIFERENTE = 17,                 /* DIFERENTE  */
+  YYSYMBOL_MAIS = 18,                      /* MAIS  */
+  YYSYMBOL_MENOS = 19,                     /* MENOS  */
+  YYSYMBOL_VEZES = 20,                     /* VEZES  */
+  YYSYMBOL_SOBRE = 21,                     /* SOBRE  */
+  YYSYMBOL_LPARENTESES = 22,               /* LPARENTESES  */
+  YYSYMBOL_RPARENTESES = 23,               /* RPARENTESES  */
+  YYSYMBOL_LCOLCHETE = 24,                 /* LCOLCHETE  */
+  YYSYMBOL_RCOLCHETE = 25,                 /* RCOLCHETE  */
+  YYSYMBOL_LCHAVE = 26,                    /* LCHAVE  */
+  YYSYMBOL_RCHAVE = 27,                    /* RCHAVE  */
+  YYSYMBOL_PONTOEVIRGULA = 28,             /* PONTOEVIRGULA  */
+  YYSYMBOL_VIRGULA = 29,                   /* VIRGULA  */
+  YYSYMBOL_ERROR = 30,                     /* ERROR  */
+  YYSYMBOL_ENDFILE = 31,                   /* ENDFILE  */
+  YYSYMBOL_YYACCEPT = 32,                  /* $accept  */
+  YYSYMBOL_programa = 33,                  /* programa  */
+  YYSYMBOL_lista_declaracoes = 34,         /* lista_declaracoes  */
+  YYSYMBOL_declaracao = 35,                /* declaracao  */
+  YYSYMBOL_var_declaracao = 36,            /* var_declaracao  */
+  YYSYMBOL_tipo_especificador = 37,        /* tipo_especificador  */
+  YYSYMBOL_func_declaracao = 38,           /* func_declaracao  */
+  YYSYMBOL_params = 39,                    /* params  */
+  YYSYMBOL_param_lista = 40,               /* param_lista  */
+  YYSYMBOL_param = 41,                     /* param  */
+  YYSYMBOL_composto_decl = 42,             /* composto_decl  */
+  YYSYMBOL_local_declaracoes = 43,         /* local_declaracoes  */
+  YYSYMBOL_statement_lista = 44,           /* statement_lista  */
+  YYSYMBOL_statement = 45,                 /* statement  */
+  YYSYMBOL_expressao_decl = 46,            /* expressao_decl  */
+  YYSYMBOL_selecao_decl = 47,              /* selecao_decl  */
+  YYSYMBOL_iteracao_decl = 48,             /* iteracao_decl  */
+  YYSYMBOL_retorno_decl = 49,              /* retorno_decl  */
+  YYSYMBOL_expressao = 50,                 /* expressao  */
+  YYSYMBOL_var = 51,                       /* var  */
+  YYSYMBOL_expressao_simples = 52,         /* expressao_simples  */
+  YYSYMBOL_relop = 53,                     /* relop  */
+  YYSYMBOL_relacional = 54,                /* relacional  */
+  YYSYMBOL_soma = 55,                      /* soma  */
+  YYSYMBOL_termo = 56,                     /* termo  */
+  YYSYMBOL_mult = 57,                      /* mult  */
+  YYSYMBOL_fator = 58,                     /* fator  */
+  YYSYMBOL_ativacao = 59,                  /* ativacao  */
+  YYSYMBOL_args = 60,                      /* args  */
+  YYSYMBOL_arg_lista = 61                  /* arg_lista  */
+};
+typedef enum yysymbol_kind_t yysymbol_kind_t;
+
+
+
+/* Unqualified %code blocks.  */
+#line 53 "cminus.y"
+
+int yylex(YYSTYPE* lvalp, CompilerContext* ctx);
+void yyerror(CompilerContext* ctx, const char* message);
+
+#line 176 "cminus.tab.c"
+
+#ifdef short
+# undef short
+#endif
+
+/* On compilers that do not define __PTRDIFF_MAX__ etc., make sure
+   <limits.h> and (if available) <stdint.h> are included
+   so that the code can choose integer types of a good width.  */
+
+#ifndef __PTRDIFF_MAX__
+# include <limits.h> /* INFRINGES ON USER NAME SPACE */
+# if defined __STDC_VERSION__ && 199901 <= __STDC_VERSION__
+#  include <stdint.h> /* INFRINGES ON USER NAME SPACE */
+#  define YY_STDINT_H
+# endif
+#endif
+
+/* Narrow types that promote to a signed type and that can represent a
+   signed or unsigned integer of at least N bits.  In tables they can
+   save space and decrease cache pressure.  Promoting to a signed type
+   helps avoid bugs in integer arithmetic.  */
+
+#ifdef __INT_LEAST8_MAX__
+typedef __INT_LEAST8_TYPE__ yytype_int8;
+#elif defined YY_STDINT_H
+typedef int_least8_t yytype_int8;
+#else
+typedef signed char yytype_int8;
+#endif
+
+#ifdef __INT_LEAST16_MAX__
+typedef __INT_LEAST16_TYPE__ yytype_int16;
+#elif defined YY_STDINT_H
+typedef int_least16_t yytype_int16;
+#else
+typedef short yytype_int16;
+#endif
+
+/* Work around bug in HP-UX 11.23, which defines these macros
+   incorrectly for preprocessor constants.  This workaround can likely
+   be removed in 2023, as HPE has promised support for HP-UX 11.23
+   (aka HP-UX 11i v2) only through the end of 2022; see Table 2 of
+   <https://h20195.www2.hpe.com/V2/getpdf.aspx/4AA4-7673ENW.pdf>.  */
+#ifdef __hpux
+# undef UINT_LEAST8_MAX
+# undef UINT_LEAST16_MAX
+# define UINT_LEAST8_MAX 255
+# define UINT_LEAST16_MAX 65535
+#endif
+
+#if defined __UINT_LEAST8_MAX__ && __UINT_LEAST8_MAX__ <= __INT_MAX__
+typedef __UINT_LEAST8_TYPE__ yytype_uint8;
+#elif (!defined __UINT_LEAST8_MAX__ && defined YY_STDINT_H \
+       && UINT_LEAST8_MAX <= INT_MAX)
+typedef uint_least8_t yytype_uint8;
+#elif !defined __UINT_LEAST8_MAX__ && UCHAR_MAX <= INT_MAX
+typedef unsigned char yytype_uint8;
+#else
+typedef short yytype_uint8;
+#endif
+
+#if defined __UINT_LEAST16_MAX__ && __UINT_LEAST16_MAX__ <= __INT_MAX__
+typedef __UINT_LEAST16_TYPE__ yytype_uint16;
+#elif (!defined __UINT_LEAST16_MAX__ && defined YY_STDINT_H \
+       && UINT_LEAST16_MAX <= INT_MAX)
+typedef uint_least16_t yytype_uint16;
+#elif !defined __UINT_LEAST16_MAX__ && USHRT_MAX <= INT_MAX
+typedef unsigned short yytype_uint16;
+#else
+typedef int yytype_uint16;
+#endif
+
+#ifndef YYPTRDIFF_T
+# if defined __PTRDIFF_TYPE__ && defined __PTRDIFF_MAX__
+#  define YYPTRDIFF_T __PTRDIFF_TYPE__
+#  define YYPTRDIFF_MAXIMUM __PTRDIFF_MAX__
+# elif defined PTRDIFF_MAX
+#  ifndef ptrdiff_t
+#   include <stddef.h> /* INFRINGES ON USER NAME SPACE */
+#  endif
+#  define YYPTRDIFF_T ptrdiff_t
+#  define YYPTRDIFF_MAXIMUM PTRDIFF_MAX
+# else
+#  define YYPTRDIFF_T long
+#  define YYPTRDIFF_MAXIMUM LONG_MAX
+# endif
+#endif
+
+#ifndef YYSIZE_T
+# ifdef __SIZE_TYPE__
+#  define YYSIZE_T __SIZE_TYPE__
+# elif defined size_t
+#  define YYSIZE_T size_t
+# elif defined __STDC_VERSION__ && 199901 <= __STDC_VERSION__
+#  include <stddef.h> /* INFRINGES ON USER NAME SPACE */
+#  define YYSIZE_T size_t
+# else
+#  define YYSIZE_T unsigned
+# endif
+#endif
+
+#define YYSIZE_MAXIMUM                                  \
+  YY_CAST (YYPTRDIFF_T,                                 \
+           (YYPTRDIFF_MAXIMUM < YY_CAST (YYSIZE_T, -1)  \
+            ? YYPTRDIFF_MAXIMUM                         \
+            : YY_CAST (YYSIZE_T, -1)))
+
+#define YYSIZEOF(X) YY_CAST (YYPTRDIFF_T, sizeof (X))
+
+
+/* Stored state numbers (used for stacks). */
+typedef yytype_int8 yy_state_t;
+
+/* State numbers in computations.  */
+typedef int yy_state_fast_t;
+
+#ifndef YY_
+# if defined YYENABLE_NLS && YYENABLE_NLS
+#  if ENABLE_NLS
+#   include <libintl.h> /* INFRINGES ON USER NAME SPACE */
+#   define YY_(Msgid) dgettext ("bison-runtime", Msgid)
+#  endif
+# endif
+# ifndef YY_
+#  define YY_(Msgid) Msgid
+# endif
+#endif
+
+
+#ifndef YY_ATTRIBUTE_PURE
+# if defined __GNUC__ && 2 < __GNUC__ + (96 <= __GNUC_MINOR__)
+#  define YY_ATTRIBUTE_PURE __attribute__ ((__pure__))
+# else
+#  define YY_ATTRIBUTE_PURE
+# endif
+#endif
+
+#ifndef YY_ATTRIBUTE_UNUSED
+# if defined __GNUC__ && 2 < __GNUC__ + (7 <= __GNUC_MINOR__)
+#  define YY_ATTRIBUTE_UNUSED __attribute__ ((__unused__))
+# else
+#  define YY_ATTRIBUTE_UNUSED
+# endif
+#endif
+
+/* Suppress unused-variable warnings by "using" E.  */
+#if ! defined lint || defined __GNUC__
+# define YY_USE(E) ((void) (E))
+#else
+# define YY_USE(E) /* empty */
+#endif
+
+/* Suppress an incorrect diagnostic about yylval being uninitialized.  */
+#if defined __GNUC__ && ! defined __ICC && 406 <= __GNUC__ * 100 + __GNUC_MINOR__
+# if __GNUC__ * 100 + __GNUC_MINOR__ < 407
+#  define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN                           \
+    _Pragma ("GCC diagnostic push")                                     \
+    _Pragma ("GCC diagnostic ignored \"-Wuninitialized\"")
+# else
+#  define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN                           \
+    _Pragma ("GCC diagnostic push")                                     \
+    _Pragma ("GCC diagnostic ignored \"-Wuninitialized\"")              \
+    _Pragma ("GCC diagnostic ignored \"-Wmaybe-uninitialized\"")
+# endif
+# define YY_IGNORE_MAYBE_UNINITIALIZED_END      \
+    _Pragma ("GCC diagnostic pop")
+#else
+# define YY_INITIAL_VALUE(Value) Value
+#endif
+#ifndef YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+# define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+# define YY_IGNORE_MAYBE_UNINITIALIZED_END
+#endif
+#ifndef YY_INITIAL_VALUE
+# define YY_INITIAL_VALUE(Value) /* Nothing. */
+#endif
+
+#if defined __cplusplus && defined __GNUC__ && ! defined __ICC && 6 <= __GNUC__
+# define YY_IGNORE_USELESS_CAST_BEGIN                          \
+    _Pragma ("GCC diagnostic push")                            \
+    _Pragma ("GCC diagnostic ignored \"-Wuseless-cast\"")
+# define YY_IGNORE_USELESS_CAST_END            \
+    _Pragma ("GCC diagnostic pop")
+#endif
+#ifndef YY_IGNORE_USELESS_CAST_BEGIN
+# define YY_IGNORE_USELESS_CAST_BEGIN
+# define YY_IGNORE_USELESS_CAST_END
+#endif
+
+
+#define YY_ASSERT(E) ((void) (0 && (E)))
+
+#if !defined yyoverflow
+
+/* The parser invokes alloca or malloc; define the necessary symbols.  */
+
+# ifdef YYSTACK_USE_ALLOCA
+#  if YYSTACK_USE_ALLOCA
+#   ifdef __GNUC__
+#    define YYSTACK_ALLOC __builtin_alloca
+#   elif defined __BUILTIN_VA_ARG_INCR
+#    include <alloca.h> /* INFRINGES ON USER NAME SPACE */
+#   elif defined _AIX
+#    define YYSTACK_ALLOC __alloca
+#   elif defined _MSC_VER
+#    include <malloc.h> /* INFRINGES ON USER NAME SPACE */
+#    define alloca _alloca
+#   else
+#    define YYSTACK_ALLOC alloca
+#    if ! defined _ALLOCA_H && ! defined EXIT_SUCCESS
+#     include <stdlib.h> /* INFRINGES ON USER NAME SPACE */
+      /* Use EXIT_SUCCESS as a witness for stdlib.h.  */
+#     ifndef EXIT_SUCCESS
+#      define EXIT_SUCCESS 0
+#     endif
+#    endif
+#   endif
+#  endif
+# endif
+
+# ifdef YYSTACK_ALLOC
+   /* Pacify GCC's 'empty if-body' warning.  */
+#  define YYSTACK_FREE(Ptr) do { /* empty */; } while (0)
+#  ifndef YYSTACK_ALLOC_MAXIMUM
+    /* The OS might guarantee only one guard page at the bottom of the stack,
+       and a page size can be as small as 4096 bytes.  So we cannot safely
+       invoke alloca (N) if N exceeds 4096.  Use a slightly smaller number
+       to allow for a few compiler-allocated temporary stack slots.  */
+#   define YYSTACK_ALLOC_MAXIMUM 4032 /* reasonable circa 2006 */
+#  endif
+# else
+#  define YYSTACK_ALLOC YYMALLOC
+#  define YYSTACK_FREE YYFREE
+#  ifndef YYSTACK_ALLOC_MAXIMUM
+#   define YYSTACK_ALLOC_MAXIMUM YYSIZE_MAXIMUM
+#  endif
+#  if (defined __cplusplus && ! defined EXIT_SUCCESS \
+       && ! ((defined YYMALLOC || defined malloc) \
+             && (defined YYFREE || defined free)))
+#   include <stdlib.h> /* INFRINGES ON USER NAME SPACE */
+#   ifndef EXIT_SUCCESS
+#    define EXIT_SUCCESS 0
+#   endif
+#  endif
+#  ifndef YYMALLOC
+#   define YYMALLOC malloc
+#   if ! defined malloc && ! defined EXIT_SUCCESS
+void *malloc (YYSIZE_T); /* INFRINGES ON USER NAME SPACE */
+#   endif
+#  endif
+#  ifndef YYFREE
+#   define YYFREE free
+#   if ! defined free && ! defined EXIT_SUCCESS
+void free (void *); /* INFRINGES ON USER NAME SPACE */
+#   endif
+#  endif
+# endif
+#endif /* !defined yyoverflow */
+
+#if (! defined yyoverflow \
+     && (! defined __cplusplus \
+         || (defined YYSTYPE_IS_TRIVIAL && YYSTYPE_IS_TRIVIAL)))
+
+/* A type that is properly aligned for any stack member.  */
+union yyalloc
+{
+  yy_state_t yyss_alloc;
+  YYSTYPE yyvs_alloc;
+};
+
+/* The size of the maximum gap between one aligned stack and the next.  */
+# define YYSTACK_GAP_MAXIMUM (YYSIZEOF (union yyalloc) - 1)
+
+/* The size of an array large to enough to hold all stacks, each with
+   N elements.  */
+# define YYSTACK_BYTES(N) \
+     ((N) * (YYSIZEOF (yy_state_t) + YYSIZEOF (YYSTYPE)) \
+      + YYSTACK_GAP_MAXIMUM)
+
+# define YYCOPY_NEEDED 1
+
+/* Relocate STACK from its old location to the new one.  The
+   local variables YYSIZE and YYSTACKSIZE give the old and new number of
+   elements in the stack, and YYPTR gives the new location of the
+   stack.  Advance YYPTR to a properly aligned location for the next
+   stack.  */
+# define YYSTACK_RELOCATE(Stack_alloc, Stack)                           \
+    do                                                                  \
+      {                                                                 \
+        YYPTRDIFF_T yynewbytes;                                         \
+        YYCOPY (&yyptr->Stack_alloc, Stack, yysize);                    \
+        Stack = &yyptr->Stack_alloc;                                    \
+        yynewbytes = yystacksize * YYSIZEOF (*Stack) + YYSTACK_GAP_MAXIMUM; \
+        yyptr += yynewbytes / YYSIZEOF (*yyptr);                        \
+      }                                                                 \
+    while (0)
+
+#endif
+
+#if defined YYCOPY_NEEDED && YYCOPY_NEEDED
+/* Copy COUNT objects from SRC to DST.  The source and destination do
+   not overlap.  */
+# ifndef YYCOPY
+#  if defined __GNUC__ && 1 < __GNUC__
+#   define YYCOPY(Dst, Src, Count) \
+      __builtin_memcpy (Dst, Src, YY_CAST (YYSIZE_T, (Count)) * sizeof (*(Src)))
+#  else
+#   define YYCOPY(Dst, Src, Count)              \
+      do                                        \
+        {                                       \
+          YYPTRDIFF_T yyi;                      \
+          for (yyi = 0; yyi < (Count); yyi++)   \
+            (Dst)[yyi] = (Src)[yyi];            \
+        }                                       \
+      while (0)
+#  endif
+# endif
+#endif /* !YYCOPY_NEEDED */
+
+/* YYFINAL -- State number of the termination state.  */
+#define YYFINAL  9
+/* YYLAST -- Last index in YYTABLE.  */
+#define YYLAST   94
+
+/* YYNTOKENS -- Number of terminals.  */
+#define YYNTOKENS  32
+/* YYNNTS -- Number of nonterminals.  */
+#define YYNNTS  30
+/* YYNRULES -- Number of rules.  */
+#define YYNRULES  63
+/* YYNSTATES -- Number of states.  */
+#define YYNSTATES  102
+
+/* YYMAXUTOK -- Last valid token kind.  */
+#define YYMAXUTOK   286
+
+
+/* YYTRANSLATE(TOKEN-NUM) -- Symbol number corresponding to TOKEN-NUM
+   as returned by yylex, with out-of-bounds checking.  */
+#define YYTRANSLATE(YYX)                                \
+  (0 <= (YYX) && (YYX) <= YYMAXUTOK                     \
+   ? YY_CAST (yysymbol_kind_t, yytranslate[YYX])        \
+   : YYSYMBOL_YYUNDEF)
+
+/* YYTRANSLATE[TOKEN-NUM] -- Symbol number corresponding to TOKEN-NUM
+   as returned by yylex.  */
+static const yytype_int8 yytranslate[] =
+{
+       0,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     1,     2,     3,     4,
+       5,     6,     7,     8,     9,    10,    11,    12,    13,    14,
+      15,    16,    17,    18,    19,    20,    21,    22,    23,    24,
+      25,    26,    27,    28,    29,    30,    31
+};
+
+#if YYDEBUG
+/* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
+static const yytype_int16 yyrline[] =
+{
+       0,    79,    79,    89,   104,   116,   118,   123,   129,   140,
+     142,   147,   158,   160,   165,   177,   182,   188,   198,   207,
+     220,   226,   239,   243,   245,   247,   249,   251,   256,   258,
+     263,   269,   279,   288,   292,   300,   306,   311,   316,   325,
+     332,   337,   339,   341,   343,   345,   347,   352,   359,   364,
+     366,   371,   378,   383,   385,   390,   392,   394,   396,   404,
+     413,   416,   420,   432
+};
+#endif
+
+/** Accessing symbol of state STATE.  */
+#define YY_ACCESSING_SYMBOL(State) YY_CAST (yysymbol_kind_t, yystos[State])
+
+#if YYDEBUG || 0
+/* The user-facing name of the symbol whose (internal) number is
+   YYSYMBOL.  No bounds checking.  */
+static const char *yysymbol_name (yysymbol_kind_t yysymbol) YY_ATTRIBUTE_UNUSED;
+
+/* YYTNAME[SYMBOL-NUM] -- String name of the symbol SYMBOL-NUM.
+   First, the terminals, then, starting at YYNTOKENS, nonterminals.  */
+static const char *const yytname[] =
+{
+  "\"end of file\"", "error", "\"invalid token\"", "ID", "NUM", "ELSE",
+  "IF", "INT", "RETURN", "VOID", "WHILE", "ATRIBUICAO", "IGUAL", "MENOR",
+  "MENORIGUAL", "MAIOR", "MAIORIGUAL", "DIFERENTE", "MAIS", "MENOS",
+  "VEZES", "SOBRE", "LPARENTESES", "RPARENTESES", "LCOLCHETE", "RCOLCHETE",
+  "LCHAVE", "RCHAVE", "PONTOEVIRGULA", "VIRGULA", "ERROR", "ENDFILE",
+  "$accept", "programa", "lista_declaracoes", "declaracao",
+  "var_declaracao", "tipo_especificador", "func_declaracao", "params",
+  "param_lista", "param", "composto_decl", "local_declaracoes",
+  "statement_lista", "statement", "expressao_decl", "selecao_decl",
+  "iteracao_decl", "retorno_decl", "expressao", "var", "expressao_simples",
+  "relop", "relacional", "soma", "termo", "mult", "fator", "ativacao",
+  "args", "arg_lista", YY_NULLPTR
+};
+
+static const char *
+yysymbol_name (yysymbol_kind_t yysymbol)
+{
+  return yytname[yysymbol];
+}
+#endif
+
+#define YYPACT_NINF (-62)
+
+#define yypact_value_is_default(Yyn) \
+  ((Yyn) == YYPACT_NINF)
+
+#define YYTABLE_NINF (-14)
+
+#define yytable_value_is_error(Yyn) \
+  0
+
+/* YYPACT[STATE-NUM] -- Index in YYTABLE of the portion describing
+   STATE-NUM.  */
+static const yytype_int8 yypact[] =
+{
+      34,   -62,   -62,     1,    34,   -62,   -62,    18,   -62,   -62,
+     -62,   -15,    53,    38,   -62,    15,    58,    46,    27,   -62,
+      40,    47,    44,    34,    45,    50,   -62,   -62,   -62,   -62,
+     -62,    34,   -62,    69,     2,     3,    42,   -62,    52,    12,
+      54,     0,   -62,   -62,   -62,   -62,   -62,   -62,   -62,   -62,
+      51,    66,    33,    49,    32,   -62,   -62,     0,     0,     0,
+     -62,    55,     0,    57,   -62,     0,   -62,   -62,   -62,   -62,
+     -62,   -62,     0,   -62,   -62,     0,   -62,   -62,     0,   -62,
+      59,    56,    61,    64,   -62,    65,   -62,   -62,   -62,    49,
+      32,   -62,   -62,     0,   -62,    29,    29,   -62,    73,   -62,
+      29,   -62
+};
+
+/* YYDEFACT[STATE-NUM] -- Default reduction number in state STATE-NUM.
+   Performed when YYTABLE does not specify something else to do.  Zero
+   means the default is an error.  */
+static const yytype_int8 yydefact[] =
+{
+       0,     9,    10,     0,     2,     4,     5,     0,     6,     1,
+       3,     0,     0,     0,     7,    10,     0,     0,    12,    15,
+       0,    16,     0,     0,     0,     0,    20,    11,    14,     8,
+      17,    22,    19,     0,     0,     0,    37,    58,     0,     0,
+       0,     0,    18,    29,    24,    21,    23,    25,    26,    27,
+       0,    56,    36,    40,    48,    52,    57,    61,     0,     0,
+      33,     0,     0,     0,    28,     0,    45,    42,    41,    43,
+      44,    46,     0,    49,    50,     0,    53,    54,     0,    63,
+       0,    60,     0,     0,    34,     0,    55,    35,    56,    39,
+      47,    51,    59,     0,    38,     0,     0,    62,    30,    32,
+       0,    31
+};
+
+/* YYPGOTO[NTERM-NUM].  */
+static const yytype_int8 yypgoto[] =
+{
+     -62,   -62,   -62,    77,    60,    13,   -62,   -62,   -62,    67,
+      62,   -62,   -62,   -37,   -62,   -62,   -62,   -62,   -39,   -61,
+     -62,   -62,    17,   -62,    19,   -62,    14,   -62,   -62,   -62
+};
+
+/* YYDEFGOTO[NTERM-NUM].  */
+static const yytype_int8 yydefgoto[] =
+{
+       0,     3,     4,     5,     6,     7,     8,    17,    18,    19,
+      44,    31,    34,    45,    46,    47,    48,    49,    50,    51,
+      52,    72,    53,    75,    54,    78,    55,    56,    80,    81
+};
+
+/* YYTABLE[YYPACT[STATE-NUM]] -- What to do in state STATE-NUM.  If
+   positive, shift that token.  If negative, reduce the rule whose
+   number is the opposite.  If YYTABLE_NINF, syntax error.  */
+static const yytype_int8 yytable[] =
+{
+      61,     9,    63,    36,    37,    36,    37,    12,    38,    13,
+      39,    88,    40,    14,    88,    36,    37,    88,    79,    82,
+      83,    11,    41,    85,    41,    16,    87,    13,    26,    42,
+      43,    14,    36,    37,    41,    38,    16,    39,   -13,    40,
+      60,     1,    20,     2,    33,    66,    67,    68,    69,    70,
+      71,    41,    76,    77,    97,    26,    23,    43,    98,    99,
+       1,    21,    15,   101,    57,    24,    58,    73,    74,    22,
+      26,    25,    35,    29,    59,    30,    62,    65,   100,    64,
+      86,    10,    92,    84,    27,    93,    94,    95,    96,    89,
+      28,    32,    91,     0,    90
+};
+
+static const yytype_int8 yycheck[] =
+{
+      39,     0,    41,     3,     4,     3,     4,    22,     6,    24,
+       8,    72,    10,    28,    75,     3,     4,    78,    57,    58,
+      59,     3,    22,    62,    22,    12,    65,    24,    26,    27,
+      28,    28,     3,     4,    22,     6,    23,     8,    23,    10,
+      28,     7,     4,     9,    31,    12,    13,    14,    15,    16,
+      17,    22,    20,    21,    93,    26,    29,    28,    95,    96,
+       7,     3,     9,   100,    22,    25,    24,    18,    19,    23,
+      26,    24,     3,    28,    22,    25,    22,    11,     5,    28,
+      23,     4,    23,    28,    22,    29,    25,    23,    23,    72,
+      23,    31,    78,    -1,    75
+};
+
+/* YYSTOS[STATE-NUM] -- The symbol kind of the accessing symbol of
+   state STATE-NUM.  */
+static const yytype_int8 yystos[] =
+{
+       0,     7,     9,    33,    34,    35,    36,    37,    38,     0,
+      35,     3,    22,    24,    28,     9,    37,    39,    40,    41,
+       4,     3,    23,    29,    25,    24,    26,    42,    41,    28,
+      25,    43,    36,    37,    44,     3,     3,     4,     6,     8,
+      10,    22,    27,    28,    42,    45,    46,    47,    48,    49,
+      50,    51,    52,    54,    56,    58,    59,    22,    24,    22,
+      28,    50,    22,    50,    28,    11,    12,    13,    14,    15,
+      16,    17,    53,    18,    19,    55,    20,    21,    57,    50,
+      60,    61,    50,    50,    28,    50,    23,    50,    51,    54,
+      56,    58,    23,    29,    25,    23,    23,    50,    45,    45,
+       5,    45
+};
+
+/* YYR1[RULE-NUM] -- Symbol kind of the left-hand side of rule RULE-NUM.  */
+static const yytype_int8 yyr1[] =
+{
+       0,    32,    33,    34,    34,    35,    35,    36,    36,    37,
+      37,    38,    39,    39,    40,    40,    41,    41,    42,    43,
+      43,    44,    44,    45,    45,    45,    45,    45,    46,    46,
+      47,    47,    48,    49,    49,    50,    50,    51,    51,    52,
+      52,    53,    53,    53,    53,    53,    53,    54,    54,    55,
+      55,    56,    56,    57,    57,    58,    58,    58,    58,    59,
+      60,    60,    61,    61
+};
+
+/* YYR2[RULE-NUM] -- Number of symbols on the right-hand side of rule RULE-NUM.  */
+static const yytype_int8 yyr2[] =
+{
+       0,     2,     1,     2,     1,     1,     1,     3,     6,     1,
+       1,     6,     1,     1,     3,     1,     2,     4,     4,     2,
+       0,     2,     0,     1,     1,     1,     1,     1,     2,     1,
+       5,     7,     5,     2,     3,     3,     1,     1,     4,     3,
+       1,     1,     1,     1,     1,     1,     1,     3,     1,     1,
+       1,     3,     1,     1,     1,     3,     1,     1,     1,     4,
+       1,     0,     3,     1
+};
+
+
+enum { YYENOMEM = -2 };
+
+#define yyerrok         (yyerrstatus = 0)
+#define yyclearin       (yychar = YYEMPTY)
+
+#define YYACCEPT        goto yyacceptlab
+#define YYABORT         goto yyabortlab
+#define YYERROR         goto yyerrorlab
+#define YYNOMEM         goto yyexhaustedlab
+
+
+#define YYRECOVERING()  (!!yyerrstatus)
+
+#define YYBACKUP(Token, Value)                                    \
+  do                                                              \
+    if (yychar == YYEMPTY)                                        \
+      {                                                           \
+        yychar = (Token);                                         \
+        yylval = (Value);                                         \
+        YYPOPSTACK (yylen);                                       \
+        yystate = *yyssp;                                         \
+        goto yybackup;                                            \
+      }                                                           \
+    else                                                          \
+      {                                                           \
+        yyerror (ctx, YY_("syntax error: cannot back up")); \
+        YYERROR;                                                  \
+      }                                                           \
+  while (0)
+
+/* Backward compatibility with an undocumented macro.
+   Use YYerror or YYUNDEF. */
+#define YYERRCODE YYUNDEF
+
+
+/* Enable debugging if requested.  */
+#if YYDEBUG
+
+# ifndef YYFPRINTF
+#  include <stdio.h> /* INFRINGES ON USER NAME SPACE */
+#  define YYFPRINTF fprintf
+# endif
+
+# define YYDPRINTF(Args)                        \
+do {                                            \
+  if (yydebug)                                  \
+    YYFPRINTF Args;                             \
+} while (0)
+
+
+
+
+# define YY_SYMBOL_PRINT(Title, Kind, Value, Location)                    \
+do {                                                                      \
+  if (yydebug)                                                            \
+    {                                                                     \
+      YYFPRINTF (stderr, "%s ", Title);                                   \
+      yy_symbol_print (stderr,                                            \
+                  Kind, Value, ctx); \
+      YYFPRINTF (stderr, "\n");                                           \
+    }                                                                     \
+} while (0)
+
+
+/*-----------------------------------.
+| Print this symbol's value on YYO.  |
+`-----------------------------------*/
+
+static void
+yy_symbol_value_print (FILE *yyo,
+                       yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep, CompilerContext* ctx)
+{
+  FILE *yyoutput = yyo;
+  YY_USE (yyoutput);
+  YY_USE (ctx);
+  if (!yyvaluep)
+    return;
+  YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+  YY_USE (yykind);
+  YY_IGNORE_MAYBE_UNINITIALIZED_END
+}
+
+
+/*---------------------------.
+| Print this symbol on YYO.  |
+`---------------------------*/
+
+static void
+yy_symbol_print (FILE *yyo,
+                 yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep, CompilerContext* ctx)
+{
+  YYFPRINTF (yyo, "%s %s (",
+             yykind < YYNTOKENS ? "token" : "nterm", yysymbol_name (yykind));
+
+  yy_symbol_value_print (yyo, yykind, yyvaluep, ctx);
+  YYFPRINTF (yyo, ")");
+}
+
+/*------------------------------------------------------------------.
+| yy_stack_print -- Print the state stack from its BOTTOM up to its |
+| TOP (included).                                                   |
+`------------------------------------------------------------------*/
+
+static void
+yy_stack_print (yy_state_t *yybottom, yy_state_t *yytop)
+{
+  YYFPRINTF (stderr, "Stack now");
+  for (; yybottom <= yytop; yybottom++)
+    {
+      int yybot = *yybottom;
+      YYFPRINTF (stderr, " %d", yybot);
+    }
+  YYFPRINTF (stderr, "\n");
+}
+
+# define YY_STACK_PRINT(Bottom, Top)                            \
+do {                                                            \
+  if (yydebug)                                                  \
+    yy_stack_print ((Bottom), (Top));                           \
+} while (0)
+
+
+/*------------------------------------------------.
+| Report that the YYRULE is going to be reduced.  |
+`------------------------------------------------*/
+
+static void
+yy_reduce_print (yy_state_t *yyssp, YYSTYPE *yyvsp,
+                 int yyrule, CompilerContext* ctx)
+{
+  int yylno = yyrline[yyrule];
+  int yynrhs = yyr2[yyrule];
+  int yyi;
+  YYFPRINTF (stderr, "Reducing stack by rule %d (line %d):\n",
+             yyrule - 1, yylno);
+  /* The symbols being reduced.  */
+  for (yyi = 0; yyi < yynrhs; yyi++)
+    {
+      YYFPRINTF (stderr, "   $%d = ", yyi + 1);
+      yy_symbol_print (stderr,
+                       YY_ACCESSING_SYMBOL (+yyssp[yyi + 1 - yynrhs]),
+                       &yyvsp[(yyi + 1) - (yynrhs)], ctx);
+      YYFPRINTF (stderr, "\n");
+    }
+}
+
+# define YY_REDUCE_PRINT(Rule)          \
+do {                                    \
+  if (yydebug)                          \
+    yy_reduce_print (yyssp, yyvsp, Rule, ctx); \
+} while (0)
+
+/* Nonzero means print parse trace.  It is left uninitialized so that
+   multiple parsers can coexist.  */
+int yydebug;
+#else /* !YYDEBUG */
+# define YYDPRINTF(Args) ((void) 0)
+# define YY_SYMBOL_PRINT(Title, Kind, Value, Location)
+# define YY_STACK_PRINT(Bottom, Top)
+# define YY_REDUCE_PRINT(Rule)
+#endif /* !YYDEBUG */
+
+
+/* YYINITDEPTH -- initial size of the parser's stacks.  */
+#ifndef YYINITDEPTH
+# define YYINITDEPTH 200
+#endif
+
+/* YYMAXDEPTH -- maximum size the stacks can grow to (effective only
+   if the built-in stack extension method is used).
+
+   Do not make this value too large; the results are undefined if
+   YYSTACK_ALLOC_MAXIMUM < YYSTACK_BYTES (YYMAXDEPTH)
+   evaluated with infinite-precision integer arithmetic.  */
+
+#ifndef YYMAXDEPTH
+# define YYMAXDEPTH 10000
+#endif
+
+
+
+
+
+
+/*-----------------------------------------------.
+| Release the memory associated to this symbol.  |
+`-----------------------------------------------*/
+
+static void
+yydestruct (const char *yymsg,
+            yysymbol_kind_t yykind, YYSTYPE *yyvaluep, CompilerContext* ctx)
+{
+  YY_USE (yyvaluep);
+  YY_USE (ctx);
+  if (!yymsg)
+    yymsg = "Deleting";
+  YY_SYMBOL_PRINT (yymsg, yykind, yyvaluep, yylocationp);
+
+  YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+  switch (yykind)
+    {
+    case YYSYMBOL_ID: /* ID  */
+#line 68 "cminus.y"
+            { free(((*yyvaluep).name)); }
+#line 941 "cminus.tab.c"
+        break;
+
+    case YYSYMBOL_programa: /* programa  */
+#line 67 "cminus.y"
+            { freeTree(((*yyvaluep).node)); }
+#line 947 "cminus.tab.c"
+        break;
+
+    case YYSYMBOL_lista_declaracoes: /* lista_declaracoes  */
+#line 67 "cminus.y"
+            { freeTree(((*yyvaluep).node)); }
+#line 953 "cminus.tab.c"
+        break;
+
+    case YYSYMBOL_declaracao: /* declaracao  */
+#line 67 "cminus.y"
+            { freeTree(((*yyvaluep).node)); }
+#line 959 "cminus.tab.c"
+        break;
+
+    case YYSYMBOL_var_declaracao: /* var_declaracao  */
+#line 67 "cminus.y"
+            { freeTree(((*yyvaluep).node)); }
+#line 965 "cminus.tab.c"
+        break;
+
+    case YYSYMBOL_func_declaracao: /* func_declaracao  */
+#line 67 "cminus.y"
+            { freeTree(((*yyvaluep).node)); }
+#line 971 "cminus.tab.c"
+        break;
+
+    case YYSYMBOL_params: /* params  */
+#line 67 "cminus.y"
+            { freeTree(((*yyvaluep).node)); }
+#line 977 "cminus.tab.c"
+        break;
+
+    case YYSYMBOL_param_lista: /* param_lista  */
+#line 67 "cminus.y"
+            { freeTree(((*yyvaluep).node)); }
+#line 983 "cminus.tab.c"
+        break;
+
+    case YYSYMBOL_param: /* param  */
+#line 67 "cminus.y"
+            { freeTree(((*yyvaluep).node)); }
+#line 989 "cminus.tab.c"
+        break;
+
+    case YYSYMBOL_composto_decl: /* composto_decl  */
+#line 67 "cminus.y"
+            { freeTree(((*yyvaluep).node)); }
+#line 995 "cminus.tab.c"
+        break;
+
+    case YYSYMBOL_local_declaracoes: /* local_declaracoes  */
+#line 67 "cminus.y"
+            { freeTree(((*yyvaluep).node)); }
+#line 1001 "cminus.tab.c"
+        break;
+
+    case YYSYMBOL_statement_lista: /* statement_lista  */
+#line 67 "cminus.y"
+            { freeTree(((*yyvaluep).node)); }
+#line 1007 "cminus.tab.c"
+        break;
+
+    case YYSYMBOL_statement: /* statement  */
+#line 67 "cminus.y"
+            { freeTree(((*yyvaluep).node)); }
+#line 1013 "cminus.tab.c"
+        break;
+
+    case YYSYMBOL_expressao_decl: /* expressao_decl  */
+#line 67 "cminus.y"
+            { freeTree(((*yyvaluep).node)); }
+#line 1019 "cminus.tab.c"
+        break;
+
+    case YYSYMBOL_selecao_decl: /* selecao_decl  */
+#line 67 "cminus.y"
+            { freeTree(((*yyvaluep).node)); }
+#line 1025 "cminus.tab.c"
+        break;
+
+    case YYSYMBOL_iteracao_decl: /* iteracao_decl  */
+#line 67 "cminus.y"
+            { freeTree(((*yyvaluep).node)); }
+#line 1031 "cminus.tab.c"
+        break;
+
+    case YYSYMBOL_retorno_decl: /* retorno_decl  */
+#line 67 "cminus.y"
+            { freeTree(((*yyvaluep).node)); }
+#line 1037 "cminus.tab.c"
+        break;
+
+    case YYSYMBOL_expressao: /* expressao  */
+#line 67 "cminus.y"
+            { freeTree(((*yyvaluep).node)); }
+#line 1043 "cminus.tab.c"
+        break;
+
+    case YYSYMBOL_var: /* var  */
+#line 67 "cminus.y"
+            { freeTree(((*yyvaluep).node)); }
+#line 1049 "cminus.tab.c"
+        break;
+
+    case YYSYMBOL_expressao_simples: /* expressao_simples  */
+#line 67 "cminus.y"
+            { freeTree(((*yyvaluep).node)); }
+#line 1055 "cminus.tab.c"
+        break;
+
+    case YYSYMBOL_relacional: /* relacional  */
+#line 67 "cminus.y"
+            { freeTree(((*yyvaluep).node)); }
+#line 1061 "cminus.tab.c"
+        break;
+
+    case YYSYMBOL_termo: /* termo  */
+#line 67 "cminus.y"
+            { freeTree(((*yyvaluep).node)); }
+#line 1067 "cminus.tab.c"
+        break;
+
+    case YYSYMBOL_fator: /* fator  */
+#line 67 "cminus.y"
+            { freeTree(((*yyvaluep).node)); }
+#line 1073 "cminus.tab.c"
+        break;
+
+    case YYSYMBOL_ativacao: /* ativacao  */
+#line 67 "cminus.y"
+            { freeTree(((*yyvaluep).node)); }
+#line 1079 "cminus.tab.c"
+        break;
+
+    case YYSYMBOL_args: /* args  */
+#line 67 "cminus.y"
+            { freeTree(((*yyvaluep).node)); }
+#line 1085 "cminus.tab.c"
+        break;
+
+    case YYSYMBOL_arg_lista: /* arg_lista  */
+#line 67 "cminus.y"
+            { freeTree(((*yyvaluep).node)); }
+#line 1091 "cminus.tab.c"
+        break;
+
+      default:
+        break;
+    }
+  YY_IGNORE_MAYBE_UNINITIALIZED_END
+}
+
+
+
+
+
+
+/*----------.
+| yyparse.  |
+`----------*/
+
+int
+yyparse (CompilerContext* ctx)
+{
+/* Lookahead token kind.  */
+int yychar;
+
+
+/* The semantic value of the lookahead symbol.  */
+/* Default value used for initialization, for pacifying older GCCs
+   or non-GCC compilers.  */
+YY_INITIAL_VALUE (static YYSTYPE yyval_default;)
+YYSTYPE yylval YY_INITIAL_VALUE (= yyval_default);
+
+    /* Number of syntax errors so far.  */
+    int yynerrs = 0;
+
+    yy_state_fast_t yystate = 0;
+    /* Number of tokens to shift before error messages enabled.  */
+    int yyerrstatus = 0;
+
+    /* Refer to the stacks through separate pointers, to allow yyoverflow
+       to reallocate them elsewhere.  */
+
+    /* Their size.  */
+    YYPTRDIFF_T yystacksize = YYINITDEPTH;
+
+    /* The state stack: array, bottom, top.  */
+    yy_state_t yyssa[YYINITDEPTH];
+    yy_state_t *yyss = yyssa;
+    yy_state_t *yyssp = yyss;
+
+    /* The semantic value stack: array, bottom, top.  */
+    YYSTYPE yyvsa[YYINITDEPTH];
+    YYSTYPE *yyvs = yyvsa;
+    YYSTYPE *yyvsp = yyvs;
+
+  int yyn;
+  /* The return value of yyparse.  */
+  int yyresult;
+  /* Lookahead symbol kind.  */
+  yysymbol_kind_t yytoken = YYSYMBOL_YYEMPTY;
+  /* The variables used to return semantic value and location from the
+     action routines.  */
+  YYSTYPE yyval;
+
+
+
+#define YYPOPSTACK(N)   (yyvsp -= (N), yyssp -= (N))
+
+  /* The number of symbols on the RHS of the reduced rule.
+     Keep to zero when no symbol should be popped.  */
+  int yylen = 0;
+
+  YYDPRINTF ((stderr, "Starting parse\n"));
+
+  yychar = YYEMPTY; /* Cause a token to be read.  */
+
+  goto yysetstate;
+
+
+/*------------------------------------------------------------.
+| yynewstate -- push a new state, which is found in yystate.  |
+`------------------------------------------------------------*/
+yynewstate:
+  /* In all cases, when you get here, the value and location stacks
+     have just been pushed.  So pushing a state here evens the stacks.  */
+  yyssp++;
+
+
+/*--------------------------------------------------------------------.
+| yysetstate -- set current state (the top of the stack) to yystate.  |
+`--------------------------------------------------------------------*/
+yysetstate:
+  YYDPRINTF ((stderr, "Entering state %d\n", yystate));
+  YY_ASSERT (0 <= yystate && yystate < YYNSTATES);
+  YY_IGNORE_USELESS_CAST_BEGIN
+  *yyssp = YY_CAST (yy_state_t, yystate);
+  YY_IGNORE_USELESS_CAST_END
+  YY_STACK_PRINT (yyss, yyssp);
+
+  if (yyss + yystacksize - 1 <= yyssp)
+#if !defined yyoverflow && !defined YYSTACK_RELOCATE
+    YYNOMEM;
+#else
+    {
+      /* Get the current used size of the three stacks, in elements.  */
+      YYPTRDIFF_T yysize = yyssp - yyss + 1;
+
+# if defined yyoverflow
+      {
+        /* Give user a chance to reallocate the stack.  Use copies of
+           these so that the &'s don't force the real ones into
+           memory.  */
+        yy_state_t *yyss1 = yyss;
+        YYSTYPE *yyvs1 = yyvs;
+
+        /* Each stack pointer address is followed by the size of the
+           data in use in that stack, in bytes.  This used to be a
+           conditional around just the two extra args, but that might
+           be undefined if yyoverflow is a macro.  */
+        yyoverflow (YY_("memory exhausted"),
+                    &yyss1, yysize * YYSIZEOF (*yyssp),
+                    &yyvs1, yysize * YYSIZEOF (*yyvsp),
+                    &yystacksize);
+        yyss = yyss1;
+        yyvs = yyvs1;
+      }
+# else /* defined YYSTACK_RELOCATE */
+      /* Extend the stack our own way.  */
+      if (YYMAXDEPTH <= yystacksize)
+        YYNOMEM;
+      yystacksize *= 2;
+      if (YYMAXDEPTH < yystacksize)
+        yystacksize = YYMAXDEPTH;
+
+      {
+        yy_state_t *yyss1 = yyss;
+        union yyalloc *yyptr =
+          YY_CAST (union yyalloc *,
+                   YYSTACK_ALLOC (YY_CAST (YYSIZE_T, YYSTACK_BYTES (yystacksize))));
+        if (! yyptr)
+          YYNOMEM;
+        YYSTACK_RELOCATE (yyss_alloc, yyss);
+        YYSTACK_RELOCATE (yyvs_alloc, yyvs);
+#  undef YYSTACK_RELOCATE
+        if (yyss1 != yyssa)
+          YYSTACK_FREE (yyss1);
+      }
+# endif
+
+      yyssp = yyss + yysize - 1;
+      yyvsp = yyvs + yysize - 1;
+
+      YY_IGNORE_USELESS_CAST_BEGIN
+      YYDPRINTF ((stderr, "Stack size increased to %ld\n",
+                  YY_CAST (long, yystacksize)));
+      YY_IGNORE_USELESS_CAST_END
+
+      if (yyss + yystacksize - 1 <= yyssp)
+        YYABORT;
+    }
+#endif /* !defined yyoverflow && !defined YYSTACK_RELOCATE */
+
+
+  if (yystate == YYFINAL)
+    YYACCEPT;
+
+  goto yybackup;
+
+
+/*-----------.
+| yybackup.  |
+`-----------*/
+yybackup:
+  /* Do appropriate processing given the current state.  Read a
+     lookahead token if we need one and don't already have one.  */
+
+  /* First try to decide what to do without reference to lookahead token.  */
+  yyn = yypact[yystate];
+  if (yypact_value_is_default (yyn))
+    goto yydefault;
+
+  /* Not known => get a lookahead token if don't already have one.  */
+
+  /* YYCHAR is either empty, or end-of-input, or a valid lookahead.  */
+  if (yychar == YYEMPTY)
+    {
+      YYDPRINTF ((stderr, "Reading a token\n"));
+      yychar = yylex (&yylval, ctx);
+    }
+
+  if (yychar <= YYEOF)
+    {
+      yychar = YYEOF;
+      yytoken = YYSYMBOL_YYEOF;
+      YYDPRINTF ((stderr, "Now at end of input.\n"));
+    }
+  else if (yychar == YYerror)
+    {
+      /* The scanner already issued an error message, process directly
+         to error recovery.  But do not keep the error token as
+         lookahead, it is too special and may lead us to an endless
+         loop in error recovery. */
+      yychar = YYUNDEF;
+      yytoken = YYSYMBOL_YYerror;
+      goto yyerrlab1;
+    }
+  else
+    {
+      yytoken = YYTRANSLATE (yychar);
+      YY_SYMBOL_PRINT ("Next token is", yytoken, &yylval, &yylloc);
+    }
+
+  /* If the proper action on seeing token YYTOKEN is to reduce or to
+     detect an error, take that action.  */
+  yyn += yytoken;
+  if (yyn < 0 || YYLAST < yyn || yycheck[yyn] != yytoken)
+    goto yydefault;
+  yyn = yytable[yyn];
+  if (yyn <= 0)
+    {
+      if (yytable_value_is_error (yyn))
+        goto yyerrlab;
+      yyn = -yyn;
+      goto yyreduce;
+    }
+
+  /* Count tokens shifted since error; after three, turn off error
+     status.  */
+  if (yyerrstatus)
+    yyerrstatus--;
+
+  /* Shift the lookahead token.  */
+  YY_SYMBOL_PRINT ("Shifting", yytoken, &yylval, &yylloc);
+  yystate = yyn;
+  YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+  *++yyvsp = yylval;
+  YY_IGNORE_MAYBE_UNINITIALIZED_END
+
+  /* Discard the shifted token.  */
+  yychar = YYEMPTY;
+  goto yynewstate;
+
+
+/*-----------------------------------------------------------.
+| yydefault -- do the default action for the current state.  |
+`-----------------------------------------------------------*/
+yydefault:
+  yyn = yydefact[yystate];
+  if (yyn == 0)
+    goto yyerrlab;
+  goto yyreduce;
+
+
+/*-----------------------------.
+| yyreduce -- do a reduction.  |
+`-----------------------------*/
+yyreduce:
+  /* yyn is the number of a rule to reduce with.  */
+  yylen = yyr2[yyn];
+
+  /* If YYLEN is nonzero, implement the default value of the action:
+     '$$ = $1'.
+
+     Otherwise, the following line sets YYVAL to garbage.
+     This behavior is undocumented and Bison
+     users should not rely upon it.  Assigning to YYVAL
+     unconditionally makes the parser a bit smaller, and it avoids a
+     GCC warning that YYVAL may be used uninitialized.  */
+  yyval = yyvsp[1-yylen];
+
+
+  YY_REDUCE_PRINT (yyn);
+  switch (yyn)
+    {
+  case 2: /* programa: lista_declaracoes  */
+#line 80 "cminus.y"
+        {
+            if (ctx->onDecl == NULL)
+                ctx->savedTree = (yyvsp[0].node);
+            (yyval.node) = NULL;  // a arvore pertence a ctx->savedTree
+        }
+#line 1371 "cminus.tab.c"
+    break;
+
+  case 3: /* lista_declaracoes: lista_declaracoes declaracao  */
+#line 90 "cminus.y"
+        {
+            TreeNode* t = (yyvsp[-1].node);
+            if (ctx->onDecl != NULL) {
+                ctx->onDecl(ctx, (yyvsp[0].node));
+                (yyval.node) = NULL;
+            } else if (t != NULL) {
+                while (t->sibling != NULL)
+                    t = t->sibling;
+                t->sibling = (yyvsp[0].node);
+                (yyval.node) = (yyvsp[-1].node);
+            } else {
+                (yyval.node) = (yyvsp[0].node);
+            }
+        }
+#line 1390 "cminus.tab.c"
+    break;
+
+  case 4: /* lista_declaracoes: declaracao  */
+#line 105 "cminus.y"
+        {
+            if (ctx->onDecl != NULL) {
+                ctx->onDecl(ctx, (yyvsp[0].node));
+                (yyval.node) = NULL;
+            } else {
+                (yyval.node) = (yyvsp[0].node);
+            }
+        }
+#line 1403 "cminus.tab.c"
+    break;
+
+  case 5: /* declaracao: var_declaracao  */
+#line 117 "cminus.y"
+        { (yyval.node) = (yyvsp[0].node); }
+#line 1409 "cminus.tab.c"
+    break;
+
+  case 6: /* declaracao: func_declaracao  */
+#line 119 "cminus.y"
+        { (yyval.node) = (yyvsp[0].node); }
+#line 1415 "cminus.tab.c"
+    break;
+
+  case 7: /* var_declaracao: tipo_especificador ID PONTOEVIRGULA  */
+#line 124 "cminus.y"
+        {
+            (yyval.node) = newDeclNode(ctx, VarK);
+            (yyval.node)->attr.name = (yyvsp[-1].name);
+            (yyval.node)->type = ((yyvsp[-2].token) == INT) ? Integer : Void;
+        }
+#line 1425 "cminus.tab.c"
+    break;
+
+  case 8: /* var_declaracao: tipo_especificador ID LCOLCHETE NUM RCOLCHETE PONTOEVIRGULA  */
+#line 130 "cminus.y"
+        {
+            (yyval.node) = newDeclNode(ctx, ArrayK);
+            (yyval.node)->attr.name = (yyvsp[-4].name);
+            (yyval.node)->type = IntegerArray;
+            (yyval.node)->child[0] = newExpNode(ctx, ConstK);
+            (yyval.node)->child[0]->attr.val = (yyvsp[-2].val);
+        }
+#line 1437 "cminus.tab.c"
+    break;
+
+  case 9: /* tipo_especificador: INT  */
+#line 141 "cminus.y"
+        { (yyval.token) = INT; }
+#line 1443 "cminus.tab.c"
+    break;
+
+  case 10: /* tipo_especificador: VOID  */
+#line 143 "cminus.y"
+        { (yyval.token) = VOID; }
+#line 1449 "cminus.tab.c"
+    break;
+
+  case 11: /* func_declaracao: tipo_especificador ID LPARENTESES params RPARENTESES composto_decl  */
+#line 148 "cminus.y"
+        {
+            (yyval.node) = newDeclNode(ctx, FunK);
+            (yyval.node)->attr.name = (yyvsp[-4].name);
+            (yyval.node)->type = ((yyvsp[-5].token) == INT) ? Integer : Void;
+            (yyval.node)->child[0] = (yyvsp[-2].node);
+            (yyval.node)->child[1] = (yyvsp[0].node);
+        }
+#line 1461 "cminus.tab.c"
+    break;
+
+  case 12: /* params: param_lista  */
+#line 159 "cminus.y"
+        { (yyval.node) = (yyvsp[0].node); }
+#line 1467 "cminus.tab.c"
+    break;
+
+  case 13: /* params: VOID  */
+#line 161 "cminus.y"
+        { (yyval.node) = NULL; }
+#line 1473 "cminus.tab.c"
+    break;
+
+  case 14: /* param_lista: param_lista VIRGULA param  */
+#line 166 "cminus.y"
+        {
+            TreeNode* t = (yyvsp[-2].node);
+            if (t != NULL) {
+                while (t->sibling != NULL)
+                    t = t->sibling;
+                t->sibling = (yyvsp[0].node);
+                (yyval.node) = (yyvsp[-2].node);
+            } else {
+                (yyval.node) = (yyvsp[0].node);
+            }
+        }
+#line 1489 "cminus.tab.c"
+    break;
+
+  case 15: /* param_lista: param  */
+#line 178 "cminus.y"
+        { (yyval.node) = (yyvsp[0].node); }
+#line 1495 "cminus.tab.c"
+    break;
+
+  case 16: /* param: tipo_especificador ID  */
+#line 183 "cminus.y"
+        {
+            (yyval.node) = newDeclNode(ctx, ParamK);
+            (yyval.node)->attr.name = (yyvsp[0].name);
+            (yyval.node)->type = ((yyvsp[-1].token) == INT) ? Integer : Void;
+        }
+#line 1505 "cminus.tab.c"
+    break;
+
+  case 17: /* param: tipo_especificador ID LCOLCHETE RCOLCHETE  */
+#line 189 "cminus.y"
+        {
+            (yyval.node) = newDeclNode(ctx, ParamK);
+            (yyval.node)->attr.name = (yyvsp[-2].name);
+            (yyval.node)->type = IntegerArray;
+        }
+#line 1515 "cminus.tab.c"
+    break;
+
+  case 18: /* composto_decl: LCHAVE local_declaracoes statement_lista RCHAVE  */
+#line 199 "cminus.y"
+        {
+            (yyval.node) = newStmtNode(ctx, CompoundK);
+            (yyval.node)->child[0] = (yyvsp[-2].node);
+            (yyval.node)->child[1] = (yyvsp[-1].node);
+        }
+#line 1525 "cminus.tab.c"
+    break;
+
+  case 19: /* local_declaracoes: local_declaracoes var_declaracao  */
+#line 208 "cminus.y"
+        {
+            TreeNode* t = (yyvsp[-1].node);
+            if (t != NULL) {
+                while (t->sibling != NULL)
+                    t = t->sibling;
+                t->sibling = (yyvsp[0].node);
+                (yyval.node) = (yyvsp[-1].node);
+            } else {
+                (yyval.node) = (yyvsp[0].node);
+            }
+        }
+#line 1541 "cminus.tab.c"
+    break;
+
+  case 20: /* local_declaracoes: %empty  */
+#line 220 "cminus.y"
+        { (yyval.node) = NULL; }
+#line 1547 "cminus.tab.c"
+    break;
+
+  case 21: /* statement_lista: statement_lista statement  */
+#line 227 "cminus.y"
+        {
+            TreeNode* t = (yyvsp[-1].node);
+            if (t != NULL) {
+                while (t->sibling != NULL)
+                    t = t->sibling;
+                t->sibling = (yyvsp[0].node);
+                (yyval.node) = (yyvsp[-1].node);
+            } else {
+                (yyval.node) = (yyvsp[0].node);
+            }
+        }
+#line 1563 "cminus.tab.c"
+    break;
+
+  case 22: /* statement_lista: %empty  */
+#line 239 "cminus.y"
+        { (yyval.node) = NULL; }
+#line 1569 "cminus.tab.c"
+    break;
+
+  case 23: /* statement: expressao_decl  */
+#line 244 "cminus.y"
+        { (yyval.node) = (yyvsp[0].node); }
+#line 1575 "cminus.tab.c"
+    break;
+
+  case 24: /* statement: composto_decl  */
+#line 246 "cminus.y"
+        { (yyval.node) = (yyvsp[0].node); }
+#line 1581 "cminus.tab.c"
+    break;
+
+  case 25: /* statement: selecao_decl  */
+#line 248 "cminus.y"
+        { (yyval.node) = (yyvsp[0].node); }
+#line 1587 "cminus.tab.c"
+    break;
+
+  case 26: /* statement: iteracao_decl  */
+#line 250 "cminus.y"
+        { (yyval.node) = (yyvsp[0].node); }
+#line 1593 "cminus.tab.c"
+    break;
+
+  case 27: /* statement: retorno_decl  */
+#line 252 "cminus.y"
+        { (yyval.node) = (yyvsp[0].node); }
+#line 1599 "cminus.tab.c"
+    break;
+
+  case 28: /* expressao_decl: expressao PONTOEVIRGULA  */
+#line 257 "cminus.y"
+        { (yyval.node) = (yyvsp[-1].node); }
+#line 1605 "cminus.tab.c"
+    break;
+
+  case 29: /* expressao_decl: PONTOEVIRGULA  */
+#line 259 "cminus.y"
+        { (yyval.node) = NULL; }
+#line 1611 "cminus.tab.c"
+    break;
+
+  case 30: /* selecao_decl: IF LPARENTESES expressao RPARENTESES statement  */
+#line 264 "cminus.y"
+        {
+            (yyval.node) = newStmtNode(ctx, IfK);
+            (yyval.node)->child[0] = (yyvsp[-2].node);
+            (yyval.node)->child[1] = (yyvsp[0].node);
+        }
+#line 1621 "cminus.tab.c"
+    break;
+
+  case 31: /* selecao_decl: IF LPARENTESES expressao RPARENTESES statement ELSE statement  */
+#line 270 "cminus.y"
+        {
+            (yyval.node) = newStmtNode(ctx, IfK);
+            (yyval.node)->child[0] = (yyvsp[-4].node);
+            (yyval.node)->child[1] = (yyvsp[-2].node);
+            (yyval.node)->child[2] = (yyvsp[0].node);
+        }
+#line 1632 "cminus.tab.c"
+    break;
+
+  case 32: /* iteracao_decl: WHILE LPARENTESES expressao RPARENTESES statement  */
+#line 280 "cminus.y"
+        {
+            (yyval.node) = newStmtNode(ctx, WhileK);
+            (yyval.node)->child[0] = (yyvsp[-2].node);
+            (yyval.node)->child[1] = (yyvsp[0].node);
+        }
+#line 1642 "cminus.tab.c"
+    break;
+
+  case 33: /* retorno_decl: RETURN PONTOEVIRGULA  */
+#line 289 "cminus.y"
+        {
+            (yyval.node) = newStmtNode(ctx, ReturnK);
+        }
+#line 1650 "cminus.tab.c"
+    break;
+
+  case 34: /* retorno_decl: RETURN expressao PONTOEVIRGULA  */
+#line 293 "cminus.y"
+        {
+            (yyval.node) = newStmtNode(ctx, ReturnK);
+            (yyval.node)->child[0] = (yyvsp[-1].node);
+        }
+#line 1659 "cminus.tab.c"
+    break;
+
+  case 35: /* expressao: var ATRIBUICAO expressao  */
+#line 301 "cminus.y"
+        {
+            (yyval.node) = newStmtNode(ctx, AssignK);
+            (yyval.node)->child[0] = (yyvsp[-2].node);
+            (yyval.node)->child[1] = (yyvsp[0].node);
+        }
+#line 1669 "cminus.tab.c"
+    break;
+
+  case 36: /* expressao: expressao_simples  */
+#line 307 "cminus.y"
+        { (yyval.node) = (yyvsp[0].node); }
+#line 1675 "cminus.tab.c"
+    break;
+
+  case 37: /* var: ID  */
+#line 312 "cminus.y"
+        {
+            (yyval.node) = newExpNode(ctx, IdK);
+            (yyval.node)->attr.name = (yyvsp[0].name);
+        }
+#line 1684 "cminus.tab.c"
+    break;
+
+  case 38: /* var: ID LCOLCHETE expressao RCOLCHETE  */
+#line 317 "cminus.y"
+        {
+            (yyval.node) = newExpNode(ctx, IdK);
+            (yyval.node)->attr.name = (yyvsp[-3].name);
+            (yyval.node)->child[0] = (yyvsp[-1].node);
+        }
+#line 1694 "cminus.tab.c"
+    break;
+
+  case 39: /* expressao_simples: expressao_simples relop relacional  */
+#line 326 "cminus.y"
+        {
+            (yyval.node) = newExpNode(ctx, OpK);
+            (yyval.node)->attr.op = (yyvsp[-1].token);
+            (yyval.node)->child[0] = (yyvsp[-2].node);
+            (yyval.node)->child[1] = (yyvsp[0].node);
+        }
+#line 1705 "cminus.tab.c"
+    break;
+
+  case 40: /* expressao_simples: relacional  */
+#line 333 "cminus.y"
+        { (yyval.node) = (yyvsp[0].node); }
+#line 1711 "cminus.tab.c"
+    break;
+
+  case 41: /* relop: MENORIGUAL  */
+#line 338 "cminus.y"
+        { (yyval.token) = MENORIGUAL; }
+#line 1717 "cminus.tab.c"
+    break;
+
+  case 42: /* relop: MENOR  */
+#line 340 "cminus.y"
+        { (yyval.token) = MENOR; }
+#line 1723 "cminus.tab.c"
+    break;
+
+  case 43: /* relop: MAIOR  */
+#line 342 "cminus.y"
+        { (yyval.token) = MAIOR; }
+#line 1729 "cminus.tab.c"
+    break;
+
+  case 44: /* relop: MAIORIGUAL  */
+#line 344 "cminus.y"
+        { (yyval.token) = MAIORIGUAL; }
+#line 1735 "cminus.tab.c"
+    break;
+
+  case 45: /* relop: IGUAL  */
+#line 346 "cminus.y"
+        { (yyval.token) = IGUAL; }
+#line 1741 "cminus.tab.c"
+    break;
+
+  case 46: /* relop: DIFERENTE  */
+#line 348 "cminus.y"
+        { (yyval.token) = DIFERENTE; }
+#line 1747 "cminus.tab.c"
+    break;
+
+  case 47: /* relacional: relacional soma termo  */
+#line 353 "cminus.y"
+        {
+            (yyval.node) = newExpNode(ctx, OpK);
+            (yyval.node)->attr.op = (yyvsp[-1].token);
+            (yyval.node)->child[0] = (yyvsp[-2].node);
+            (yyval.node)->child[1] = (yyvsp[0].node);
+        }
+#line 1758 "cminus.tab.c"
+    break;
+
+  case 48: /* relacional: termo  */
+#line 360 "cminus.y"
+        { (yyval.node) = (yyvsp[0].node); }
+#line 1764 "cminus.tab.c"
+    break;
+
+  case 49: /* soma: MAIS  */
+#line 365 "cminus.y"
+        { (yyval.token) = MAIS; }
+#line 1770 "cminus.tab.c"
+    break;
+
+  case 50: /* soma: MENOS  */
+#line 367 "cminus.y"
+        { (yyval.token) = MENOS; }
+#line 1776 "cminus.tab.c"
+    break;
+
+  case 51: /* termo: termo mult fator  */
+#line 372 "cminus.y"
+        {
+            (yyval.node) = newExpNode(ctx, OpK);
+            (yyval.node)->attr.op = (yyvsp[-1].token);
+            (yyval.node)->child[0] = (yyvsp[-2].node);
+            (yyval.node)->child[1] = (yyvsp[0].node);
+        }
+#line 1787 "cminus.tab.c"
+    break;
+
+  case 52: /* termo: fator  */
+#line 379 "cminus.y"
+        { (yyval.node) = (yyvsp[0].node); }
+#line 1793 "cminus.tab.c"
+    break;
+
+  case 53: /* mult: VEZES  */
+#line 384 "cminus.y"
+        { (yyval.token) = VEZES; }
+#line 1799 "cminus.tab.c"
+    break;
+
+  case 54: /* mult: SOBRE  */
+#line 386 "cminus.y"
+        { (yyval.token) = SOBRE; }
+#line 1805 "cminus.tab.c"
+    break;
+
+  case 55: /* fator: LPARENTESES expressao RPARENTESES  */
+#line 391 "cminus.y"
+        { (yyval.node) = (yyvsp[-1].node); }
+#line 1811 "cminus.tab.c"
+    break;
+
+  case 56: /* fator: var  */
+#line 393 "cminus.y"
+        { (yyval.node) = (yyvsp[0].node); }
+#line 1817 "cminus.tab.c"
+    break;
+
+  case 57: /* fator: ativacao  */
+#line 395 "cminus.y"
+        { (yyval.node) = (yyvsp[0].node); }
+#line 1823 "cminus.tab.c"
+    break;
+
+  case 58: /* fator: NUM  */
+#line 397 "cminus.y"
+        {
+            (yyval.node) = newExpNode(ctx, ConstK);
+            (yyval.node)->attr.val = (yyvsp[0].val);
+        }
+#line 1832 "cminus.tab.c"
+    break;
+
+  case 59: /* ativacao: ID LPARENTESES args RPARENTESES  */
+#line 405 "cminus.y"
+        {
+            (yyval.node) = newExpNode(ctx, CallK);
+            (yyval.node)->attr.name = (yyvsp[-3].name);
+            (yyval.node)->child[0] = (yyvsp[-1].node);
+        }
+#line 1842 "cminus.tab.c"
+    break;
+
+  case 60: /* args: arg_lista  */
+#line 414 "cminus.y"
+        { (yyval.node) = (yyvsp[0].node); }
+#line 1848 "cminus.tab.c"
+    break;
+
+  case 61: /* args: %empty  */
+#line 416 "cminus.y"
+        { (yyval.node) = NULL; }
+#line 1854 "cminus.tab.c"
+    break;
+
+  case 62: /* arg_lista: arg_lista VIRGULA expressao  */
+#line 421 "cminus.y"
+        {
+            TreeNode* t = (yyvsp[-2].node);
+            if (t != NULL) {
+                while (t->sibling != NULL)
+                    t = t->sibling;
+                t->sibling = (yyvsp[0].node);
+                (yyval.node) = (yyvsp[-2].node);
+            } else {
+                (yyval.node) = (yyvsp[0].node);
+            }
+        }
+#line 1870 "cminus.tab.c"
+    break;
+
+  case 63: /* arg_lista: expressao  */
+#line 433 "cminus.y"
+        { (yyval.node) = (yyvsp[0].node); }
+#line 1876 "cminus.tab.c"
+    break;
+
+
+#line 1880 "cminus.tab.c"
+
+      default: break;
+    }
+  /* User semantic actions sometimes alter yychar, and that requires
+     that yytoken be updated with the new translation.  We take the
+     approach of translating immediately before every use of yytoken.
+     One alternative is translating here after every semantic action,
+     but that translation would be missed if the semantic action invokes
+     YYABORT, YYACCEPT, or YYERROR immediately after altering yychar or
+     if it invokes YYBACKUP.  In the case of YYABORT or YYACCEPT, an
+     incorrect destructor might then be invoked immediately.  In the
+     case of YYERROR or YYBACKUP, subsequent parser actions might lead
+     to an incorrect destructor call or verbose syntax error message
+     before the lookahead is translated.  */
+  YY_SYMBOL_PRINT ("-> $$ =", YY_CAST (yysymbol_kind_t, yyr1[yyn]), &yyval, &yyloc);
+
+  YYPOPSTACK (yylen);
+  yylen = 0;
+
+  *++yyvsp = yyval;
+
+  /* Now 'shift' the result of the reduction.  Determine what state
+     that goes to, based on the state we popped back to and the rule
+     number reduced by.  */
+  {
+    const int yylhs = yyr1[yyn] - YYNTOKENS;
+    const int yyi = yypgoto[yylhs] + *yyssp;
+    yystate = (0 <= yyi && yyi <= YYLAST && yycheck[yyi] == *yyssp
+               ? yytable[yyi]
+               : yydefgoto[yylhs]);
+  }
+
+  goto yynewstate;
+
+
+/*--------------------------------------.
+| yyerrlab -- here on detecting error.  |
+`--------------------------------------*/
+yyerrlab:
+  /* Make sure we have latest lookahead translation.  See comments at
+     user semantic actions for why this is necessary.  */
+  yytoken = yychar == YYEMPTY ? YYSYMBOL_YYEMPTY : YYTRANSLATE (yychar);
+  /* If not already recovering from an error, report this error.  */
+  if (!yyerrstatus)
+    {
+      ++yynerrs;
+      yyerror (ctx, YY_("syntax error"));
+    }
+
+  if (yyerrstatus == 3)
+    {
+      /* If just tried and failed to reuse lookahead token after an
+         error, discard it.  */
+
+      if (yychar <= YYEOF)
+        {
+          /* Return failure if at end of input.  */
+          if (yychar == YYEOF)
+            YYABORT;
+        }
+      else
+        {
+          yydestruct ("Error: discarding",
+                      yytoken, &yylval, ctx);
+          yychar = YYEMPTY;
+        }
+    }
+
+  /* Else will try to reuse lookahead token after shifting the error
+     token.  */
+  goto yyerrlab1;
+
+
+/*---------------------------------------------------.
+| yyerrorlab -- error raised explicitly by YYERROR.  |
+`---------------------------------------------------*/
+yyerrorlab:
+  /* Pacify compilers when the user code never invokes YYERROR and the
+     label yyerrorlab therefore never appears in user code.  */
+  if (0)
+    YYERROR;
+  ++yynerrs;
+
+  /* Do not reclaim the symbols of the rule whose action triggered
+     this YYERROR.  */
+  YYPOPSTACK (yylen);
+  yylen = 0;
+  YY_STACK_PRINT (yyss, yyssp);
+  yystate = *yyssp;
+  goto yyerrlab1;
+
+
+/*-------------------------------------------------------------.
+| yyerrlab1 -- common code for both syntax error and YYERROR.  |
+`-------------------------------------------------------------*/
+yyerrlab1:
+  yyerrstatus = 3;      /* Each real token shifted decrements this.  */
+
+  /* Pop stack until we find a state that shifts the error token.  */
+  for (;;)
+    {
+      yyn = yypact[yystate];
+      if (!yypact_value_is_default (yyn))
+        {
+          yyn += YYSYMBOL_YYerror;
+          if (0 <= yyn && yyn <= YYLAST && yycheck[yyn] == YYSYMBOL_YYerror)
+            {
+              yyn = yytable[yyn];
+              if (0 < yyn)
+                break;
+            }
+        }
+
+      /* Pop the current state because it cannot handle the error token.  */
+      if (yyssp == yyss)
+        YYABORT;
+
+
+      yydestruct ("Error: popping",
+                  YY_ACCESSING_SYMBOL (yystate), yyvsp, ctx);
+      YYPOPSTACK (1);
+      yystate = *yyssp;
+      YY_STACK_PRINT (yyss, yyssp);
+    }
+
+  YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+  *++yyvsp = yylval;
+  YY_IGNORE_MAYBE_UNINITIALIZED_END
+
+
+  /* Shift the error token.  */
+  YY_SYMBOL_PRINT ("Shifting", YY_ACCESSING_SYMBOL (yyn), yyvsp, yylsp);
+
+  yystate = yyn;
+  goto yynewstate;
+
+
+/*-------------------------------------.
+| yyacceptlab -- YYACCEPT comes here.  |
+`-------------------------------------*/
+yyacceptlab:
+  yyresult = 0;
+  goto yyreturnlab;
+
+
+/*-----------------------------------.
+| yyabortlab -- YYABORT comes here.  |
+`-----------------------------------*/
+yyabortlab:
+  yyresult = 1;
+  goto yyreturnlab;
+
+
+/*-----------------------------------------------------------.
+| yyexhaustedlab -- YYNOMEM (memory exhaustion) comes here.  |
+`-----------------------------------------------------------*/
+yyexhaustedlab:
+  yyerror (ctx, YY_("memory exhausted"));
+  yyresult = 2;
+  goto yyreturnlab;
+
+
+/*----------------------------------------------------------.
+| yyreturnlab -- parsing is finished, clean up and return.  |
+`----------------------------------------------------------*/
+yyreturnlab:
+  if (yychar != YYEMPTY)
+    {
+      /* Make sure we have latest lookahead translation.  See comments at
+         user semantic actions for why this is necessary.  */
+      yytoken = YYTRANSLATE (yychar);
+      yydestruct ("Cleanup: discarding lookahead",
+                  yytoken, &yylval, ctx);
+    }
+  /* Do not reclaim the symbols of the rule whose action triggered
+     this YYABORT or YYACCEPT.  */
+  YYPOPSTACK (yylen);
+  YY_STACK_PRINT (yyss, yyssp);
+  while (yyssp != yyss)
+    {
+      yydestruct ("Cleanup: popping",
+                  YY_ACCESSING_SYMBOL (+*yyssp), yyvsp, ctx);
+      YYPOPSTACK (1);
+    }
+#ifndef yyoverflow
+  if (yyss != yyssa)
+    YYSTACK_FREE (yyss);
+#endif
+
+  return yyresult;
+}
+
+#line 436 "cminus.y"
+
+
+/**
+ * @brief Funcao de tratamento de erros sintaticos
+ * @param ctx Contexto da compilacao
+ * @param message Mensagem de erro
+ */
+void yyerror(CompilerContext* ctx, const char* message) {
+    fprintf(ctx->errors, "ERRO SINTATICO: %s LINHA: %d\n", message, ctx->lineno);
+    ctx->error = TRUE;
+}
@@ -0,0 +1,143 @@
+/* A Bison parser, made by GNU Bison 3.8.2.  */
+
+/* Bison interface for Yacc-like parsers in C
+
+   Copyright (C) 1984, 1989-1990, 2000-2015, 2018-2021 Free Software Foundation,
+   Inc.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+/* As a special exception, you may create a larger work that contains
+   part or all of the Bison parser skeleton and distribute that work
+   under terms of your choice, so long as that work isn't itself a
+   parser generator using the skeleton or a modified version thereof
+   as a parser skeleton.  Alternatively, if you modify or redistribute
+   the parser skeleton itself, you may (at your option) remove this
+   special exception, which will cause the skeleton and the resulting
+   Bison output files to be licensed under the GNU General Public
+   License without this special exception.
+
+   This special exception was added by the Free Software Foundation in
+   version 2.2 of Bison.  */
+
+/* DO NOT RELY ON FEATURES THAT ARE NOT DOCUMENTED in the manual,
+   especially those whose name start with YY_ or yy_.  They are
+   private implementation details that can be changed or removed.  */
+
+#ifndef YY_YY_CMINUS_TAB_H_INCLUDED
+# define YY_YY_CMINUS_TAB_H_INCLUDED
+/* Debug traces.  */
+#ifndef YYDEBUG
+# define YYDEBUG 0
+#endif
+#if YYDEBUG
+extern int yydebug;
+#endif
+/* "%code requires" blocks.  */
+#line 6 "cminus.y"
+
+#include "globals.h"
+
+#line 53 "cminus.tab.h"
+
+/* Token kinds.  */
+#ifndef YYTOKENTYPE
+# define YYTOKENTYPE
+  enum yytokentype
+  {
+    YYEMPTY = -2,
+    YYEOF = 0,                     /* "end of file"  */
+    YYerror = 256,                 /* error  */
+    YYUNDEF = 257,                 /* "invalid token"  */
+    ID = 258,                      /* ID  */
+    NUM = 259,                     /* NUM  */
+    ELSE = 260,                    /* ELSE  */
+    IF = 261,                      /* IF  */
+    INT = 262,                     /* INT  */
+    RETURN = 263,                  /* RETURN  */
+    VOID = 264,                    /* VOID  */
+    WHILE = 265,                   /* WHILE  */
+    ATRIBUICAO = 266,              /* ATRIBUICAO  */
+    IGUAL = 267,                   /* IGUAL  */
+    MENOR = 268,                   /* MENOR  */
+    MENORIGUAL = 269,              /* MENORIGUAL  */
+    MAIOR = 270,                   /* MAIOR  */
+    MAIORIGUAL = 271,              /* MAIORIGUAL  */
+    DIFERENTE = 272,               /* DIFERENTE  */
+    MAIS = 273,                    /* MAIS  */
+    MENOS = 274,                   /* MENOS  */
+    VEZES = 275,                   /* VEZES  */
+    SOBRE = 276,                   /* SOBRE  */
+    LPARENTESES = 277,             /* LPARENTESES  */
+    RPARENTESES = 278,             /* RPARENTESES  */
+    LCOLCHETE = 279,               /* LCOLCHETE  */
+    RCOLCHETE = 280,               /* RCOLCHETE  */
+    LCHAVE = 281,                  /* LCHAVE  */
+    RCHAVE = 282,                  /* RCHAVE  */
+    PONTOEVIRGULA = 283,           /* PONTOEVIRGULA  */
+    VIRGULA = 284,                 /* VIRGULA  */
+    ERROR = 285,                   /* ERROR  */
+    ENDFILE = 286                  /* ENDFILE  */
+  };
+  typedef enum yytokentype yytoken_kind_t;
+#endif
+
+/* Value type.  */
+#if ! defined YYSTYPE && ! defined YYSTYPE_IS_DECLARED
+union YYSTYPE
+{
+#line 17 "cminus.y"
+
+    TreeNode* node;
+    int val;
+    char* name;
+    TokenType token;
+
+#line 108 "cminus.tab.h"
+
+};
+typedef union YYSTYPE YYSTYPE;
+# define YYSTYPE_IS_TRIVIAL 1
+# define YYSTYPE_IS_DECLARED 1
+#endif
+
+
+
+
+int yyparse (CompilerContext* ctx);
+
+/* "%code provides" blocks.  */
+#line 33 "cminus.y"
+
+/**
+ * @brief Analisa um programa em memoria (scanner reentrante em cminus.l)
+ * @param ctx Contexto da compilacao
+ * @param src Codigo fonte (com ctx->scanInPlace, seguido de dois '\0' e alteravel)
+ * @param len Tamanho do codigo fonte
+ * @return 0 se sucesso, diferente de 0 se erro
+ */
+int cminus_parse(CompilerContext* ctx, const char* src, size_t len);
+
+/**
+ * @brief Imprime os tokens de um programa (linha, codigo e valor) em ctx->listing
+ * @param ctx Contexto da compilacao (ctx->lexer escolhe o scanner)
+ * @param src Codigo fonte
+ * @param len Tamanho do codigo fonte
+ * @return 0 se sucesso, 1 se houve erro lexico
+ */
+int cminus_dump_tokens(CompilerContext* ctx, const char* src, size_t len);
+
+#line 142 "cminus.tab.h"
+
+#endif /* !YY_YY_CMINUS_TAB_H_INCLUDED  */
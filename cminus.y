@@ -3,17 +3,17 @@
  * @brief Analisador sintatico para a linguagem C-
  */
 
-%{
+%code requires {
 #include "globals.h"
-#include "util.h"
-
-TreeNode* savedTree;
+}
 
-extern int lineno;
-extern int yylex(void);
-void yyerror(const char* message);
+%{
+#include "util.h"
 %}
 
+%define api.pure full
+%param { CompilerContext* ctx }
+
 %union {
     TreeNode* node;
     int val;
@@ -30,6 +30,31 @@ void yyerror(const char* message);
 %token PONTOEVIRGULA VIRGULA
 %token ERROR ENDFILE
 
+%code provides {
+/**
+ * @brief Analisa um programa em memoria (scanner reentrante em cminus.l)
+ * @param ctx Contexto da compilacao
+ * @param src Codigo fonte (com ctx->scanInPlace, seguido de dois '\0' e alteravel)
+ * @param len Tamanho do codigo fonte
+ * @return 0 se sucesso, diferente de 0 se erro
+ */
+int cminus_parse(CompilerContext* ctx, const char* src, size_t len);
+
+/**
+ * @brief Imprime os tokens de um programa (linha, codigo e valor) em ctx->listing
+ * @param ctx Contexto da compilacao (ctx->lexer escolhe o scanner)
+ * @param src Codigo fonte
+ * @param len Tamanho do codigo fonte
+ * @return 0 se sucesso, 1 se houve erro lexico
+ */
+int cminus_dump_tokens(CompilerContext* ctx, const char* src, size_t len);
+}
+
+%code {
+int yylex(YYSTYPE* lvalp, CompilerContext* ctx);
+void yyerror(CompilerContext* ctx, const char* message);
+}
+
 %type <node> programa lista_declaracoes declaracao var_declaracao func_declaracao
 %type <node> params param_lista param composto_decl local_declaracoes
 %type <node> statement_lista statement expressao_decl selecao_decl iteracao_decl
@@ -37,6 +62,11 @@ void yyerror(const char* message);
 %type <node> ativacao args arg_lista
 %type <token> relop soma mult tipo_especificador
 
+// valores descartados da pilha quando o parser desiste em um erro sintatico
+// (sem isso cada erro vaza a arvore parcial, o que pesa no --watch)
+%destructor { freeTree($$); } <node>
+%destructor { free($$); } <name>
+
 %right ATRIBUICAO
 %left IGUAL DIFERENTE
 %left MENOR MENORIGUAL MAIOR MAIORIGUAL
@@ -47,14 +77,22 @@ void yyerror(const char* message);
 
 programa
     : lista_declaracoes
-        { savedTree = $1; }
+        {
+            if (ctx->onDecl == NULL)
+                ctx->savedTree = $1;
+            $$ = NULL;  // a arvore pertence a ctx->savedTree
+        }
     ;
 
+// no modo streaming cada declaracao global e entregue a ctx->onDecl assim que reduzida
 lista_declaracoes
     : lista_declaracoes declaracao
         {
             TreeNode* t = $1;
-            if (t != NULL) {
+            if (ctx->onDecl != NULL) {
+                ctx->onDecl(ctx, $2);
+                $$ = NULL;
+            } else if (t != NULL) {
                 while (t->sibling != NULL)
                     t = t->sibling;
                 t->sibling = $2;
@@ -64,7 +102,14 @@ lista_declaracoes
             }
         }
     | declaracao
-        { $$ = $1; }
+        {
+            if (ctx->onDecl != NULL) {
+                ctx->onDecl(ctx, $1);
+                $$ = NULL;
+            } else {
+                $$ = $1;
+            }
+        }
     ;
 
 declaracao
@@ -77,16 +122,16 @@ declaracao
 var_declaracao
     : tipo_especificador ID PONTOEVIRGULA
         {
-            $$ = newDeclNode(VarK);
+            $$ = newDeclNode(ctx, VarK);
             $$->attr.name = $2;
             $$->type = ($1 == INT) ? Integer : Void;
         }
     | tipo_especificador ID LCOLCHETE NUM RCOLCHETE PONTOEVIRGULA
         {
-            $$ = newDeclNode(ArrayK);
+            $$ = newDeclNode(ctx, ArrayK);
             $$->attr.name = $2;
             $$->type = IntegerArray;
-            $$->child[0] = newExpNode(ConstK);
+            $$->child[0] = newExpNode(ctx, ConstK);
             $$->child[0]->attr.val = $4;
         }
     ;
@@ -101,7 +146,7 @@ tipo_especificador
 func_declaracao
     : tipo_especificador ID LPARENTESES params RPARENTESES composto_decl
         {
-            $$ = newDeclNode(FunK);
+            $$ = newDeclNode(ctx, FunK);
             $$->attr.name = $2;
             $$->type = ($1 == INT) ? Integer : Void;
             $$->child[0] = $4;
@@ -136,13 +181,13 @@ param_lista
 param
     : tipo_especificador ID
         {
-            $$ = newDeclNode(ParamK);
+            $$ = newDeclNode(ctx, ParamK);
             $$->attr.name = $2;
             $$->type = ($1 == INT) ? Integer : Void;
         }
     | tipo_especificador ID LCOLCHETE RCOLCHETE
         {
-            $$ = newDeclNode(ParamK);
+            $$ = newDeclNode(ctx, ParamK);
             $$->attr.name = $2;
             $$->type = IntegerArray;
         }
@@ -152,7 +197,7 @@ param
 composto_decl
     : LCHAVE local_declaracoes statement_lista RCHAVE
         {
-            $$ = newStmtNode(CompoundK);
+            $$ = newStmtNode(ctx, CompoundK);
             $$->child[0] = $2;
             $$->child[1] = $3;
         }
@@ -217,13 +262,13 @@ expressao_decl
 selecao_decl
     : IF LPARENTESES expressao RPARENTESES statement
         {
-            $$ = newStmtNode(IfK);
+            $$ = newStmtNode(ctx, IfK);
             $$->child[0] = $3;
             $$->child[1] = $5;
         }
     | IF LPARENTESES expressao RPARENTESES statement ELSE statement
         {
-            $$ = newStmtNode(IfK);
+            $$ = newStmtNode(ctx, IfK);
             $$->child[0] = $3;
             $$->child[1] = $5;
             $$->child[2] = $7;
@@ -233,7 +278,7 @@ selecao_decl
 iteracao_decl
     : WHILE LPARENTESES expressao RPARENTESES statement
         {
-            $$ = newStmtNode(WhileK);
+            $$ = newStmtNode(ctx, WhileK);
             $$->child[0] = $3;
             $$->child[1] = $5;
         }
@@ -242,11 +287,11 @@ iteracao_decl
 retorno_decl
     : RETURN PONTOEVIRGULA
         {
-            $$ = newStmtNode(ReturnK);
+            $$ = newStmtNode(ctx, ReturnK);
         }
     | RETURN expressao PONTOEVIRGULA
         {
-            $$ = newStmtNode(ReturnK);
+            $$ = newStmtNode(ctx, ReturnK);
             $$->child[0] = $2;
         }
     ;
@@ -254,7 +299,7 @@ retorno_decl
 expressao
     : var ATRIBUICAO expressao
         {
-            $$ = newStmtNode(AssignK);
+            $$ = newStmtNode(ctx, AssignK);
             $$->child[0] = $1;
             $$->child[1] = $3;
         }
@@ -265,12 +310,12 @@ expressao
 var
     : ID
         {
-            $$ = newExpNode(IdK);
+            $$ = newExpNode(ctx, IdK);
             $$->attr.name = $1;
         }
     | ID LCOLCHETE expressao RCOLCHETE
         {
-            $$ = newExpNode(IdK);
+            $$ = newExpNode(ctx, IdK);
             $$->attr.name = $1;
             $$->child[0] = $3;
         }
@@ -279,7 +324,7 @@ var
 expressao_simples
     : expressao_simples relop relacional
         {
-            $$ = newExpNode(OpK);
+            $$ = newExpNode(ctx, OpK);
             $$->attr.op = $2;
             $$->child[0] = $1;
             $$->child[1] = $3;
@@ -306,7 +351,7 @@ relop
 relacional
     : relacional soma termo
         {
-            $$ = newExpNode(OpK);
+            $$ = newExpNode(ctx, OpK);
             $$->attr.op = $2;
             $$->child[0] = $1;
             $$->child[1] = $3;
@@ -325,7 +370,7 @@ soma
 termo
     : termo mult fator
         {
-            $$ = newExpNode(OpK);
+            $$ = newExpNode(ctx, OpK);
             $$->attr.op = $2;
             $$->child[0] = $1;
             $$->child[1] = $3;
@@ -350,7 +395,7 @@ fator
         { $$ = $1; }
     | NUM
         {
-            $$ = newExpNode(ConstK);
+            $$ = newExpNode(ctx, ConstK);
             $$->attr.val = $1;
         }
     ;
@@ -358,7 +403,7 @@ fator
 ativacao
     : ID LPARENTESES args RPARENTESES
         {
-            $$ = newExpNode(CallK);
+            $$ = newExpNode(ctx, CallK);
             $$->attr.name = $1;
             $$->child[0] = $3;
         }
@@ -392,9 +437,10 @@ arg_lista
 
 /**
  * @brief Funcao de tratamento de erros sintaticos
+ * @param ctx Contexto da compilacao
  * @param message Mensagem de erro
  */
-void yyerror(const char* message) {
-    fprintf(stderr, "ERRO SINTATICO: %s LINHA: %d\n", message, lineno);
-    Error = TRUE;
+void yyerror(CompilerContext* ctx, const char* message) {
+    fprintf(ctx->errors, "ERRO SINTATICO: %s LINHA: %d\n", message, ctx->lineno);
+    ctx->error = TRUE;
 }
@@ -0,0 +1,221 @@
+/**
+ * @file cminusc.c
+ * @brief Cliente do servidor de compilacao (cminus --serve)
+ *
+ * Envia o arquivo ao servidor e imprime a listagem e os erros como o
+ * proprio cminus faria, sem iniciar o compilador a cada chamada.
+ */
+
+#include "globals.h"
+#include "rpc.h"
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/**
+ * @brief Le um arquivo inteiro
+ * @param path Caminho
+ * @param len Tamanho lido
+ * @return Conteudo alocado ou NULL se erro
+ */
+static char* readFile(const char* path, size_t* len) {
+    FILE* f = fopen(path, "rb");
+    size_t cap = 4096, n = 0, r;
+    char* buf;
+    if (f == NULL)
+        return NULL;
+    buf = (char*)malloc(cap);
+    while (buf != NULL && (r = fread(buf + n, 1, cap - n, f)) > 0) {
+        n += r;
+        if (n == cap) {
+            char* p = (char*)realloc(buf, cap * 2);
+            if (p == NULL) {
+                free(buf);
+                buf = NULL;
+            } else {
+                buf = p;
+                cap *= 2;
+            }
+        }
+    }
+    fclose(f);
+    *len = n;
+    return buf;
+}
+
+/**
+ * @brief Conecta ao servidor
+ * @param path Caminho do socket
+ * @return Descritor ou -1 se erro
+ */
+static int connectTo(const char* path) {
+    struct sockaddr_un addr;
+    int fd;
+    if (strlen(path) >= sizeof(addr.sun_path))
+        return -1;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd >= 0 && connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        fd = -1;
+    }
+    return fd;
+}
+
+/**
+ * @brief Le um bloco da resposta
+ * @param fd Conexao
+ * @param n Tamanho
+ * @return Bloco alocado ou NULL se erro
+ */
+static char* readBlock(int fd, uint32_t n) {
+    char* p = (char*)malloc(n ? n : 1);
+    if (p != NULL && rpc_read(fd, p, n) != 0) {
+        free(p);
+        p = NULL;
+    }
+    return p;
+}
+
+/**
+ * @brief Funcao principal do cliente
+ * @param argc Numero de argumentos
+ * @param argv Vetor de argumentos
+ * @return Status da compilacao (0 se sucesso, 1 se erro)
+ */
+int main(int argc, char* argv[]) {
+    char socketPath[256];
+    RpcRequest req;
+    RpcResponse resp;
+    char* fileName = NULL;
+    char* binName = NULL;
+    char* src = NULL;
+    char* listing;
+    char* errors;
+    char* cmir;
+    size_t len = 0;
+    int stats = FALSE;
+    int fd;
+    int i;
+
+    rpc_default_socket(socketPath, sizeof(socketPath));
+    memset(&req, 0, sizeof(req));
+    req.unroll = -1;
+    for (i = 1; i < argc; i++) {
+        if ((strcmp(argv[i], "--socket") == 0 || strcmp(argv[i], "-S") == 0) && i + 1 < argc) {
+            snprintf(socketPath, sizeof(socketPath), "%s", argv[++i]);
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            binName = argv[++i];
+        } else if (strcmp(argv[i], "--stream") == 0) {
+            req.flags |= RPC_STREAM;
+        } else if (strcmp(argv[i], "--lexer") == 0 && i + 1 < argc &&
+                   (strcmp(argv[i + 1], "flex") == 0 || strcmp(argv[i + 1], "simd") == 0)) {
+            if (strcmp(argv[++i], "simd") == 0)
+                req.flags |= RPC_SIMD;
+        } else if (strcmp(argv[i], "--prelex") == 0) {
+            req.flags |= RPC_PRELEX;
+        } else if (strcmp(argv[i], "-O") == 0) {
+            req.optimize = 1;
+        } else if (strncmp(argv[i], "-O", 2) == 0 && argv[i][2] >= '0' && argv[i][2] <= '3' && argv[i][3] == '\0') {
+            req.optimize = argv[i][2] - '0';
+        } else if (strcmp(argv[i], "--unroll") == 0 && i + 1 < argc) {
+            req.unroll = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--profile-generate") == 0 || strcmp(argv[i], "--profile-use") == 0 ||
+                   strcmp(argv[i], "--opt-stats") == 0 || strcmp(argv[i], "--frames") == 0) {
+            // o perfil e os relatorios em stderr ficam no processo do servidor
+            fprintf(stderr, "Erro: %s nao funciona com o servidor (use cminus)\n", argv[i]);
+            return 1;
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            stats = TRUE;
+        } else if (argv[i][0] != '-' && fileName == NULL) {
+            fileName = argv[i];
+        } else {
+            fileName = NULL;
+            stats = FALSE;
+            break;
+        }
+    }
+    if (fileName == NULL && !stats) {
+        fprintf(stderr, "Uso: %s [opcoes] <arquivo.cm>\n", argv[0]);
+        fprintf(stderr, "     %s [--socket <caminho>] --stats\n", argv[0]);
+        fprintf(stderr, "  --socket <caminho>   socket do servidor (padrao: $CMINUS_SOCKET ou %s)\n", socketPath);
+        fprintf(stderr, "  -S <caminho>         o mesmo que --socket\n");
+        fprintf(stderr, "  -o <saida.cmir>      grava o codigo intermediario binario\n");
+        fprintf(stderr, "  --stream             analisa e gera cada funcao assim que lida\n");
+        fprintf(stderr, "  --lexer flex|simd    scanner usado pelo servidor\n");
+        fprintf(stderr, "  --prelex             le os tokens para um vetor antes do parser\n");
+        fprintf(stderr, "  -O, -O<n>            nivel de otimizacao (0 a 3, como no cminus)\n");
+        fprintf(stderr, "  --unroll <n>         desenrola os lacos com contador <n> vezes (1 desliga)\n");
+        fprintf(stderr, "  --stats              imprime as requisicoes e os percentis de latencia do servidor\n");
+        return 1;
+    }
+
+    req.magic = RPC_REQUEST_MAGIC;
+    if (stats) {
+        req.kind = RPC_STATS;
+        fileName = "";
+    } else {
+        req.kind = RPC_COMPILE;
+        src = readFile(fileName, &len);
+        if (src == NULL || len > RPC_MAX_SOURCE) {
+            fprintf(stderr, "Erro: nao foi possivel abrir o arquivo '%s'\n", fileName);
+            free(src);
+            return 1;
+        }
+        if (binName != NULL)
+            req.flags |= RPC_CMIR;
+    }
+    req.nameLen = (uint32_t)strlen(fileName);
+    req.srcLen = (uint32_t)len;
+
+    fd = connectTo(socketPath);
+    if (fd < 0) {
+        fprintf(stderr, "Erro: servidor nao encontrado em '%s' (inicie com cminus --serve)\n", socketPath);
+        free(src);
+        return 1;
+    }
+    if (rpc_write(fd, &req, sizeof(req)) != 0 || rpc_write(fd, fileName, req.nameLen) != 0 ||
+        rpc_write(fd, src, len) != 0 || rpc_read(fd, &resp, sizeof(resp)) != 0 ||
+        resp.magic != RPC_RESPONSE_MAGIC) {
+        fprintf(stderr, "Erro: falha na comunicacao com o servidor\n");
+        close(fd);
+        free(src);
+        return 1;
+    }
+    free(src);
+    listing = readBlock(fd, resp.listingLen);
+    errors = readBlock(fd, resp.errorsLen);
+    cmir = readBlock(fd, resp.cmirLen);
+    close(fd);
+    if (listing == NULL || errors == NULL || cmir == NULL) {
+        fprintf(stderr, "Erro: falha na comunicacao com o servidor\n");
+        free(listing);
+        free(errors);
+        free(cmir);
+        return 1;
+    }
+
+    fwrite(errors, 1, resp.errorsLen, stderr);
+    fwrite(listing, 1, resp.listingLen, stdout);
+    if (!stats && resp.status == 0) {
+        if (binName != NULL) {
+            FILE* f = fopen(binName, "wb");
+            if (f == NULL || fwrite(cmir, 1, resp.cmirLen, f) != resp.cmirLen) {
+                fprintf(stderr, "Erro: nao foi possivel gravar o arquivo '%s'\n", binName);
+                resp.status = 1;
+            } else {
+                fprintf(stdout, "Codigo binario gravado em: %s\n", binName);
+            }
+            if (f != NULL && fclose(f) != 0)
+                resp.status = 1;
+        }
+        if (resp.status == 0)
+            fprintf(stdout, "\nCompilacao concluida com sucesso!\n\n");
+    }
+    free(listing);
+    free(errors);
+    free(cmir);
+    return resp.status == 0 ? 0 : 1;
+}
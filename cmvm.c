@@ -0,0 +1,144 @@
+/**
+ * @file cmvm.c
+ * @brief Executor de programas C- compilados para o formato binario (.cmir)
+ */
+
+#include "globals.h"
+#include "irfile.h"
+#include "vm.h"
+#include "profile.h"
+
+// Linhas do relatorio --hot-lines
+#define CMVM_HOT_LINES 20
+
+/**
+ * @brief Soma as contagens da execucao no arquivo de perfil
+ *
+ * Se o arquivo ja existe, as contagens sao somadas as dele (varias
+ * execucoes com entradas diferentes formam um unico perfil).
+ *
+ * @param vm Maquina que executou o programa
+ * @param path Arquivo de perfil
+ * @return 0 se sucesso, -1 se erro
+ */
+static int writeProfile(Vm* vm, const char* path) {
+    Profile prof;
+    int status;
+    profile_init(&prof);
+    status = profile_read(&prof, path) < 0 ? -1 : 0;
+    if (status == 0 && vm_profile_collect(vm, &prof) != 0) {
+        fprintf(stderr, "Erro: falta de memoria no perfil\n");
+        status = -1;
+    }
+    if (status == 0 && prof.nfuncs == 0) {
+        fprintf(stderr, "Erro: o programa nao foi compilado com --profile-generate\n");
+        status = -1;
+    }
+    if (status == 0)
+        status = profile_write(&prof, path);
+    if (status == 0)
+        fprintf(stderr, "Perfil gravado em: %s\n", path);
+    profile_free(&prof);
+    return status;
+}
+
+/**
+ * @brief Grava as pilhas de chamadas da execucao (formato do flamegraph.pl)
+ * @param vm Maquina que executou o programa
+ * @param path Arquivo de saida
+ * @return 0 se sucesso, -1 se erro
+ */
+static int writeStacks(Vm* vm, const char* path) {
+    FILE* f = fopen(path, "w");
+    int status;
+    if (f == NULL) {
+        fprintf(stderr, "Erro: nao foi possivel criar o arquivo '%s'\n", path);
+        return -1;
+    }
+    status = vm_lines_stacks(vm, f);
+    if (ferror(f))
+        status = -1;
+    if (fclose(f) != 0 || status != 0) {
+        fprintf(stderr, "Erro: falha ao gravar o arquivo '%s'\n", path);
+        return -1;
+    }
+    fprintf(stderr, "Pilhas gravadas em: %s\n", path);
+    return 0;
+}
+
+/**
+ * @brief Funcao principal do executor
+ * @param argc Numero de argumentos
+ * @param argv Vetor de argumentos
+ * @return 0 se sucesso, 1 se erro
+ */
+int main(int argc, char* argv[]) {
+    IrFile file;
+    Vm vm;
+    int dump = FALSE;
+    int status;
+    char* fileName = NULL;
+    char* profilePath = NULL;
+    int hotLines = FALSE;
+    char* stacksPath = NULL;
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-d") == 0) {
+            dump = TRUE;
+        } else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+            profilePath = argv[++i];
+        } else if (strcmp(argv[i], "--hot-lines") == 0) {
+            hotLines = TRUE;
+        } else if (strcmp(argv[i], "--stacks") == 0 && i + 1 < argc) {
+            stacksPath = argv[++i];
+        } else if (argv[i][0] != '-' && fileName == NULL) {
+            fileName = argv[i];
+        } else {
+            fileName = NULL;
+            break;
+        }
+    }
+    if (fileName == NULL) {
+        fprintf(stderr, "Uso: %s [-d] [--profile <arquivo>] [--hot-lines] [--stacks <arquivo>] <arquivo.cmir>\n", argv[0]);
+        fprintf(stderr, "  -d                   imprime o codigo de tres enderecos em vez de executar\n");
+        fprintf(stderr, "  --profile <arquivo>  soma as contagens de um programa compilado com\n");
+        fprintf(stderr, "                       --profile-generate no arquivo (para o --profile-use)\n");
+        fprintf(stderr, "  --hot-lines          imprime em stderr as %d linhas do fonte e as funcoes\n", CMVM_HOT_LINES);
+        fprintf(stderr, "                       que mais executaram instrucoes\n");
+        fprintf(stderr, "  --stacks <arquivo>   grava as instrucoes de cada pilha de chamadas (flamegraph.pl)\n");
+        return 1;
+    }
+
+    if (irfile_open(fileName, &file) != 0)
+        return 1;
+
+    if (dump) {
+        ir_print(&file.view, stdout);
+        irfile_close(&file);
+        return 0;
+    }
+
+    if (vm_init(&vm, &file.view) != 0) {
+        irfile_close(&file);
+        return 1;
+    }
+    vm.profile = profilePath != NULL;
+    if ((hotLines || stacksPath != NULL) && vm_lines_enable(&vm) != 0) {
+        fprintf(stderr, "Erro: falta de memoria para contar as linhas\n");
+        vm_free(&vm);
+        irfile_close(&file);
+        return 1;
+    }
+    status = vm_run_main(&vm);
+    if (status == 0 && profilePath != NULL && writeProfile(&vm, profilePath) != 0)
+        status = -1;
+    // mesmo depois de um erro de execucao: mostra onde o programa estava gastando tempo
+    if (hotLines)
+        vm_lines_report(&vm, stderr, CMVM_HOT_LINES);
+    if (stacksPath != NULL && writeStacks(&vm, stacksPath) != 0)
+        status = -1;
+    vm_free(&vm);
+    irfile_close(&file);
+    return status == 0 ? 0 : 1;
+}
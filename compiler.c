@@ -0,0 +1,217 @@
+/**
+ * @file compiler.c
+ * @brief Implementacao da biblioteca do compilador C- (libcminus)
+ */
+
+#include "compiler.h"
+#include "util.h"
+#include "symtab.h"
+#include "analyze.h"
+#include "cgen.h"
+#include "phase.h"
+#include "cminus.tab.h"
+
+/**
+ * @brief Estado do modo streaming
+ */
+typedef struct {
+    CodeGen* cg;
+    TreeNode* tail;          // ultima declaracao residente
+    int symtabError;         // erro ao inserir alguma declaracao na tabela
+    int typeError;           // erro na verificacao de tipos
+    long decls;              // declaracoes globais processadas
+    long funcs;              // funcoes processadas
+} StreamState;
+
+/**
+ * @brief Conta os nos de uma AST (itens da fase do parser)
+ * @param t Primeiro no da lista
+ * @return Numero de nos
+ */
+static long countNodes(TreeNode* t) {
+    long n = 0;
+    for (; t != NULL; t = t->sibling) {
+        int i;
+        n++;
+        for (i = 0; i < MAXCHILDREN; i++)
+            n += countNodes(t->child[i]);
+    }
+    return n;
+}
+
+/**
+ * @brief Conta as instrucoes geradas (itens da fase de geracao de codigo)
+ * @param program Codigo intermediario
+ * @return Numero de instrucoes
+ */
+static long countInstrs(const IrProgram* program) {
+    long n = 0;
+    uint32_t i;
+    for (i = 0; i < program->nunits; i++)
+        n += program->units[i].rec.count;
+    return n;
+}
+
+char* cminus_cache_options(char* buf, size_t size, int stream, int optimize, int unroll) {
+    int n;
+    // sem otimizacao a chave e a mesma de antes do -O
+    if (optimize > 0)
+        n = snprintf(buf, size, "%sO%d", stream ? "stream " : "", optimize);
+    else
+        n = snprintf(buf, size, "%s", stream ? "stream" : "");
+    if (unroll > 1 && n >= 0 && (size_t)n < size)
+        snprintf(buf + n, size - n, "%sU%d", n > 0 ? " " : "", unroll);
+    return buf;
+}
+
+void cminus_init(CompilerContext* ctx, FILE* listing, FILE* errors) {
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->listing = listing;
+    ctx->errors = errors;
+    ctx->lineno = 1;
+}
+
+int cminus_compile(CompilerContext* ctx, const char* src, size_t len, IrProgram* program) {
+    PhaseReport* report = ctx->report;
+    TreeNode* syntaxTree;
+
+    phase_begin(report, "parser");
+    cminus_parse(ctx, src, len);
+    syntaxTree = ctx->savedTree;
+    phase_end(report, report != NULL ? countNodes(syntaxTree) : -1, "nos");
+
+    if (ctx->error) {
+        fprintf(ctx->listing, "\nErros encontrados durante a analise. Compilacao abortada.\n");
+        return 1;
+    }
+
+    if (syntaxTree == NULL) {
+        fprintf(ctx->listing, "\nErro: arvore sintatica nao foi construida.\n");
+        return 1;
+    }
+
+    phase_begin(report, "arvore");
+    fprintf(ctx->listing, "\n******** ARVORE SINTATICA ABSTRATA ********\n\n");
+    printTree(ctx, syntaxTree);
+    phase_end(report, -1, NULL);
+
+    phase_begin(report, "simbolos");
+    fprintf(ctx->listing, "\n******** ANALISE SEMANTICA ********\n\n");
+    fprintf(ctx->listing, "Construindo tabela de simbolos...\n");
+    buildSymtab(ctx, syntaxTree);
+    phase_end(report, report != NULL ? st_count(ctx) : -1, "simbolos");
+
+    if (ctx->error) {
+        fprintf(ctx->listing, "\nErros semanticos encontrados. Compilacao abortada.\n");
+        return 1;
+    }
+
+    phase_begin(report, "tipos");
+    fprintf(ctx->listing, "\nVerificacao de tipos...\n");
+    typeCheck(ctx, syntaxTree);
+    phase_end(report, -1, NULL);
+
+    if (ctx->error) {
+        fprintf(ctx->listing, "\nErros de tipo encontrados. Compilacao abortada.\n");
+        return 1;
+    }
+
+    phase_begin(report, "tabela");
+    fprintf(ctx->listing, "\n******** TABELA DE SIMBOLOS ********\n\n");
+    printSymTab(ctx);
+    st_pop_scope(ctx);
+    phase_end(report, -1, NULL);
+
+    phase_begin(report, "codigo");
+    fprintf(ctx->listing, "\n******** GERACAO DE CODIGO ********\n");
+    codeGen(ctx, syntaxTree, program);
+    phase_end(report, countInstrs(program), "instrucoes");
+    return 0;
+}
+
+/**
+ * @brief Analisa, gera e descarta uma declaracao global recem reduzida
+ *
+ * Chamada pelo parser (ctx->onDecl). Variaveis globais e o cabecalho das
+ * funcoes (nome e parametros) ficam na AST, encadeados em ctx->savedTree,
+ * porque a tabela de simbolos e a recompilacao incremental apontam para
+ * eles; o corpo da funcao e o seu escopo sao liberados.
+ *
+ * @param ctx Contexto da compilacao
+ * @param decl Declaracao global (sem irmaos)
+ */
+static void streamDecl(CompilerContext* ctx, TreeNode* decl) {
+    StreamState* s = (StreamState*)ctx->stream;
+    int failed = ctx->error;
+    if (decl == NULL)
+        return;
+    s->decls++;
+    buildSymtabDecl(ctx, decl);
+    if (ctx->error && !failed)
+        s->symtabError = TRUE;
+    if (!ctx->error) {
+        typeCheckDecl(ctx, decl);
+        if (ctx->error)
+            s->typeError = TRUE;
+    }
+    if (!ctx->error)
+        codeGenDecl(s->cg, decl);
+    if (decl->nodekind == DeclK && decl->kind.decl == FunK) {
+        s->funcs++;
+        st_free_scope(ctx, decl->attr.name);
+        freeTree(decl->child[1]);
+        decl->child[1] = NULL;
+    }
+    if (s->tail == NULL)
+        ctx->savedTree = decl;
+    else
+        s->tail->sibling = decl;
+    s->tail = decl;
+}
+
+int cminus_compile_stream(CompilerContext* ctx, const char* src, size_t len, IrProgram* program) {
+    StreamState s;
+    int status;
+
+    memset(&s, 0, sizeof(s));
+    // analise e geracao acontecem dentro do parser, em uma unica fase
+    phase_begin(ctx->report, "streaming");
+    s.cg = codeGenBegin(ctx, program);
+    ctx->stream = &s;
+    ctx->onDecl = streamDecl;
+    status = cminus_parse(ctx, src, len);
+    ctx->onDecl = NULL;
+    ctx->stream = NULL;
+    codeGenEnd(s.cg);
+    phase_end(ctx->report, s.decls, "declaracoes");
+
+    fprintf(ctx->listing, "\n******** COMPILACAO POR FUNCAO (STREAMING) ********\n\n");
+    fprintf(ctx->listing, "Declaracoes globais: %ld (funcoes: %ld)\n", s.decls, s.funcs);
+
+    if (status != 0 || (ctx->error && !s.symtabError && !s.typeError)) {
+        fprintf(ctx->listing, "\nErros encontrados durante a analise. Compilacao abortada.\n");
+        return 1;
+    }
+    if (s.symtabError) {
+        fprintf(ctx->listing, "\nErros semanticos encontrados. Compilacao abortada.\n");
+        return 1;
+    }
+    if (!ctx->error)
+        checkMain(ctx);
+    if (ctx->error) {
+        fprintf(ctx->listing, "\nErros de tipo encontrados. Compilacao abortada.\n");
+        return 1;
+    }
+
+    phase_begin(ctx->report, "listagem");
+    fprintf(ctx->listing, "\n******** GERACAO DE CODIGO ********\n");
+    printIR(ctx, program);
+    phase_end(ctx->report, countInstrs(program), "instrucoes");
+    return 0;
+}
+
+void cminus_free(CompilerContext* ctx) {
+    freeTree(ctx->savedTree);
+    ctx->savedTree = NULL;
+    st_free(ctx);
+}
@@ -0,0 +1,77 @@
+/**
+ * @file compiler.h
+ * @brief Interface da biblioteca do compilador C- (libcminus)
+ *
+ * Cada compilacao usa o seu proprio CompilerContext; contextos diferentes
+ * podem ser usados ao mesmo tempo em threads diferentes.
+ *
+ * Uso tipico:
+ *     CompilerContext ctx;
+ *     IrProgram prog;
+ *     cminus_init(&ctx, listing, stderr);
+ *     ir_init(&prog);
+ *     if (cminus_compile(&ctx, src, len, &prog) == 0) { ... }
+ *     ir_free(&prog);
+ *     cminus_free(&ctx);
+ */
+
+#ifndef _COMPILER_H_
+#define _COMPILER_H_
+
+#include "globals.h"
+#include "ir.h"
+
+/**
+ * @brief Inicializa um contexto de compilacao
+ * @param ctx Contexto
+ * @param listing Saida das fases (arvore, tabela de simbolos, codigo)
+ * @param errors Saida das mensagens de erro
+ */
+void cminus_init(CompilerContext* ctx, FILE* listing, FILE* errors);
+
+/**
+ * @brief Compila um programa C- a partir de um buffer em memoria
+ * @param ctx Contexto (inicializado com cminus_init, usado uma unica vez)
+ * @param src Codigo fonte (com ctx->scanInPlace, seguido de dois '\0' e alteravel)
+ * @param len Tamanho do codigo fonte
+ * @param program Codigo intermediario gerado (inicializado com ir_init)
+ * @return 0 se sucesso, 1 se erro
+ */
+int cminus_compile(CompilerContext* ctx, const char* src, size_t len, IrProgram* program);
+
+/**
+ * @brief Compila um programa C- declaracao por declaracao (modo streaming)
+ *
+ * Cada declaracao global e analisada e gerada assim que o parser a reduz, e
+ * o corpo de cada funcao e liberado em seguida (a linguagem exige declarar
+ * antes de usar). A memoria da AST fica limitada a maior funcao mais as
+ * declaracoes globais. A listagem traz apenas o codigo intermediario (a
+ * arvore e a tabela de simbolos completas nao existem mais ao final); o
+ * codigo gerado e identico ao de cminus_compile. ctx->pool e ignorado.
+ *
+ * @param ctx Contexto (inicializado com cminus_init, usado uma unica vez)
+ * @param src Codigo fonte (com ctx->scanInPlace, seguido de dois '\0' e alteravel)
+ * @param len Tamanho do codigo fonte
+ * @param program Codigo intermediario gerado (inicializado com ir_init)
+ * @return 0 se sucesso, 1 se erro
+ */
+int cminus_compile_stream(CompilerContext* ctx, const char* src, size_t len, IrProgram* program);
+
+/**
+ * @brief Opcoes que alteram a saida, para a chave do cache de compilacao
+ * @param buf Destino
+ * @param size Tamanho do destino
+ * @param stream TRUE no modo streaming (a listagem muda)
+ * @param optimize Nivel de otimizacao (o codigo muda)
+ * @param unroll Fator de desenrolamento dos lacos (o codigo muda)
+ * @return buf
+ */
+char* cminus_cache_options(char* buf, size_t size, int stream, int optimize, int unroll);
+
+/**
+ * @brief Libera a arvore sintatica e a tabela de simbolos de um contexto
+ * @param ctx Contexto
+ */
+void cminus_free(CompilerContext* ctx);
+
+#endif
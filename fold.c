@@ -0,0 +1,352 @@
+/**
+ * @file fold.c
+ * @brief Implementacao da avaliacao de chamadas puras na compilacao
+ */
+
+#include "globals.h"
+#include "fold.h"
+#include "opt.h"
+#include "ssa.h"
+#include "vm.h"
+#include <time.h>
+
+// Memoria da maquina virtual durante a avaliacao (inteiros)
+#define FOLD_MEM_LIMIT (1u << 20)
+
+// Passadas sobre uma funcao (chamadas aninhadas com argumentos constantes)
+#define FOLD_MAX_ROUNDS 4
+
+/**
+ * @brief Resultado de uma chamada ja avaliada (funcao e argumentos)
+ */
+typedef struct {
+    uint32_t unit;
+    uint32_t nargs;
+    uint32_t argOff;         // argumentos em FoldMemo.args
+    int32_t result;
+    uint8_t used;
+    uint8_t ok;              // FALSE: erro ou limite de passos
+} FoldEntry;
+
+/**
+ * @brief Tabela hash das chamadas avaliadas
+ *
+ * A mesma chamada com as mesmas constantes costuma se repetir no programa
+ * (por exemplo, um tamanho calculado por uma funcao auxiliar).
+ */
+typedef struct {
+    FoldEntry* table;
+    uint32_t cap;
+    uint32_t count;
+    int32_t* args;
+    uint32_t nargs;
+    uint32_t argCap;
+} FoldMemo;
+
+/**
+ * @brief Tempo monotonico em segundos
+ */
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Hash de uma chamada (FNV-1a sobre a funcao e os argumentos)
+ */
+static uint32_t callHash(uint32_t unit, const int32_t* args, uint32_t n) {
+    uint32_t h = (2166136261u ^ unit) * 16777619u;
+    uint32_t i;
+    for (i = 0; i < n; i++)
+        h = (h ^ (uint32_t)args[i]) * 16777619u;
+    return h;
+}
+
+/**
+ * @brief Procura uma chamada na tabela
+ * @return Entrada ou NULL se ainda nao avaliada
+ */
+static FoldEntry* memoFind(const FoldMemo* m, uint32_t unit, const int32_t* args, uint32_t n) {
+    uint32_t j;
+    if (m->cap == 0)
+        return NULL;
+    for (j = callHash(unit, args, n) & (m->cap - 1); m->table[j].used; j = (j + 1) & (m->cap - 1)) {
+        FoldEntry* e = &m->table[j];
+        if (e->unit == unit && e->nargs == n && (n == 0 || memcmp(&m->args[e->argOff], args, n * sizeof(int32_t)) == 0))
+            return e;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Guarda o resultado de uma chamada
+ * @return 0 em sucesso, -1 sem memoria (o resultado so nao fica guardado)
+ */
+static int memoPut(FoldMemo* m, uint32_t unit, const int32_t* args, uint32_t n, int ok, int32_t result) {
+    FoldEntry* e;
+    uint32_t j;
+    if ((m->count + 1) * 2 > m->cap) {
+        FoldEntry* old = m->table;
+        uint32_t oldCap = m->cap, i;
+        uint32_t cap = m->cap ? m->cap * 2 : 64;
+        FoldEntry* table = (FoldEntry*)calloc(cap, sizeof(FoldEntry));
+        if (table == NULL)
+            return -1;
+        m->table = table;
+        m->cap = cap;
+        for (i = 0; i < oldCap; i++) {
+            if (!old[i].used)
+                continue;
+            j = callHash(old[i].unit, &m->args[old[i].argOff], old[i].nargs) & (cap - 1);
+            while (table[j].used)
+                j = (j + 1) & (cap - 1);
+            table[j] = old[i];
+        }
+        free(old);
+    }
+    if (m->nargs + n > m->argCap) {
+        uint32_t cap = m->argCap ? m->argCap * 2 : 256;
+        int32_t* grown;
+        while (cap < m->nargs + n)
+            cap *= 2;
+        grown = (int32_t*)realloc(m->args, cap * sizeof(int32_t));
+        if (grown == NULL)
+            return -1;
+        m->args = grown;
+        m->argCap = cap;
+    }
+    for (j = callHash(unit, args, n) & (m->cap - 1); m->table[j].used; j = (j + 1) & (m->cap - 1))
+        ;
+    e = &m->table[j];
+    e->used = 1;
+    e->unit = unit;
+    e->nargs = n;
+    e->argOff = m->nargs;
+    e->ok = (uint8_t)ok;
+    e->result = result;
+    if (n > 0)
+        memcpy(&m->args[m->nargs], args, n * sizeof(int32_t));
+    m->nargs += n;
+    m->count++;
+    return 0;
+}
+
+/**
+ * @brief Verifica se uma funcao e pura sem olhar as funcoes que ela chama
+ * @param unit Funcao
+ * @return TRUE se nao usa globais, input/output nem parametros int[]
+ */
+static int localPure(const IrUnit* unit) {
+    uint32_t i;
+    for (i = 0; i < unit->rec.nparams; i++)
+        if (unit->slots[i].size != IR_SCALAR)
+            return FALSE;
+    for (i = 0; i < unit->rec.count; i++) {
+        const IrInstr* in = &unit->code[i];
+        if (in->kd == IR_GLOBAL || in->ka == IR_GLOBAL || in->kb == IR_GLOBAL)
+            return FALSE;
+        if (in->op == IR_CALL && in->ka == IR_FUNC && in->a < 0)
+            return FALSE;
+    }
+    return TRUE;
+}
+
+/**
+ * @brief Funcoes puras: puras localmente e que so chamam funcoes puras
+ * @param prog Programa
+ * @return Vetor com uma marca por funcao (liberar com free) ou NULL
+ */
+static uint8_t* findPure(const IrProgram* prog) {
+    uint8_t* pure = (uint8_t*)malloc(prog->nunits + 1);
+    uint32_t u, i;
+    int changed = TRUE;
+    if (pure == NULL)
+        return NULL;
+    for (u = 0; u < prog->nunits; u++)
+        pure[u] = (uint8_t)localPure(&prog->units[u]);
+    // ponto fixo: uma chamada a funcao impura contamina quem chama
+    while (changed) {
+        changed = FALSE;
+        for (u = 0; u < prog->nunits; u++) {
+            const IrUnit* unit = &prog->units[u];
+            if (!pure[u])
+                continue;
+            for (i = 0; i < unit->rec.count; i++) {
+                const IrInstr* in = &unit->code[i];
+                if (in->op == IR_CALL && in->ka == IR_FUNC &&
+                    ((uint32_t)in->a >= prog->nunits || !pure[in->a])) {
+                    pure[u] = 0;
+                    changed = TRUE;
+                    break;
+                }
+            }
+        }
+    }
+    return pure;
+}
+
+/**
+ * @brief Avalia (ou reaproveita) uma chamada
+ * @param vm Maquina virtual
+ * @param memo Chamadas ja avaliadas
+ * @param unit Funcao chamada
+ * @param args Argumentos constantes
+ * @param n Numero de argumentos
+ * @param result Valor de retorno
+ * @param failed Soma as chamadas (distintas) que falharam ou passaram do limite
+ * @return TRUE se a chamada terminou sem erro dentro do limite
+ */
+static int evaluate(Vm* vm, FoldMemo* memo, uint32_t unit, const int32_t* args, uint32_t n, int32_t* result,
+                    uint32_t* failed) {
+    FoldEntry* e = memoFind(memo, unit, args, n);
+    int ok;
+    if (e != NULL) {
+        *result = e->result;
+        return e->ok;
+    }
+    vm->steps = 0;
+    vm->stepLimit = FOLD_STEP_LIMIT;
+    vm->error = 0;
+    *result = 0;
+    ok = vm_call(vm, (int)unit, args, (int)n, result) == 0;
+    if (!ok)
+        (*failed)++;
+    memoPut(memo, unit, args, n, ok, *result);
+    return ok;
+}
+
+/**
+ * @brief Substitui as chamadas avaliaveis de uma funcao
+ * @param prog Programa
+ * @param unit Funcao que faz as chamadas
+ * @param pure Funcoes puras
+ * @param vm Maquina virtual
+ * @param memo Chamadas ja avaliadas
+ * @param params Pilha de param pendentes (uma posicao por instrucao)
+ * @param args Argumentos da chamada (uma posicao por parametro)
+ * @param failed Soma as chamadas que falharam ou passaram do limite
+ * @return Numero de chamadas substituidas
+ */
+static uint32_t foldUnit(const IrProgram* prog, IrUnit* unit, const uint8_t* pure, Vm* vm, FoldMemo* memo,
+                         uint32_t* params, int32_t* args, uint32_t* failed) {
+    uint32_t np = 0, folded = 0, i, k;
+    for (i = 0; i < unit->rec.count; i++) {
+        IrInstr* in = &unit->code[i];
+        if (in->op == IR_PARAM) {
+            params[np++] = i;
+        } else if (in->op == IR_CALL) {
+            uint32_t n = (uint32_t)in->b;
+            uint32_t callee = (uint32_t)in->a;
+            int32_t result;
+            if (n > np) {
+                np = 0;
+                continue;
+            }
+            np -= n;
+            if (in->ka != IR_FUNC || callee >= prog->nunits || !pure[callee] ||
+                n != prog->units[callee].rec.nparams)
+                continue;
+            for (k = 0; k < n && unit->code[params[np + k]].ka == IR_CONST; k++)
+                args[k] = unit->code[params[np + k]].a;
+            if (k < n)
+                continue;
+            if (!evaluate(vm, memo, callee, args, n, &result, failed))
+                continue;
+            for (k = 0; k < n; k++)
+                memset(&unit->code[params[np + k]], 0, sizeof(IrInstr));
+            if (in->kd != IR_NONE) {
+                in->op = IR_COPY;
+                in->ka = IR_CONST;
+                in->a = result;
+                in->kb = IR_NONE;
+                in->b = 0;
+            } else {
+                memset(in, 0, sizeof(*in));
+            }
+            folded++;
+        } else if (in->op == IR_LABEL_DEF || in->op == IR_GOTO || in->op == IR_IFFALSE || in->op == IR_RETURN) {
+            // os argumentos de uma chamada nunca atravessam desvios
+            np = 0;
+        }
+    }
+    if (folded) {
+        uint32_t n = 0;
+        for (i = 0; i < unit->rec.count; i++)
+            if (unit->code[i].op != IR_NOP)
+                unit->code[n++] = unit->code[i];
+        unit->rec.count = n;
+        // propaga o resultado (sem somar de novo nos contadores dos passes)
+        ssa_sccp(unit, NULL);
+        opt_peephole(unit, NULL);
+    }
+    return folded;
+}
+
+uint32_t fold_pure_calls(IrProgram* prog, OptStats* stats) {
+    double start = now();
+    uint8_t* pure = findPure(prog);
+    uint32_t* params = NULL;
+    int32_t* args = NULL;
+    uint32_t folded = 0, failed = 0, maxParams = 0, maxCount = 0;
+    uint32_t u;
+    FoldMemo memo;
+    IrView view;
+    Vm vm;
+
+    memset(&memo, 0, sizeof(memo));
+    memset(&view, 0, sizeof(view));
+    memset(&vm, 0, sizeof(vm));
+    if (pure == NULL)
+        return 0;
+    for (u = 0; u < prog->nunits; u++) {
+        if (prog->units[u].rec.nparams > maxParams)
+            maxParams = prog->units[u].rec.nparams;
+        if (prog->units[u].rec.count > maxCount)
+            maxCount = prog->units[u].rec.count;
+    }
+    for (u = 0; u < prog->nunits && !pure[u]; u++)
+        ;
+    if (u == prog->nunits)
+        goto done;
+    params = (uint32_t*)malloc((maxCount + 1) * sizeof(uint32_t));
+    args = (int32_t*)malloc((maxParams + 1) * sizeof(int32_t));
+    if (params == NULL || args == NULL)
+        goto done;
+
+    // o VM executa uma copia do programa anterior a esta passada; as
+    // funcoes alteradas aqui continuam equivalentes
+    ir_flatten(prog, &view);
+    if (vm_init(&vm, &view) != 0)
+        goto done;
+    vm.quiet = 1;
+    vm.memLimit = FOLD_MEM_LIMIT;
+    vm.in = NULL;
+    vm.out = NULL;
+
+    for (u = 0; u < prog->nunits; u++) {
+        IrUnit* unit = &prog->units[u];
+        uint32_t round, changed = 1;
+        // f(g(1)): g vira constante e o SCCP a leva ate o param de f
+        for (round = 0; round < FOLD_MAX_ROUNDS && changed; round++) {
+            changed = foldUnit(prog, unit, pure, &vm, &memo, params, args, &failed);
+            folded += changed;
+        }
+    }
+
+done:
+    if (vm.view != NULL)
+        vm_free(&vm);
+    ir_view_free(&view);
+    free(memo.table);
+    free(memo.args);
+    free(params);
+    free(args);
+    free(pure);
+    if (stats != NULL) {
+        __atomic_add_fetch(&stats->foldCalls, (unsigned long)folded, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&stats->foldFailed, (unsigned long)failed, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&stats->foldMicros, (unsigned long)((now() - start) * 1e6), __ATOMIC_RELAXED);
+    }
+    return folded;
+}
@@ -0,0 +1,35 @@
+/**
+ * @file fold.h
+ * @brief Avaliacao em tempo de compilacao de chamadas puras (-O2)
+ *
+ * Uma funcao e pura quando nao chama input/output, nao le nem grava
+ * globais, nao recebe arrays e so chama funcoes puras. Uma chamada a uma
+ * funcao pura com todos os argumentos constantes e executada pela maquina
+ * virtual durante a compilacao, com limite de passos e de memoria; se
+ * termina, a chamada e os seus param sao trocados pelo resultado.
+ */
+
+#ifndef _FOLD_H_
+#define _FOLD_H_
+
+#include "ir.h"
+
+struct OptStats;
+
+// Instrucoes executadas por chamada avaliada
+#define FOLD_STEP_LIMIT 100000
+
+/**
+ * @brief Avalia as chamadas puras com argumentos constantes de um programa
+ *
+ * Roda depois que todas as funcoes foram geradas (o corpo das chamadas
+ * precisa estar pronto). As funcoes alteradas passam de novo pelo SCCP e
+ * pelo peephole para propagar os resultados.
+ *
+ * @param prog Programa
+ * @param stats Contadores (NULL = nao conta)
+ * @return Numero de chamadas substituidas
+ */
+uint32_t fold_pure_calls(IrProgram* prog, struct OptStats* stats);
+
+#endif
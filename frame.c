@@ -0,0 +1,377 @@
+/**
+ * @file frame.c
+ * @brief Reuso das celulas dos temporarios e relatorio do registro de ativacao
+ */
+
+#include "globals.h"
+#include "frame.h"
+#include "opt.h"
+
+// Limite dos conjuntos de vivacidade (palavras de 64 bits por conjunto);
+// acima disso a funcao fica com os temporarios como estao
+#define FRAME_MAX_WORDS (1u << 20)
+
+#define FRAME_NONE UINT32_MAX
+
+/**
+ * @brief Inicio do intervalo de vida de um temporario (ordenacao)
+ */
+typedef struct {
+    uint32_t start;
+    uint32_t temp;
+} FrameStart;
+
+/**
+ * @brief Celula ocupada ate o fim de um intervalo (heap de minimo por 'end')
+ */
+typedef struct {
+    uint32_t end;
+    uint32_t cell;
+} FrameActive;
+
+/**
+ * @brief Verifica se a instrucao grava no temporario d
+ */
+static int definesTemp(const IrInstr* in) {
+    if (in->kd != IR_TEMP)
+        return FALSE;
+    return in->op == IR_COPY || (in->op >= IR_ADD && in->op <= IR_NE) || in->op == IR_LOAD || in->op == IR_CALL;
+}
+
+/**
+ * @brief Verifica se a instrucao i comeca um bloco basico
+ */
+static int isLeader(const IrInstr* code, uint32_t i) {
+    return i == 0 || code[i].op == IR_LABEL_DEF || code[i - 1].op == IR_GOTO ||
+           code[i - 1].op == IR_IFFALSE || code[i - 1].op == IR_RETURN;
+}
+
+/**
+ * @brief Temporarios lidos por uma instrucao
+ * @param in Instrucao
+ * @param ntemps Temporarios da funcao
+ * @param out Ate tres temporarios
+ * @return Quantidade
+ */
+static int readsOf(const IrInstr* in, uint32_t ntemps, uint32_t out[3]) {
+    int n = 0;
+    if (in->ka == IR_TEMP && (uint32_t)in->a < ntemps)
+        out[n++] = (uint32_t)in->a;
+    if (in->kb == IR_TEMP && (uint32_t)in->b < ntemps)
+        out[n++] = (uint32_t)in->b;
+    if (in->kd == IR_TEMP && !definesTemp(in) && (uint32_t)in->d < ntemps)
+        out[n++] = (uint32_t)in->d;
+    return n;
+}
+
+/**
+ * @brief Estende o intervalo de vida de um temporario ate um ponto
+ *
+ * A instrucao i tem dois pontos: 2i (leituras) e 2i + 1 (gravacao), de
+ * forma que um temporario lido pela ultima vez em i e o gravado em i
+ * podem dividir a celula.
+ */
+static void extend(uint32_t* start, uint32_t* end, uint32_t t, uint32_t point) {
+    if (start[t] == FRAME_NONE || point < start[t])
+        start[t] = point;
+    if (end[t] == FRAME_NONE || point > end[t])
+        end[t] = point;
+}
+
+static int compareStarts(const void* x, const void* y) {
+    const FrameStart* a = (const FrameStart*)x;
+    const FrameStart* b = (const FrameStart*)y;
+    if (a->start != b->start)
+        return (a->start > b->start) - (a->start < b->start);
+    return (a->temp > b->temp) - (a->temp < b->temp);
+}
+
+/**
+ * @brief Insere no heap de celulas ocupadas
+ */
+static void heapPush(FrameActive* heap, uint32_t* n, FrameActive item) {
+    uint32_t i = (*n)++;
+    while (i > 0 && heap[(i - 1) / 2].end > item.end) {
+        heap[i] = heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    heap[i] = item;
+}
+
+/**
+ * @brief Remove o intervalo que termina primeiro
+ */
+static FrameActive heapPop(FrameActive* heap, uint32_t* n) {
+    FrameActive top = heap[0];
+    FrameActive last = heap[--(*n)];
+    uint32_t i = 0, c;
+    while ((c = 2 * i + 1) < *n) {
+        if (c + 1 < *n && heap[c + 1].end < heap[c].end)
+            c++;
+        if (heap[c].end >= last.end)
+            break;
+        heap[i] = heap[c];
+        i = c;
+    }
+    heap[i] = last;
+    return top;
+}
+
+/**
+ * @brief Vivacidade dos temporarios lidos fora do bloco que os define
+ *
+ * Estende start/end de cada um ate a entrada dos blocos em que esta vivo
+ * na entrada e ate o fim dos blocos em que esta vivo na saida.
+ *
+ * @return 0 em sucesso, -1 sem memoria, label inexistente ou funcao grande demais
+ */
+static int globalLiveness(const IrUnit* unit, const uint32_t* global, uint32_t nglobal,
+                          uint32_t* start, uint32_t* end) {
+    const IrInstr* code = unit->code;
+    uint32_t n = unit->rec.count, ntemps = unit->rec.ntemps, nlabels = unit->rec.nlabels;
+    uint32_t nblocks = 0, words = (nglobal + 63) / 64;
+    uint32_t* first = NULL;
+    uint32_t* succ = NULL;
+    uint32_t* labelBlock = NULL;
+    uint32_t* stamp = NULL;
+    uint32_t* globalTemp = NULL;
+    uint64_t* sets = NULL;
+    uint64_t *use, *def, *in, *out;
+    uint32_t i, b, k, w, t;
+    int changed, status = -1;
+
+    for (i = 0; i < n; i++)
+        if (isLeader(code, i))
+            nblocks++;
+    if ((uint64_t)nblocks * words > FRAME_MAX_WORDS)
+        return -1;
+    first = (uint32_t*)malloc((nblocks + 1) * sizeof(uint32_t));
+    succ = (uint32_t*)malloc((2 * nblocks + 1) * sizeof(uint32_t));
+    labelBlock = (uint32_t*)malloc((nlabels + 1) * sizeof(uint32_t));
+    stamp = (uint32_t*)calloc(ntemps + 1, sizeof(uint32_t));
+    globalTemp = (uint32_t*)malloc((nglobal + 1) * sizeof(uint32_t));
+    sets = (uint64_t*)calloc(4 * (size_t)nblocks * words + 1, sizeof(uint64_t));
+    if (first == NULL || succ == NULL || labelBlock == NULL || stamp == NULL || globalTemp == NULL || sets == NULL)
+        goto done;
+    use = sets;
+    def = use + (size_t)nblocks * words;
+    in = def + (size_t)nblocks * words;
+    out = in + (size_t)nblocks * words;
+
+    // blocos basicos: first[b] .. first[b + 1] - 1
+    for (i = 0; i < nlabels; i++)
+        labelBlock[i] = FRAME_NONE;
+    for (i = 0, b = 0; i < n; i++) {
+        if (isLeader(code, i))
+            first[b++] = i;
+        if (code[i].op == IR_LABEL_DEF && code[i].ka == IR_LABEL && (uint32_t)code[i].a < nlabels)
+            labelBlock[code[i].a] = b - 1;
+    }
+    first[nblocks] = n;
+    for (b = 0; b < nblocks; b++) {
+        const IrInstr* last = &code[first[b + 1] - 1];
+        uint32_t fall = b + 1 < nblocks ? b + 1 : FRAME_NONE;
+        succ[2 * b] = succ[2 * b + 1] = FRAME_NONE;
+        if (last->op == IR_GOTO || last->op == IR_IFFALSE) {
+            int32_t l = last->op == IR_GOTO ? last->a : last->b;
+            uint8_t kind = last->op == IR_GOTO ? last->ka : last->kb;
+            if (kind != IR_LABEL || (uint32_t)l >= nlabels || labelBlock[l] == FRAME_NONE)
+                goto done;
+            succ[2 * b] = labelBlock[l];
+            if (last->op == IR_IFFALSE)
+                succ[2 * b + 1] = fall;
+        } else if (last->op != IR_RETURN) {
+            succ[2 * b] = fall;
+        }
+    }
+
+    // leituras antes de uma gravacao no bloco (use) e gravacoes (def)
+    for (t = 0; t < ntemps; t++)
+        if (global[t] != FRAME_NONE)
+            globalTemp[global[t]] = t;
+    for (b = 0; b < nblocks; b++) {
+        for (i = first[b]; i < first[b + 1]; i++) {
+            uint32_t r[3];
+            int nr = readsOf(&code[i], ntemps, r), j;
+            for (j = 0; j < nr; j++) {
+                uint32_t g = global[r[j]];
+                if (g != FRAME_NONE && stamp[r[j]] != b + 1)
+                    use[(size_t)b * words + g / 64] |= 1ull << (g % 64);
+            }
+            if (definesTemp(&code[i]) && (uint32_t)code[i].d < ntemps) {
+                uint32_t g = global[code[i].d];
+                stamp[code[i].d] = b + 1;
+                if (g != FRAME_NONE)
+                    def[(size_t)b * words + g / 64] |= 1ull << (g % 64);
+            }
+        }
+    }
+
+    // in = use | (out & ~def), out = uniao dos in dos sucessores
+    do {
+        changed = FALSE;
+        for (b = nblocks; b-- > 0;) {
+            uint64_t* bo = out + (size_t)b * words;
+            uint64_t* bi = in + (size_t)b * words;
+            for (k = 0; k < 2; k++) {
+                uint32_t s = succ[2 * b + k];
+                if (s == FRAME_NONE)
+                    continue;
+                for (w = 0; w < words; w++)
+                    bo[w] |= in[(size_t)s * words + w];
+            }
+            for (w = 0; w < words; w++) {
+                uint64_t v = use[(size_t)b * words + w] | (bo[w] & ~def[(size_t)b * words + w]);
+                if (v != bi[w]) {
+                    bi[w] = v;
+                    changed = TRUE;
+                }
+            }
+        }
+    } while (changed);
+
+    for (b = 0; b < nblocks; b++) {
+        for (w = 0; w < words; w++) {
+            uint64_t vin = in[(size_t)b * words + w];
+            uint64_t vout = out[(size_t)b * words + w];
+            while (vin != 0) {
+                extend(start, end, globalTemp[w * 64 + (uint32_t)__builtin_ctzll(vin)], 2 * first[b]);
+                vin &= vin - 1;
+            }
+            while (vout != 0) {
+                extend(start, end, globalTemp[w * 64 + (uint32_t)__builtin_ctzll(vout)], 2 * (first[b + 1] - 1) + 1);
+                vout &= vout - 1;
+            }
+        }
+    }
+    status = 0;
+done:
+    free(first);
+    free(succ);
+    free(labelBlock);
+    free(stamp);
+    free(globalTemp);
+    free(sets);
+    return status;
+}
+
+uint32_t frame_pack_temps(IrUnit* unit, OptStats* stats) {
+    IrInstr* code = unit->code;
+    uint32_t n = unit->rec.count, ntemps = unit->rec.ntemps;
+    uint32_t* start = NULL;
+    uint32_t* end = NULL;
+    uint32_t* global = NULL;
+    uint32_t* stamp = NULL;
+    uint32_t* cell = NULL;
+    uint32_t* freeCells = NULL;
+    FrameStart* order = NULL;
+    FrameActive* heap = NULL;
+    uint32_t i, t, b, nglobal = 0, norder = 0, nactive = 0, nfree = 0, ncells = ntemps;
+
+    if (n == 0 || ntemps < 2)
+        goto done;
+    start = (uint32_t*)malloc(ntemps * sizeof(uint32_t));
+    end = (uint32_t*)malloc(ntemps * sizeof(uint32_t));
+    global = (uint32_t*)malloc(ntemps * sizeof(uint32_t));
+    stamp = (uint32_t*)calloc(ntemps, sizeof(uint32_t));
+    cell = (uint32_t*)malloc(ntemps * sizeof(uint32_t));
+    freeCells = (uint32_t*)malloc(ntemps * sizeof(uint32_t));
+    order = (FrameStart*)malloc(ntemps * sizeof(FrameStart));
+    heap = (FrameActive*)malloc(ntemps * sizeof(FrameActive));
+    if (start == NULL || end == NULL || global == NULL || stamp == NULL || cell == NULL ||
+        freeCells == NULL || order == NULL || heap == NULL)
+        goto done;
+
+    // pontos de cada temporario; os lidos antes de gravados no mesmo bloco
+    // (a maioria vive dentro de uma expressao) precisam da vivacidade entre blocos
+    for (t = 0; t < ntemps; t++) {
+        start[t] = end[t] = FRAME_NONE;
+        global[t] = FRAME_NONE;
+    }
+    for (i = 0, b = 0; i < n; i++) {
+        uint32_t r[3];
+        int nr, j;
+        if (isLeader(code, i))
+            b++;
+        nr = readsOf(&code[i], ntemps, r);
+        for (j = 0; j < nr; j++) {
+            extend(start, end, r[j], 2 * i);
+            if (stamp[r[j]] != b && global[r[j]] == FRAME_NONE)
+                global[r[j]] = nglobal++;
+        }
+        if (definesTemp(&code[i]) && (uint32_t)code[i].d < ntemps) {
+            extend(start, end, (uint32_t)code[i].d, 2 * i + 1);
+            stamp[code[i].d] = b;
+        }
+    }
+    if (nglobal > 0 && globalLiveness(unit, global, nglobal, start, end) != 0)
+        goto done;
+
+    // varredura linear: cada temporario pega uma celula cujo ultimo
+    // intervalo ja terminou, ou uma nova
+    for (t = 0; t < ntemps; t++) {
+        if (start[t] != FRAME_NONE) {
+            order[norder].start = start[t];
+            order[norder].temp = t;
+            norder++;
+        }
+    }
+    qsort(order, norder, sizeof(FrameStart), compareStarts);
+    ncells = 0;
+    for (i = 0; i < norder; i++) {
+        FrameActive item;
+        t = order[i].temp;
+        while (nactive > 0 && heap[0].end < start[t])
+            freeCells[nfree++] = heapPop(heap, &nactive).cell;
+        cell[t] = nfree > 0 ? freeCells[--nfree] : ncells++;
+        item.end = end[t];
+        item.cell = cell[t];
+        heapPush(heap, &nactive, item);
+    }
+    for (i = 0; i < n; i++) {
+        IrInstr* in = &code[i];
+        if (in->kd == IR_TEMP && (uint32_t)in->d < ntemps)
+            in->d = (int32_t)cell[in->d];
+        if (in->ka == IR_TEMP && (uint32_t)in->a < ntemps)
+            in->a = (int32_t)cell[in->a];
+        if (in->kb == IR_TEMP && (uint32_t)in->b < ntemps)
+            in->b = (int32_t)cell[in->b];
+    }
+    unit->rec.ntemps = ncells;
+
+done:
+    if (stats != NULL) {
+        __atomic_add_fetch(&stats->tempsBefore, (unsigned long)ntemps, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&stats->tempsAfter, (unsigned long)ncells, __ATOMIC_RELAXED);
+    }
+    free(start);
+    free(end);
+    free(global);
+    free(stamp);
+    free(cell);
+    free(freeCells);
+    free(order);
+    free(heap);
+    return ntemps - ncells;
+}
+
+void frame_print(const IrView* view, FILE* out) {
+    uint32_t i, k;
+    fprintf(out, "Registros de ativacao (celulas de 32 bits):\n");
+    fprintf(out, "  %-20s %8s %18s %12s %8s\n", "funcao", "params", "variaveis", "temporarios", "total");
+    for (i = 0; i < view->nunits; i++) {
+        const IrUnitRec* u = &view->units[i];
+        const IrSlotRec* slots = view->slots + u->slotFirst;
+        uint32_t used = ir_frame_slots(slots, u->nslots);
+        uint32_t vars = used > u->nparams ? used - u->nparams : 0;
+        uint32_t sum = 0;
+        char buf[32];
+        for (k = u->nparams; k < u->nslots; k++)
+            sum += slots[k].size > 0 ? (uint32_t)slots[k].size : 1;
+        if (sum != vars)
+            snprintf(buf, sizeof(buf), "%u (de %u)", vars, sum);
+        else
+            snprintf(buf, sizeof(buf), "%u", vars);
+        fprintf(out, "  %-20s %8u %18s %12u %8u\n", view->strs + u->name, u->nparams, buf, u->ntemps, used + u->ntemps);
+    }
+}
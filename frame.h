@@ -0,0 +1,43 @@
+/**
+ * @file frame.h
+ * @brief Registro de ativacao das funcoes: reuso de temporarios e relatorio
+ *
+ * O registro de uma funcao tem os parametros, as variaveis locais e os
+ * temporarios, nessa ordem. Os offsets dos slots sao escolhidos na geracao
+ * de codigo (ir_add_slot): variaveis de blocos irmaos dividem as mesmas
+ * celulas. Os temporarios saem do gerador com um numero novo por valor;
+ * frame_pack_temps() calcula a vida de cada um e renumera os que nunca
+ * estao vivos ao mesmo tempo para a mesma celula (-O1 em diante; em -O2,
+ * depois dos passes sobre o programa inteiro).
+ */
+
+#ifndef _FRAME_H_
+#define _FRAME_H_
+
+#include <stdio.h>
+#include "ir.h"
+
+struct OptStats;
+
+/**
+ * @brief Renumera os temporarios de uma funcao reaproveitando as celulas
+ *
+ * A vida de cada temporario vem de uma analise de vivacidade sobre os
+ * blocos basicos (so para os temporarios lidos em um bloco diferente do
+ * que os define); dois temporarios cujos intervalos de vida nao se cruzam
+ * recebem o mesmo numero (varredura linear).
+ *
+ * @param unit Funcao
+ * @param stats Contadores somados de forma atomica (NULL = nao conta)
+ * @return Temporarios economizados
+ */
+uint32_t frame_pack_temps(IrUnit* unit, struct OptStats* stats);
+
+/**
+ * @brief Imprime o tamanho do registro de ativacao de cada funcao
+ * @param view Programa
+ * @param out Arquivo de saida
+ */
+void frame_print(const IrView* view, FILE* out);
+
+#endif
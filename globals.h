@@ -20,11 +20,12 @@
 
 #define MAXCHILDREN 3
 
+// Versao do compilador (faz parte da chave do cache de compilacao)
+#define CMINUS_VERSION "1.1"
+
 typedef int Boolean;
 typedef int TokenType;
 
-extern int lineno;
-
 // Categorias de nos da AST
 typedef enum {
     StmtK,     // Statement (comando/instrucao)
@@ -89,15 +90,39 @@ typedef struct treeNode {
     ExpType type;
 } TreeNode;
 
-extern FILE* source;
-extern FILE* listing;
-extern FILE* code;
-
-extern int EchoSource;
-extern int TraceScan;
-extern int TraceParse;
-extern int TraceAnalyze;
-extern int TraceCode;
-extern int Error;
+/**
+ * @brief Estado de uma compilacao
+ *
+ * Todo o estado das fases (scanner, parser, tabela de simbolos, analise e
+ * geracao de codigo) fica aqui, de forma que varias compilacoes possam
+ * rodar no mesmo processo, inclusive em threads diferentes.
+ */
+typedef struct CompilerContext {
+    FILE* listing;                    // saida das fases (arvore, tabela, codigo)
+    FILE* errors;                     // mensagens de erro
+    int error;                        // TRUE se alguma fase encontrou erro
+    int lineno;                       // linha atual do scanner
+    void* scanner;                    // scanner reentrante (yyscan_t)
+    int scanInPlace;                  // fonte termina com dois '\0' e o scanner pode altera-lo (sem copia)
+    int lexer;                        // scanner usado (LEXER_FLEX ou LEXER_SIMD, lexer.h)
+    int prelex;                       // le os tokens para um vetor antes do parser (tokens.h)
+    struct TokenStream* tokens;       // vetor de tokens em uso pelo parser (NULL = sob demanda)
+    TreeNode* savedTree;              // raiz da AST construida pelo parser
+    struct ScopeListRec* scopeStack;  // pilha de escopos ativos
+    struct ScopeListRec* allScopes;   // todos os escopos criados
+    int globalMemLoc;                 // contador para variaveis globais
+    int localMemLoc;                  // contador para variaveis locais
+    int indentno;                     // indentacao de printTree
+    struct IncrState* incr;           // recompilacao incremental (NULL desativa)
+    struct Pool* pool;                // threads da geracao de codigo (NULL = serial)
+    void (*onDecl)(struct CompilerContext*, TreeNode*); // declaracao global completa (NULL = guarda a AST)
+    void* stream;                     // estado do modo streaming (compiler.c)
+    struct PhaseReport* report;       // tempo e memoria por fase (NULL desativa, phase.h)
+    int optimize;                     // nivel de otimizacao (0 = nenhuma, 1 = peephole, opt.h)
+    struct OptStats* optStats;        // aplicacoes de cada regra do peephole (NULL = nao conta)
+    int unroll;                       // fator de desenrolamento dos lacos com contador (< 2 desliga, unroll.h)
+    int profileGen;                   // --profile-generate: conta blocos e chamadas na execucao (profile.h)
+    const struct Profile* profile;    // --profile-use (NULL = sem perfil)
+} CompilerContext;
 
 #endif
@@ -0,0 +1,462 @@
+/**
+ * @file incr.c
+ * @brief Implementacao da recompilacao incremental por funcao
+ */
+
+#include "incr.h"
+#include "cminus.tab.h"
+
+#define INCR_MAGIC 0x4e46434du   // "CMFN"
+
+/**
+ * @brief Cabecalho do blob de uma funcao
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t nparams;
+    uint32_t nslots;
+    uint32_t ntemps;
+    uint32_t nlabels;
+    uint32_t count;
+    uint32_t nstrs;
+    uint32_t strBytes;
+} IncrBlobHeader;
+
+/**
+ * @brief Hash de string para a tabela de declaracoes globais
+ * @param s String
+ * @return Valor hash
+ */
+static uint32_t nameHash(const char* s) {
+    uint32_t h = 2166136261u;
+    while (*s != '\0') {
+        h ^= (unsigned char)*s++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/**
+ * @brief Procura a declaracao global de um nome
+ * @param st Estado
+ * @param name Nome
+ * @return Declaracao ou NULL
+ */
+static TreeNode* findDecl(IncrState* st, const char* name) {
+    uint32_t j;
+    if (st->declCap == 0)
+        return NULL;
+    j = nameHash(name) & (st->declCap - 1);
+    while (st->decls[j] != NULL) {
+        if (strcmp(st->decls[j]->attr.name, name) == 0)
+            return st->decls[j];
+        j = (j + 1) & (st->declCap - 1);
+    }
+    return NULL;
+}
+
+void incr_init(IncrState* st, Cache* cache) {
+    memset(st, 0, sizeof(*st));
+    st->cache = cache;
+}
+
+void incr_begin(IncrState* st, TreeNode* syntaxTree) {
+    TreeNode* t;
+    uint32_t n = 0;
+    for (t = syntaxTree; t != NULL; t = t->sibling)
+        n++;
+    free(st->decls);
+    st->declCap = 16;
+    while (st->declCap < n * 2)
+        st->declCap *= 2;
+    st->decls = (TreeNode**)calloc(st->declCap, sizeof(TreeNode*));
+    st->declCount = 0;
+    for (t = syntaxTree; t != NULL; t = t->sibling)
+        incr_declare(st, t);
+}
+
+void incr_declare(IncrState* st, TreeNode* decl) {
+    uint32_t i, j;
+    if (decl->nodekind != DeclK || findDecl(st, decl->attr.name) != NULL)
+        return;
+    if ((st->declCount + 1) * 2 > st->declCap) {
+        TreeNode** old = st->decls;
+        uint32_t oldCap = st->declCap;
+        st->declCap = st->declCap ? st->declCap * 2 : 16;
+        st->decls = (TreeNode**)calloc(st->declCap, sizeof(TreeNode*));
+        for (i = 0; i < oldCap; i++) {
+            if (old[i] != NULL) {
+                j = nameHash(old[i]->attr.name) & (st->declCap - 1);
+                while (st->decls[j] != NULL)
+                    j = (j + 1) & (st->declCap - 1);
+                st->decls[j] = old[i];
+            }
+        }
+        free(old);
+    }
+    j = nameHash(decl->attr.name) & (st->declCap - 1);
+    while (st->decls[j] != NULL)
+        j = (j + 1) & (st->declCap - 1);
+    st->decls[j] = decl;
+    st->declCount++;
+}
+
+void incr_free(IncrState* st) {
+    free(st->decls);
+    free(st->buf);
+    free(st->locals);
+    memset(st, 0, sizeof(*st));
+}
+
+/**
+ * @brief Acrescenta bytes a impressao digital
+ * @param st Estado
+ * @param p Dados
+ * @param n Numero de bytes
+ */
+static void put(IncrState* st, const void* p, size_t n) {
+    if (st->len + n > st->cap) {
+        while (st->len + n > st->cap)
+            st->cap = st->cap ? st->cap * 2 : 1024;
+        st->buf = (char*)realloc(st->buf, st->cap);
+    }
+    memcpy(st->buf + st->len, p, n);
+    st->len += n;
+}
+
+/**
+ * @brief Acrescenta um inteiro a impressao digital
+ * @param st Estado
+ * @param v Valor
+ */
+static void putInt(IncrState* st, int32_t v) {
+    put(st, &v, sizeof(v));
+}
+
+/**
+ * @brief Acrescenta uma string (com o '\0') a impressao digital
+ * @param st Estado
+ * @param s String
+ */
+static void putStr(IncrState* st, const char* s) {
+    put(st, s, strlen(s) + 1);
+}
+
+/**
+ * @brief Acrescenta a assinatura de um nome global referenciado
+ * @param st Estado
+ * @param name Nome
+ */
+static void putSignature(IncrState* st, const char* name) {
+    TreeNode* d = findDecl(st, name);
+    TreeNode* p;
+    put(st, "E", 1);
+    if (d == NULL) {
+        // input/output ou nome inexistente (rejeitado pela analise semantica)
+        putStr(st, name);
+        return;
+    }
+    putInt(st, d->kind.decl);
+    putInt(st, d->type);
+    if (d->kind.decl == ArrayK && d->child[0] != NULL)
+        putInt(st, d->child[0]->attr.val);
+    if (d->kind.decl == FunK)
+        for (p = d->child[0]; p != NULL; p = p->sibling)
+            putInt(st, p->type);
+}
+
+/**
+ * @brief Verifica se um nome e local no ponto atual da travessia
+ * @param st Estado
+ * @param name Nome
+ * @return TRUE se local
+ */
+static int isLocal(IncrState* st, const char* name) {
+    int i;
+    for (i = st->nlocals - 1; i >= 0; i--)
+        if (strcmp(st->locals[i], name) == 0)
+            return TRUE;
+    return FALSE;
+}
+
+/**
+ * @brief Torna um nome local visivel
+ * @param st Estado
+ * @param name Nome
+ */
+static void pushLocal(IncrState* st, char* name) {
+    if (st->nlocals == st->localCap) {
+        st->localCap = st->localCap ? st->localCap * 2 : 16;
+        st->locals = (char**)realloc(st->locals, st->localCap * sizeof(char*));
+    }
+    st->locals[st->nlocals++] = name;
+}
+
+/**
+ * @brief Serializa uma lista de nos irmaos na impressao digital
+ * @param st Estado
+ * @param t Primeiro no da lista
+ */
+static void walk(IncrState* st, TreeNode* t) {
+    for (; t != NULL; t = t->sibling) {
+        int mark = st->nlocals;
+        int i;
+        put(st, "N", 1);
+        // linha relativa: as instrucoes guardadas levam a linha do fonte
+        putInt(st, t->lineno - st->baseLine);
+        putInt(st, t->nodekind);
+        putInt(st, t->kind.stmt);
+        putInt(st, t->type);
+        if (t->nodekind == ExpK && t->kind.exp == OpK) {
+            putInt(st, t->attr.op);
+        } else if (t->nodekind == ExpK && t->kind.exp == ConstK) {
+            putInt(st, t->attr.val);
+        } else if (t->nodekind == ExpK && (t->kind.exp == IdK || t->kind.exp == CallK)) {
+            putStr(st, t->attr.name);
+            if (!isLocal(st, t->attr.name))
+                putSignature(st, t->attr.name);
+        } else if (t->nodekind == DeclK) {
+            putStr(st, t->attr.name);
+            if (t->kind.decl == ArrayK && t->child[0] != NULL)
+                putInt(st, t->child[0]->attr.val);
+        }
+        if (t->nodekind == StmtK && t->kind.stmt == CompoundK) {
+            TreeNode* d;
+            for (d = t->child[0]; d != NULL; d = d->sibling)
+                pushLocal(st, d->attr.name);
+        }
+        for (i = 0; i < MAXCHILDREN; i++) {
+            if (t->child[i] == NULL || (t->nodekind == DeclK && t->kind.decl == ArrayK)) {
+                put(st, "-", 1);
+            } else {
+                put(st, "(", 1);
+                walk(st, t->child[i]);
+                put(st, ")", 1);
+            }
+        }
+        if (t->nodekind == StmtK && t->kind.stmt == CompoundK)
+            st->nlocals = mark;
+    }
+}
+
+void incr_fingerprint(IncrState* st, TreeNode* fun, CacheKey* key) {
+    TreeNode* p;
+    st->len = 0;
+    st->nlocals = 0;
+    st->baseLine = fun->lineno;
+    put(st, "F", 1);
+    // o codigo guardado depende do nivel de otimizacao (sem -O a chave nao muda)
+    if (st->optimize > 0) {
+        put(st, "O", 1);
+        putInt(st, st->optimize);
+    }
+    if (st->unroll > 1) {
+        put(st, "U", 1);
+        putInt(st, st->unroll);
+    }
+    if (st->profileGen)
+        put(st, "G", 1);
+    if (st->profile != 0) {
+        put(st, "P", 1);
+        put(st, &st->profile, sizeof(st->profile));
+    }
+    putStr(st, fun->attr.name);
+    putInt(st, fun->type);
+    for (p = fun->child[0]; p != NULL; p = p->sibling) {
+        putStr(st, p->attr.name);
+        putInt(st, p->type);
+        pushLocal(st, p->attr.name);
+    }
+    put(st, "(", 1);
+    walk(st, fun->child[1]);
+    put(st, ")", 1);
+    cache_key(key, st->buf, st->len, "fn");
+}
+
+/**
+ * @brief Indice de uma string na lista de nomes do blob (insere se ausente)
+ * @param offs Offsets na tabela do programa ja inseridos
+ * @param n Numero de nomes inseridos (atualizado)
+ * @param off Offset do nome
+ * @param dedupe TRUE para reaproveitar um nome igual
+ * @return Ordinal do nome no blob
+ */
+static uint32_t blobName(uint32_t* offs, uint32_t* n, uint32_t off, int dedupe) {
+    uint32_t i;
+    if (dedupe)
+        for (i = 0; i < *n; i++)
+            if (offs[i] == off)
+                return i;
+    offs[*n] = off;
+    return (*n)++;
+}
+
+/**
+ * @brief Troca operandos globais e de funcao pelo ordinal do nome no blob
+ * @param prog Programa
+ * @param kind Tipo do operando
+ * @param val Valor do operando (atualizado)
+ * @param offs Nomes do blob
+ * @param n Numero de nomes do blob
+ */
+static void encodeOpnd(const IrProgram* prog, uint8_t kind, int32_t* val, uint32_t* offs, uint32_t* n) {
+    if (kind == IR_GLOBAL)
+        *val = (int32_t)blobName(offs, n, prog->globals[*val].name, TRUE);
+    else if (kind == IR_FUNC && *val >= 0)
+        *val = (int32_t)blobName(offs, n, prog->units[*val].rec.name, TRUE);
+}
+
+void incr_save(IncrState* st, const CacheKey* key, int line, const IrProgram* prog, const IrUnit* unit) {
+    IncrBlobHeader h;
+    uint32_t* offs;
+    IrInstr* code;
+    char* blob;
+    size_t size, pos;
+    uint32_t i, nstrs = 0, strBytes = 0;
+    __atomic_add_fetch(&st->rebuilt, 1, __ATOMIC_RELAXED);
+    // no maximo um nome por slot e tres por instrucao
+    offs = (uint32_t*)malloc((unit->rec.nslots + 3 * unit->rec.count + 1) * sizeof(uint32_t));
+    code = (IrInstr*)malloc((unit->rec.count + 1) * sizeof(IrInstr));
+    if (offs == NULL || code == NULL) {
+        free(offs);
+        free(code);
+        return;
+    }
+    for (i = 0; i < unit->rec.nslots; i++)
+        blobName(offs, &nstrs, unit->slots[i].name, FALSE);
+    for (i = 0; i < unit->rec.count; i++) {
+        code[i] = unit->code[i];
+        // INT32_MIN marca a instrucao sem linha (a linha relativa pode ser 0)
+        code[i].line = code[i].line != 0 ? code[i].line - line : INT32_MIN;
+        encodeOpnd(prog, code[i].kd, &code[i].d, offs, &nstrs);
+        encodeOpnd(prog, code[i].ka, &code[i].a, offs, &nstrs);
+        encodeOpnd(prog, code[i].kb, &code[i].b, offs, &nstrs);
+    }
+    for (i = 0; i < nstrs; i++)
+        strBytes += (uint32_t)strlen(prog->strs.data + offs[i]) + 1;
+    h.magic = INCR_MAGIC;
+    h.nparams = unit->rec.nparams;
+    h.nslots = unit->rec.nslots;
+    h.ntemps = unit->rec.ntemps;
+    h.nlabels = unit->rec.nlabels;
+    h.count = unit->rec.count;
+    h.nstrs = nstrs;
+    h.strBytes = strBytes;
+    size = sizeof(h) + h.nslots * 2 * sizeof(int32_t) + h.count * sizeof(IrInstr) + strBytes;
+    blob = (char*)malloc(size);
+    if (blob != NULL) {
+        memcpy(blob, &h, sizeof(h));
+        pos = sizeof(h);
+        for (i = 0; i < h.nslots; i++) {
+            memcpy(blob + pos, &unit->slots[i].size, sizeof(int32_t));
+            memcpy(blob + pos + sizeof(int32_t), &unit->slots[i].offset, sizeof(int32_t));
+            pos += 2 * sizeof(int32_t);
+        }
+        memcpy(blob + pos, code, h.count * sizeof(IrInstr));
+        pos += h.count * sizeof(IrInstr);
+        for (i = 0; i < nstrs; i++) {
+            size_t n = strlen(prog->strs.data + offs[i]) + 1;
+            memcpy(blob + pos, prog->strs.data + offs[i], n);
+            pos += n;
+        }
+        cache_put_blob(st->cache, key, blob, size);
+        free(blob);
+    }
+    free(offs);
+    free(code);
+}
+
+/**
+ * @brief Troca o ordinal de um nome do blob pelo operando do programa atual
+ * @param names Nomes do blob
+ * @param nstrs Numero de nomes
+ * @param resolve Resolucao de nomes globais
+ * @param arg Argumento repassado a 'resolve'
+ * @param kind Tipo do operando (atualizado)
+ * @param val Valor do operando (atualizado)
+ * @return 0 se sucesso, -1 se o nome nao existe mais
+ */
+static int decodeOpnd(char** names, uint32_t nstrs, IncrResolve resolve, void* arg,
+                      uint8_t* kind, int32_t* val) {
+    IrInstr r;
+    if (*kind != IR_GLOBAL && !(*kind == IR_FUNC && *val >= 0))
+        return 0;
+    if ((uint32_t)*val >= nstrs)
+        return -1;
+    r = resolve(arg, names[*val]);
+    if (r.ka != *kind)
+        return -1;
+    *val = r.a;
+    return 0;
+}
+
+int incr_load(IncrState* st, const CacheKey* key, int line, IrProgram* prog, IrUnit* unit,
+              IncrResolve resolve, void* arg) {
+    IncrBlobHeader h;
+    char* blob;
+    size_t size, pos, need;
+    char** names = NULL;
+    const int32_t* sizes;
+    IrInstr* code;
+    uint32_t i;
+    int ok = TRUE;
+    if (!cache_get_blob(st->cache, key, &blob, &size))
+        return 0;
+    if (size < sizeof(h)) {
+        free(blob);
+        return 0;
+    }
+    memcpy(&h, blob, sizeof(h));
+    need = sizeof(h) + (size_t)h.nslots * 2 * sizeof(int32_t) + (size_t)h.count * sizeof(IrInstr) + h.strBytes;
+    if (h.magic != INCR_MAGIC || need != size || h.nparams > h.nslots || h.nslots > h.nstrs) {
+        free(blob);
+        return 0;
+    }
+    pos = sizeof(h);
+    sizes = (const int32_t*)(blob + pos);
+    pos += h.nslots * 2 * sizeof(int32_t);
+    code = (IrInstr*)(blob + pos);
+    pos += h.count * sizeof(IrInstr);
+    names = (char**)malloc((h.nstrs + 1) * sizeof(char*));
+    for (i = 0; ok && i < h.nstrs; i++) {
+        char* end = memchr(blob + pos, '\0', size - pos);
+        if (end == NULL) {
+            ok = FALSE;
+            break;
+        }
+        names[i] = blob + pos;
+        pos = (size_t)(end - blob) + 1;
+    }
+    for (i = 0; ok && i < h.count; i++) {
+        IrInstr in;
+        memcpy(&in, &code[i], sizeof(in));
+        if (decodeOpnd(names, h.nstrs, resolve, arg, &in.kd, &in.d) != 0 ||
+            decodeOpnd(names, h.nstrs, resolve, arg, &in.ka, &in.a) != 0 ||
+            decodeOpnd(names, h.nstrs, resolve, arg, &in.kb, &in.b) != 0)
+            ok = FALSE;
+        memcpy(&code[i], &in, sizeof(in));
+    }
+    if (ok) {
+        for (i = 0; i < h.nslots; i++) {
+            int32_t sz, off;
+            int slot;
+            memcpy(&sz, &sizes[2 * i], sizeof(sz));
+            memcpy(&off, &sizes[2 * i + 1], sizeof(off));
+            slot = ir_add_slot(prog, unit, names[i], sz);
+            unit->slots[slot].offset = off;
+        }
+        for (i = 0; i < h.count; i++) {
+            IrInstr in;
+            memcpy(&in, &code[i], sizeof(in));
+            in.line = in.line != INT32_MIN ? in.line + line : 0;
+            ir_emit(unit, in);
+        }
+        unit->rec.nparams = h.nparams;
+        unit->rec.ntemps = h.ntemps;
+        unit->rec.nlabels = h.nlabels;
+        __atomic_add_fetch(&st->reused, 1, __ATOMIC_RELAXED);
+    }
+    free(names);
+    free(blob);
+    return ok;
+}
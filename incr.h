@@ -0,0 +1,122 @@
+/**
+ * @file incr.h
+ * @brief Recompilacao incremental por funcao
+ *
+ * A impressao digital de uma funcao cobre a subarvore FunK inteira (tipos,
+ * nomes, constantes e operadores, sem numeros de linha) e a assinatura de
+ * cada global e funcao chamada que ela referencia. Se a assinatura de uma
+ * funcao chamada muda, a impressao digital de quem a chama tambem muda, de
+ * forma que os dependentes sao regenerados junto.
+ *
+ * O codigo intermediario de cada funcao e guardado no cache (blob ".fn")
+ * com os nomes das globais e funcoes referenciadas, e remapeado para os
+ * indices do programa atual quando reutilizado.
+ *
+ * incr_fingerprint usa buffers do estado e deve ser chamada por uma thread
+ * de cada vez; incr_load e incr_save podem rodar em paralelo (funcoes
+ * diferentes) desde que os nomes locais ja estejam na tabela de strings.
+ */
+
+#ifndef _INCR_H_
+#define _INCR_H_
+
+#include "globals.h"
+#include "ir.h"
+#include "cache.h"
+
+/**
+ * @brief Resolve um nome global para um operando (IR_GLOBAL ou IR_FUNC)
+ */
+typedef IrInstr (*IncrResolve)(void* arg, char* name);
+
+/**
+ * @brief Estado da recompilacao incremental de um programa
+ */
+typedef struct IncrState {
+    Cache* cache;
+    TreeNode** decls;       // hash aberto nome -> declaracao global
+    uint32_t declCap;
+    uint32_t declCount;
+    char* buf;              // impressao digital em construcao
+    size_t len;
+    size_t cap;
+    char** locals;          // nomes locais visiveis durante a travessia
+    int nlocals;
+    int localCap;
+    int reused;             // funcoes reutilizadas do cache (atomico)
+    int rebuilt;            // funcoes regeneradas (atomico)
+    int optimize;           // nivel de otimizacao do codigo guardado (cgen.c)
+    int unroll;             // fator de desenrolamento do codigo guardado (cgen.c)
+    int profileGen;         // codigo guardado com contadores (--profile-generate)
+    int baseLine;           // linha da funcao na impressao digital em construcao
+    unsigned long long profile; // hash do perfil usado no codigo guardado (0 = nenhum)
+} IncrState;
+
+/**
+ * @brief Prepara a recompilacao incremental
+ * @param st Estado a inicializar
+ * @param cache Cache onde ficam os blobs de funcao
+ */
+void incr_init(IncrState* st, Cache* cache);
+
+/**
+ * @brief Indexa as declaracoes globais de um programa antes da geracao
+ * @param st Estado
+ * @param syntaxTree Raiz da arvore sintatica (declaracoes globais)
+ */
+void incr_begin(IncrState* st, TreeNode* syntaxTree);
+
+/**
+ * @brief Indexa uma declaracao global (modo streaming, antes de gerar a funcao)
+ *
+ * A declaracao precisa continuar valida enquanto o estado for usado; no modo
+ * streaming so o corpo das funcoes e liberado.
+ *
+ * @param st Estado
+ * @param decl Declaracao global
+ */
+void incr_declare(IncrState* st, TreeNode* decl);
+
+/**
+ * @brief Libera o estado da recompilacao incremental
+ * @param st Estado
+ */
+void incr_free(IncrState* st);
+
+/**
+ * @brief Calcula a impressao digital de uma funcao
+ * @param st Estado
+ * @param fun No FunK
+ * @param key Chave do blob da funcao
+ */
+void incr_fingerprint(IncrState* st, TreeNode* fun, CacheKey* key);
+
+/**
+ * @brief Reaproveita o codigo de uma funcao guardado no cache
+ *
+ * As linhas das instrucoes ficam no blob relativas a linha da funcao, de
+ * forma que uma funcao que so mudou de lugar no fonte continua valendo.
+ *
+ * @param st Estado
+ * @param key Impressao digital da funcao
+ * @param line Linha da funcao no fonte atual (TreeNode.lineno do FunK)
+ * @param prog Programa em construcao
+ * @param unit Funcao recem criada (vazia) a preencher
+ * @param resolve Resolucao de nomes globais do programa atual
+ * @param arg Argumento repassado a 'resolve'
+ * @return 1 se reutilizou, 0 se a funcao precisa ser gerada
+ */
+int incr_load(IncrState* st, const CacheKey* key, int line, IrProgram* prog, IrUnit* unit,
+              IncrResolve resolve, void* arg);
+
+/**
+ * @brief Guarda o codigo de uma funcao recem gerada no cache
+ * @param st Estado
+ * @param key Impressao digital da funcao
+ * @param line Linha da funcao no fonte
+ * @param prog Programa em construcao
+ * @param unit Funcao gerada
+ */
+void incr_save(IncrState* st, const CacheKey* key, int line, const IrProgram* prog, const IrUnit* unit);
+
+#endif
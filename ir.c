@@ -0,0 +1,420 @@
+/**
+ * @file ir.c
+ * @brief Implementacao da representacao intermediaria em memoria
+ */
+
+#include "ir.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief realloc que aborta em falta de memoria
+ * @param p Bloco atual
+ * @param n Novo tamanho em bytes
+ * @return Bloco realocado
+ */
+static void* irRealloc(void* p, size_t n) {
+    void* q = realloc(p, n);
+    if (q == NULL && n != 0) {
+        fprintf(stderr, "Erro de alocacao de memoria no codigo intermediario\n");
+        exit(1);
+    }
+    return q;
+}
+
+/**
+ * @brief Funcao hash FNV-1a para a tabela de strings
+ * @param s String
+ * @return Valor hash
+ */
+static uint32_t strHash(const char* s) {
+    uint32_t h = 2166136261u;
+    while (*s != '\0') {
+        h ^= (unsigned char)*s++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/**
+ * @brief Dobra a tabela hash de strings e reinsere as entradas
+ * @param tab Tabela de strings
+ */
+static void strtabGrow(IrStrTab* tab) {
+    uint32_t newCap = tab->hashCap ? tab->hashCap * 2 : 64;
+    uint32_t* newHash = (uint32_t*)calloc(newCap, sizeof(uint32_t));
+    uint32_t i;
+    if (newHash == NULL) {
+        fprintf(stderr, "Erro de alocacao de memoria no codigo intermediario\n");
+        exit(1);
+    }
+    for (i = 0; i < tab->hashCap; i++) {
+        if (tab->hash[i] != 0) {
+            uint32_t j = strHash(tab->data + tab->hash[i] - 1) & (newCap - 1);
+            while (newHash[j] != 0)
+                j = (j + 1) & (newCap - 1);
+            newHash[j] = tab->hash[i];
+        }
+    }
+    free(tab->hash);
+    tab->hash = newHash;
+    tab->hashCap = newCap;
+}
+
+uint32_t ir_strtab_find(const IrStrTab* tab, const char* s) {
+    uint32_t j;
+    if (tab->hashCap == 0)
+        return UINT32_MAX;
+    j = strHash(s) & (tab->hashCap - 1);
+    while (tab->hash[j] != 0) {
+        if (strcmp(tab->data + tab->hash[j] - 1, s) == 0)
+            return tab->hash[j] - 1;
+        j = (j + 1) & (tab->hashCap - 1);
+    }
+    return UINT32_MAX;
+}
+
+uint32_t ir_intern(IrStrTab* tab, const char* s) {
+    uint32_t off = ir_strtab_find(tab, s);
+    uint32_t n, j;
+    if (off != UINT32_MAX)
+        return off;
+    if ((tab->count + 1) * 2 > tab->hashCap)
+        strtabGrow(tab);
+    n = (uint32_t)strlen(s) + 1;
+    if (tab->size + n > tab->cap) {
+        while (tab->size + n > tab->cap)
+            tab->cap = tab->cap ? tab->cap * 2 : 256;
+        tab->data = (char*)irRealloc(tab->data, tab->cap);
+    }
+    off = tab->size;
+    memcpy(tab->data + off, s, n);
+    tab->size += n;
+    j = strHash(s) & (tab->hashCap - 1);
+    while (tab->hash[j] != 0)
+        j = (j + 1) & (tab->hashCap - 1);
+    tab->hash[j] = off + 1;
+    tab->count++;
+    return off;
+}
+
+void ir_init(IrProgram* prog) {
+    memset(prog, 0, sizeof(*prog));
+}
+
+void ir_free(IrProgram* prog) {
+    uint32_t i;
+    for (i = 0; i < prog->nunits; i++) {
+        free(prog->units[i].code);
+        free(prog->units[i].slots);
+    }
+    free(prog->units);
+    free(prog->globals);
+    free(prog->strs.data);
+    free(prog->strs.hash);
+    memset(prog, 0, sizeof(*prog));
+}
+
+void ir_reset(IrProgram* prog) {
+    uint32_t i;
+    for (i = 0; i < prog->nunits; i++) {
+        free(prog->units[i].code);
+        free(prog->units[i].slots);
+    }
+    prog->nunits = 0;
+    prog->nglobals = 0;
+    prog->strs.size = 0;
+    prog->strs.count = 0;
+    if (prog->strs.hash != NULL)
+        memset(prog->strs.hash, 0, prog->strs.hashCap * sizeof(uint32_t));
+}
+
+int ir_add_global(IrProgram* prog, const char* name, int size) {
+    IrGlobalRec* g;
+    if (prog->nglobals == prog->globalCap) {
+        prog->globalCap = prog->globalCap ? prog->globalCap * 2 : 16;
+        prog->globals = (IrGlobalRec*)irRealloc(prog->globals, prog->globalCap * sizeof(IrGlobalRec));
+    }
+    g = &prog->globals[prog->nglobals];
+    g->name = ir_intern(&prog->strs, name);
+    g->size = size;
+    g->pos = prog->nunits;
+    return (int)prog->nglobals++;
+}
+
+IrUnit* ir_add_unit(IrProgram* prog, const char* name) {
+    IrUnit* u;
+    if (prog->nunits == prog->unitCap) {
+        prog->unitCap = prog->unitCap ? prog->unitCap * 2 : 16;
+        prog->units = (IrUnit*)irRealloc(prog->units, prog->unitCap * sizeof(IrUnit));
+    }
+    u = &prog->units[prog->nunits++];
+    memset(u, 0, sizeof(*u));
+    u->rec.name = ir_intern(&prog->strs, name);
+    return u;
+}
+
+int ir_add_slot(IrProgram* prog, IrUnit* unit, const char* name, int size) {
+    IrSlotRec* s;
+    if (unit->rec.nslots == unit->slotCap) {
+        unit->slotCap = unit->slotCap ? unit->slotCap * 2 : 8;
+        unit->slots = (IrSlotRec*)irRealloc(unit->slots, unit->slotCap * sizeof(IrSlotRec));
+    }
+    s = &unit->slots[unit->rec.nslots];
+    s->name = ir_intern(&prog->strs, name);
+    s->size = size;
+    s->offset = (int32_t)unit->slotTop;
+    unit->slotTop += size > 0 ? (uint32_t)size : 1;
+    return (int)unit->rec.nslots++;
+}
+
+uint32_t ir_frame_slots(const IrSlotRec* slots, uint32_t nslots) {
+    uint32_t k, top = 0;
+    for (k = 0; k < nslots; k++) {
+        uint32_t end = (uint32_t)slots[k].offset + (slots[k].size > 0 ? (uint32_t)slots[k].size : 1);
+        if (end > top)
+            top = end;
+    }
+    return top;
+}
+
+void ir_emit(IrUnit* unit, IrInstr ins) {
+    if (unit->rec.count == unit->cap) {
+        unit->cap = unit->cap ? unit->cap * 2 : 32;
+        unit->code = (IrInstr*)irRealloc(unit->code, unit->cap * sizeof(IrInstr));
+    }
+    if (ins.line == 0)
+        ins.line = unit->line;
+    unit->code[unit->rec.count++] = ins;
+}
+
+void ir_flatten(const IrProgram* prog, IrView* view) {
+    IrUnitRec* units;
+    IrSlotRec* slots;
+    IrInstr* code;
+    uint32_t i, ncode = 0, nslots = 0;
+    for (i = 0; i < prog->nunits; i++) {
+        ncode += prog->units[i].rec.count;
+        nslots += prog->units[i].rec.nslots;
+    }
+    units = (IrUnitRec*)irRealloc(NULL, (prog->nunits + 1) * sizeof(IrUnitRec));
+    slots = (IrSlotRec*)irRealloc(NULL, (nslots + 1) * sizeof(IrSlotRec));
+    code = (IrInstr*)irRealloc(NULL, (ncode + 1) * sizeof(IrInstr));
+    ncode = 0;
+    nslots = 0;
+    for (i = 0; i < prog->nunits; i++) {
+        const IrUnit* u = &prog->units[i];
+        units[i] = u->rec;
+        units[i].first = ncode;
+        units[i].slotFirst = nslots;
+        if (u->rec.count > 0)
+            memcpy(code + ncode, u->code, u->rec.count * sizeof(IrInstr));
+        if (u->rec.nslots > 0)
+            memcpy(slots + nslots, u->slots, u->rec.nslots * sizeof(IrSlotRec));
+        ncode += u->rec.count;
+        nslots += u->rec.nslots;
+    }
+    view->units = units;
+    view->nunits = prog->nunits;
+    view->globals = prog->globals;
+    view->nglobals = prog->nglobals;
+    view->slots = slots;
+    view->nslots = nslots;
+    view->code = code;
+    view->ncode = ncode;
+    view->strs = prog->strs.data;
+    view->strSize = prog->strs.size;
+}
+
+void ir_view_free(IrView* view) {
+    free((void*)view->units);
+    free((void*)view->slots);
+    free((void*)view->code);
+    memset(view, 0, sizeof(*view));
+}
+
+const char* ir_op_str(IrOp op) {
+    switch (op) {
+        case IR_ADD: return "+";
+        case IR_SUB: return "-";
+        case IR_MUL: return "*";
+        case IR_DIV: return "/";
+        case IR_LT:  return "<";
+        case IR_LE:  return "<=";
+        case IR_GT:  return ">";
+        case IR_GE:  return ">=";
+        case IR_EQ:  return "==";
+        case IR_NE:  return "!=";
+        default:     return NULL;
+    }
+}
+
+// Pares (escalar, vetorial), na ordem de IrOp
+static const IrOp vectorPairs[][2] = {
+    {IR_COPY, IR_VCOPY}, {IR_ADD, IR_VADD}, {IR_SUB, IR_VSUB}, {IR_MUL, IR_VMUL},
+    {IR_LT, IR_VLT}, {IR_LE, IR_VLE}, {IR_GT, IR_VGT}, {IR_GE, IR_VGE},
+    {IR_EQ, IR_VEQ}, {IR_NE, IR_VNE}
+};
+
+IrOp ir_vector_op(IrOp op) {
+    size_t i;
+    for (i = 0; i < sizeof(vectorPairs) / sizeof(vectorPairs[0]); i++)
+        if (vectorPairs[i][0] == op)
+            return vectorPairs[i][1];
+    return IR_NOP;
+}
+
+IrOp ir_scalar_op(IrOp op) {
+    size_t i;
+    for (i = 0; i < sizeof(vectorPairs) / sizeof(vectorPairs[0]); i++)
+        if (vectorPairs[i][1] == op)
+            return vectorPairs[i][0];
+    return IR_NOP;
+}
+
+/**
+ * @brief Verifica se um operando e um array (local, parametro int[] ou global)
+ */
+static int isArrayOpnd(const IrView* view, const IrUnitRec* u, int kind, int32_t val) {
+    if (kind == IR_LOCAL)
+        return view->slots[u->slotFirst + val].size != IR_SCALAR;
+    if (kind == IR_GLOBAL)
+        return view->globals[val].size > 0;
+    return 0;
+}
+
+/**
+ * @brief Formata um operando no texto de tres enderecos
+ * @param view Programa
+ * @param u Funcao que contem o operando
+ * @param kind Tipo do operando
+ * @param val Valor do operando
+ * @param tempBase Deslocamento de temporarios da funcao
+ * @param labelBase Deslocamento de labels da funcao
+ * @param buf Buffer de saida (minimo 16 bytes)
+ * @return Texto do operando
+ */
+static const char* opndStr(const IrView* view, const IrUnitRec* u, int kind, int32_t val,
+                           uint32_t tempBase, uint32_t labelBase, char* buf) {
+    switch (kind) {
+        case IR_TEMP:
+            sprintf(buf, "t%u", tempBase + (uint32_t)val);
+            return buf;
+        case IR_CONST:
+            sprintf(buf, "%d", val);
+            return buf;
+        case IR_LABEL:
+            sprintf(buf, "L%u", labelBase + (uint32_t)val);
+            return buf;
+        case IR_LOCAL:
+            return view->strs + view->slots[u->slotFirst + val].name;
+        case IR_GLOBAL:
+            return view->strs + view->globals[val].name;
+        case IR_FUNC:
+            if (val == IR_BUILTIN_INPUT)
+                return "input";
+            if (val == IR_BUILTIN_OUTPUT)
+                return "output";
+            return view->strs + view->units[val].name;
+        default:
+            return "?";
+    }
+}
+
+/**
+ * @brief Imprime as declaracoes de arrays globais de uma posicao
+ * @param view Programa
+ * @param pos Numero de funcoes que precedem as declaracoes
+ * @param g Proxima global a considerar (atualizado)
+ * @param out Arquivo de saida
+ */
+static void printGlobals(const IrView* view, uint32_t pos, uint32_t* g, FILE* out) {
+    while (*g < view->nglobals && view->globals[*g].pos <= pos) {
+        const IrGlobalRec* gr = &view->globals[*g];
+        if (gr->size > 0)
+            fprintf(out, "array %s[%d]\n", view->strs + gr->name, gr->size);
+        (*g)++;
+    }
+}
+
+void ir_print(const IrView* view, FILE* out) {
+    uint32_t tempBase = 0;
+    uint32_t labelBase = 0;
+    uint32_t g = 0;
+    uint32_t i, k;
+    char b1[16], b2[16], b3[16];
+    for (i = 0; i < view->nunits; i++) {
+        const IrUnitRec* u = &view->units[i];
+        printGlobals(view, i, &g, out);
+        fprintf(out, "\nfunc %s:\n", view->strs + u->name);
+        for (k = 0; k < u->nparams; k++)
+            fprintf(out, "param %s\n", view->strs + view->slots[u->slotFirst + k].name);
+        for (k = 0; k < u->count; k++) {
+            const IrInstr* in = &view->code[u->first + k];
+            const char* d = opndStr(view, u, in->kd, in->d, tempBase, labelBase, b1);
+            const char* a = opndStr(view, u, in->ka, in->a, tempBase, labelBase, b2);
+            const char* b = opndStr(view, u, in->kb, in->b, tempBase, labelBase, b3);
+            switch (in->op) {
+                case IR_COPY:
+                    fprintf(out, "%s = %s\n", d, a);
+                    break;
+                case IR_LOAD:
+                    fprintf(out, "%s = %s[%s]\n", d, a, b);
+                    break;
+                case IR_STORE:
+                    fprintf(out, "%s[%s] = %s\n", d, a, b);
+                    break;
+                case IR_PARAM:
+                    fprintf(out, "param %s\n", a);
+                    break;
+                case IR_CALL:
+                    if (in->kd != IR_NONE)
+                        fprintf(out, "%s = call %s, %s\n", d, a, b);
+                    else
+                        fprintf(out, "call %s, %s\n", a, b);
+                    break;
+                case IR_IFFALSE:
+                    fprintf(out, "if_false %s goto %s\n", a, b);
+                    break;
+                case IR_GOTO:
+                    fprintf(out, "goto %s\n", a);
+                    break;
+                case IR_LABEL_DEF:
+                    fprintf(out, "%s:\n", a);
+                    break;
+                case IR_RETURN:
+                    if (in->ka != IR_NONE)
+                        fprintf(out, "return %s\n", a);
+                    else
+                        fprintf(out, "return\n");
+                    break;
+                case IR_VSPAN:
+                    fprintf(out, "vspan %s, %s\n", a, b);
+                    break;
+                case IR_COUNT:
+                    fprintf(out, "count %s\n", a);
+                    break;
+                case IR_NOP:
+                    break;
+                default:
+                    if (IR_IS_VECTOR(in->op)) {
+                        IrOp op = ir_scalar_op((IrOp)in->op);
+                        const char* sa = isArrayOpnd(view, u, in->ka, in->a) ? "[]" : "";
+                        const char* sb = isArrayOpnd(view, u, in->kb, in->b) ? "[]" : "";
+                        if (op == IR_COPY)
+                            fprintf(out, "%s[] = %s%s\n", d, a, sa);
+                        else
+                            fprintf(out, "%s[] = %s%s %s %s%s\n", d, a, sa, ir_op_str(op), b, sb);
+                        break;
+                    }
+                    if (ir_op_str((IrOp)in->op) != NULL)
+                        fprintf(out, "%s = %s %s %s\n", d, a, ir_op_str((IrOp)in->op), b);
+                    break;
+            }
+        }
+        fprintf(out, "endfunc\n");
+        tempBase += u->ntemps;
+        labelBase += u->nlabels;
+    }
+    printGlobals(view, view->nunits, &g, out);
+}
@@ -0,0 +1,319 @@
+/**
+ * @file ir.h
+ * @brief Representacao intermediaria (codigo de tres enderecos) em memoria
+ *
+ * O gerador de codigo constroi um IrProgram em vez de imprimir o texto
+ * diretamente. O mesmo layout de registros (IrInstr, IrUnitRec, IrSlotRec,
+ * IrGlobalRec) e usado no arquivo binario .cmir (ver irfile.h), de forma que
+ * o VM executa tanto o programa recem gerado quanto o arquivo mapeado.
+ */
+
+#ifndef _IR_H_
+#define _IR_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+// Tipos de operandos de uma instrucao
+typedef enum {
+    IR_NONE,     // operando ausente
+    IR_TEMP,     // temporario tN (numeracao local a funcao)
+    IR_CONST,    // constante inteira
+    IR_LABEL,    // label LN (numeracao local a funcao)
+    IR_LOCAL,    // slot local da funcao (parametro ou variavel)
+    IR_GLOBAL,   // indice na tabela de globais do programa
+    IR_FUNC      // indice da funcao chamada (ou IR_BUILTIN_*)
+} IrOpndKind;
+
+// Funcoes predefinidas da linguagem C-
+#define IR_BUILTIN_INPUT  (-1)
+#define IR_BUILTIN_OUTPUT (-2)
+
+// Operacoes do codigo de tres enderecos
+typedef enum {
+    IR_NOP,
+    IR_COPY,      // d = a
+    IR_ADD,       // d = a + b
+    IR_SUB,       // d = a - b
+    IR_MUL,       // d = a * b
+    IR_DIV,       // d = a / b
+    IR_LT,        // d = a < b
+    IR_LE,        // d = a <= b
+    IR_GT,        // d = a > b
+    IR_GE,        // d = a >= b
+    IR_EQ,        // d = a == b
+    IR_NE,        // d = a != b
+    IR_LOAD,      // d = a[b]
+    IR_STORE,     // d[a] = b
+    IR_PARAM,     // param a
+    IR_CALL,      // d = call a, b  (d ausente em chamadas como statement)
+    IR_IFFALSE,   // if_false a goto b
+    IR_GOTO,      // goto a
+    IR_LABEL_DEF, // a:
+    IR_RETURN,    // return a
+    // operacoes vetoriais (-O3): cada operando e um array, lido elemento a
+    // elemento, ou um escalar repetido em todos os elementos
+    IR_VSPAN,     // vspan a, b: elementos [a, b) da proxima operacao vetorial
+    IR_VCOPY,     // d[] = a[]
+    IR_VADD,      // d[] = a[] + b[]
+    IR_VSUB,      // d[] = a[] - b[]
+    IR_VMUL,      // d[] = a[] * b[]
+    IR_VLT,       // d[] = a[] < b[]
+    IR_VLE,       // d[] = a[] <= b[]
+    IR_VGT,       // d[] = a[] > b[]
+    IR_VGE,       // d[] = a[] >= b[]
+    IR_VEQ,       // d[] = a[] == b[]
+    IR_VNE,       // d[] = a[] != b[]
+    IR_COUNT,     // count a: soma 1 no contador a da funcao (b = checksum da AST, profile.h)
+    IR_NUM_OPS
+} IrOp;
+
+// Operacao vetorial que grava no array d (depois de um IR_VSPAN)
+#define IR_IS_VECTOR(op) ((op) >= IR_VCOPY && (op) <= IR_VNE)
+
+/**
+ * @brief Instrucao de tres enderecos com largura fixa (20 bytes)
+ */
+typedef struct {
+    uint8_t op;             // IrOp
+    uint8_t kd, ka, kb;     // IrOpndKind de cada operando
+    int32_t d, a, b;        // valores dos operandos
+    int32_t line;           // linha do fonte que gerou a instrucao (0 = nenhuma)
+} IrInstr;
+
+// Tamanho dos slots locais e globais
+#define IR_SCALAR   0       // variavel inteira
+#define IR_ARRAYREF (-1)    // parametro int[] (referencia para array)
+
+/**
+ * @brief Slot local de uma funcao (parametros vem primeiro)
+ *
+ * Slots de blocos irmaos ({ int x; ... } { int y; ... }) nunca estao vivos
+ * ao mesmo tempo e recebem o mesmo offset no registro de ativacao.
+ */
+typedef struct {
+    uint32_t name;          // offset na tabela de strings
+    int32_t size;           // IR_SCALAR, IR_ARRAYREF ou numero de elementos
+    int32_t offset;         // primeira celula no registro de ativacao
+} IrSlotRec;
+
+/**
+ * @brief Variavel global
+ */
+typedef struct {
+    uint32_t name;          // offset na tabela de strings
+    int32_t size;           // IR_SCALAR ou numero de elementos
+    uint32_t pos;           // numero de funcoes declaradas antes dela
+} IrGlobalRec;
+
+/**
+ * @brief Indice de uma funcao: faixas de instrucoes e de slots
+ */
+typedef struct {
+    uint32_t name;          // offset na tabela de strings
+    uint32_t first;         // primeira instrucao
+    uint32_t count;         // numero de instrucoes
+    uint32_t slotFirst;     // primeiro slot
+    uint32_t nslots;        // numero de slots (parametros + locais)
+    uint32_t nparams;       // numero de parametros
+    uint32_t ntemps;        // temporarios usados
+    uint32_t nlabels;       // labels usados
+} IrUnitRec;
+
+/**
+ * @brief Tabela de strings com interning (nomes terminados em '\0')
+ */
+typedef struct {
+    char* data;
+    uint32_t size;
+    uint32_t cap;
+    uint32_t* hash;         // offset + 1 de cada entrada, 0 = vazio
+    uint32_t hashCap;
+    uint32_t count;
+} IrStrTab;
+
+/**
+ * @brief Funcao em construcao, com buffers proprios
+ */
+typedef struct {
+    IrUnitRec rec;
+    IrInstr* code;
+    uint32_t cap;
+    IrSlotRec* slots;
+    uint32_t slotCap;
+    uint32_t slotTop;       // proxima celula livre do registro (ir_add_slot)
+    int32_t line;           // linha das instrucoes emitidas sem linha (ir_emit)
+} IrUnit;
+
+/**
+ * @brief Programa completo em memoria
+ */
+typedef struct {
+    IrStrTab strs;
+    IrUnit* units;
+    uint32_t nunits;
+    uint32_t unitCap;
+    IrGlobalRec* globals;
+    uint32_t nglobals;
+    uint32_t globalCap;
+} IrProgram;
+
+/**
+ * @brief Visao somente leitura e contigua de um programa
+ *
+ * Preenchida por ir_flatten() a partir de um IrProgram ou apontando
+ * diretamente para as secoes de um arquivo .cmir mapeado em memoria.
+ */
+typedef struct {
+    const IrUnitRec* units;
+    uint32_t nunits;
+    const IrGlobalRec* globals;
+    uint32_t nglobals;
+    const IrSlotRec* slots;
+    uint32_t nslots;
+    const IrInstr* code;
+    uint32_t ncode;
+    const char* strs;
+    uint32_t strSize;
+} IrView;
+
+/**
+ * @brief Inicializa um programa vazio
+ * @param prog Programa a inicializar
+ */
+void ir_init(IrProgram* prog);
+
+/**
+ * @brief Libera toda a memoria de um programa
+ * @param prog Programa a liberar
+ */
+void ir_free(IrProgram* prog);
+
+/**
+ * @brief Esvazia um programa mantendo a capacidade das tabelas
+ *
+ * Usado para reaproveitar o mesmo programa em varias compilacoes (servidor
+ * de compilacao): a tabela de strings, o vetor de funcoes e o de globais
+ * continuam alocados e aquecidos.
+ *
+ * @param prog Programa
+ */
+void ir_reset(IrProgram* prog);
+
+/**
+ * @brief Insere (ou encontra) um nome na tabela de strings
+ * @param tab Tabela de strings
+ * @param s Nome
+ * @return Offset do nome na tabela
+ */
+uint32_t ir_intern(IrStrTab* tab, const char* s);
+
+/**
+ * @brief Busca um nome na tabela de strings sem inserir
+ * @param tab Tabela de strings
+ * @param s Nome
+ * @return Offset do nome ou UINT32_MAX se ausente
+ */
+uint32_t ir_strtab_find(const IrStrTab* tab, const char* s);
+
+/**
+ * @brief Acrescenta uma variavel global ao programa
+ * @param prog Programa
+ * @param name Nome da variavel
+ * @param size IR_SCALAR ou numero de elementos
+ * @return Indice da global
+ */
+int ir_add_global(IrProgram* prog, const char* name, int size);
+
+/**
+ * @brief Acrescenta uma funcao vazia ao programa
+ * @param prog Programa
+ * @param name Nome da funcao
+ * @return Ponteiro para a nova unidade
+ */
+IrUnit* ir_add_unit(IrProgram* prog, const char* name);
+
+/**
+ * @brief Acrescenta um slot local a uma funcao
+ *
+ * O slot ocupa as celulas a partir de unit->slotTop, que avanca; quem gera
+ * o codigo volta slotTop ao valor da entrada de um bloco na saida dele para
+ * que o proximo bloco reaproveite as mesmas celulas.
+ *
+ * @param prog Programa (tabela de strings)
+ * @param unit Funcao
+ * @param name Nome do slot
+ * @param size IR_SCALAR, IR_ARRAYREF ou numero de elementos
+ * @return Indice do slot
+ */
+int ir_add_slot(IrProgram* prog, IrUnit* unit, const char* name, int size);
+
+/**
+ * @brief Celulas ocupadas pelos slots de uma funcao no registro de ativacao
+ *
+ * Os temporarios ficam logo depois: o registro tem ir_frame_slots() +
+ * ntemps celulas.
+ *
+ * @param slots Slots da funcao
+ * @param nslots Numero de slots
+ * @return Maior offset + tamanho entre os slots
+ */
+uint32_t ir_frame_slots(const IrSlotRec* slots, uint32_t nslots);
+
+/**
+ * @brief Acrescenta uma instrucao ao final de uma funcao
+ *
+ * Uma instrucao sem linha (line 0) recebe unit->line, a linha do comando
+ * sendo gerado.
+ *
+ * @param unit Funcao
+ * @param ins Instrucao
+ */
+void ir_emit(IrUnit* unit, IrInstr ins);
+
+/**
+ * @brief Constroi uma visao contigua do programa (aloca code/slots/units)
+ * @param prog Programa
+ * @param view Visao preenchida; liberar com ir_view_free()
+ */
+void ir_flatten(const IrProgram* prog, IrView* view);
+
+/**
+ * @brief Libera os arrays alocados por ir_flatten()
+ * @param view Visao
+ */
+void ir_view_free(IrView* view);
+
+/**
+ * @brief Imprime o programa no formato texto de tres enderecos
+ *
+ * Temporarios e labels sao numerados localmente em cada funcao; a impressao
+ * soma um deslocamento acumulado para manter a numeracao global do texto.
+ *
+ * @param view Programa
+ * @param out Arquivo de saida
+ */
+void ir_print(const IrView* view, FILE* out);
+
+/**
+ * @brief Nome textual de uma operacao binaria ("+", "<=", ...)
+ * @param op Operacao
+ * @return String do operador ou NULL se nao for binaria
+ */
+const char* ir_op_str(IrOp op);
+
+/**
+ * @brief Operacao vetorial correspondente a uma operacao binaria
+ * @param op IR_COPY ou IR_ADD a IR_NE
+ * @return IR_VCOPY a IR_VNE, ou IR_NOP se nao ha versao vetorial (divisao)
+ */
+IrOp ir_vector_op(IrOp op);
+
+/**
+ * @brief Operacao aplicada a cada elemento por uma operacao vetorial
+ * @param op IR_VCOPY a IR_VNE
+ * @return IR_COPY ou IR_ADD a IR_NE (IR_NOP se op nao e vetorial)
+ */
+IrOp ir_scalar_op(IrOp op);
+
+#endif
@@ -0,0 +1,271 @@
+/**
+ * @file irfile.c
+ * @brief Escrita e leitura (via mmap) do codigo intermediario binario
+ */
+
+#include "irfile.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define ALIGN8(x) (((x) + 7u) & ~7u)
+// Maior registro de ativacao e maior area de globais aceitos, em celulas
+#define IRFILE_MAX_CELLS ((uint64_t)INT32_MAX)
+
+void* irfile_serialize(const IrView* view, size_t* size) {
+    IrFileHeader h;
+    char* buf;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, IRFILE_MAGIC, 4);
+    h.version = IRFILE_VERSION;
+    h.endian = IRFILE_ENDIAN;
+    h.headerSize = sizeof(IrFileHeader);
+    h.nunits = view->nunits;
+    h.nglobals = view->nglobals;
+    h.nslots = view->nslots;
+    h.ncode = view->ncode;
+    h.strSize = view->strSize;
+    h.unitsOff = ALIGN8((uint32_t)sizeof(IrFileHeader));
+    h.globalsOff = ALIGN8(h.unitsOff + h.nunits * (uint32_t)sizeof(IrUnitRec));
+    h.slotsOff = ALIGN8(h.globalsOff + h.nglobals * (uint32_t)sizeof(IrGlobalRec));
+    h.codeOff = ALIGN8(h.slotsOff + h.nslots * (uint32_t)sizeof(IrSlotRec));
+    h.strsOff = ALIGN8(h.codeOff + h.ncode * (uint32_t)sizeof(IrInstr));
+    h.fileSize = ALIGN8(h.strsOff + h.strSize);
+    buf = (char*)calloc(1, h.fileSize);
+    if (buf == NULL)
+        return NULL;
+    memcpy(buf, &h, sizeof(h));
+    if (h.nunits > 0)
+        memcpy(buf + h.unitsOff, view->units, h.nunits * sizeof(IrUnitRec));
+    if (h.nglobals > 0)
+        memcpy(buf + h.globalsOff, view->globals, h.nglobals * sizeof(IrGlobalRec));
+    if (h.nslots > 0)
+        memcpy(buf + h.slotsOff, view->slots, h.nslots * sizeof(IrSlotRec));
+    if (h.ncode > 0)
+        memcpy(buf + h.codeOff, view->code, h.ncode * sizeof(IrInstr));
+    if (h.strSize > 0)
+        memcpy(buf + h.strsOff, view->strs, h.strSize);
+    *size = h.fileSize;
+    return buf;
+}
+
+int irfile_write(const IrView* view, const char* path) {
+    size_t size;
+    void* buf = irfile_serialize(view, &size);
+    FILE* f;
+    if (buf == NULL) {
+        fprintf(stderr, "Erro de alocacao de memoria ao serializar '%s'\n", path);
+        return -1;
+    }
+    f = fopen(path, "wb");
+    if (f == NULL) {
+        fprintf(stderr, "Erro: nao foi possivel criar o arquivo '%s'\n", path);
+        free(buf);
+        return -1;
+    }
+    if (fwrite(buf, 1, size, f) != size) {
+        fprintf(stderr, "Erro: falha ao gravar o arquivo '%s'\n", path);
+        fclose(f);
+        free(buf);
+        return -1;
+    }
+    fclose(f);
+    free(buf);
+    return 0;
+}
+
+/**
+ * @brief Verifica se uma secao cabe no arquivo e esta alinhada
+ * @param off Offset da secao
+ * @param count Numero de registros
+ * @param recSize Tamanho de cada registro
+ * @param size Tamanho do arquivo
+ * @return TRUE se a secao e valida
+ */
+static int sectionOk(uint32_t off, uint32_t count, size_t recSize, size_t size) {
+    if (off % 4 != 0 || off > size)
+        return 0;
+    return (size - off) / recSize >= count;
+}
+
+/**
+ * @brief Verifica se um operando existe na funcao que o usa
+ * @param view Programa
+ * @param u Funcao
+ * @param kind Tipo do operando
+ * @param val Valor do operando
+ * @return TRUE se o operando e valido
+ */
+static int opndOk(const IrView* view, const IrUnitRec* u, uint8_t kind, int32_t val) {
+    switch (kind) {
+        case IR_NONE:
+        case IR_CONST:
+            return 1;
+        case IR_TEMP:
+            return (uint32_t)val < u->ntemps;
+        case IR_LABEL:
+            return (uint32_t)val < u->nlabels;
+        case IR_LOCAL:
+            return (uint32_t)val < u->nslots;
+        case IR_GLOBAL:
+            return (uint32_t)val < view->nglobals;
+        case IR_FUNC:
+            return (uint32_t)val < view->nunits || val == IR_BUILTIN_INPUT || val == IR_BUILTIN_OUTPUT;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief Confere os slots, o tamanho do registro e as instrucoes de uma funcao
+ * @param view Programa (indice ja conferido)
+ * @param u Funcao
+ * @return TRUE se a funcao e valida
+ */
+static int unitOk(const IrView* view, const IrUnitRec* u) {
+    const IrSlotRec* slots = view->slots + u->slotFirst;
+    uint32_t k;
+    for (k = 0; k < u->nslots; k++) {
+        // parametros sao escalares ou referencias; arrays so como variaveis
+        if (slots[k].size < IR_ARRAYREF || (k < u->nparams && slots[k].size > IR_SCALAR))
+            return 0;
+    }
+    // temporarios depois dos slots: o registro inteiro cabe nos enderecos de 32 bits
+    if ((uint64_t)ir_frame_slots(slots, u->nslots) + u->ntemps > IRFILE_MAX_CELLS)
+        return 0;
+    for (k = 0; k < u->count; k++) {
+        const IrInstr* in = &view->code[u->first + k];
+        if (in->op >= IR_NUM_OPS || !opndOk(view, u, in->kd, in->d) ||
+            !opndOk(view, u, in->ka, in->a) || !opndOk(view, u, in->kb, in->b))
+            return 0;
+    }
+    return 1;
+}
+
+int irfile_view(const void* base, size_t size, IrView* view) {
+    const IrFileHeader* h = (const IrFileHeader*)base;
+    const char* p = (const char*)base;
+    uint64_t cells = 1;
+    uint32_t i;
+    if (size < sizeof(IrFileHeader) || memcmp(h->magic, IRFILE_MAGIC, 4) != 0)
+        return -1;
+    if (h->version != IRFILE_VERSION || h->endian != IRFILE_ENDIAN ||
+        h->headerSize != sizeof(IrFileHeader) || h->fileSize > size)
+        return -1;
+    if (!sectionOk(h->unitsOff, h->nunits, sizeof(IrUnitRec), size) ||
+        !sectionOk(h->globalsOff, h->nglobals, sizeof(IrGlobalRec), size) ||
+        !sectionOk(h->slotsOff, h->nslots, sizeof(IrSlotRec), size) ||
+        !sectionOk(h->codeOff, h->ncode, sizeof(IrInstr), size) ||
+        !sectionOk(h->strsOff, h->strSize, 1, size))
+        return -1;
+    if (h->strSize == 0 || p[h->strsOff + h->strSize - 1] != '\0')
+        return -1;
+    view->units = (const IrUnitRec*)(p + h->unitsOff);
+    view->nunits = h->nunits;
+    view->globals = (const IrGlobalRec*)(p + h->globalsOff);
+    view->nglobals = h->nglobals;
+    view->slots = (const IrSlotRec*)(p + h->slotsOff);
+    view->nslots = h->nslots;
+    view->code = (const IrInstr*)(p + h->codeOff);
+    view->ncode = h->ncode;
+    view->strs = p + h->strsOff;
+    view->strSize = h->strSize;
+    // tudo e conferido aqui, uma vez: o VM calcula o registro de ativacao e
+    // os enderecos a partir desses offsets, tamanhos e indices
+    for (i = 0; i < view->nslots; i++)
+        if (view->slots[i].name >= view->strSize || view->slots[i].offset < 0 ||
+            view->slots[i].size > INT32_MAX - view->slots[i].offset)
+            return -1;
+    for (i = 0; i < view->nglobals; i++) {
+        if (view->globals[i].name >= view->strSize || view->globals[i].size < IR_SCALAR)
+            return -1;
+        cells += view->globals[i].size > 0 ? (uint64_t)view->globals[i].size : 1;
+        if (cells > IRFILE_MAX_CELLS)
+            return -1;
+    }
+    for (i = 0; i < view->nunits; i++) {
+        const IrUnitRec* u = &view->units[i];
+        if (u->name >= view->strSize || u->first > view->ncode ||
+            u->count > view->ncode - u->first || u->slotFirst > view->nslots ||
+            u->nslots > view->nslots - u->slotFirst || u->nparams > u->nslots || !unitOk(view, u))
+            return -1;
+    }
+    return 0;
+}
+
+int irfile_open(const char* path, IrFile* file) {
+    memset(file, 0, sizeof(*file));
+#ifndef _WIN32
+    {
+        struct stat st;
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) {
+            fprintf(stderr, "Erro: nao foi possivel abrir o arquivo '%s'\n", path);
+            return -1;
+        }
+        if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+            fprintf(stderr, "Erro: arquivo '%s' vazio ou inacessivel\n", path);
+            close(fd);
+            return -1;
+        }
+        file->size = (size_t)st.st_size;
+        file->base = mmap(NULL, file->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (file->base == MAP_FAILED) {
+            fprintf(stderr, "Erro: falha no mmap de '%s'\n", path);
+            file->base = NULL;
+            return -1;
+        }
+        file->mapped = 1;
+    }
+#else
+    {
+        FILE* f = fopen(path, "rb");
+        long n;
+        if (f == NULL) {
+            fprintf(stderr, "Erro: nao foi possivel abrir o arquivo '%s'\n", path);
+            return -1;
+        }
+        fseek(f, 0, SEEK_END);
+        n = ftell(f);
+        fseek(f, 0, SEEK_SET);
+        file->base = malloc(n > 0 ? (size_t)n : 1);
+        if (file->base == NULL || n <= 0 || fread(file->base, 1, (size_t)n, f) != (size_t)n) {
+            fprintf(stderr, "Erro: falha ao ler o arquivo '%s'\n", path);
+            fclose(f);
+            free(file->base);
+            file->base = NULL;
+            return -1;
+        }
+        fclose(f);
+        file->size = (size_t)n;
+    }
+#endif
+    if (irfile_view(file->base, file->size, &file->view) != 0) {
+        fprintf(stderr, "Erro: '%s' nao e um arquivo .cmir valido (versao %d)\n", path, IRFILE_VERSION);
+        irfile_close(file);
+        return -1;
+    }
+    return 0;
+}
+
+void irfile_close(IrFile* file) {
+    if (file->base != NULL) {
+#ifndef _WIN32
+        if (file->mapped)
+            munmap(file->base, file->size);
+        else
+            free(file->base);
+#else
+        free(file->base);
+#endif
+    }
+    memset(file, 0, sizeof(*file));
+}
@@ -0,0 +1,98 @@
+/**
+ * @file irfile.h
+ * @brief Formato binario versionado do codigo intermediario (.cmir)
+ *
+ * Layout do arquivo (todas as secoes alinhadas em 8 bytes, ordem de bytes
+ * da maquina que gerou o arquivo):
+ *
+ *   IrFileHeader
+ *   IrUnitRec[nunits]      indice de funcoes
+ *   IrGlobalRec[nglobals]  variaveis globais
+ *   IrSlotRec[nslots]      slots locais de todas as funcoes
+ *   IrInstr[ncode]         instrucoes de largura fixa
+ *   char[strSize]          tabela de strings (nomes terminados em '\0')
+ *
+ * O leitor mapeia o arquivo com mmap e aponta um IrView direto para as
+ * secoes, sem copiar nem interpretar as instrucoes.
+ */
+
+#ifndef _IRFILE_H_
+#define _IRFILE_H_
+
+#include "ir.h"
+#include <stddef.h>
+
+#define IRFILE_MAGIC   "CMIR"
+#define IRFILE_VERSION 3
+#define IRFILE_ENDIAN  0x01020304u
+
+/**
+ * @brief Cabecalho do arquivo .cmir (64 bytes)
+ */
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t endian;
+    uint32_t headerSize;
+    uint32_t nunits, nglobals, nslots, ncode, strSize;
+    uint32_t unitsOff, globalsOff, slotsOff, codeOff, strsOff;
+    uint32_t fileSize;
+    uint32_t reserved;
+} IrFileHeader;
+
+/**
+ * @brief Arquivo .cmir carregado
+ */
+typedef struct {
+    void* base;       // inicio do mapeamento (ou buffer lido)
+    size_t size;      // tamanho do arquivo
+    int mapped;       // TRUE se base veio de mmap
+    IrView view;      // secoes do arquivo
+} IrFile;
+
+/**
+ * @brief Grava um programa no formato binario
+ * @param view Programa (ver ir_flatten)
+ * @param path Caminho do arquivo de saida
+ * @return 0 se sucesso, -1 se erro
+ */
+int irfile_write(const IrView* view, const char* path);
+
+/**
+ * @brief Serializa um programa em um buffer alocado
+ * @param view Programa
+ * @param size Tamanho do buffer gerado
+ * @return Buffer (liberar com free) ou NULL se erro
+ */
+void* irfile_serialize(const IrView* view, size_t* size);
+
+/**
+ * @brief Mapeia um arquivo .cmir e valida cabecalho e secoes
+ * @param path Caminho do arquivo
+ * @param file Arquivo carregado
+ * @return 0 se sucesso, -1 se erro (mensagem em stderr)
+ */
+int irfile_open(const char* path, IrFile* file);
+
+/**
+ * @brief Valida um buffer .cmir ja em memoria e preenche a visao
+ *
+ * Alem das secoes, confere cada funcao: slots e temporarios cabem em um
+ * registro de enderecos de 32 bits, e todo operando (temporario, slot,
+ * global, label ou funcao) existe. Um arquivo truncado ou forjado e
+ * rejeitado aqui, e nao durante a execucao.
+ *
+ * @param base Inicio do buffer (alinhado em 8 bytes)
+ * @param size Tamanho do buffer
+ * @param view Visao preenchida
+ * @return 0 se sucesso, -1 se o buffer nao e um .cmir valido
+ */
+int irfile_view(const void* base, size_t size, IrView* view);
+
+/**
+ * @brief Desfaz o mapeamento de um arquivo .cmir
+ * @param file Arquivo carregado
+ */
+void irfile_close(IrFile* file);
+
+#endif
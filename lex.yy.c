@@ -0,0 +1,78 @@
+/* stub de teste (fora do repo) emulando o scanner flex reentrante */
+#include "globals.h"
+#include "cminus.tab.h"
+#include <ctype.h>
+#include "lexer.h"
+#include "tokens.h"
+typedef struct { const char* p; const char* end; } Sc;
+#define nextc() (sc->p < sc->end ? (unsigned char)*sc->p++ : EOF)
+#define unget(c) do { if ((c) != EOF) sc->p--; } while (0)
+static int stub_scan(YYSTYPE* lv, CompilerContext* ctx){
+  Sc* sc = (Sc*)ctx->scanner;
+  int c;
+  for(;;){
+    c = nextc();
+    if (c==EOF) return 0;
+    if (c=='\n'){ctx->lineno++;continue;}
+    if (c==' '||c=='\t'||c=='\r') continue;
+    if (c=='/'){ int d=nextc(); if(d=='*'){ int p=0,start=ctx->lineno; while((c=nextc())!=EOF){ if(c=='\n')ctx->lineno++; if(p=='*'&&c=='/')break; p=c;} if(c==EOF){fprintf(ctx->errors,"ERRO LEXICO: '/*' LINHA: %d\n",start);return ERROR;} continue;} unget(d); return SOBRE; }
+    break;
+  }
+  if (isdigit(c)){ int v=0; while(isdigit(c)){v=v*10+c-'0';c=nextc();} unget(c); lv->val=v; return NUM; }
+  if (isalpha(c)){ char b[256]; int n=0; while(isalpha(c)){b[n++]=c;c=nextc();} b[n]=0; unget(c);
+    if(!strcmp(b,"else"))return ELSE; if(!strcmp(b,"if"))return IF; if(!strcmp(b,"int"))return INT;
+    if(!strcmp(b,"return"))return RETURN; if(!strcmp(b,"void"))return VOID; if(!strcmp(b,"while"))return WHILE;
+    lv->name=strdup(b); return ID; }
+  int d;
+  switch(c){
+   case '+':return MAIS; case '-':return MENOS; case '*':return VEZES;
+   case '<': d=nextc(); if(d=='=')return MENORIGUAL; unget(d); return MENOR;
+   case '>': d=nextc(); if(d=='=')return MAIORIGUAL; unget(d); return MAIOR;
+   case '=': d=nextc(); if(d=='=')return IGUAL; unget(d); return ATRIBUICAO;
+   case '!': d=nextc(); if(d=='=')return DIFERENTE; unget(d); break;
+   case ';':return PONTOEVIRGULA; case ',':return VIRGULA; case '(':return LPARENTESES; case ')':return RPARENTESES;
+   case '[':return LCOLCHETE; case ']':return RCOLCHETE; case '{':return LCHAVE; case '}':return RCHAVE;
+  }
+  fprintf(ctx->errors,"ERRO LEXICO: '%c' LINHA: %d\n",c,ctx->lineno); return ERROR;
+}
+int yylex(YYSTYPE* lv, CompilerContext* ctx){
+  if (ctx->tokens != NULL) return tokens_next(ctx->tokens, lv, ctx);
+  if (ctx->lexer == LEXER_SIMD) return fastlex_next((FastLexer*)ctx->scanner, lv, ctx);
+  return stub_scan(lv, ctx);
+}
+static int open_(CompilerContext* ctx, const char* src, size_t len, FastLexer* f){
+  if (ctx->lexer == LEXER_SIMD){ fastlex_init(f, src, len); ctx->scanner=f; }
+  else { Sc* s=malloc(sizeof *s); s->p=src; s->end=src+len; ctx->scanner=s; }
+  return 0;
+}
+static void close_(CompilerContext* ctx){ if (ctx->lexer != LEXER_SIMD) free(ctx->scanner); ctx->scanner=NULL; }
+static const TokenScanner chunkScanner = { open_, yylex, close_ };
+static int beginTokens(CompilerContext* ctx, const char* src, size_t len, TokenStream* t, FastLexer* f){
+  if (ctx->prelex && ctx->pool != NULL && len >= TOKENS_CHUNKED_MIN) {
+    if (tokens_init(t, ctx)) return 1;
+    if (tokens_start_chunks(t, &chunkScanner, src, len, ctx->pool) == 0) { ctx->tokens=t; return 0; }
+    tokens_free(t);
+  }
+  if (ctx->prelex && (len < TOKENS_THREAD_MIN || ctx->pool != NULL)) { if (tokens_init(t, ctx)) return 1; open_(&t->lex,src,len,f);
+    tokens_start(t, yylex, getenv("NOTHR") ? 0 : len >= TOKENS_THREAD_MIN); ctx->tokens=t; return 0; }
+  return open_(ctx,src,len,f);
+}
+static void endTokens(CompilerContext* ctx, TokenStream* t){
+  if (ctx->tokens == NULL) { close_(ctx); return; }
+  ctx->tokens=NULL; tokens_free(t); if (t->lex.scanner) close_(&t->lex);
+}
+int cminus_parse(CompilerContext* ctx, const char* src, size_t len){
+  int st; FastLexer f; TokenStream t;
+  if (beginTokens(ctx,src,len,&t,&f)) return 1; st = yyparse(ctx); endTokens(ctx,&t); return st;
+}
+int cminus_dump_tokens(CompilerContext* ctx, const char* src, size_t len){
+  YYSTYPE lval; int token; FastLexer f; TokenStream t; if (beginTokens(ctx,src,len,&t,&f)) return 1;
+  while ((token = yylex(&lval, ctx)) != 0) {
+    fprintf(ctx->listing, "%d %d", ctx->lineno, token);
+    if (token == ID) { fprintf(ctx->listing, " %s", lval.name); free(lval.name); }
+    else if (token == NUM) fprintf(ctx->listing, " %d", lval.val);
+    else if (token == ERROR) ctx->error = TRUE;
+    fprintf(ctx->listing, "\n");
+  }
+  endTokens(ctx,&t); return ctx->error ? 1 : 0;
+}
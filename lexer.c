@@ -0,0 +1,330 @@
+/**
+ * @file lexer.c
+ * @brief Implementacao do analisador lexico escrito a mao
+ */
+
+#include "lexer.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define LEX_BLOCK 32
+#define LEX_FULL 0xffffffffu
+typedef __m256i LexVec;
+#define vload(p)    _mm256_loadu_si256((const __m256i*)(p))
+#define vset(c)     _mm256_set1_epi8((char)(c))
+#define veq(a, b)   _mm256_cmpeq_epi8(a, b)
+#define vgt(a, b)   _mm256_cmpgt_epi8(a, b)
+#define vor(a, b)   _mm256_or_si256(a, b)
+#define vadd(a, b)  _mm256_add_epi8(a, b)
+#define vmask(v)    ((uint32_t)_mm256_movemask_epi8(v))
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define LEX_BLOCK 16
+#define LEX_FULL 0xffffu
+typedef __m128i LexVec;
+#define vload(p)    _mm_loadu_si128((const __m128i*)(p))
+#define vset(c)     _mm_set1_epi8((char)(c))
+#define veq(a, b)   _mm_cmpeq_epi8(a, b)
+#define vgt(a, b)   _mm_cmpgt_epi8(a, b)
+#define vor(a, b)   _mm_or_si128(a, b)
+#define vadd(a, b)  _mm_add_epi8(a, b)
+#define vmask(v)    ((uint32_t)_mm_movemask_epi8(v))
+#endif
+
+#ifdef LEX_BLOCK
+// a maioria dos tokens e curta: os primeiros bytes sao testados um a um e
+// so as sequencias mais longas seguem em blocos
+#define LEX_SHORT 8
+
+/**
+ * @brief Marca os bytes no intervalo [lo, lo + n)
+ * @param v Bytes
+ * @param lo Inicio do intervalo
+ * @param n Tamanho do intervalo (menor que 128)
+ * @return 0xff nos bytes do intervalo
+ */
+static LexVec inRange(LexVec v, int lo, int n) {
+    // desloca o intervalo para o inicio dos valores com sinal
+    LexVec t = vadd(v, vset(-128 - lo));
+    return vgt(vset(-128 + n), t);
+}
+
+/**
+ * @brief Bits abaixo de n
+ * @param n Numero de bits
+ * @return Mascara
+ */
+static uint32_t lowBits(int n) {
+    return (uint32_t)(((uint64_t)1 << n) - 1);
+}
+#endif
+
+/**
+ * @brief Verifica se um byte e letra
+ * @param c Byte
+ * @return TRUE se letra
+ */
+static int isLetter(char c) {
+    return (unsigned)((c | 0x20) - 'a') < 26;
+}
+
+/**
+ * @brief Verifica se um byte e digito
+ * @param c Byte
+ * @return TRUE se digito
+ */
+static int isDigit(char c) {
+    return (unsigned)(c - '0') < 10;
+}
+
+/**
+ * @brief Avanca sobre uma sequencia de letras
+ * @param p Inicio
+ * @param end Fim do fonte
+ * @return Primeiro byte que nao e letra
+ */
+static const char* skipLetters(const char* p, const char* end) {
+#ifdef LEX_BLOCK
+    const char* stop = end - p > LEX_SHORT ? p + LEX_SHORT : end;
+    while (p < stop && isLetter(*p))
+        p++;
+    if (p < stop)
+        return p;
+    while (end - p >= LEX_BLOCK) {
+        uint32_t m = ~vmask(inRange(vor(vload(p), vset(0x20)), 'a', 26)) & LEX_FULL;
+        if (m != 0)
+            return p + __builtin_ctz(m);
+        p += LEX_BLOCK;
+    }
+#endif
+    while (p < end && isLetter(*p))
+        p++;
+    return p;
+}
+
+/**
+ * @brief Avanca sobre uma sequencia de digitos
+ * @param p Inicio
+ * @param end Fim do fonte
+ * @return Primeiro byte que nao e digito
+ */
+static const char* skipDigits(const char* p, const char* end) {
+#ifdef LEX_BLOCK
+    const char* stop = end - p > LEX_SHORT ? p + LEX_SHORT : end;
+    while (p < stop && isDigit(*p))
+        p++;
+    if (p < stop)
+        return p;
+    while (end - p >= LEX_BLOCK) {
+        uint32_t m = ~vmask(inRange(vload(p), '0', 10)) & LEX_FULL;
+        if (m != 0)
+            return p + __builtin_ctz(m);
+        p += LEX_BLOCK;
+    }
+#endif
+    while (p < end && isDigit(*p))
+        p++;
+    return p;
+}
+
+/**
+ * @brief Avanca sobre espacos, tabulacoes e quebras de linha
+ * @param p Inicio
+ * @param end Fim do fonte
+ * @param lineno Linha atual (atualizada)
+ * @return Primeiro byte que nao e espaco
+ */
+static const char* skipBlanks(const char* p, const char* end, int* lineno) {
+#ifdef LEX_BLOCK
+    const char* stop = end - p > LEX_SHORT ? p + LEX_SHORT : end;
+    while (p < stop && (*p == ' ' || *p == '\t' || *p == '\n')) {
+        if (*p == '\n')
+            (*lineno)++;
+        p++;
+    }
+    if (p < stop)
+        return p;
+    while (end - p >= LEX_BLOCK) {
+        LexVec v = vload(p);
+        uint32_t nl = vmask(veq(v, vset('\n')));
+        uint32_t m = ~(vmask(vor(veq(v, vset(' ')), veq(v, vset('\t')))) | nl) & LEX_FULL;
+        if (m != 0) {
+            int n = __builtin_ctz(m);
+            *lineno += __builtin_popcount(nl & lowBits(n));
+            return p + n;
+        }
+        *lineno += __builtin_popcount(nl);
+        p += LEX_BLOCK;
+    }
+#endif
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\n')) {
+        if (*p == '\n')
+            (*lineno)++;
+        p++;
+    }
+    return p;
+}
+
+/**
+ * @brief Procura o "*" + "/" que fecha um comentario
+ * @param p Primeiro byte depois da abertura
+ * @param end Fim do fonte
+ * @param lineno Linha atual (atualizada ate o fechamento ou o fim)
+ * @return Byte depois do fechamento ou NULL se o comentario nao termina
+ */
+static const char* skipComment(const char* p, const char* end, int* lineno) {
+#ifdef LEX_BLOCK
+    while (end - p > LEX_BLOCK) {
+        LexVec v = vload(p);
+        uint32_t nl = vmask(veq(v, vset('\n')));
+        uint32_t close = vmask(veq(v, vset('*'))) & vmask(veq(vload(p + 1), vset('/')));
+        if (close != 0) {
+            int n = __builtin_ctz(close);
+            *lineno += __builtin_popcount(nl & lowBits(n));
+            return p + n + 2;
+        }
+        *lineno += __builtin_popcount(nl);
+        p += LEX_BLOCK;
+    }
+#endif
+    while (p < end) {
+        if (*p == '*' && p + 1 < end && p[1] == '/')
+            return p + 2;
+        if (*p == '\n')
+            (*lineno)++;
+        p++;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Reconhece uma palavra reservada por hash perfeito
+ * @param s Inicio do identificador
+ * @param n Tamanho do identificador
+ * @return Token da palavra reservada ou ID
+ */
+static int keyword(const char* s, size_t n) {
+    // (s[0] + 3 * (n + s[1])) % 8 e distinto para as seis palavras
+    static const struct { const char* word; int len; int token; } table[8] = {
+        { NULL, 0, 0 },
+        { "if", 2, IF },
+        { NULL, 0, 0 },
+        { "return", 6, RETURN },
+        { "int", 3, INT },
+        { "else", 4, ELSE },
+        { "while", 5, WHILE },
+        { "void", 4, VOID }
+    };
+    unsigned h;
+    if (n < 2 || n > 6)
+        return ID;
+    h = ((unsigned char)s[0] + 3 * ((unsigned)n + (unsigned char)s[1])) & 7;
+    if (table[h].len == (int)n && memcmp(table[h].word, s, n) == 0)
+        return table[h].token;
+    return ID;
+}
+
+void fastlex_init(FastLexer* lx, const char* src, size_t len) {
+    lx->p = src;
+    lx->end = src + len;
+}
+
+int fastlex_next(FastLexer* lx, YYSTYPE* lval, CompilerContext* ctx) {
+    const char* p = lx->p;
+    const char* end = lx->end;
+    const char* start;
+    char c;
+    for (;;) {
+        p = skipBlanks(p, end, &ctx->lineno);
+        if (p == end) {
+            lx->p = p;
+            return 0;
+        }
+        if (p[0] == '/' && p + 1 < end && p[1] == '*') {
+            int line = ctx->lineno;
+            const char* q = skipComment(p + 2, end, &ctx->lineno);
+            if (q == NULL) {
+                // como no scanner do flex: o resto do fonte e comentario (skipComment
+                // ja contou as linhas ate o fim) e o erro informa a linha da abertura
+                fprintf(ctx->errors, "ERRO LEXICO: '/*' LINHA: %d\n", line);
+                lx->p = end;
+                return ERROR;
+            }
+            p = q;
+            continue;
+        }
+        break;
+    }
+    start = p;
+    c = *p;
+    if (isLetter(c)) {
+        size_t n;
+        int token;
+        p = skipLetters(p, end);
+        n = (size_t)(p - start);
+        token = keyword(start, n);
+        if (token == ID) {
+            lval->name = (char*)malloc(n + 1);
+            memcpy(lval->name, start, n);
+            lval->name[n] = '\0';
+        }
+        lx->p = p;
+        return token;
+    }
+    if (isDigit(c)) {
+        size_t n;
+        p = skipDigits(p, end);
+        n = (size_t)(p - start);
+        if (n <= 9) {
+            int v = 0;
+            const char* s;
+            for (s = start; s < p; s++)
+                v = v * 10 + (*s - '0');
+            lval->val = v;
+        } else {
+            // mesmo resultado de atoi para numeros grandes
+            char* buf = (char*)malloc(n + 1);
+            memcpy(buf, start, n);
+            buf[n] = '\0';
+            lval->val = atoi(buf);
+            free(buf);
+        }
+        lx->p = p;
+        return NUM;
+    }
+    lx->p = p + 1;
+    switch (c) {
+        case '+': return MAIS;
+        case '-': return MENOS;
+        case '*': return VEZES;
+        case '/': return SOBRE;
+        case ';': return PONTOEVIRGULA;
+        case ',': return VIRGULA;
+        case '(': return LPARENTESES;
+        case ')': return RPARENTESES;
+        case '[': return LCOLCHETE;
+        case ']': return RCOLCHETE;
+        case '{': return LCHAVE;
+        case '}': return RCHAVE;
+        case '<':
+        case '>':
+        case '=':
+        case '!':
+            if (p + 1 < end && p[1] == '=') {
+                lx->p = p + 2;
+                return c == '<' ? MENORIGUAL : c == '>' ? MAIORIGUAL : c == '=' ? IGUAL : DIFERENTE;
+            }
+            if (c != '!')
+                return c == '<' ? MENOR : c == '>' ? MAIOR : ATRIBUICAO;
+            break;
+        default:
+            break;
+    }
+    {
+        char text[2] = { c, '\0' };
+        fprintf(ctx->errors, "ERRO LEXICO: '%s' LINHA: %d\n", text, ctx->lineno);
+    }
+    return ERROR;
+}
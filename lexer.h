@@ -0,0 +1,46 @@
+/**
+ * @file lexer.h
+ * @brief Analisador lexico escrito a mao (alternativa ao scanner do flex)
+ *
+ * Produz a mesma sequencia de tokens e os mesmos numeros de linha que
+ * cminus.l. As sequencias de espacos, letras e digitos sao classificadas
+ * 16 (SSE2) ou 32 (AVX2) bytes por vez, e as seis palavras reservadas sao
+ * reconhecidas por um hash perfeito.
+ */
+
+#ifndef _LEXER_H_
+#define _LEXER_H_
+
+#include "globals.h"
+#include "cminus.tab.h"
+
+// Scanners disponiveis (CompilerContext.lexer)
+#define LEXER_FLEX 0
+#define LEXER_SIMD 1
+
+/**
+ * @brief Estado do scanner escrito a mao
+ */
+typedef struct {
+    const char* p;          // proximo byte
+    const char* end;        // fim do fonte
+} FastLexer;
+
+/**
+ * @brief Inicializa o scanner sobre um buffer
+ * @param lx Scanner
+ * @param src Codigo fonte
+ * @param len Tamanho do codigo fonte
+ */
+void fastlex_init(FastLexer* lx, const char* src, size_t len);
+
+/**
+ * @brief Le o proximo token
+ * @param lx Scanner
+ * @param lval Valor semantico do token (NUM e ID)
+ * @param ctx Contexto da compilacao (linha atual e mensagens de erro)
+ * @return Codigo do token (0 no fim da entrada)
+ */
+int fastlex_next(FastLexer* lx, YYSTYPE* lval, CompilerContext* ctx);
+
+#endif
@@ -4,18 +4,85 @@
  */
 
 #include "globals.h"
-#include "util.h"
-#include "symtab.h"
-#include "analyze.h"
-#include "cgen.h"
+#include "compiler.h"
+#include "irfile.h"
+#include "cache.h"
+#include "incr.h"
+#include "batch.h"
+#include "pool.h"
+#include "source.h"
+#include "lexer.h"
+#include "ast.h"
+#include "phase.h"
+#include "memcount.h"
+#include "server.h"
+#include "rpc.h"
+#include "watch.h"
+#include "opt.h"
+#include "unroll.h"
+#include "frame.h"
+#include "profile.h"
+#include <sys/stat.h>
 
-FILE* source;
-FILE* listing;
-int Error = FALSE;
+/**
+ * @brief Le todo o conteudo de um arquivo aberto e volta ao inicio
+ * @param f Arquivo
+ * @param len Tamanho lido
+ * @return Conteudo alocado ou NULL se erro
+ */
+static char* readAll(FILE* f, size_t* len) {
+    size_t cap = 4096, n = 0, r;
+    char* buf = (char*)malloc(cap);
+    while (buf != NULL && (r = fread(buf + n, 1, cap - n, f)) > 0) {
+        n += r;
+        if (n == cap) {
+            cap *= 2;
+            buf = (char*)realloc(buf, cap);
+        }
+    }
+    rewind(f);
+    *len = n;
+    return buf;
+}
+
+/**
+ * @brief Copia o conteudo de um arquivo temporario para a saida
+ * @param tmp Arquivo temporario
+ * @param out Saida
+ * @param len Tamanho copiado
+ * @return Conteudo copiado (alocado) ou NULL se erro
+ */
+static char* drainListing(FILE* tmp, FILE* out, size_t* len) {
+    char* buf;
+    fflush(tmp);
+    rewind(tmp);
+    buf = readAll(tmp, len);
+    if (buf != NULL)
+        fwrite(buf, 1, *len, out);
+    return buf;
+}
 
-extern int yyparse(void);
-extern TreeNode* savedTree;
-extern FILE* yyin;
+/**
+ * @brief Grava um arquivo binario a partir de um buffer
+ * @param path Caminho
+ * @param data Conteudo
+ * @param size Tamanho
+ * @return 0 se sucesso, -1 se erro
+ */
+static int writeBytes(const char* path, const void* data, size_t size) {
+    FILE* f = fopen(path, "wb");
+    int ok;
+    if (f == NULL) {
+        fprintf(stderr, "Erro: nao foi possivel criar o arquivo '%s'\n", path);
+        return -1;
+    }
+    ok = fwrite(data, 1, size, f) == size;
+    if (fclose(f) != 0 || !ok) {
+        fprintf(stderr, "Erro: falha ao gravar o arquivo '%s'\n", path);
+        return -1;
+    }
+    return 0;
+}
 
 /**
  * @brief Funcao principal do compilador
@@ -24,68 +91,452 @@ extern FILE* yyin;
  * @return 0 se sucesso, 1 se erro
  */
 int main(int argc, char* argv[]) {
-    TreeNode* syntaxTree;
-    char* fileName;
-    
-    if (argc != 2) {
-        fprintf(stderr, "Uso: %s <arquivo.cm>\n", argv[0]);
+    IrProgram program;
+    SourceFile source;
+    FILE* listing;
+    char* text;
+    size_t textSize;
+    Cache cache;
+    CacheKey key;
+    CacheEntry entry;
+    char* fileName = NULL;
+    char** inputs;
+    int ninputs = 0;
+    int threads = 0;
+    int quiet = FALSE;
+    int stream = FALSE;
+    int lexer = LEXER_FLEX;
+    int dumpTokens = FALSE;
+    int prelex = FALSE;
+    int astStats = FALSE;
+    int timeReport = 0;       // 1 = tabela, 2 = JSON
+    PhaseReport report;
+    PhaseReport* phases = NULL;
+    char* outDir = NULL;
+    char socketPath[256];
+    int serve = FALSE;
+    int watch = FALSE;
+    int optimize = 0;
+    int unroll = -1;
+    int showOptStats = FALSE;
+    int showFrames = FALSE;
+    int profileGen = FALSE;
+    char* profilePath = NULL;
+    Profile profile;
+    OptStats optStats;
+    char options[64];
+    int debounceMs = 0;
+    char* binName = NULL;
+    char* cacheDir = getenv("CMINUS_CACHE_DIR");
+    unsigned long long cacheMax = 0;
+    int cacheStats = FALSE;
+    int incremental = FALSE;
+    int useCache = FALSE;
+    int batchMode = FALSE;
+    char* cmir = NULL;
+    size_t cmirSize = 0;
+    int status;
+    int i;
+
+    inputs = (char**)malloc((argc > 1 ? argc : 1) * sizeof(char*));
+    if (inputs == NULL)
         return 1;
+    rpc_default_socket(socketPath, sizeof(socketPath));
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            binName = argv[++i];
+        } else if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+            cacheDir = argv[++i];
+        } else if (strcmp(argv[i], "--cache-max") == 0 && i + 1 < argc) {
+            cacheMax = strtoull(argv[++i], NULL, 10) * 1024 * 1024;
+        } else if (strcmp(argv[i], "--cache-stats") == 0) {
+            cacheStats = TRUE;
+        } else if (strcmp(argv[i], "--incremental") == 0) {
+            incremental = TRUE;
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strncmp(argv[i], "-j", 2) == 0 && argv[i][2] != '\0') {
+            threads = atoi(argv[i] + 2);
+        } else if (strcmp(argv[i], "--stream") == 0) {
+            stream = TRUE;
+        } else if (strcmp(argv[i], "--lexer") == 0 && i + 1 < argc &&
+                   (strcmp(argv[i + 1], "flex") == 0 || strcmp(argv[i + 1], "simd") == 0)) {
+            lexer = strcmp(argv[++i], "simd") == 0 ? LEXER_SIMD : LEXER_FLEX;
+        } else if (strcmp(argv[i], "--prelex") == 0) {
+            prelex = TRUE;
+        } else if (strcmp(argv[i], "--dump-tokens") == 0) {
+            dumpTokens = TRUE;
+        } else if (strcmp(argv[i], "--time-report") == 0) {
+            timeReport = 1;
+        } else if (strcmp(argv[i], "--time-report=json") == 0) {
+            timeReport = 2;
+        } else if (strcmp(argv[i], "--ast-stats") == 0) {
+            astStats = TRUE;
+        } else if (strcmp(argv[i], "-q") == 0) {
+            quiet = TRUE;
+        } else if (strcmp(argv[i], "--out-dir") == 0 && i + 1 < argc) {
+            outDir = argv[++i];
+        } else if (strcmp(argv[i], "-O") == 0) {
+            optimize = 1;
+        } else if (strncmp(argv[i], "-O", 2) == 0 && argv[i][2] >= '0' && argv[i][2] <= '9' && argv[i][3] == '\0') {
+            if (argv[i][2] > '3') {
+                fprintf(stderr, "Erro: nivel de otimizacao invalido '%s' (use -O0 a -O3)\n", argv[i]);
+                free(inputs);
+                return 1;
+            }
+            optimize = argv[i][2] - '0';
+        } else if (strcmp(argv[i], "--unroll") == 0 && i + 1 < argc) {
+            unroll = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--opt-stats") == 0) {
+            showOptStats = TRUE;
+        } else if (strcmp(argv[i], "--frames") == 0) {
+            showFrames = TRUE;
+        } else if (strcmp(argv[i], "--profile-generate") == 0) {
+            profileGen = TRUE;
+        } else if (strcmp(argv[i], "--profile-use") == 0 && i + 1 < argc) {
+            profilePath = argv[++i];
+        } else if (strcmp(argv[i], "--watch") == 0) {
+            watch = TRUE;
+        } else if (strcmp(argv[i], "--debounce") == 0 && i + 1 < argc) {
+            debounceMs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--serve") == 0) {
+            serve = TRUE;
+        } else if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+            snprintf(socketPath, sizeof(socketPath), "%s", argv[++i]);
+        } else if (argv[i][0] != '-') {
+            inputs[ninputs++] = argv[i];
+        } else {
+            ninputs = 0;
+            break;
+        }
     }
-    
-    fileName = argv[1];
-    source = fopen(fileName, "r");
-    if (source == NULL) {
-        fprintf(stderr, "Erro: nao foi possivel abrir o arquivo '%s'\n", fileName);
+
+    unroll = unroll_factor(optimize, unroll);
+
+    if (profileGen && profilePath != NULL) {
+        fprintf(stderr, "Erro: --profile-generate e --profile-use sao exclusivos\n");
+        free(inputs);
         return 1;
     }
-    
-    listing = stdout;
-    yyin = source;
-    
-    fprintf(listing, "Arquivo de entrada: %s\n\n", fileName);
-    
-    yyparse();
-    syntaxTree = savedTree;
-    fclose(source);
-    
-    if (Error) {
-        fprintf(listing, "\nErros encontrados durante a analise. Compilacao abortada.\n");
+
+    // servidor de compilacao: os arquivos e as opcoes de cada compilacao vem do cliente
+    if (serve && ninputs > 0) {
+        fprintf(stderr, "Erro: --serve nao aceita arquivos (envie-os com cminusc)\n");
+        free(inputs);
+        return 1;
+    }
+    if (serve) {
+        ServerOptions opts;
+        opts.socketPath = socketPath;
+        opts.threads = threads;
+        free(inputs);
+        return server_run(&opts);
+    }
+
+    // recompila a cada gravacao ate Ctrl+C
+    if (watch && ninputs > 0) {
+        WatchOptions opts;
+        if (profileGen || profilePath != NULL) {
+            fprintf(stderr, "Erro: %s nao funciona com --watch\n", profileGen ? "--profile-generate" : "--profile-use");
+            free(inputs);
+            return 1;
+        }
+        if (binName != NULL && ninputs > 1) {
+            fprintf(stderr, "Erro: -o aceita um unico arquivo\n");
+            free(inputs);
+            return 1;
+        }
+        opts.inputs = inputs;
+        opts.ninputs = ninputs;
+        opts.threads = threads;
+        opts.quiet = quiet;
+        opts.binName = binName;
+        opts.stream = stream;
+        opts.lexer = lexer;
+        opts.prelex = prelex;
+        opts.optimize = optimize;
+        opts.unroll = unroll;
+        opts.debounceMs = debounceMs;
+        status = watch_run(&opts);
+        free(inputs);
+        return status;
+    }
+
+    // varios arquivos ou um diretorio: compilacao em lote
+    if (ninputs == 1) {
+        struct stat st;
+        if (stat(inputs[0], &st) == 0 && S_ISDIR(st.st_mode))
+            batchMode = TRUE;
+        else
+            fileName = inputs[0];
+    } else if (ninputs > 1) {
+        batchMode = TRUE;
+    }
+    if (batchMode && (dumpTokens || astStats || timeReport || showFrames || profileGen || profilePath != NULL)) {
+        fprintf(stderr, "Erro: %s aceita um unico arquivo\n",
+                dumpTokens ? "--dump-tokens" : astStats ? "--ast-stats" : timeReport ? "--time-report" :
+                showFrames ? "--frames" : profileGen ? "--profile-generate" : "--profile-use");
+        free(inputs);
         return 1;
     }
-    
-    if (syntaxTree == NULL) {
-        fprintf(listing, "\nErro: arvore sintatica nao foi construida.\n");
+    if (batchMode && binName != NULL) {
+        fprintf(stderr, "Erro: use --out-dir em vez de -o com varios arquivos\n");
+        free(inputs);
         return 1;
     }
-    
-    fprintf(listing, "\n******** ARVORE SINTATICA ABSTRATA ********\n\n");
-    printTree(syntaxTree);
-    
-    fprintf(listing, "\n******** ANALISE SEMANTICA ********\n\n");
-    fprintf(listing, "Construindo tabela de simbolos...\n");
-    buildSymtab(syntaxTree);
-    
-    if (Error) {
-        fprintf(listing, "\nErros semanticos encontrados. Compilacao abortada.\n");
+
+    if (fileName == NULL && !batchMode) {
+        fprintf(stderr, "Uso: %s [opcoes] <arquivo.cm | diretorio>...\n", argv[0]);
+        fprintf(stderr, "  -o <saida.cmir>      grava o codigo intermediario binario\n");
+        fprintf(stderr, "  --cache <dir>        usa um cache de compilacao (ou CMINUS_CACHE_DIR)\n");
+        fprintf(stderr, "  --cache-max <MiB>    tamanho maximo do cache (padrao 256)\n");
+        fprintf(stderr, "  --cache-stats        imprime as estatisticas do cache em stderr\n");
+        fprintf(stderr, "  --incremental        reutiliza o codigo das funcoes inalteradas (requer cache)\n");
+        fprintf(stderr, "  -j <n>               threads de compilacao (padrao: processadores)\n");
+        fprintf(stderr, "  -O, -O<n>            otimiza o codigo intermediario (1 = peephole, 2 = SSA/SCCP + peephole, 3 = -O2 + lacos vetoriais; -O0 desliga)\n");
+        fprintf(stderr, "  --unroll <n>         desenrola os lacos com contador <n> vezes (padrao %d em -O2; 1 desliga)\n", UNROLL_DEFAULT);
+        fprintf(stderr, "  --opt-stats          imprime os lacos desenrolados e os contadores do SCCP e do peephole\n");
+        fprintf(stderr, "  --frames             imprime o tamanho do registro de ativacao de cada funcao\n");
+        fprintf(stderr, "  --profile-generate   conta blocos e chamadas na execucao (cmvm --profile <arquivo>)\n");
+        fprintf(stderr, "  --profile-use <arq>  usa o perfil gravado pelo cmvm nos lacos, desvios e chamadas\n");
+        fprintf(stderr, "  --stream             analisa e gera cada funcao assim que lida (memoria limitada)\n");
+        fprintf(stderr, "  --lexer flex|simd    scanner gerado pelo flex (padrao) ou escrito a mao com SIMD\n");
+        fprintf(stderr, "  --prelex             le os tokens para um vetor antes do parser (thread propria em arquivos grandes)\n");
+        fprintf(stderr, "  --dump-tokens        imprime os tokens (linha, codigo, valor) e termina\n");
+        fprintf(stderr, "  --time-report[=json] imprime tempo, alocacoes e memoria por fase em stderr\n");
+        fprintf(stderr, "  --ast-stats          compara memoria e percurso da AST de ponteiros e da compacta\n");
+        fprintf(stderr, "  -q                   nao imprime as listagens (lote e --watch)\n");
+        fprintf(stderr, "  --out-dir <dir>      grava os .cmir da compilacao em lote em <dir>\n");
+        fprintf(stderr, "  --watch              recompila os arquivos a cada gravacao (so as funcoes alteradas)\n");
+        fprintf(stderr, "  --debounce <ms>      espera sem gravacoes antes de recompilar (padrao %d)\n", WATCH_DEBOUNCE_MS);
+        fprintf(stderr, "  --serve              atende compilacoes do cminusc em um socket local (-j threads)\n");
+        fprintf(stderr, "  --socket <caminho>   socket do servidor (padrao: $CMINUS_SOCKET ou %s)\n", socketPath);
+        free(inputs);
         return 1;
     }
-    
-    fprintf(listing, "\nVerificacao de tipos...\n");
-    typeCheck(syntaxTree);
-    
-    if (Error) {
-        fprintf(listing, "\nErros de tipo encontrados. Compilacao abortada.\n");
+
+    if (batchMode) {
+        BatchOptions opts;
+        opts.inputs = inputs;
+        opts.ninputs = ninputs;
+        opts.threads = threads;
+        opts.quiet = quiet;
+        opts.outDir = outDir;
+        opts.cache = NULL;
+        opts.incremental = incremental;
+        opts.stream = stream;
+        opts.lexer = lexer;
+        opts.prelex = prelex;
+        opts.optimize = optimize;
+        opts.unroll = unroll;
+        opts.optStats = showOptStats ? &optStats : NULL;
+        memset(&optStats, 0, sizeof(optStats));
+        if (cacheDir != NULL && cacheDir[0] != '\0' && cache_open(&cache, cacheDir, cacheMax) == 0)
+            opts.cache = &cache;
+        status = batch_run(&opts);
+        if (showOptStats) {
+            opt_print_stats(&optStats, stderr);
+            opt_stats_free(&optStats);
+        }
+        if (opts.cache != NULL) {
+            if (cacheStats)
+                cache_print_stats(&cache, stderr);
+            cache_close(&cache);
+        }
+        free(inputs);
+        return status;
+    }
+    free(inputs);
+
+    if (timeReport) {
+        phase_init(&report, memcount_available() ? memcount_read : NULL);
+        phases = &report;
+    }
+    phase_begin(phases, "fonte");
+    if (source_open(fileName, &source) != 0) {
+        fprintf(stderr, "Erro: nao foi possivel abrir o arquivo '%s'\n", fileName);
         return 1;
     }
-    
-    fprintf(listing, "\n******** TABELA DE SIMBOLOS ********\n\n");
-    printSymTab();
-    st_pop_scope();
-    
-    fprintf(listing, "\n******** GERACAO DE CODIGO ********\n");
-    codeGen(syntaxTree);
-    
-    fprintf(listing, "\nCompilacao concluida com sucesso!\n\n");
-    
-    return 0;
+    text = source.data;
+    textSize = source.size;
+    phase_end(phases, (long)textSize, "bytes");
+
+    if (dumpTokens) {
+        CompilerContext ctx;
+        Pool pool;
+        cminus_init(&ctx, stdout, stderr);
+        ctx.scanInPlace = TRUE;
+        ctx.lexer = lexer;
+        ctx.prelex = prelex;
+        if (threads <= 0)
+            threads = pool_cpu_count();
+        if (prelex && threads > 1 && pool_create(&pool, threads) == 0)
+            ctx.pool = &pool;
+        status = cminus_dump_tokens(&ctx, text, textSize);
+        if (ctx.pool != NULL)
+            pool_destroy(&pool);
+        source_close(&source);
+        return status;
+    }
+
+    if (astStats) {
+        CompilerContext ctx;
+        cminus_init(&ctx, stdout, stderr);
+        ctx.scanInPlace = TRUE;
+        ctx.lexer = lexer;
+        cminus_parse(&ctx, text, textSize);
+        if (ctx.error || ctx.savedTree == NULL)
+            status = 1;
+        else
+            status = ast_report(ctx.savedTree, ctx.lineno, stdout) == 0 ? 0 : 1;
+        cminus_free(&ctx);
+        source_close(&source);
+        return status;
+    }
+
+    profile_init(&profile);
+    if (profilePath != NULL) {
+        int loaded = profile_read(&profile, profilePath);
+        if (loaded != 0) {
+            if (loaded > 0)
+                fprintf(stderr, "Erro: nao foi possivel abrir o perfil '%s'\n", profilePath);
+            profile_free(&profile);
+            source_close(&source);
+            return 1;
+        }
+    }
+
+    listing = stdout;
+
+    fprintf(listing, "Arquivo de entrada: %s\n\n", fileName);
+
+    if (cacheDir != NULL && cacheDir[0] != '\0' && cache_open(&cache, cacheDir, cacheMax) == 0) {
+        size_t n;
+        useCache = TRUE;
+        // --stream, -O e o perfil mudam a saida; as demais opcoes nao
+        cminus_cache_options(options, sizeof(options), stream, optimize, unroll);
+        n = strlen(options);
+        if (profileGen)
+            snprintf(options + n, sizeof(options) - n, "%sG", n > 0 ? " " : "");
+        else if (profilePath != NULL)
+            snprintf(options + n, sizeof(options) - n, "%sP%016llx", n > 0 ? " " : "",
+                     (unsigned long long)profile.hash);
+        cache_key(&key, text, textSize, options);
+    }
+
+    if (useCache)
+        phase_begin(phases, "cache");
+    if (useCache && cache_lookup(&cache, &key, &entry)) {
+        phase_end(phases, -1, NULL);
+        fwrite(entry.listing, 1, entry.listingSize, stdout);
+        status = 0;
+        if (binName != NULL) {
+            status = writeBytes(binName, entry.cmir, entry.cmirSize) == 0 ? 0 : 1;
+            if (status == 0)
+                fprintf(listing, "Codigo binario gravado em: %s\n", binName);
+        }
+        if (showFrames) {
+            // a entrada do cache guarda o .cmir logo depois da listagem (sem alinhamento)
+            IrView view;
+            void* copy = malloc(entry.cmirSize + 1);
+            if (copy != NULL) {
+                memcpy(copy, entry.cmir, entry.cmirSize);
+                if (irfile_view(copy, entry.cmirSize, &view) == 0)
+                    frame_print(&view, stderr);
+                free(copy);
+            }
+        }
+        cache_entry_free(&entry);
+    } else {
+        CompilerContext ctx;
+        IncrState incr;
+        Pool pool;
+        FILE* tmp;
+        if (useCache)
+            phase_end(phases, -1, NULL);
+        tmp = useCache ? tmpfile() : NULL;
+        if (tmp != NULL)
+            listing = tmp;
+        cminus_init(&ctx, listing, stderr);
+        ctx.scanInPlace = TRUE;
+        ctx.lexer = lexer;
+        ctx.prelex = prelex;
+        ctx.report = phases;
+        ctx.optimize = optimize;
+        ctx.unroll = unroll;
+        ctx.profileGen = profileGen;
+        ctx.profile = profilePath != NULL ? &profile : NULL;
+        if (showOptStats) {
+            memset(&optStats, 0, sizeof(optStats));
+            ctx.optStats = &optStats;
+        }
+        if (threads <= 0)
+            threads = pool_cpu_count();
+        if (threads > 1 && pool_create(&pool, threads) == 0)
+            ctx.pool = &pool;
+        if (useCache && incremental) {
+            incr_init(&incr, &cache);
+            ctx.incr = &incr;
+        }
+        ir_init(&program);
+        if (stream)
+            status = cminus_compile_stream(&ctx, text, textSize, &program);
+        else
+            status = cminus_compile(&ctx, text, textSize, &program);
+        if (ctx.incr != NULL) {
+            if (status == 0)
+                fprintf(stderr, "Funcoes reutilizadas: %d, regeneradas: %d\n", incr.reused, incr.rebuilt);
+            incr_free(&incr);
+        }
+        if (ctx.optStats != NULL) {
+            opt_print_stats(&optStats, stderr);
+            opt_stats_free(&optStats);
+        }
+        cminus_free(&ctx);
+        if (ctx.pool != NULL)
+            pool_destroy(&pool);
+        if (status == 0) {
+            IrView view;
+            phase_begin(ctx.report, "cmir");
+            ir_flatten(&program, &view);
+            if (showFrames)
+                frame_print(&view, stderr);
+            cmir = (char*)irfile_serialize(&view, &cmirSize);
+            ir_view_free(&view);
+            phase_end(ctx.report, (long)cmirSize, "bytes");
+        }
+        ir_free(&program);
+        if (tmp != NULL) {
+            size_t listingSize;
+            char* out = drainListing(tmp, stdout, &listingSize);
+            fclose(tmp);
+            listing = stdout;
+            if (status == 0 && out != NULL && cmir != NULL)
+                cache_store(&cache, &key, out, listingSize, cmir, cmirSize);
+            free(out);
+        }
+        if (status == 0 && binName != NULL) {
+            if (cmir == NULL || writeBytes(binName, cmir, cmirSize) != 0)
+                status = 1;
+            else
+                fprintf(listing, "Codigo binario gravado em: %s\n", binName);
+        }
+        free(cmir);
+    }
+    source_close(&source);
+    profile_free(&profile);
+
+    if (status == 0)
+        fprintf(listing, "\nCompilacao concluida com sucesso!\n\n");
+
+    if (useCache) {
+        if (cacheStats)
+            cache_print_stats(&cache, stderr);
+        cache_close(&cache);
+    }
+
+    if (phases != NULL)
+        phase_print(phases, stderr, timeReport == 2);
+
+    return status;
 }
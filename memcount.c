@@ -0,0 +1,61 @@
+/**
+ * @file memcount.c
+ * @brief Implementacao da contagem de alocacoes
+ */
+
+#include "memcount.h"
+#include <stdlib.h>
+
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__) && !defined(__SANITIZE_THREAD__)
+#define MEMCOUNT 1
+
+// implementacoes originais exportadas pela glibc
+extern void* __libc_malloc(size_t n);
+extern void* __libc_calloc(size_t n, size_t size);
+extern void* __libc_realloc(void* p, size_t n);
+
+static unsigned long long allocCount;
+static unsigned long long allocBytes;
+
+/**
+ * @brief Soma uma alocacao aos contadores
+ * @param n Bytes pedidos
+ */
+static void countAlloc(size_t n) {
+    __atomic_fetch_add(&allocCount, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&allocBytes, n, __ATOMIC_RELAXED);
+}
+
+void* malloc(size_t n) {
+    countAlloc(n);
+    return __libc_malloc(n);
+}
+
+void* calloc(size_t n, size_t size) {
+    countAlloc(n * size);
+    return __libc_calloc(n, size);
+}
+
+void* realloc(void* p, size_t n) {
+    countAlloc(n);
+    return __libc_realloc(p, n);
+}
+#endif
+
+int memcount_available(void) {
+#ifdef MEMCOUNT
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+void memcount_read(unsigned long long* count, unsigned long long* bytes) {
+#ifdef MEMCOUNT
+    *count = __atomic_load_n(&allocCount, __ATOMIC_RELAXED);
+    *bytes = __atomic_load_n(&allocBytes, __ATOMIC_RELAXED);
+#else
+    *count = 0;
+    *bytes = 0;
+#endif
+}
@@ -0,0 +1,28 @@
+/**
+ * @file memcount.h
+ * @brief Contagem das alocacoes do processo (usada por --time-report)
+ *
+ * Ligado so ao executavel cminus, e nao a libcminus.a: substitui malloc,
+ * calloc e realloc da glibc por versoes que somam o numero de chamadas e
+ * os bytes pedidos (dois incrementos atomicos relaxados) antes de chamar as
+ * originais. Em outras bibliotecas C e com sanitizers a contagem fica
+ * desligada.
+ */
+
+#ifndef _MEMCOUNT_H_
+#define _MEMCOUNT_H_
+
+/**
+ * @brief Verifica se as alocacoes estao sendo contadas
+ * @return TRUE se memcount_read tem valores validos
+ */
+int memcount_available(void);
+
+/**
+ * @brief Le os contadores de alocacao
+ * @param count Numero de alocacoes desde o inicio do processo
+ * @param bytes Bytes pedidos desde o inicio do processo
+ */
+void memcount_read(unsigned long long* count, unsigned long long* bytes);
+
+#endif
@@ -0,0 +1,553 @@
+/**
+ * @file opt.c
+ * @brief Implementacao do otimizador peephole
+ */
+
+#include "globals.h"
+#include "opt.h"
+
+// Limite de passadas sobre uma funcao (cada passada tenta todas as regras)
+#define OPT_MAX_SWEEPS 16
+
+/**
+ * @brief Funcao em otimizacao
+ *
+ * Instrucoes removidas viram IR_NOP e so sao compactadas no final, de
+ * forma que as posicoes dos labels continuam validas durante as passadas.
+ */
+typedef struct {
+    IrInstr* code;
+    uint32_t count;
+    uint32_t* uses;          // leituras de cada temporario
+    uint32_t ntemps;
+    uint32_t* refs;          // desvios para cada label
+    int32_t* labelPos;       // posicao de cada label (-1 = ausente)
+    uint32_t nlabels;
+} Peep;
+
+/**
+ * @brief Regra do peephole
+ */
+typedef struct {
+    const char* name;
+    int (*apply)(Peep* p, uint32_t i);   // TRUE se reescreveu a janela em i
+} PeepRule;
+
+/**
+ * @brief Verifica se a operacao grava no operando d
+ * @param op Operacao
+ * @return TRUE se d e destino
+ */
+static int defines(int op) {
+    return op == IR_COPY || (op >= IR_ADD && op <= IR_NE) || op == IR_LOAD || op == IR_CALL;
+}
+
+/**
+ * @brief Verifica se a operacao pode ser removida quando o resultado nao e usado
+ * @param op Operacao
+ * @return TRUE se nao tem efeito alem do destino (divisao e load podem falhar)
+ */
+static int isPure(int op) {
+    return op == IR_COPY || op == IR_ADD || op == IR_SUB || op == IR_MUL || (op >= IR_LT && op <= IR_NE);
+}
+
+/**
+ * @brief Verifica se um operando e a constante 'v'
+ */
+static int isConst(uint8_t kind, int32_t val, int32_t v) {
+    return kind == IR_CONST && val == v;
+}
+
+/**
+ * @brief Soma 'delta' aos usos dos temporarios e as referencias dos labels de uma instrucao
+ * @param p Funcao
+ * @param in Instrucao
+ * @param delta +1 ou -1
+ */
+static void count(Peep* p, const IrInstr* in, int delta) {
+    if (in->ka == IR_TEMP && (uint32_t)in->a < p->ntemps)
+        p->uses[in->a] += delta;
+    if (in->kb == IR_TEMP && (uint32_t)in->b < p->ntemps)
+        p->uses[in->b] += delta;
+    if (in->op == IR_STORE && in->kd == IR_TEMP && (uint32_t)in->d < p->ntemps)
+        p->uses[in->d] += delta;
+    if (in->op == IR_GOTO && in->ka == IR_LABEL && (uint32_t)in->a < p->nlabels)
+        p->refs[in->a] += delta;
+    if (in->op == IR_IFFALSE && in->kb == IR_LABEL && (uint32_t)in->b < p->nlabels)
+        p->refs[in->b] += delta;
+}
+
+/**
+ * @brief Remove uma instrucao
+ * @param p Funcao
+ * @param i Posicao
+ */
+static void kill(Peep* p, uint32_t i) {
+    IrInstr* in = &p->code[i];
+    count(p, in, -1);
+    if (in->op == IR_LABEL_DEF && in->ka == IR_LABEL && (uint32_t)in->a < p->nlabels)
+        p->labelPos[in->a] = -1;
+    memset(in, 0, sizeof(*in));
+}
+
+/**
+ * @brief Proxima instrucao nao removida
+ * @param p Funcao
+ * @param i Posicao atual
+ * @return Posicao seguinte ou p->count
+ */
+static uint32_t next(const Peep* p, uint32_t i) {
+    for (i++; i < p->count && p->code[i].op == IR_NOP; i++)
+        ;
+    return i;
+}
+
+/**
+ * @brief Primeira instrucao que nao e label a partir de uma posicao
+ * @param p Funcao
+ * @param i Posicao (inclusive)
+ * @return Posicao ou p->count
+ */
+static uint32_t skipLabels(const Peep* p, uint32_t i) {
+    while (i < p->count && (p->code[i].op == IR_NOP || p->code[i].op == IR_LABEL_DEF))
+        i++;
+    return i;
+}
+
+/**
+ * @brief Troca uma instrucao mantendo os contadores
+ * @param p Funcao
+ * @param i Posicao
+ * @param in Nova instrucao
+ */
+static void replace(Peep* p, uint32_t i, IrInstr in) {
+    count(p, &p->code[i], -1);
+    p->code[i] = in;
+    count(p, &p->code[i], 1);
+}
+
+/**
+ * @brief Transforma a instrucao em uma copia 'd = (kind, val)'
+ */
+static void toCopy(Peep* p, uint32_t i, uint8_t kind, int32_t val) {
+    IrInstr in = p->code[i];
+    in.op = IR_COPY;
+    in.ka = kind;
+    in.a = val;
+    in.kb = IR_NONE;
+    in.b = 0;
+    replace(p, i, in);
+}
+
+/**
+ * @brief t = x seguido de uma instrucao que le t (unica leitura): le x direto
+ */
+static int copyForward(Peep* p, uint32_t i) {
+    IrInstr in = p->code[i];
+    IrInstr use;
+    uint32_t j;
+    if (in.op != IR_COPY || in.kd != IR_TEMP || (uint32_t)in.d >= p->ntemps || p->uses[in.d] != 1)
+        return FALSE;
+    j = next(p, i);
+    if (j == p->count)
+        return FALSE;
+    use = p->code[j];
+    if (use.ka == IR_TEMP && use.a == in.d) {
+        use.ka = in.ka;
+        use.a = in.a;
+    } else if (use.kb == IR_TEMP && use.b == in.d) {
+        use.kb = in.ka;
+        use.b = in.a;
+    } else {
+        return FALSE;
+    }
+    replace(p, j, use);
+    kill(p, i);
+    return TRUE;
+}
+
+/**
+ * @brief t = a op b seguido de x = t (unica leitura de t): grava direto em x
+ */
+static int directDest(Peep* p, uint32_t i) {
+    IrInstr in = p->code[i];
+    IrInstr* copy;
+    uint32_t j;
+    if (!defines(in.op) || in.kd != IR_TEMP || (uint32_t)in.d >= p->ntemps || p->uses[in.d] != 1)
+        return FALSE;
+    j = next(p, i);
+    if (j == p->count)
+        return FALSE;
+    copy = &p->code[j];
+    if (copy->op != IR_COPY || copy->ka != IR_TEMP || copy->a != in.d)
+        return FALSE;
+    in.kd = copy->kd;
+    in.d = copy->d;
+    kill(p, j);
+    replace(p, i, in);
+    return TRUE;
+}
+
+/**
+ * @brief x = x
+ */
+static int selfCopy(Peep* p, uint32_t i) {
+    IrInstr* in = &p->code[i];
+    if (in->op != IR_COPY || in->kd != in->ka || in->d != in->a)
+        return FALSE;
+    kill(p, i);
+    return TRUE;
+}
+
+/**
+ * @brief x + 0, 0 + x, x - 0, x * 1, 1 * x, x / 1
+ */
+static int identity(Peep* p, uint32_t i) {
+    IrInstr in = p->code[i];
+    int right = (in.op == IR_ADD && isConst(in.kb, in.b, 0)) || (in.op == IR_SUB && isConst(in.kb, in.b, 0)) ||
+                (in.op == IR_MUL && isConst(in.kb, in.b, 1)) || (in.op == IR_DIV && isConst(in.kb, in.b, 1));
+    int left = (in.op == IR_ADD && isConst(in.ka, in.a, 0)) || (in.op == IR_MUL && isConst(in.ka, in.a, 1));
+    if (right)
+        toCopy(p, i, in.ka, in.a);
+    else if (left)
+        toCopy(p, i, in.kb, in.b);
+    return right || left;
+}
+
+/**
+ * @brief x * 0, 0 * x
+ */
+static int mulZero(Peep* p, uint32_t i) {
+    IrInstr* in = &p->code[i];
+    if (in->op != IR_MUL || !(isConst(in->ka, in->a, 0) || isConst(in->kb, in->b, 0)))
+        return FALSE;
+    toCopy(p, i, IR_CONST, 0);
+    return TRUE;
+}
+
+/**
+ * @brief Operacao entre duas constantes
+ */
+static int constFold(Peep* p, uint32_t i) {
+    IrInstr* in = &p->code[i];
+    int32_t v;
+    if (in->op < IR_ADD || in->op > IR_NE || in->ka != IR_CONST || in->kb != IR_CONST)
+        return FALSE;
+    if (!opt_fold(in->op, in->a, in->b, &v))
+        return FALSE;
+    toCopy(p, i, IR_CONST, v);
+    return TRUE;
+}
+
+/**
+ * @brief if_false com condicao constante
+ */
+static int constBranch(Peep* p, uint32_t i) {
+    IrInstr in = p->code[i];
+    if (in.op != IR_IFFALSE || in.ka != IR_CONST)
+        return FALSE;
+    if (in.a != 0) {
+        kill(p, i);
+    } else {
+        in.op = IR_GOTO;
+        in.ka = in.kb;
+        in.a = in.b;
+        in.kb = IR_NONE;
+        in.b = 0;
+        replace(p, i, in);
+    }
+    return TRUE;
+}
+
+/**
+ * @brief Label de destino de um desvio
+ * @return Ponteiro para o operando do label ou NULL se nao e desvio
+ */
+static int32_t* target(IrInstr* in) {
+    if (in->op == IR_GOTO && in->ka == IR_LABEL)
+        return &in->a;
+    if (in->op == IR_IFFALSE && in->kb == IR_LABEL)
+        return &in->b;
+    return NULL;
+}
+
+/**
+ * @brief Desvio para um label que ja e a proxima instrucao
+ */
+static int jumpNext(Peep* p, uint32_t i) {
+    int32_t* l = target(&p->code[i]);
+    uint32_t j;
+    if (l == NULL)
+        return FALSE;
+    for (j = next(p, i); j < p->count && p->code[j].op == IR_LABEL_DEF; j = next(p, j)) {
+        if (p->code[j].a == *l) {
+            kill(p, i);
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/**
+ * @brief Desvio para um label seguido de goto: desvia direto para o destino final
+ */
+static int jumpChain(Peep* p, uint32_t i) {
+    IrInstr in = p->code[i];
+    int32_t* l = target(&in);
+    int32_t dest;
+    uint32_t hops, k;
+    if (l == NULL || (uint32_t)*l >= p->nlabels)
+        return FALSE;
+    dest = *l;
+    // limitado pelo numero de labels (ciclos de gotos nao terminam)
+    for (hops = 0; hops < p->nlabels && p->labelPos[dest] >= 0; hops++) {
+        k = skipLabels(p, (uint32_t)p->labelPos[dest]);
+        if (k == p->count || p->code[k].op != IR_GOTO || p->code[k].ka != IR_LABEL ||
+            (uint32_t)p->code[k].a >= p->nlabels || p->code[k].a == dest)
+            break;
+        dest = p->code[k].a;
+    }
+    if (dest == *l)
+        return FALSE;
+    *l = dest;
+    replace(p, i, in);
+    return TRUE;
+}
+
+/**
+ * @brief Instrucoes depois de goto ou return, antes do proximo label
+ */
+static int unreachable(Peep* p, uint32_t i) {
+    uint32_t j;
+    if (p->code[i].op != IR_GOTO && p->code[i].op != IR_RETURN)
+        return FALSE;
+    j = next(p, i);
+    if (j == p->count || p->code[j].op == IR_LABEL_DEF)
+        return FALSE;
+    kill(p, j);
+    return TRUE;
+}
+
+/**
+ * @brief Label sem desvios para ele
+ */
+static int deadLabel(Peep* p, uint32_t i) {
+    IrInstr* in = &p->code[i];
+    if (in->op != IR_LABEL_DEF || in->ka != IR_LABEL || (uint32_t)in->a >= p->nlabels || p->refs[in->a] != 0)
+        return FALSE;
+    kill(p, i);
+    return TRUE;
+}
+
+/**
+ * @brief Temporario calculado e nunca lido
+ */
+static int deadTemp(Peep* p, uint32_t i) {
+    IrInstr* in = &p->code[i];
+    if (!isPure(in->op) || in->kd != IR_TEMP || (uint32_t)in->d >= p->ntemps || p->uses[in->d] != 0)
+        return FALSE;
+    kill(p, i);
+    return TRUE;
+}
+
+// Tabela de regras, na ordem de OptRule
+static const PeepRule rules[OPT_NRULES] = {
+    [OPT_COPY_FORWARD] = {"copia-adiante", copyForward},
+    [OPT_DIRECT_DEST]  = {"destino-direto", directDest},
+    [OPT_SELF_COPY]    = {"copia-inutil", selfCopy},
+    [OPT_IDENTITY]     = {"identidade", identity},
+    [OPT_MUL_ZERO]     = {"multiplica-zero", mulZero},
+    [OPT_CONST_FOLD]   = {"constantes", constFold},
+    [OPT_CONST_BRANCH] = {"desvio-constante", constBranch},
+    [OPT_JUMP_NEXT]    = {"salto-proximo", jumpNext},
+    [OPT_JUMP_CHAIN]   = {"cadeia-de-saltos", jumpChain},
+    [OPT_UNREACHABLE]  = {"inalcancavel", unreachable},
+    [OPT_DEAD_LABEL]   = {"label-morto", deadLabel},
+    [OPT_DEAD_TEMP]    = {"temp-morto", deadTemp},
+};
+
+uint32_t opt_peephole(IrUnit* unit, OptStats* stats) {
+    unsigned long applied[OPT_NRULES];
+    uint32_t before = unit->rec.count;
+    uint32_t i, n;
+    int changed = TRUE;
+    int sweep, r;
+    Peep p;
+
+    if (before == 0)
+        return 0;
+    p.code = unit->code;
+    p.count = before;
+    p.ntemps = unit->rec.ntemps;
+    p.nlabels = unit->rec.nlabels;
+    p.uses = (uint32_t*)calloc(p.ntemps + 1, sizeof(uint32_t));
+    p.refs = (uint32_t*)calloc(p.nlabels + 1, sizeof(uint32_t));
+    p.labelPos = (int32_t*)malloc((p.nlabels + 1) * sizeof(int32_t));
+    if (p.uses == NULL || p.refs == NULL || p.labelPos == NULL) {
+        free(p.uses);
+        free(p.refs);
+        free(p.labelPos);
+        return 0;
+    }
+    memset(applied, 0, sizeof(applied));
+    for (i = 0; i < p.nlabels; i++)
+        p.labelPos[i] = -1;
+    for (i = 0; i < p.count; i++) {
+        IrInstr* in = &p.code[i];
+        count(&p, in, 1);
+        if (in->op == IR_LABEL_DEF && in->ka == IR_LABEL && (uint32_t)in->a < p.nlabels)
+            p.labelPos[in->a] = (int32_t)i;
+    }
+
+    for (sweep = 0; changed && sweep < OPT_MAX_SWEEPS; sweep++) {
+        changed = FALSE;
+        for (i = 0; i < p.count; i++) {
+            for (r = 0; r < OPT_NRULES && p.code[i].op != IR_NOP; r++) {
+                if (rules[r].apply(&p, i)) {
+                    applied[r]++;
+                    changed = TRUE;
+                }
+            }
+        }
+    }
+
+    for (i = 0, n = 0; i < p.count; i++)
+        if (p.code[i].op != IR_NOP)
+            p.code[n++] = p.code[i];
+    unit->rec.count = n;
+    free(p.uses);
+    free(p.refs);
+    free(p.labelPos);
+
+    if (stats != NULL) {
+        for (r = 0; r < OPT_NRULES; r++)
+            if (applied[r] != 0)
+                __atomic_add_fetch(&stats->applied[r], applied[r], __ATOMIC_RELAXED);
+        __atomic_add_fetch(&stats->before, (unsigned long)before, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&stats->after, (unsigned long)n, __ATOMIC_RELAXED);
+    }
+    return before - n;
+}
+
+int opt_fold(int op, int32_t a, int32_t b, int32_t* out) {
+    switch (op) {
+        case IR_ADD: *out = (int32_t)((uint32_t)a + (uint32_t)b); return TRUE;
+        case IR_SUB: *out = (int32_t)((uint32_t)a - (uint32_t)b); return TRUE;
+        case IR_MUL: *out = (int32_t)((uint32_t)a * (uint32_t)b); return TRUE;
+        case IR_DIV:
+            // o erro de divisao fica para a execucao
+            if (b == 0 || (a == INT32_MIN && b == -1))
+                return FALSE;
+            *out = a / b;
+            return TRUE;
+        case IR_LT: *out = a < b; return TRUE;
+        case IR_LE: *out = a <= b; return TRUE;
+        case IR_GT: *out = a > b; return TRUE;
+        case IR_GE: *out = a >= b; return TRUE;
+        case IR_EQ: *out = a == b; return TRUE;
+        case IR_NE: *out = a != b; return TRUE;
+        default:    return FALSE;
+    }
+}
+
+const char* opt_rule_name(OptRule rule) {
+    return rule < OPT_NRULES ? rules[rule].name : "?";
+}
+
+void opt_note_loop(OptStats* stats, const char* func, int line, int factor, long trips, int remainder) {
+    size_t len = strlen(func);
+    OptLoop* loop;
+    if (stats == NULL)
+        return;
+    loop = (OptLoop*)malloc(sizeof(OptLoop) + len + 1);
+    if (loop == NULL)
+        return;
+    loop->line = line;
+    loop->factor = factor;
+    loop->trips = trips;
+    loop->remainder = remainder;
+    memcpy(loop->func, func, len + 1);
+    loop->next = __atomic_load_n(&stats->loops, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&stats->loops, &loop->next, loop, TRUE, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+        ;
+    if (factor < 0) {
+        __atomic_add_fetch(&stats->vectorLoops, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    __atomic_add_fetch(&stats->unrollLoops, 1, __ATOMIC_RELAXED);
+    if (factor == 0)
+        __atomic_add_fetch(&stats->unrollFull, 1, __ATOMIC_RELAXED);
+}
+
+void opt_stats_free(OptStats* stats) {
+    OptLoop* loop = stats->loops;
+    while (loop != NULL) {
+        OptLoop* next = loop->next;
+        free(loop);
+        loop = next;
+    }
+    stats->loops = NULL;
+}
+
+/**
+ * @brief Ordem do relatorio dos lacos: funcao e linha (a lista sai na ordem das threads)
+ */
+static int compareLoops(const void* x, const void* y) {
+    const OptLoop* a = *(const OptLoop* const*)x;
+    const OptLoop* b = *(const OptLoop* const*)y;
+    int c = strcmp(a->func, b->func);
+    if (c != 0)
+        return c;
+    return (a->line > b->line) - (a->line < b->line);
+}
+
+/**
+ * @brief Imprime os lacos desenrolados e vetorizados
+ */
+static void printLoops(const OptStats* stats, FILE* out) {
+    OptLoop** sorted;
+    OptLoop* loop;
+    unsigned long i, n = 0;
+    fprintf(out, "Lacos desenrolados: %lu (%lu por completo), vetorizados: %lu\n",
+            stats->unrollLoops, stats->unrollFull, stats->vectorLoops);
+    for (loop = stats->loops; loop != NULL; loop = loop->next)
+        n++;
+    sorted = (OptLoop**)malloc((n ? n : 1) * sizeof(OptLoop*));
+    if (sorted == NULL)
+        return;
+    for (i = 0, loop = stats->loops; loop != NULL; loop = loop->next)
+        sorted[i++] = loop;
+    qsort(sorted, n, sizeof(OptLoop*), compareLoops);
+    for (i = 0; i < n; i++) {
+        loop = sorted[i];
+        if (loop->factor < 0)
+            fprintf(out, "  %s, linha %d: vetorizado\n", loop->func, loop->line);
+        else if (loop->factor == 0)
+            fprintf(out, "  %s, linha %d: por completo (%ld iteracoes)\n", loop->func, loop->line, loop->trips);
+        else
+            fprintf(out, "  %s, linha %d: fator %d%s\n", loop->func, loop->line, loop->factor,
+                    loop->remainder ? " + laco de resto" : "");
+    }
+    free(sorted);
+}
+
+void opt_print_stats(const OptStats* stats, FILE* out) {
+    int r;
+    if (stats->unrollLoops > 0 || stats->vectorLoops > 0)
+        printLoops(stats, out);
+    if (stats->ssaFunctions > 0)
+        fprintf(out, "SCCP: %lu funcoes, %lu phis, %lu constantes, %lu desvios resolvidos, %lu blocos removidos\n",
+                stats->ssaFunctions, stats->ssaPhis, stats->ssaConstants, stats->ssaBranches, stats->ssaDeadBlocks);
+    if (stats->ssaFunctions > 0)
+        fprintf(out, "Chamadas puras avaliadas: %lu (%lu falharam ou passaram do limite), %.3f ms\n",
+                stats->foldCalls, stats->foldFailed, (double)stats->foldMicros / 1000.0);
+    fprintf(out, "Peephole: %lu -> %lu instrucoes (%.1f%% removidas)\n", stats->before, stats->after,
+            stats->before ? 100.0 * (double)(stats->before - stats->after) / (double)stats->before : 0.0);
+    for (r = 0; r < OPT_NRULES; r++)
+        fprintf(out, "  %-18s %lu\n", rules[r].name, stats->applied[r]);
+    fprintf(out, "Temporarios: %lu -> %lu celulas no registro de ativacao\n", stats->tempsBefore, stats->tempsAfter);
+    if (stats->pgoInlined + stats->pgoRotated + stats->pgoColdBlocks + stats->pgoNoUnroll + stats->pgoStale > 0)
+        fprintf(out, "Perfil: %lu chamadas expandidas, %lu lacos rodados, %lu ramos frios, "
+                "%lu lacos nao desenrolados, %lu funcoes desatualizadas\n", stats->pgoInlined, stats->pgoRotated,
+                stats->pgoColdBlocks, stats->pgoNoUnroll, stats->pgoStale);
+}
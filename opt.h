@@ -0,0 +1,126 @@
+/**
+ * @file opt.h
+ * @brief Otimizador peephole do codigo de tres enderecos (-O) e contadores dos passes
+ *
+ * Uma janela deslizante percorre as instrucoes de cada funcao logo depois
+ * da geracao e aplica as regras da tabela em opt.c (copias redundantes,
+ * identidades algebricas, constantes, saltos encadeados e codigo
+ * inalcancavel) ate nenhuma regra casar. O numero de aplicacoes de cada
+ * regra e somado em um OptStats, que pode ser compartilhado entre as
+ * threads da geracao de codigo e tambem guarda os lacos desenrolados
+ * (unroll.h) e os contadores dos passes de -O2.
+ */
+
+#ifndef _OPT_H_
+#define _OPT_H_
+
+#include <stdio.h>
+#include "ir.h"
+
+// Regras do peephole, na ordem em que sao tentadas
+typedef enum {
+    OPT_COPY_FORWARD,    // t = x; ... t ...        =>  ... x ...
+    OPT_DIRECT_DEST,     // t = a op b; x = t       =>  x = a op b
+    OPT_SELF_COPY,       // x = x                   =>  (removida)
+    OPT_IDENTITY,        // x + 0, x - 0, x * 1, x / 1  =>  x
+    OPT_MUL_ZERO,        // x * 0                   =>  0
+    OPT_CONST_FOLD,      // c1 op c2                =>  c
+    OPT_CONST_BRANCH,    // if_false c goto L       =>  goto L ou nada
+    OPT_JUMP_NEXT,       // goto L; L:              =>  L:
+    OPT_JUMP_CHAIN,      // goto L1 ... L1: goto L2 =>  goto L2
+    OPT_UNREACHABLE,     // goto/return; x          =>  goto/return
+    OPT_DEAD_LABEL,      // L: sem referencias      =>  (removido)
+    OPT_DEAD_TEMP,       // t = ... sem usos        =>  (removida)
+    OPT_NRULES
+} OptRule;
+
+/**
+ * @brief Laco desenrolado ou vetorizado (relatorio do --opt-stats)
+ */
+typedef struct OptLoop {
+    struct OptLoop* next;
+    int line;                    // linha do while
+    int factor;                  // copias do corpo por teste (0 = desenrolado por completo, -1 = vetorizado)
+    long trips;                  // iteracoes do laco desenrolado por completo
+    int remainder;               // TRUE se ficou um laco de resto
+    char func[];                 // funcao
+} OptLoop;
+
+/**
+ * @brief Aplicacoes de cada regra e tamanho do codigo antes e depois
+ */
+typedef struct OptStats {
+    unsigned long applied[OPT_NRULES];
+    unsigned long before;        // instrucoes antes do peephole
+    unsigned long after;         // instrucoes depois do peephole
+    unsigned long ssaFunctions;  // funcoes que passaram pelo SCCP (-O2)
+    unsigned long ssaPhis;       // phis inseridos
+    unsigned long ssaConstants;  // leituras e definicoes trocadas por constantes
+    unsigned long ssaBranches;   // if_false resolvidos
+    unsigned long ssaDeadBlocks; // blocos nunca executados removidos
+    unsigned long foldCalls;     // chamadas puras trocadas pelo resultado
+    unsigned long foldFailed;    // chamadas que falharam ou passaram do limite de passos
+    unsigned long foldMicros;    // tempo da avaliacao das chamadas
+    unsigned long unrollLoops;   // lacos com contador desenrolados
+    unsigned long unrollFull;    // desses, desenrolados por completo
+    unsigned long vectorLoops;   // lacos trocados por uma operacao vetorial (-O3)
+    unsigned long tempsBefore;   // temporarios antes do reuso de celulas (frame.h)
+    unsigned long tempsAfter;    // celulas de temporarios depois do reuso
+    unsigned long pgoInlined;    // chamadas quentes expandidas no chamador (--profile-use, pgo.h)
+    unsigned long pgoRotated;    // while quentes com o teste no fim do corpo
+    unsigned long pgoColdBlocks; // ramos frios de if-else gerados no fim da funcao
+    unsigned long pgoNoUnroll;   // lacos nao desenrolados por executarem poucas iteracoes
+    unsigned long pgoStale;      // funcoes com contagens de uma versao anterior do fonte
+    OptLoop* loops;              // relatorio de cada laco (lista atomica, opt_stats_free)
+} OptStats;
+
+/**
+ * @brief Otimiza o codigo de uma funcao
+ * @param unit Funcao gerada
+ * @param stats Contadores somados de forma atomica (NULL = nao conta)
+ * @return Numero de instrucoes removidas
+ */
+uint32_t opt_peephole(IrUnit* unit, OptStats* stats);
+
+/**
+ * @brief Calcula uma operacao binaria entre constantes com a aritmetica do VM
+ * @param op Operacao (IR_ADD a IR_NE)
+ * @param a Operando esquerdo
+ * @param b Operando direito
+ * @param out Resultado
+ * @return TRUE se calculou; FALSE para divisao por zero ou estouro (o erro fica para a execucao)
+ */
+int opt_fold(int op, int32_t a, int32_t b, int32_t* out);
+
+/**
+ * @brief Nome de uma regra (usado no relatorio)
+ * @param rule Regra
+ * @return Nome curto
+ */
+const char* opt_rule_name(OptRule rule);
+
+/**
+ * @brief Registra um laco desenrolado ou vetorizado (pode ser chamada de qualquer thread)
+ * @param stats Contadores (NULL = nao registra)
+ * @param func Nome da funcao
+ * @param line Linha do while
+ * @param factor Copias do corpo por teste (0 = desenrolado por completo, -1 = vetorizado)
+ * @param trips Iteracoes (laco desenrolado por completo)
+ * @param remainder TRUE se ficou um laco de resto
+ */
+void opt_note_loop(OptStats* stats, const char* func, int line, int factor, long trips, int remainder);
+
+/**
+ * @brief Libera o relatorio dos lacos desenrolados
+ * @param stats Contadores
+ */
+void opt_stats_free(OptStats* stats);
+
+/**
+ * @brief Imprime os contadores do SCCP e as aplicacoes de cada regra do peephole
+ * @param stats Contadores
+ * @param out Saida
+ */
+void opt_print_stats(const OptStats* stats, FILE* out);
+
+#endif
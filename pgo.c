@@ -0,0 +1,451 @@
+/**
+ * @file pgo.c
+ * @brief Implementacao dos pontos de contagem e da expansao de chamadas guiada por perfil
+ */
+
+#include "pgo.h"
+#include "profile.h"
+#include "opt.h"
+#include "ssa.h"
+
+/**
+ * @brief Estado da numeracao dos pontos de contagem
+ */
+typedef struct {
+    PgoSites* sites;
+    uint32_t cap;
+    uint32_t hash;
+    int ok;
+} SiteWalk;
+
+/**
+ * @brief Soma um inteiro ao checksum (FNV-1a)
+ */
+static void hashInt(SiteWalk* w, uint32_t v) {
+    int i;
+    for (i = 0; i < 4; i++) {
+        w->hash = (w->hash ^ (v & 0xff)) * 16777619u;
+        v >>= 8;
+    }
+}
+
+/**
+ * @brief Soma uma string ao checksum (com o '\0', que separa nomes seguidos)
+ */
+static void hashStr(SiteWalk* w, const char* s) {
+    if (s == NULL)
+        s = "";
+    do {
+        w->hash = (w->hash ^ (unsigned char)*s) * 16777619u;
+    } while (*s++ != '\0');
+}
+
+/**
+ * @brief Percorre uma lista de irmaos em pre-ordem numerando os while e if
+ * @param w Estado
+ * @param t Primeiro no
+ */
+static void walkSites(SiteWalk* w, const TreeNode* t) {
+    int i;
+    for (; t != NULL && w->ok; t = t->sibling) {
+        hashInt(w, (uint32_t)t->nodekind);
+        hashInt(w, (uint32_t)t->kind.stmt);
+        hashInt(w, (uint32_t)t->type);
+        if (t->nodekind == ExpK && t->kind.exp == OpK)
+            hashInt(w, (uint32_t)t->attr.op);
+        else if (t->nodekind == ExpK && t->kind.exp == ConstK)
+            hashInt(w, (uint32_t)t->attr.val);
+        else if (t->nodekind == DeclK || (t->nodekind == ExpK && (t->kind.exp == IdK || t->kind.exp == CallK)))
+            hashStr(w, t->attr.name);
+        if (t->nodekind == StmtK && (t->kind.stmt == WhileK || t->kind.stmt == IfK)) {
+            PgoSites* s = w->sites;
+            if (s->nsites == w->cap) {
+                uint32_t cap = w->cap ? w->cap * 2 : 16;
+                PgoSite* grown = (PgoSite*)realloc(s->sites, cap * sizeof(PgoSite));
+                if (grown == NULL) {
+                    w->ok = FALSE;
+                    return;
+                }
+                s->sites = grown;
+                w->cap = cap;
+            }
+            s->sites[s->nsites].node = t;
+            s->sites[s->nsites].counter = 1 + 2 * s->nsites;
+            s->nsites++;
+        }
+        for (i = 0; i < MAXCHILDREN; i++) {
+            // o tamanho de um array declarado ja entrou como filho ConstK
+            hashInt(w, t->child[i] != NULL);
+            walkSites(w, t->child[i]);
+        }
+    }
+}
+
+/**
+ * @brief Ordem dos pontos pelo endereco do no (busca binaria)
+ */
+static int compareSites(const void* x, const void* y) {
+    uintptr_t a = (uintptr_t)((const PgoSite*)x)->node;
+    uintptr_t b = (uintptr_t)((const PgoSite*)y)->node;
+    return (a > b) - (a < b);
+}
+
+int pgo_sites(PgoSites* sites, TreeNode* fun) {
+    SiteWalk w;
+    memset(sites, 0, sizeof(*sites));
+    w.sites = sites;
+    w.cap = 0;
+    w.hash = 2166136261u;
+    w.ok = TRUE;
+    hashInt(&w, (uint32_t)fun->type);
+    walkSites(&w, fun->child[0]);
+    hashInt(&w, 0xffffffffu);
+    walkSites(&w, fun->child[1]);
+    if (!w.ok) {
+        pgo_sites_free(sites);
+        return -1;
+    }
+    sites->ncounts = 1 + 2 * sites->nsites;
+    sites->checksum = w.hash;
+    if (sites->nsites > 1)
+        qsort(sites->sites, sites->nsites, sizeof(PgoSite), compareSites);
+    return 0;
+}
+
+int32_t pgo_counter(const PgoSites* sites, const TreeNode* node) {
+    uint32_t lo = 0, hi = sites->nsites;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (sites->sites[mid].node == node)
+            return (int32_t)sites->sites[mid].counter;
+        if ((uintptr_t)sites->sites[mid].node < (uintptr_t)node)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return -1;
+}
+
+void pgo_sites_free(PgoSites* sites) {
+    free(sites->sites);
+    memset(sites, 0, sizeof(*sites));
+}
+
+/**
+ * @brief Codigo de um chamador em reconstrucao
+ */
+typedef struct {
+    IrInstr* code;
+    uint32_t count;
+    uint32_t cap;
+    int ok;
+} CodeBuf;
+
+/**
+ * @brief Acrescenta uma instrucao
+ */
+static void put(CodeBuf* b, IrInstr in) {
+    if (b->count == b->cap) {
+        uint32_t cap = b->cap ? b->cap * 2 : 64;
+        IrInstr* grown = (IrInstr*)realloc(b->code, cap * sizeof(IrInstr));
+        if (grown == NULL) {
+            b->ok = FALSE;
+            return;
+        }
+        b->code = grown;
+        b->cap = cap;
+    }
+    b->code[b->count++] = in;
+}
+
+/**
+ * @brief Monta uma instrucao d = a (kb ausente) da linha 'line' do fonte
+ */
+static IrInstr copyInstr(uint8_t kd, int32_t d, uint8_t ka, int32_t a, int32_t line) {
+    IrInstr in;
+    memset(&in, 0, sizeof(in));
+    in.op = IR_COPY;
+    in.kd = kd;
+    in.d = d;
+    in.ka = ka;
+    in.a = a;
+    in.line = line;
+    return in;
+}
+
+/**
+ * @brief Verifica se uma funcao pode ser expandida no chamador
+ * @param callee Funcao chamada
+ * @return TRUE se e pequena e nao tem arrays locais (aumentariam o registro de quem chama)
+ */
+static int inlinable(const IrUnit* callee) {
+    uint32_t k;
+    if (callee->rec.count > PGO_INLINE_MAX)
+        return FALSE;
+    for (k = callee->rec.nparams; k < callee->rec.nslots; k++)
+        if (callee->slots[k].size > 0)
+            return FALSE;
+    return TRUE;
+}
+
+/**
+ * @brief Variaveis locais que podem ser lidas antes de gravadas
+ *
+ * Na chamada o registro comeca zerado; a copia expandida reusa os slots a
+ * cada execucao e precisa zerar essas variaveis explicitamente.
+ *
+ * @param callee Funcao chamada
+ * @param zero Recebe uma marca por slot
+ */
+static void zeroSlots(IrUnit* callee, uint8_t* zero) {
+    SsaFunc s;
+    uint32_t ntemps = callee->rec.ntemps;
+    uint32_t first = ntemps + callee->rec.nparams;
+    uint32_t i, j, v;
+    memset(zero, 0, callee->rec.nslots);
+    if (callee->rec.count == 0)
+        return;
+    if (ssa_build(&s, callee) != 0) {
+        // sem a SSA, zera todas
+        memset(zero + callee->rec.nparams, 1, callee->rec.nslots - callee->rec.nparams);
+        return;
+    }
+    // os valores [0, nvars) sao os valores de entrada de cada variavel
+    for (i = 0; i < 3 * callee->rec.count; i++)
+        if ((v = s.useVal[i]) != SSA_NONE && v >= first && v < s.nvars)
+            zero[v - ntemps] = 1;
+    for (i = 0; i < s.nphis; i++)
+        for (j = 0; j < s.blocks[s.phis[i].block].npreds; j++)
+            if ((v = s.phis[i].args[j]) != SSA_NONE && v >= first && v < s.nvars)
+                zero[v - ntemps] = 1;
+    ssa_free(&s);
+}
+
+/**
+ * @brief Renumera um operando da funcao chamada para o chamador
+ */
+static void remap(uint8_t kind, int32_t* val, int32_t tempBase, int32_t labelBase, int32_t slotBase) {
+    if (kind == IR_TEMP)
+        *val += tempBase;
+    else if (kind == IR_LABEL)
+        *val += labelBase;
+    else if (kind == IR_LOCAL)
+        *val += slotBase;
+}
+
+/**
+ * @brief Expande uma chamada
+ * @param prog Programa
+ * @param unit Chamador
+ * @param callee Funcao chamada
+ * @param call Instrucao IR_CALL
+ * @param out Codigo novo do chamador (os param da chamada ja estao nele)
+ * @param params Posicao em 'out' de cada param da chamada
+ * @return 0 se sucesso, -1 sem memoria
+ */
+static int expand(IrProgram* prog, IrUnit* unit, IrUnit* callee, const IrInstr* call, CodeBuf* out,
+                  const uint32_t* params) {
+    int32_t tempBase = (int32_t)unit->rec.ntemps;
+    int32_t labelBase = (int32_t)unit->rec.nlabels;
+    int32_t slotBase = (int32_t)unit->rec.nslots;
+    int32_t done = labelBase + (int32_t)callee->rec.nlabels;
+    uint32_t frameTop = ir_frame_slots(unit->slots, unit->rec.nslots);
+    uint32_t slotTop = unit->slotTop;
+    uint8_t* zero = (uint8_t*)malloc(callee->rec.nslots + 1);
+    IrInstr none;
+    uint32_t k;
+    int fallsOff;
+    if (zero == NULL)
+        return -1;
+    zeroSlots(callee, zero);
+    // slots novos depois dos do chamador, com o mesmo layout da funcao chamada
+    for (k = 0; k < callee->rec.nslots; k++) {
+        const char* fname = prog->strs.data + callee->rec.name;
+        const char* sname = prog->strs.data + callee->slots[k].name;
+        char* name = (char*)malloc(strlen(fname) + strlen(sname) + 2);
+        int slot;
+        if (name == NULL) {
+            free(zero);
+            return -1;
+        }
+        sprintf(name, "%s.%s", fname, sname);
+        slot = ir_add_slot(prog, unit, name, callee->slots[k].size);
+        unit->slots[slot].offset = (int32_t)frameTop + callee->slots[k].offset;
+        free(name);
+    }
+    unit->slotTop = slotTop;
+    unit->rec.ntemps += callee->rec.ntemps;
+    unit->rec.nlabels += callee->rec.nlabels + 1;
+    // param x  =>  f.p = x, no mesmo ponto (os argumentos seguintes podem mudar x)
+    for (k = 0; k < callee->rec.nparams; k++) {
+        IrInstr* p = &out->code[params[k]];
+        *p = copyInstr(IR_LOCAL, slotBase + (int32_t)k, p->ka, p->a, p->line);
+    }
+    for (k = callee->rec.nparams; k < callee->rec.nslots; k++)
+        if (zero[k])
+            put(out, copyInstr(IR_LOCAL, slotBase + (int32_t)k, IR_CONST, 0, call->line));
+    free(zero);
+    memset(&none, 0, sizeof(none));
+    for (k = 0; k < callee->rec.count; k++) {
+        IrInstr in = callee->code[k];
+        remap(in.kd, &in.d, tempBase, labelBase, slotBase);
+        remap(in.ka, &in.a, tempBase, labelBase, slotBase);
+        remap(in.kb, &in.b, tempBase, labelBase, slotBase);
+        if (in.op != IR_RETURN) {
+            put(out, in);
+            continue;
+        }
+        if (call->kd != IR_NONE)
+            put(out, in.ka != IR_NONE ? copyInstr(call->kd, call->d, in.ka, in.a, in.line)
+                                      : copyInstr(call->kd, call->d, IR_CONST, 0, in.line));
+        none.op = IR_GOTO;
+        none.ka = IR_LABEL;
+        none.a = done;
+        none.line = in.line;
+        put(out, none);
+    }
+    // fim da funcao sem return: o valor e 0
+    fallsOff = callee->rec.count == 0 || (callee->code[callee->rec.count - 1].op != IR_RETURN &&
+                                          callee->code[callee->rec.count - 1].op != IR_GOTO);
+    if (fallsOff && call->kd != IR_NONE)
+        put(out, copyInstr(call->kd, call->d, IR_CONST, 0, call->line));
+    memset(&none, 0, sizeof(none));
+    none.op = IR_LABEL_DEF;
+    none.ka = IR_LABEL;
+    none.a = done;
+    none.line = call->line;
+    put(out, none);
+    return out->ok ? 0 : -1;
+}
+
+/**
+ * @brief Expande as chamadas quentes de uma funcao
+ * @param prog Programa
+ * @param u Indice do chamador
+ * @param prof Perfil
+ * @return Chamadas expandidas
+ */
+static uint32_t inlineUnit(IrProgram* prog, uint32_t u, const Profile* prof) {
+    IrUnit* unit = &prog->units[u];
+    uint32_t n = unit->rec.count;
+    uint32_t* params = (uint32_t*)malloc((n + 1) * sizeof(uint32_t));
+    uint32_t np = 0, inlined = 0, i;
+    CodeBuf out;
+    memset(&out, 0, sizeof(out));
+    out.ok = TRUE;
+    if (params == NULL)
+        return 0;
+    for (i = 0; i < n && out.ok; i++) {
+        IrInstr in = unit->code[i];
+        if (in.op == IR_PARAM) {
+            params[np++] = out.count;
+        } else if (in.op == IR_CALL) {
+            uint32_t nargs = (uint32_t)in.b;
+            IrUnit* callee;
+            if (nargs > np) {
+                np = 0;
+                put(&out, in);
+                continue;
+            }
+            np -= nargs;
+            if (in.ka != IR_FUNC || in.a < 0 || (uint32_t)in.a >= prog->nunits || (uint32_t)in.a == u) {
+                put(&out, in);
+                continue;
+            }
+            callee = &prog->units[in.a];
+            if (callee->rec.nparams != nargs || !inlinable(callee) ||
+                out.count + (n - i) + callee->rec.count > PGO_INLINE_GROWTH ||
+                !profile_hot(prof, profile_edge(prof, prog->strs.data + unit->rec.name,
+                                                prog->strs.data + callee->rec.name))) {
+                put(&out, in);
+                continue;
+            }
+            if (expand(prog, unit, callee, &in, &out, &params[np]) != 0)
+                break;
+            inlined++;
+            continue;
+        } else if (in.op == IR_LABEL_DEF || in.op == IR_GOTO || in.op == IR_IFFALSE || in.op == IR_RETURN) {
+            // os argumentos de uma chamada nunca atravessam desvios
+            np = 0;
+        }
+        put(&out, in);
+    }
+    free(params);
+    if (!out.ok || i < n || inlined == 0) {
+        // sem memoria no meio: os slots, temporarios e labels a mais nao atrapalham
+        free(out.code);
+        return 0;
+    }
+    free(unit->code);
+    unit->code = out.code;
+    unit->cap = out.cap;
+    unit->rec.count = out.count;
+    // propaga os argumentos constantes (sem somar de novo nos contadores dos passes); os
+    // temporarios sao juntados depois, junto com os das outras funcoes
+    ssa_sccp(unit, NULL);
+    opt_peephole(unit, NULL);
+    return inlined;
+}
+
+/**
+ * @brief Ordem das funcoes: as chamadas antes de quem chama (pos-ordem do grafo de chamadas)
+ * @param prog Programa
+ * @param order Recebe os indices das funcoes
+ * @return 0 se sucesso, -1 sem memoria
+ */
+static int callOrder(const IrProgram* prog, uint32_t* order) {
+    uint8_t* state = (uint8_t*)calloc(prog->nunits + 1, 1);      // 0 novo, 1 na pilha, 2 pronto
+    uint32_t* stack = (uint32_t*)malloc((prog->nunits + 1) * sizeof(uint32_t));
+    uint32_t* pc = (uint32_t*)calloc(prog->nunits + 1, sizeof(uint32_t));
+    uint32_t n = 0, sp, r;
+    if (state == NULL || stack == NULL || pc == NULL) {
+        free(state);
+        free(stack);
+        free(pc);
+        return -1;
+    }
+    for (r = 0; r < prog->nunits; r++) {
+        if (state[r] != 0)
+            continue;
+        sp = 0;
+        stack[sp++] = r;
+        state[r] = 1;
+        while (sp > 0) {
+            uint32_t u = stack[sp - 1];
+            const IrUnit* unit = &prog->units[u];
+            int pushed = FALSE;
+            while (pc[u] < unit->rec.count && !pushed) {
+                const IrInstr* in = &unit->code[pc[u]++];
+                if (in->op == IR_CALL && in->ka == IR_FUNC && in->a >= 0 && (uint32_t)in->a < prog->nunits &&
+                    state[in->a] == 0) {
+                    state[in->a] = 1;
+                    stack[sp++] = (uint32_t)in->a;
+                    pushed = TRUE;
+                }
+            }
+            if (!pushed) {
+                state[u] = 2;
+                order[n++] = u;
+                sp--;
+            }
+        }
+    }
+    free(state);
+    free(stack);
+    free(pc);
+    return 0;
+}
+
+uint32_t pgo_inline(IrProgram* prog, const Profile* prof, OptStats* stats) {
+    uint32_t* order = (uint32_t*)malloc((prog->nunits + 1) * sizeof(uint32_t));
+    uint32_t inlined = 0, i;
+    if (order == NULL)
+        return 0;
+    if (callOrder(prog, order) == 0)
+        for (i = 0; i < prog->nunits; i++)
+            inlined += inlineUnit(prog, order[i], prof);
+    free(order);
+    if (stats != NULL)
+        __atomic_add_fetch(&stats->pgoInlined, (unsigned long)inlined, __ATOMIC_RELAXED);
+    return inlined;
+}
@@ -0,0 +1,98 @@
+/**
+ * @file pgo.h
+ * @brief Otimizacao guiada por perfil: pontos de contagem e expansao de chamadas
+ *
+ * Os pontos de contagem de uma funcao sao numerados em pre-ordem sobre a
+ * AST: o contador 0 e a entrada da funcao e cada while ou if recebe dois
+ * contadores seguidos (entrada e corpo do while; ramo then e ramo else do
+ * if). A numeracao e o checksum da AST sao os mesmos no --profile-generate,
+ * que emite as instrucoes IR_COUNT, e no --profile-use, que le as
+ * contagens do perfil (profile.h) para:
+ *
+ * - desenrolar so os lacos executados com iteracoes suficientes, e com o
+ *   dobro do fator os lacos quentes com muitas iteracoes;
+ * - rodar os while quentes (teste no fim do corpo, um desvio a menos por
+ *   iteracao) e gerar no fim da funcao o ramo frio de um if-else;
+ * - expandir no chamador as funcoes pequenas chamadas em chamadas quentes
+ *   (pgo_inline, -O2).
+ */
+
+#ifndef _PGO_H_
+#define _PGO_H_
+
+#include "globals.h"
+#include "ir.h"
+
+struct Profile;
+struct OptStats;
+
+// Um ramo de if e frio se executa PGO_COLD_RATIO vezes menos que o outro
+#define PGO_COLD_RATIO 4
+// Iteracoes por entrada a partir das quais um laco quente tem o fator de desenrolamento dobrado
+#define PGO_HOT_TRIPS 32
+// Instrucoes de uma funcao expandida no chamador
+#define PGO_INLINE_MAX 64
+// Instrucoes de um chamador depois das expansoes
+#define PGO_INLINE_GROWTH 4096
+
+/**
+ * @brief while ou if com contadores
+ */
+typedef struct {
+    const TreeNode* node;
+    uint32_t counter;        // primeiro dos dois contadores
+} PgoSite;
+
+/**
+ * @brief Pontos de contagem de uma funcao
+ */
+typedef struct {
+    PgoSite* sites;          // ordenados pelo endereco do no
+    uint32_t nsites;
+    uint32_t ncounts;        // 1 (entrada) + 2 por while ou if
+    uint32_t checksum;       // FNV-1a da AST da funcao
+} PgoSites;
+
+/**
+ * @brief Numera os pontos de contagem de uma funcao e calcula o checksum da AST
+ * @param sites Pontos (liberar com pgo_sites_free)
+ * @param fun No FunK
+ * @return 0 se sucesso, -1 sem memoria
+ */
+int pgo_sites(PgoSites* sites, TreeNode* fun);
+
+/**
+ * @brief Primeiro contador de um while ou if
+ * @param sites Pontos da funcao
+ * @param node No WhileK ou IfK
+ * @return Contador ou -1 se o no nao e um ponto de contagem
+ */
+int32_t pgo_counter(const PgoSites* sites, const TreeNode* node);
+
+/**
+ * @brief Libera os pontos de contagem
+ * @param sites Pontos
+ */
+void pgo_sites_free(PgoSites* sites);
+
+/**
+ * @brief Expande no chamador as funcoes pequenas chamadas em chamadas quentes (-O2)
+ *
+ * Os argumentos viram copias para slots novos do chamador (um conjunto por
+ * chamada expandida, depois dos slots dele no registro), os temporarios e
+ * labels da funcao chamada sao renumerados e cada return vira uma copia
+ * para o destino da chamada seguida de um desvio para o fim. As variaveis
+ * locais que podem ser lidas antes de gravadas (valor de entrada usado na
+ * SSA) sao zeradas, como no registro novo de uma chamada. As funcoes sao
+ * processadas das chamadas para quem chama, entao uma funcao expandida ja
+ * traz as suas proprias expansoes. Funcoes com arrays locais nao sao
+ * expandidas.
+ *
+ * @param prog Programa
+ * @param prof Perfil
+ * @param stats Contadores (NULL = nao conta)
+ * @return Chamadas expandidas
+ */
+uint32_t pgo_inline(IrProgram* prog, const struct Profile* prof, struct OptStats* stats);
+
+#endif
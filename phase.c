@@ -0,0 +1,136 @@
+/**
+ * @file phase.c
+ * @brief Implementacao do relatorio de tempo e memoria por fase
+ */
+
+#include "phase.h"
+#include <string.h>
+#include <time.h>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+/**
+ * @brief Le um relogio em segundos
+ * @param clock CLOCK_MONOTONIC ou CLOCK_PROCESS_CPUTIME_ID
+ * @return Segundos
+ */
+static double seconds(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Pico de memoria residente do processo
+ * @return KiB ou -1 se indisponivel
+ */
+static long peakRss(void) {
+#ifndef _WIN32
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) == 0)
+        return ru.ru_maxrss;
+#endif
+    return -1;
+}
+
+void phase_init(PhaseReport* r, PhaseAllocFn readAllocs) {
+    memset(r, 0, sizeof(*r));
+    r->readAllocs = readAllocs;
+}
+
+void phase_begin(PhaseReport* r, const char* name) {
+    if (r == NULL)
+        return;
+    r->name = name;
+    if (r->readAllocs != NULL)
+        r->readAllocs(&r->allocs0, &r->bytes0);
+    r->cpu0 = seconds(CLOCK_PROCESS_CPUTIME_ID);
+    r->wall0 = seconds(CLOCK_MONOTONIC);
+}
+
+void phase_end(PhaseReport* r, long items, const char* unit) {
+    double wall, cpu;
+    Phase* p;
+    if (r == NULL || r->name == NULL)
+        return;
+    wall = seconds(CLOCK_MONOTONIC);
+    cpu = seconds(CLOCK_PROCESS_CPUTIME_ID);
+    if (r->nphases == PHASE_MAX) {
+        r->name = NULL;
+        return;
+    }
+    p = &r->phases[r->nphases++];
+    p->name = r->name;
+    p->wall = wall - r->wall0;
+    p->cpu = cpu - r->cpu0;
+    p->allocs = 0;
+    p->allocBytes = 0;
+    if (r->readAllocs != NULL) {
+        r->readAllocs(&p->allocs, &p->allocBytes);
+        p->allocs -= r->allocs0;
+        p->allocBytes -= r->bytes0;
+    }
+    p->peakRss = peakRss();
+    p->items = items;
+    p->unit = unit;
+    r->name = NULL;
+}
+
+void phase_print(const PhaseReport* r, FILE* out, int json) {
+    double wall = 0, cpu = 0;
+    unsigned long long allocs = 0, bytes = 0;
+    long rss = -1;
+    int i;
+    for (i = 0; i < r->nphases; i++) {
+        wall += r->phases[i].wall;
+        cpu += r->phases[i].cpu;
+        allocs += r->phases[i].allocs;
+        bytes += r->phases[i].allocBytes;
+        if (r->phases[i].peakRss > rss)
+            rss = r->phases[i].peakRss;
+    }
+
+    if (json) {
+        fprintf(out, "{\"fases\": [");
+        for (i = 0; i < r->nphases; i++) {
+            const Phase* p = &r->phases[i];
+            fprintf(out, "%s\n  {\"fase\": \"%s\", \"tempo_ms\": %.3f, \"cpu_ms\": %.3f",
+                    i > 0 ? "," : "", p->name, p->wall * 1e3, p->cpu * 1e3);
+            if (r->readAllocs != NULL)
+                fprintf(out, ", \"alocacoes\": %llu, \"bytes_alocados\": %llu", p->allocs, p->allocBytes);
+            fprintf(out, ", \"pico_rss_kb\": %ld", p->peakRss);
+            if (p->items >= 0)
+                fprintf(out, ", \"itens\": %ld, \"unidade\": \"%s\"", p->items, p->unit != NULL ? p->unit : "");
+            fprintf(out, "}");
+        }
+        fprintf(out, "\n], \"total\": {\"tempo_ms\": %.3f, \"cpu_ms\": %.3f", wall * 1e3, cpu * 1e3);
+        if (r->readAllocs != NULL)
+            fprintf(out, ", \"alocacoes\": %llu, \"bytes_alocados\": %llu", allocs, bytes);
+        fprintf(out, ", \"pico_rss_kb\": %ld}}\n", rss);
+        return;
+    }
+
+    fprintf(out, "\n******** TEMPO POR FASE ********\n\n");
+    fprintf(out, "%-12s %10s %10s %6s %12s %14s %12s  %s\n", "fase", "tempo (ms)", "cpu (ms)", "%",
+            "alocacoes", "bytes alocados", "pico RSS KiB", "itens");
+    for (i = 0; i < r->nphases; i++) {
+        const Phase* p = &r->phases[i];
+        fprintf(out, "%-12s %10.3f %10.3f %6.1f", p->name, p->wall * 1e3, p->cpu * 1e3,
+                wall > 0 ? 100.0 * p->wall / wall : 0.0);
+        if (r->readAllocs != NULL)
+            fprintf(out, " %12llu %14llu", p->allocs, p->allocBytes);
+        else
+            fprintf(out, " %12s %14s", "-", "-");
+        fprintf(out, " %12ld", p->peakRss);
+        if (p->items >= 0)
+            fprintf(out, "  %ld %s", p->items, p->unit != NULL ? p->unit : "");
+        fprintf(out, "\n");
+    }
+    fprintf(out, "%-12s %10.3f %10.3f %6.1f", "total", wall * 1e3, cpu * 1e3, 100.0);
+    if (r->readAllocs != NULL)
+        fprintf(out, " %12llu %14llu", allocs, bytes);
+    else
+        fprintf(out, " %12s %14s", "-", "-");
+    fprintf(out, " %12ld\n", rss);
+}
@@ -0,0 +1,88 @@
+/**
+ * @file phase.h
+ * @brief Relatorio de tempo e memoria por fase da compilacao (--time-report)
+ *
+ * Cada fase registra o tempo de parede e de CPU, as alocacoes feitas
+ * durante ela (numero e bytes, quando o executavel conta as alocacoes), o
+ * pico de memoria residente ao final e a quantidade de itens produzidos
+ * (nos, simbolos, instrucoes). Com o relatorio desligado (ponteiro NULL)
+ * as chamadas nao fazem nada; ligado, cada fase custa algumas chamadas ao
+ * sistema.
+ */
+
+#ifndef _PHASE_H_
+#define _PHASE_H_
+
+#include <stdio.h>
+
+// Numero maximo de fases em um relatorio
+#define PHASE_MAX 16
+
+/**
+ * @brief Le os contadores de alocacao do processo
+ * @param count Numero de alocacoes ate agora
+ * @param bytes Bytes alocados ate agora
+ */
+typedef void (*PhaseAllocFn)(unsigned long long* count, unsigned long long* bytes);
+
+/**
+ * @brief Medidas de uma fase
+ */
+typedef struct {
+    const char* name;
+    double wall;              // tempo de parede (segundos)
+    double cpu;               // tempo de CPU do processo (segundos)
+    unsigned long long allocs;
+    unsigned long long allocBytes;
+    long peakRss;             // pico de memoria residente ao final (KiB, -1 se indisponivel)
+    long items;               // itens produzidos pela fase (-1 se nao se aplica)
+    const char* unit;         // nome dos itens
+} Phase;
+
+/**
+ * @brief Relatorio de uma compilacao
+ */
+typedef struct PhaseReport {
+    Phase phases[PHASE_MAX];
+    int nphases;
+    PhaseAllocFn readAllocs;  // contadores de alocacao (NULL = nao medidas)
+
+    // inicio da fase em andamento
+    const char* name;
+    double wall0;
+    double cpu0;
+    unsigned long long allocs0;
+    unsigned long long bytes0;
+} PhaseReport;
+
+/**
+ * @brief Inicializa um relatorio vazio
+ * @param r Relatorio
+ * @param readAllocs Contadores de alocacao (NULL se indisponiveis)
+ */
+void phase_init(PhaseReport* r, PhaseAllocFn readAllocs);
+
+/**
+ * @brief Comeca uma fase
+ * @param r Relatorio (NULL nao faz nada)
+ * @param name Nome da fase (string constante)
+ */
+void phase_begin(PhaseReport* r, const char* name);
+
+/**
+ * @brief Termina a fase em andamento
+ * @param r Relatorio (NULL nao faz nada)
+ * @param items Itens produzidos pela fase (-1 se nao se aplica)
+ * @param unit Nome dos itens (ou NULL)
+ */
+void phase_end(PhaseReport* r, long items, const char* unit);
+
+/**
+ * @brief Imprime o relatorio
+ * @param r Relatorio
+ * @param out Saida
+ * @param json TRUE para JSON, FALSE para tabela
+ */
+void phase_print(const PhaseReport* r, FILE* out, int json);
+
+#endif
@@ -0,0 +1,272 @@
+/**
+ * @file pool.c
+ * @brief Implementacao do pool de threads com roubo de tarefas
+ */
+
+#include "pool.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+// Thread atual, se ela pertence a um pool
+static __thread Pool* selfPool = NULL;
+static __thread int selfIndex = -1;
+
+/**
+ * @brief Argumento de inicio de uma thread do pool
+ */
+typedef struct {
+    Pool* pool;
+    int index;
+} WorkerArg;
+
+int pool_cpu_count(void) {
+#ifdef _WIN32
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return si.dwNumberOfProcessors > 0 ? (int)si.dwNumberOfProcessors : 1;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+#endif
+}
+
+/**
+ * @brief Insere uma tarefa no fim da fila
+ * @param d Fila
+ * @param t Tarefa
+ * @return 0 se sucesso, -1 se erro
+ */
+static int dequePush(PoolDeque* d, PoolTask t) {
+    pthread_mutex_lock(&d->lock);
+    if (d->count == d->cap) {
+        int cap = d->cap ? d->cap * 2 : 64;
+        PoolTask* tasks = (PoolTask*)malloc(cap * sizeof(PoolTask));
+        int i;
+        if (tasks == NULL) {
+            pthread_mutex_unlock(&d->lock);
+            return -1;
+        }
+        for (i = 0; i < d->count; i++)
+            tasks[i] = d->tasks[(d->start + i) % d->cap];
+        free(d->tasks);
+        d->tasks = tasks;
+        d->start = 0;
+        d->cap = cap;
+    }
+    d->tasks[(d->start + d->count) % d->cap] = t;
+    d->count++;
+    pthread_mutex_unlock(&d->lock);
+    return 0;
+}
+
+/**
+ * @brief Retira a tarefa do fim da fila (usada pela thread dona)
+ * @param d Fila
+ * @param t Tarefa retirada
+ * @return 1 se retirou, 0 se a fila estava vazia
+ */
+static int dequePop(PoolDeque* d, PoolTask* t) {
+    int ok = 0;
+    pthread_mutex_lock(&d->lock);
+    if (d->count > 0) {
+        d->count--;
+        *t = d->tasks[(d->start + d->count) % d->cap];
+        ok = 1;
+    }
+    pthread_mutex_unlock(&d->lock);
+    return ok;
+}
+
+/**
+ * @brief Rouba a tarefa do inicio da fila (usada pelas outras threads)
+ * @param d Fila
+ * @param t Tarefa roubada
+ * @return 1 se roubou, 0 se a fila estava vazia
+ */
+static int dequeSteal(PoolDeque* d, PoolTask* t) {
+    int ok = 0;
+    pthread_mutex_lock(&d->lock);
+    if (d->count > 0) {
+        *t = d->tasks[d->start];
+        d->start = (d->start + 1) % d->cap;
+        d->count--;
+        ok = 1;
+    }
+    pthread_mutex_unlock(&d->lock);
+    return ok;
+}
+
+/**
+ * @brief Pega uma tarefa: primeiro da propria fila, depois das outras
+ * @param pool Pool
+ * @param self Indice da thread atual
+ * @param t Tarefa obtida
+ * @return 1 se obteve, 0 se todas as filas estavam vazias
+ */
+static int takeTask(Pool* pool, int self, PoolTask* t) {
+    int found = dequePop(&pool->deques[self], t);
+    int i;
+    for (i = 1; !found && i < pool->nthreads; i++)
+        found = dequeSteal(&pool->deques[(self + i) % pool->nthreads], t);
+    if (found)
+        __atomic_sub_fetch(&pool->queued, 1, __ATOMIC_ACQ_REL);
+    return found;
+}
+
+/**
+ * @brief Executa uma tarefa e acorda quem espera se foi a ultima (do pool ou do grupo)
+ * @param pool Pool
+ * @param t Tarefa
+ */
+static void runTask(Pool* pool, PoolTask* t) {
+    int last = 0;
+    t->fn(t->arg);
+    if (t->group != NULL && __atomic_sub_fetch(&t->group->pending, 1, __ATOMIC_ACQ_REL) == 0)
+        last = 1;
+    if (__atomic_sub_fetch(&pool->pending, 1, __ATOMIC_ACQ_REL) == 0)
+        last = 1;
+    if (last) {
+        pthread_mutex_lock(&pool->lock);
+        pthread_cond_broadcast(&pool->cond);
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+/**
+ * @brief Laco principal de uma thread do pool
+ * @param arg WorkerArg (liberado pela thread)
+ * @return NULL
+ */
+static void* workerMain(void* arg) {
+    WorkerArg* wa = (WorkerArg*)arg;
+    Pool* pool = wa->pool;
+    int self = wa->index;
+    PoolTask t;
+    free(wa);
+    selfPool = pool;
+    selfIndex = self;
+    for (;;) {
+        if (takeTask(pool, self, &t)) {
+            runTask(pool, &t);
+            continue;
+        }
+        pthread_mutex_lock(&pool->lock);
+        while (__atomic_load_n(&pool->queued, __ATOMIC_ACQUIRE) == 0 && !pool->stop)
+            pthread_cond_wait(&pool->cond, &pool->lock);
+        if (pool->stop && __atomic_load_n(&pool->queued, __ATOMIC_ACQUIRE) == 0) {
+            pthread_mutex_unlock(&pool->lock);
+            break;
+        }
+        pthread_mutex_unlock(&pool->lock);
+    }
+    return NULL;
+}
+
+int pool_create(Pool* pool, int nthreads) {
+    int i;
+    memset(pool, 0, sizeof(*pool));
+    if (nthreads <= 0)
+        nthreads = pool_cpu_count();
+    pool->deques = (PoolDeque*)calloc(nthreads, sizeof(PoolDeque));
+    pool->threads = (pthread_t*)calloc(nthreads, sizeof(pthread_t));
+    if (pool->deques == NULL || pool->threads == NULL) {
+        free(pool->deques);
+        free(pool->threads);
+        return -1;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->cond, NULL);
+    for (i = 0; i < nthreads; i++)
+        pthread_mutex_init(&pool->deques[i].lock, NULL);
+    pool->nthreads = nthreads;
+    for (i = 0; i < nthreads; i++) {
+        WorkerArg* wa = (WorkerArg*)malloc(sizeof(WorkerArg));
+        if (wa == NULL)
+            break;
+        wa->pool = pool;
+        wa->index = i;
+        if (pthread_create(&pool->threads[i], NULL, workerMain, wa) != 0) {
+            free(wa);
+            break;
+        }
+        pool->started++;
+    }
+    if (pool->started < nthreads) {
+        pool_destroy(pool);
+        return -1;
+    }
+    return 0;
+}
+
+int pool_submit(Pool* pool, PoolGroup* group, PoolFn fn, void* arg) {
+    PoolTask t;
+    int target;
+    t.fn = fn;
+    t.arg = arg;
+    t.group = group;
+    if (selfPool == pool)
+        target = selfIndex;
+    else
+        target = (int)(__atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED) % (unsigned)pool->nthreads);
+    __atomic_add_fetch(&pool->pending, 1, __ATOMIC_ACQ_REL);
+    if (group != NULL)
+        __atomic_add_fetch(&group->pending, 1, __ATOMIC_ACQ_REL);
+    if (dequePush(&pool->deques[target], t) != 0) {
+        __atomic_sub_fetch(&pool->pending, 1, __ATOMIC_ACQ_REL);
+        if (group != NULL)
+            __atomic_sub_fetch(&group->pending, 1, __ATOMIC_ACQ_REL);
+        return -1;
+    }
+    __atomic_add_fetch(&pool->queued, 1, __ATOMIC_ACQ_REL);
+    pthread_mutex_lock(&pool->lock);
+    pthread_cond_broadcast(&pool->cond);
+    pthread_mutex_unlock(&pool->lock);
+    return 0;
+}
+
+void pool_wait(Pool* pool, PoolGroup* group) {
+    PoolTask t;
+    long* pending = group != NULL ? &group->pending : &pool->pending;
+    int helper = selfPool == pool;
+    for (;;) {
+        if (__atomic_load_n(pending, __ATOMIC_ACQUIRE) == 0)
+            break;
+        if (helper && takeTask(pool, selfIndex, &t)) {
+            runTask(pool, &t);
+            continue;
+        }
+        pthread_mutex_lock(&pool->lock);
+        if (__atomic_load_n(pending, __ATOMIC_ACQUIRE) == 0) {
+            pthread_mutex_unlock(&pool->lock);
+            break;
+        }
+        if (!helper || __atomic_load_n(&pool->queued, __ATOMIC_ACQUIRE) == 0)
+            pthread_cond_wait(&pool->cond, &pool->lock);
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+void pool_destroy(Pool* pool) {
+    int i;
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = 1;
+    pthread_cond_broadcast(&pool->cond);
+    pthread_mutex_unlock(&pool->lock);
+    for (i = 0; i < pool->started; i++)
+        pthread_join(pool->threads[i], NULL);
+    for (i = 0; i < pool->nthreads; i++) {
+        pthread_mutex_destroy(&pool->deques[i].lock);
+        free(pool->deques[i].tasks);
+    }
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->cond);
+    free(pool->deques);
+    free(pool->threads);
+    memset(pool, 0, sizeof(*pool));
+}
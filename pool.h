@@ -0,0 +1,105 @@
+/**
+ * @file pool.h
+ * @brief Pool de threads com roubo de tarefas (work stealing)
+ *
+ * Cada thread tem a sua propria fila dupla de tarefas: a dona empilha e
+ * desempilha pelo fim (LIFO, melhor localidade) e as outras roubam pelo
+ * inicio (FIFO) quando a propria fila esvazia. Tarefas criadas de dentro de
+ * uma tarefa vao para a fila da thread que as criou.
+ */
+
+#ifndef _POOL_H_
+#define _POOL_H_
+
+#include <pthread.h>
+
+/**
+ * @brief Funcao executada por uma tarefa
+ */
+typedef void (*PoolFn)(void* arg);
+
+/**
+ * @brief Grupo de tarefas que podem ser esperadas juntas (iniciar com zeros)
+ */
+typedef struct {
+    long pending;             // tarefas do grupo ainda nao concluidas (atomico)
+} PoolGroup;
+
+/**
+ * @brief Tarefa pendente
+ */
+typedef struct {
+    PoolFn fn;
+    void* arg;
+    PoolGroup* group;
+} PoolTask;
+
+/**
+ * @brief Fila dupla de tarefas de uma thread (buffer circular)
+ */
+typedef struct {
+    pthread_mutex_t lock;
+    PoolTask* tasks;
+    int start;
+    int count;
+    int cap;
+} PoolDeque;
+
+/**
+ * @brief Pool de threads
+ */
+typedef struct Pool {
+    int nthreads;
+    int started;              // threads criadas com sucesso
+    pthread_t* threads;
+    PoolDeque* deques;        // uma fila por thread
+    pthread_mutex_t lock;     // protege o sono das threads
+    pthread_cond_t cond;      // nova tarefa, fim das tarefas ou parada
+    long queued;              // tarefas nas filas (atomico)
+    long pending;             // tarefas ainda nao concluidas (atomico)
+    unsigned next;            // proxima fila para envios de fora do pool
+    int stop;
+} Pool;
+
+/**
+ * @brief Numero de processadores disponiveis
+ * @return Numero de processadores (pelo menos 1)
+ */
+int pool_cpu_count(void);
+
+/**
+ * @brief Cria um pool de threads
+ * @param pool Pool a inicializar
+ * @param nthreads Numero de threads (0 = numero de processadores)
+ * @return 0 se sucesso, -1 se erro
+ */
+int pool_create(Pool* pool, int nthreads);
+
+/**
+ * @brief Envia uma tarefa para o pool
+ * @param pool Pool
+ * @param group Grupo da tarefa (NULL se nao sera esperada por grupo)
+ * @param fn Funcao da tarefa
+ * @param arg Argumento da tarefa
+ * @return 0 se sucesso, -1 se erro (falta de memoria)
+ */
+int pool_submit(Pool* pool, PoolGroup* group, PoolFn fn, void* arg);
+
+/**
+ * @brief Espera as tarefas de um grupo terminarem
+ *
+ * Chamada de dentro de uma tarefa, a thread executa outras tarefas
+ * enquanto espera, de forma que tarefas podem esperar subtarefas.
+ *
+ * @param pool Pool
+ * @param group Grupo (NULL espera todas as tarefas; nao usar dentro de tarefas)
+ */
+void pool_wait(Pool* pool, PoolGroup* group);
+
+/**
+ * @brief Termina as threads e libera o pool (as tarefas pendentes sao executadas)
+ * @param pool Pool
+ */
+void pool_destroy(Pool* pool);
+
+#endif
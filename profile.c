@@ -0,0 +1,365 @@
+/**
+ * @file profile.c
+ * @brief Implementacao da leitura e gravacao do perfil de execucao
+ */
+
+#include "globals.h"
+#include "profile.h"
+#include <errno.h>
+
+// Maior numero de contadores aceito para uma funcao do arquivo
+#define PROFILE_MAX_COUNTS (1u << 24)
+
+void profile_init(Profile* prof) {
+    memset(prof, 0, sizeof(*prof));
+}
+
+void profile_free(Profile* prof) {
+    uint32_t i;
+    for (i = 0; i < prof->nfuncs; i++) {
+        free(prof->funcs[i].name);
+        free(prof->funcs[i].counts);
+    }
+    for (i = 0; i < prof->nedges; i++) {
+        free(prof->edges[i].caller);
+        free(prof->edges[i].callee);
+    }
+    free(prof->funcs);
+    free(prof->edges);
+    memset(prof, 0, sizeof(*prof));
+}
+
+/**
+ * @brief Copia uma string
+ * @return Copia alocada ou NULL sem memoria
+ */
+static char* dupStr(const char* s) {
+    size_t n = strlen(s) + 1;
+    char* d = (char*)malloc(n);
+    if (d != NULL)
+        memcpy(d, s, n);
+    return d;
+}
+
+/**
+ * @brief Busca binaria de uma funcao
+ * @param prof Perfil
+ * @param name Nome
+ * @param found Recebe TRUE se a funcao existe
+ * @return Posicao da funcao ou onde ela deve ser inserida
+ */
+static uint32_t findFunc(const Profile* prof, const char* name, int* found) {
+    uint32_t lo = 0, hi = prof->nfuncs;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        int c = strcmp(prof->funcs[mid].name, name);
+        if (c == 0) {
+            *found = TRUE;
+            return mid;
+        }
+        if (c < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    *found = FALSE;
+    return lo;
+}
+
+/**
+ * @brief Ordem das chamadas: chamador e depois a funcao chamada
+ */
+static int compareEdge(const ProfEdge* e, const char* caller, const char* callee) {
+    int c = strcmp(e->caller, caller);
+    return c != 0 ? c : strcmp(e->callee, callee);
+}
+
+/**
+ * @brief Busca binaria de uma chamada
+ * @param prof Perfil
+ * @param caller Funcao que chama
+ * @param callee Funcao chamada
+ * @param found Recebe TRUE se a chamada existe
+ * @return Posicao da chamada ou onde ela deve ser inserida
+ */
+static uint32_t findEdge(const Profile* prof, const char* caller, const char* callee, int* found) {
+    uint32_t lo = 0, hi = prof->nedges;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        int c = compareEdge(&prof->edges[mid], caller, callee);
+        if (c == 0) {
+            *found = TRUE;
+            return mid;
+        }
+        if (c < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    *found = FALSE;
+    return lo;
+}
+
+/**
+ * @brief Remove as chamadas feitas por uma funcao
+ * @param prof Perfil
+ * @param caller Funcao
+ */
+static void dropEdges(Profile* prof, const char* caller) {
+    uint32_t first, last;
+    int found;
+    first = findEdge(prof, caller, "", &found);
+    for (last = first; last < prof->nedges && strcmp(prof->edges[last].caller, caller) == 0; last++) {
+        free(prof->edges[last].caller);
+        free(prof->edges[last].callee);
+    }
+    memmove(&prof->edges[first], &prof->edges[last], (prof->nedges - last) * sizeof(ProfEdge));
+    prof->nedges -= last - first;
+}
+
+ProfFunc* profile_add_func(Profile* prof, const char* name, uint32_t checksum, uint32_t ncounts) {
+    uint64_t* counts;
+    ProfFunc* f;
+    int found;
+    uint32_t i = findFunc(prof, name, &found);
+    if (found) {
+        f = &prof->funcs[i];
+        if (f->checksum == checksum && f->ncounts == ncounts)
+            return f;
+        // o programa mudou: as contagens antigas nao valem mais
+        counts = (uint64_t*)calloc(ncounts + 1, sizeof(uint64_t));
+        if (counts == NULL)
+            return NULL;
+        free(f->counts);
+        f->counts = counts;
+        f->checksum = checksum;
+        f->ncounts = ncounts;
+        dropEdges(prof, name);
+        return f;
+    }
+    if (prof->nfuncs == prof->funcCap) {
+        uint32_t cap = prof->funcCap ? prof->funcCap * 2 : 64;
+        ProfFunc* grown = (ProfFunc*)realloc(prof->funcs, cap * sizeof(ProfFunc));
+        if (grown == NULL)
+            return NULL;
+        prof->funcs = grown;
+        prof->funcCap = cap;
+    }
+    counts = (uint64_t*)calloc(ncounts + 1, sizeof(uint64_t));
+    name = dupStr(name);
+    if (counts == NULL || name == NULL) {
+        free(counts);
+        free((char*)name);
+        return NULL;
+    }
+    memmove(&prof->funcs[i + 1], &prof->funcs[i], (prof->nfuncs - i) * sizeof(ProfFunc));
+    prof->nfuncs++;
+    f = &prof->funcs[i];
+    f->name = (char*)name;
+    f->checksum = checksum;
+    f->ncounts = ncounts;
+    f->counts = counts;
+    return f;
+}
+
+int profile_add_edge(Profile* prof, const char* caller, const char* callee, uint64_t count) {
+    ProfEdge* e;
+    int found;
+    uint32_t i = findEdge(prof, caller, callee, &found);
+    if (found) {
+        prof->edges[i].count += count;
+        return 0;
+    }
+    if (prof->nedges == prof->edgeCap) {
+        uint32_t cap = prof->edgeCap ? prof->edgeCap * 2 : 64;
+        ProfEdge* grown = (ProfEdge*)realloc(prof->edges, cap * sizeof(ProfEdge));
+        if (grown == NULL)
+            return -1;
+        prof->edges = grown;
+        prof->edgeCap = cap;
+    }
+    caller = dupStr(caller);
+    callee = dupStr(callee);
+    if (caller == NULL || callee == NULL) {
+        free((char*)caller);
+        free((char*)callee);
+        return -1;
+    }
+    memmove(&prof->edges[i + 1], &prof->edges[i], (prof->nedges - i) * sizeof(ProfEdge));
+    prof->nedges++;
+    e = &prof->edges[i];
+    e->caller = (char*)caller;
+    e->callee = (char*)callee;
+    e->count = count;
+    return 0;
+}
+
+const ProfFunc* profile_func(const Profile* prof, const char* name) {
+    int found;
+    uint32_t i = findFunc(prof, name, &found);
+    return found ? &prof->funcs[i] : NULL;
+}
+
+uint64_t profile_edge(const Profile* prof, const char* caller, const char* callee) {
+    int found;
+    uint32_t i = findEdge(prof, caller, callee, &found);
+    return found ? prof->edges[i].count : 0;
+}
+
+int profile_hot(const Profile* prof, uint64_t count) {
+    return count >= PROFILE_HOT_MIN && count >= prof->maxCount / PROFILE_HOT_DIV;
+}
+
+/**
+ * @brief Proxima palavra do texto (separada por espacos), terminada em '\0' no lugar
+ * @param p Posicao atual (atualizada)
+ * @return Palavra ou NULL no fim do texto
+ */
+static char* nextWord(char** p) {
+    char* s = *p;
+    char* word;
+    while (*s == ' ' || *s == '\t' || *s == '\n' || *s == '\r')
+        s++;
+    if (*s == '\0') {
+        *p = s;
+        return NULL;
+    }
+    word = s;
+    while (*s != '\0' && *s != ' ' && *s != '\t' && *s != '\n' && *s != '\r')
+        s++;
+    if (*s != '\0')
+        *s++ = '\0';
+    *p = s;
+    return word;
+}
+
+/**
+ * @brief Le um numero sem sinal da proxima palavra
+ * @param p Posicao atual (atualizada)
+ * @param base 10 ou 16
+ * @param out Valor lido
+ * @return TRUE se a palavra e um numero
+ */
+static int nextNumber(char** p, int base, uint64_t* out) {
+    char* word = nextWord(p);
+    char* end;
+    if (word == NULL || *word == '-')
+        return FALSE;
+    errno = 0;
+    *out = (uint64_t)strtoull(word, &end, base);
+    return errno == 0 && end != word && *end == '\0';
+}
+
+/**
+ * @brief Interpreta o texto de um arquivo de perfil
+ * @param prof Perfil
+ * @param text Conteudo (alterado)
+ * @return 0 se sucesso, -1 se o formato e invalido ou falta memoria
+ */
+static int parse(Profile* prof, char* text) {
+    char* p = text;
+    char* word = nextWord(&p);
+    uint64_t version, checksum, n, count;
+    if (word == NULL || strcmp(word, "cminus-perfil") != 0 || !nextNumber(&p, 10, &version) ||
+        version != PROFILE_VERSION)
+        return -1;
+    while ((word = nextWord(&p)) != NULL) {
+        if (strcmp(word, "funcao") == 0) {
+            char* name = nextWord(&p);
+            ProfFunc* f;
+            uint64_t k;
+            if (name == NULL || !nextNumber(&p, 16, &checksum) || checksum > UINT32_MAX ||
+                !nextNumber(&p, 10, &n) || n > PROFILE_MAX_COUNTS)
+                return -1;
+            f = profile_add_func(prof, name, (uint32_t)checksum, (uint32_t)n);
+            if (f == NULL)
+                return -1;
+            for (k = 0; k < n; k++) {
+                if (!nextNumber(&p, 10, &count))
+                    return -1;
+                f->counts[k] += count;
+                if (f->counts[k] > prof->maxCount)
+                    prof->maxCount = f->counts[k];
+            }
+        } else if (strcmp(word, "chamada") == 0) {
+            char* caller = nextWord(&p);
+            char* callee = nextWord(&p);
+            if (caller == NULL || callee == NULL || !nextNumber(&p, 10, &count) ||
+                profile_add_edge(prof, caller, callee, count) != 0)
+                return -1;
+        } else {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int profile_read(Profile* prof, const char* path) {
+    FILE* f = fopen(path, "rb");
+    size_t cap = 4096, n = 0, r, i;
+    char* text;
+    uint64_t h = 14695981039346656037ull;
+    int status;
+    if (f == NULL) {
+        if (errno == ENOENT)
+            return 1;
+        fprintf(stderr, "Erro: nao foi possivel abrir o perfil '%s'\n", path);
+        return -1;
+    }
+    text = (char*)malloc(cap + 1);
+    while (text != NULL && (r = fread(text + n, 1, cap - n, f)) > 0) {
+        n += r;
+        if (n == cap) {
+            char* grown = (char*)realloc(text, cap * 2 + 1);
+            if (grown == NULL) {
+                free(text);
+                text = NULL;
+                break;
+            }
+            text = grown;
+            cap *= 2;
+        }
+    }
+    fclose(f);
+    if (text == NULL) {
+        fprintf(stderr, "Erro: falta de memoria lendo o perfil '%s'\n", path);
+        return -1;
+    }
+    // FNV-1a do conteudo: faz parte da chave do cache de compilacao
+    for (i = 0; i < n; i++)
+        h = (h ^ (unsigned char)text[i]) * 1099511628211ull;
+    text[n] = '\0';
+    prof->hash = h;
+    status = parse(prof, text);
+    free(text);
+    if (status != 0)
+        fprintf(stderr, "Erro: '%s' nao e um arquivo de perfil valido (versao %d)\n", path, PROFILE_VERSION);
+    return status;
+}
+
+int profile_write(const Profile* prof, const char* path) {
+    FILE* f = fopen(path, "w");
+    uint32_t i, k;
+    int ok;
+    if (f == NULL) {
+        fprintf(stderr, "Erro: nao foi possivel criar o arquivo '%s'\n", path);
+        return -1;
+    }
+    fprintf(f, "cminus-perfil %d\n", PROFILE_VERSION);
+    for (i = 0; i < prof->nfuncs; i++) {
+        const ProfFunc* fn = &prof->funcs[i];
+        fprintf(f, "funcao %s %08x %u", fn->name, (unsigned)fn->checksum, (unsigned)fn->ncounts);
+        for (k = 0; k < fn->ncounts; k++)
+            fprintf(f, " %llu", (unsigned long long)fn->counts[k]);
+        fputc('\n', f);
+    }
+    for (i = 0; i < prof->nedges; i++)
+        fprintf(f, "chamada %s %s %llu\n", prof->edges[i].caller, prof->edges[i].callee,
+                (unsigned long long)prof->edges[i].count);
+    ok = !ferror(f);
+    if (fclose(f) != 0 || !ok) {
+        fprintf(stderr, "Erro: falha ao gravar o arquivo '%s'\n", path);
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,144 @@
+/**
+ * @file profile.h
+ * @brief Perfil de execucao para a otimizacao guiada por perfil
+ *
+ * Compilado com --profile-generate, o programa ganha instrucoes IR_COUNT
+ * na entrada de cada funcao, na entrada e no corpo de cada while e nos
+ * dois ramos de cada if (pgo.h). O cmvm --profile <arquivo> executa o
+ * programa contando essas instrucoes e as chamadas entre cada par de
+ * funcoes e soma tudo em um arquivo texto:
+ *
+ *     cminus-perfil 1
+ *     funcao <nome> <checksum> <n> <contador 0> ... <contador n-1>
+ *     chamada <chamador> <chamada> <vezes>
+ *
+ * O cminus --profile-use <arquivo> le o perfil e usa as contagens para
+ * escolher os lacos desenrolados, a ordem dos blocos e as chamadas
+ * expandidas no chamador. O checksum e calculado sobre a AST da funcao:
+ * se ela mudou depois da execucao, as contagens dela sao ignoradas.
+ */
+
+#ifndef _PROFILE_H_
+#define _PROFILE_H_
+
+#include <stdint.h>
+
+// Versao do formato do arquivo de perfil
+#define PROFILE_VERSION 1
+// Execucoes minimas de um bloco ou chamada quente
+#define PROFILE_HOT_MIN 1000
+// Um bloco e quente se executa ao menos 1/PROFILE_HOT_DIV das vezes do bloco mais executado
+#define PROFILE_HOT_DIV 100
+
+/**
+ * @brief Contadores de uma funcao
+ */
+typedef struct {
+    char* name;
+    uint32_t checksum;       // AST da funcao no momento da compilacao instrumentada
+    uint32_t ncounts;
+    uint64_t* counts;        // um por IR_COUNT (0 = entrada da funcao)
+} ProfFunc;
+
+/**
+ * @brief Chamadas de uma funcao para outra
+ */
+typedef struct {
+    char* caller;
+    char* callee;
+    uint64_t count;
+} ProfEdge;
+
+/**
+ * @brief Perfil completo (funcoes e chamadas ordenadas pelo nome)
+ */
+typedef struct Profile {
+    ProfFunc* funcs;
+    uint32_t nfuncs;
+    uint32_t funcCap;
+    ProfEdge* edges;
+    uint32_t nedges;
+    uint32_t edgeCap;
+    uint64_t maxCount;       // maior contagem de um bloco (referencia de quente)
+    uint64_t hash;           // conteudo do arquivo lido (chave do cache)
+} Profile;
+
+/**
+ * @brief Inicializa um perfil vazio
+ * @param prof Perfil
+ */
+void profile_init(Profile* prof);
+
+/**
+ * @brief Libera um perfil
+ * @param prof Perfil
+ */
+void profile_free(Profile* prof);
+
+/**
+ * @brief Le um arquivo de perfil
+ * @param prof Perfil (inicializado com profile_init)
+ * @param path Caminho
+ * @return 0 se leu, 1 se o arquivo nao existe, -1 se o formato e invalido (mensagem em stderr)
+ */
+int profile_read(Profile* prof, const char* path);
+
+/**
+ * @brief Grava um perfil
+ * @param prof Perfil
+ * @param path Caminho
+ * @return 0 se sucesso, -1 se erro (mensagem em stderr)
+ */
+int profile_write(const Profile* prof, const char* path);
+
+/**
+ * @brief Contadores de uma funcao, criados se ausentes
+ *
+ * Se a funcao ja existe com outro checksum ou outro numero de contadores,
+ * o programa mudou: as contagens antigas dela (e as chamadas que ela faz)
+ * sao descartadas.
+ *
+ * @param prof Perfil
+ * @param name Nome da funcao
+ * @param checksum Checksum da AST
+ * @param ncounts Numero de contadores
+ * @return Contadores ou NULL sem memoria
+ */
+ProfFunc* profile_add_func(Profile* prof, const char* name, uint32_t checksum, uint32_t ncounts);
+
+/**
+ * @brief Soma chamadas de uma funcao para outra
+ * @param prof Perfil
+ * @param caller Funcao que chama
+ * @param callee Funcao chamada
+ * @param count Chamadas
+ * @return 0 se sucesso, -1 sem memoria
+ */
+int profile_add_edge(Profile* prof, const char* caller, const char* callee, uint64_t count);
+
+/**
+ * @brief Procura os contadores de uma funcao
+ * @param prof Perfil
+ * @param name Nome
+ * @return Contadores ou NULL se a funcao nao esta no perfil
+ */
+const ProfFunc* profile_func(const Profile* prof, const char* name);
+
+/**
+ * @brief Chamadas de uma funcao para outra
+ * @param prof Perfil
+ * @param caller Funcao que chama
+ * @param callee Funcao chamada
+ * @return Numero de chamadas (0 se ausente)
+ */
+uint64_t profile_edge(const Profile* prof, const char* caller, const char* callee);
+
+/**
+ * @brief Verifica se uma contagem e quente
+ * @param prof Perfil
+ * @param count Execucoes de um bloco ou chamadas
+ * @return TRUE se passa de PROFILE_HOT_MIN e de 1/PROFILE_HOT_DIV do bloco mais executado
+ */
+int profile_hot(const Profile* prof, uint64_t count);
+
+#endif
@@ -0,0 +1,57 @@
+/**
+ * @file rpc.c
+ * @brief Implementacao das funcoes comuns ao servidor e ao cliente
+ */
+
+#include "rpc.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <unistd.h>
+
+int rpc_read(int fd, void* buf, size_t n) {
+    char* p = (char*)buf;
+    while (n > 0) {
+        ssize_t r = recv(fd, p, n, 0);
+        if (r < 0 && errno == EINTR)
+            continue;
+        if (r <= 0)
+            return -1;
+        p += r;
+        n -= (size_t)r;
+    }
+    return 0;
+}
+
+int rpc_write(int fd, const void* buf, size_t n) {
+    const char* p = (const char*)buf;
+    while (n > 0) {
+        // sem SIGPIPE se o outro lado fechou a conexao
+        ssize_t w = send(fd, p, n, MSG_NOSIGNAL);
+        if (w < 0 && errno == EINTR)
+            continue;
+        if (w <= 0)
+            return -1;
+        p += w;
+        n -= (size_t)w;
+    }
+    return 0;
+}
+
+#endif
+
+char* rpc_default_socket(char* buf, size_t size) {
+    const char* env = getenv("CMINUS_SOCKET");
+    if (env != NULL && env[0] != '\0')
+        snprintf(buf, size, "%s", env);
+#ifndef _WIN32
+    else
+        snprintf(buf, size, "/tmp/cminusd-%lu.sock", (unsigned long)getuid());
+#else
+    else
+        snprintf(buf, size, "cminusd.sock");
+#endif
+    return buf;
+}
@@ -0,0 +1,85 @@
+/**
+ * @file rpc.h
+ * @brief Protocolo entre o servidor de compilacao (cminus --serve) e o cliente
+ *
+ * Cada mensagem e um cabecalho de tamanho fixo seguido dos dados, na ordem
+ * de bytes da maquina (o socket e local). Uma conexao pode enviar varias
+ * requisicoes, uma depois da outra; cada uma recebe uma resposta.
+ *
+ *   requisicao: RpcRequest, nome do arquivo, codigo fonte
+ *   resposta:   RpcResponse, listagem, mensagens de erro, .cmir
+ */
+
+#ifndef _RPC_H_
+#define _RPC_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define RPC_REQUEST_MAGIC  0x32524d43u   // "CMR2" (com optimize e unroll)
+#define RPC_RESPONSE_MAGIC 0x53524d43u   // "CMRS"
+
+// Maior codigo fonte aceito pelo servidor
+#define RPC_MAX_SOURCE (1u << 30)
+
+// Tipos de requisicao
+#define RPC_COMPILE 1     // compila o fonte enviado
+#define RPC_STATS   2     // devolve as estatisticas de latencia na listagem
+
+// Opcoes da compilacao (RpcRequest.flags)
+#define RPC_STREAM 0x01   // cminus_compile_stream
+#define RPC_SIMD   0x02   // scanner escrito a mao
+#define RPC_PRELEX 0x04   // tokens lidos antes do parser
+#define RPC_CMIR   0x08   // devolve o .cmir gerado
+
+/**
+ * @brief Cabecalho de uma requisicao
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t kind;          // RPC_COMPILE ou RPC_STATS
+    uint32_t flags;
+    int32_t optimize;       // nivel de otimizacao (0 a 3, opt.h)
+    int32_t unroll;         // --unroll pedido (-1 = padrao do nivel, unroll.h)
+    uint32_t nameLen;       // nome do arquivo (cabecalho da listagem)
+    uint32_t srcLen;
+} RpcRequest;
+
+/**
+ * @brief Cabecalho de uma resposta
+ */
+typedef struct {
+    uint32_t magic;
+    int32_t status;         // 0 se compilou, 1 se erro
+    uint32_t listingLen;
+    uint32_t errorsLen;
+    uint32_t cmirLen;       // 0 sem RPC_CMIR ou com erro
+} RpcResponse;
+
+/**
+ * @brief Le exatamente n bytes de um socket
+ * @param fd Socket
+ * @param buf Destino
+ * @param n Bytes
+ * @return 0 se sucesso, -1 se erro ou fim da conexao
+ */
+int rpc_read(int fd, void* buf, size_t n);
+
+/**
+ * @brief Escreve exatamente n bytes em um socket
+ * @param fd Socket
+ * @param buf Dados
+ * @param n Bytes
+ * @return 0 se sucesso, -1 se erro
+ */
+int rpc_write(int fd, const void* buf, size_t n);
+
+/**
+ * @brief Caminho padrao do socket ($CMINUS_SOCKET ou /tmp/cminusd-<uid>.sock)
+ * @param buf Destino
+ * @param size Tamanho do destino
+ * @return buf
+ */
+char* rpc_default_socket(char* buf, size_t size);
+
+#endif
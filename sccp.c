@@ -0,0 +1,333 @@
+/**
+ * @file sccp.c
+ * @brief Propagacao condicional esparsa de constantes sobre a SSA
+ *
+ * Algoritmo de Wegman e Zadeck: cada valor SSA comeca no topo do
+ * reticulado (ainda indefinido) e so desce (constante, depois variavel).
+ * Uma lista de arestas do CFG marca os blocos executaveis e uma lista de
+ * valores reavalia os usuarios de cada valor que mudou; um if_false cuja
+ * condicao e constante so torna executavel a aresta tomada, entao o codigo
+ * do outro lado nao contamina os phis da juncao.
+ */
+
+#include "globals.h"
+#include "ssa.h"
+#include "opt.h"
+
+// Reticulado: topo (sem definicao executavel ainda), constante, variavel
+enum { LAT_TOP, LAT_CONST, LAT_BOTTOM };
+
+/**
+ * @brief Estado da propagacao
+ */
+typedef struct {
+    SsaFunc* ssa;
+    uint8_t* state;          // reticulado de cada valor
+    int32_t* value;          // constante de cada valor em LAT_CONST
+    uint8_t* edgeExec;       // aresta (bloco, k) executavel, em 2 * bloco + k
+    uint8_t* blockExec;
+    uint32_t* flow;          // arestas a processar
+    uint32_t nflow;
+    uint32_t* work;          // valores que mudaram
+    uint32_t nwork;
+} Sccp;
+
+/**
+ * @brief Reticulado de um operando
+ * @param c Estado
+ * @param kind Tipo do operando
+ * @param val Valor do operando
+ * @param v Valor SSA lido (SSA_NONE se nao e variavel renomeada)
+ * @param x Constante (quando LAT_CONST)
+ * @return LAT_TOP, LAT_CONST ou LAT_BOTTOM
+ */
+static int operand(const Sccp* c, uint8_t kind, int32_t val, uint32_t v, int32_t* x) {
+    if (v != SSA_NONE) {
+        *x = c->value[v];
+        return c->state[v];
+    }
+    *x = val;
+    return kind == IR_CONST ? LAT_CONST : LAT_BOTTOM;
+}
+
+/**
+ * @brief Desce um valor no reticulado (nunca sobe)
+ */
+static void lower(Sccp* c, uint32_t v, int st, int32_t x) {
+    if (st == LAT_CONST && c->state[v] == LAT_CONST) {
+        // duas constantes diferentes: variavel
+        if (c->value[v] == x)
+            return;
+        st = LAT_BOTTOM;
+    } else if (st <= c->state[v]) {
+        return;
+    }
+    c->state[v] = (uint8_t)st;
+    c->value[v] = x;
+    c->work[c->nwork++] = v;
+}
+
+/**
+ * @brief Marca a aresta k do bloco b como executavel
+ */
+static void markEdge(Sccp* c, uint32_t b, uint32_t k) {
+    uint32_t e = 2 * b + k;
+    if (c->ssa->blocks[b].succ[k] == SSA_NONE || c->edgeExec[e])
+        return;
+    c->edgeExec[e] = 1;
+    c->flow[c->nflow++] = e;
+}
+
+/**
+ * @brief Verifica se a aresta do j-esimo predecessor ate o bloco b e executavel
+ */
+static int predExec(const Sccp* c, uint32_t b, uint32_t j) {
+    const SsaBlock* blk = &c->ssa->blocks[b];
+    uint32_t p = c->ssa->preds[blk->predFirst + j];
+    uint32_t k;
+    for (k = 0; k < c->ssa->blocks[p].nsuccs; k++)
+        if (c->ssa->blocks[p].succ[k] == b && c->ssa->blocks[p].succPred[k] == j)
+            return c->edgeExec[2 * p + k];
+    return FALSE;
+}
+
+/**
+ * @brief Encontro dos argumentos de um phi vindos de arestas executaveis
+ */
+static void visitPhi(Sccp* c, uint32_t p) {
+    const SsaPhi* phi = &c->ssa->phis[p];
+    uint32_t j, npreds = c->ssa->blocks[phi->block].npreds;
+    int st = LAT_TOP;
+    int32_t x = 0;
+    if (!c->blockExec[phi->block])
+        return;
+    for (j = 0; j < npreds && st != LAT_BOTTOM; j++) {
+        uint32_t v = phi->args[j];
+        if (!predExec(c, phi->block, j))
+            continue;
+        if (v == SSA_NONE || c->state[v] == LAT_BOTTOM) {
+            st = LAT_BOTTOM;
+        } else if (c->state[v] == LAT_CONST) {
+            if (st == LAT_TOP) {
+                st = LAT_CONST;
+                x = c->value[v];
+            } else if (x != c->value[v]) {
+                st = LAT_BOTTOM;
+            }
+        }
+    }
+    if (st != LAT_TOP)
+        lower(c, phi->dest, st, x);
+}
+
+/**
+ * @brief Avalia uma instrucao de um bloco executavel
+ */
+static void visitInstr(Sccp* c, uint32_t i) {
+    const SsaFunc* s = c->ssa;
+    const IrInstr* in = &s->unit->code[i];
+    uint32_t dest = s->defVal[i];
+    int32_t a, b, x;
+    int sa, sb;
+
+    if (in->op == IR_IFFALSE) {
+        uint32_t blk = s->blockOf[i];
+        sa = operand(c, in->ka, in->a, s->useVal[3 * i + 1], &a);
+        if (sa == LAT_BOTTOM || (sa == LAT_CONST && a != 0))
+            markEdge(c, blk, 0);
+        if (sa == LAT_BOTTOM || (sa == LAT_CONST && a == 0))
+            markEdge(c, blk, 1);
+        return;
+    }
+    if (dest == SSA_NONE)
+        return;
+    if (in->op == IR_COPY) {
+        sa = operand(c, in->ka, in->a, s->useVal[3 * i + 1], &a);
+        if (sa != LAT_TOP)
+            lower(c, dest, sa, a);
+    } else if (in->op >= IR_ADD && in->op <= IR_NE) {
+        sa = operand(c, in->ka, in->a, s->useVal[3 * i + 1], &a);
+        sb = operand(c, in->kb, in->b, s->useVal[3 * i + 2], &b);
+        if (sa == LAT_CONST && sb == LAT_CONST) {
+            if (opt_fold(in->op, a, b, &x))
+                lower(c, dest, LAT_CONST, x);
+            else
+                lower(c, dest, LAT_BOTTOM, 0);
+        } else if (in->op == IR_MUL && ((sa == LAT_CONST && a == 0) || (sb == LAT_CONST && b == 0)))
+            lower(c, dest, LAT_CONST, 0);
+        else if (sa == LAT_BOTTOM || sb == LAT_BOTTOM)
+            lower(c, dest, LAT_BOTTOM, 0);
+    } else {
+        // load e call
+        lower(c, dest, LAT_BOTTOM, 0);
+    }
+}
+
+/**
+ * @brief Processa uma aresta que acabou de se tornar executavel
+ */
+static void visitEdge(Sccp* c, uint32_t e) {
+    const SsaFunc* s = c->ssa;
+    uint32_t t = s->blocks[e / 2].succ[e % 2];
+    const SsaBlock* blk = &s->blocks[t];
+    uint32_t p, i;
+    int first = !c->blockExec[t];
+
+    c->blockExec[t] = 1;
+    for (p = blk->phiFirst; p != SSA_NONE; p = s->phis[p].next)
+        visitPhi(c, p);
+    if (!first)
+        return;
+    for (i = blk->first; i < blk->end; i++)
+        visitInstr(c, i);
+    if (blk->end == blk->first || s->unit->code[blk->end - 1].op != IR_IFFALSE)
+        for (i = 0; i < blk->nsuccs; i++)
+            markEdge(c, t, i);
+}
+
+/**
+ * @brief Propaga ate as duas listas esvaziarem
+ */
+static void propagate(Sccp* c) {
+    const SsaFunc* s = c->ssa;
+    uint32_t n = s->unit->rec.count;
+    uint32_t v, u;
+    c->blockExec[0] = 1;
+    markEdge(c, 0, 0);
+    while (c->nflow > 0 || c->nwork > 0) {
+        if (c->nflow > 0) {
+            visitEdge(c, c->flow[--c->nflow]);
+            continue;
+        }
+        v = c->work[--c->nwork];
+        for (u = s->userFirst[v]; u < s->userFirst[v + 1]; u++) {
+            uint32_t user = s->users[u];
+            if (user >= n)
+                visitPhi(c, user - n);
+            else if (c->blockExec[s->blockOf[user]])
+                visitInstr(c, user);
+        }
+    }
+}
+
+/**
+ * @brief Troca por uma constante um operando lido de um valor constante
+ * @return TRUE se trocou
+ */
+static int substitute(const Sccp* c, uint8_t* kind, int32_t* val, uint32_t v) {
+    if (v == SSA_NONE || c->state[v] != LAT_CONST)
+        return FALSE;
+    *kind = IR_CONST;
+    *val = c->value[v];
+    return TRUE;
+}
+
+/**
+ * @brief Reescreve o codigo com o resultado da propagacao
+ * @param c Estado ao final da propagacao
+ * @param stats Contadores locais
+ * @return 0 em sucesso, -1 se o resultado e inconsistente (codigo intocado)
+ */
+static int rewrite(Sccp* c, OptStats* stats) {
+    SsaFunc* s = c->ssa;
+    IrInstr* code = s->unit->code;
+    uint32_t b, i;
+
+    // um if_false com condicao nao constante precisa das duas arestas vivas
+    for (b = 1; b < s->nblocks; b++) {
+        const SsaBlock* blk = &s->blocks[b];
+        const IrInstr* last = &code[blk->end - 1];
+        int32_t x;
+        if (!c->blockExec[b] || last->op != IR_IFFALSE ||
+            operand(c, last->ka, last->a, s->useVal[3 * (blk->end - 1) + 1], &x) == LAT_CONST)
+            continue;
+        if ((blk->succ[0] != SSA_NONE && !c->edgeExec[2 * b]) || !c->edgeExec[2 * b + 1])
+            return -1;
+    }
+
+    for (b = 1; b < s->nblocks; b++) {
+        const SsaBlock* blk = &s->blocks[b];
+        if (!c->blockExec[b]) {
+            memset(&code[blk->first], 0, (blk->end - blk->first) * sizeof(IrInstr));
+            stats->ssaDeadBlocks++;
+            continue;
+        }
+        for (i = blk->first; i < blk->end; i++) {
+            IrInstr* in = &code[i];
+            uint32_t dest = s->defVal[i];
+            stats->ssaConstants += substitute(c, &in->kd, &in->d, s->useVal[3 * i]);
+            stats->ssaConstants += substitute(c, &in->ka, &in->a, s->useVal[3 * i + 1]);
+            stats->ssaConstants += substitute(c, &in->kb, &in->b, s->useVal[3 * i + 2]);
+            if (dest != SSA_NONE && c->state[dest] == LAT_CONST && in->op != IR_CALL &&
+                !(in->op == IR_COPY && in->ka == IR_CONST)) {
+                // a variavel continua sendo gravada; so o calculo vira constante
+                in->op = IR_COPY;
+                in->ka = IR_CONST;
+                in->a = c->value[dest];
+                in->kb = IR_NONE;
+                in->b = 0;
+                stats->ssaConstants++;
+            } else if (in->op == IR_IFFALSE && in->ka == IR_CONST) {
+                if (in->a != 0) {
+                    memset(in, 0, sizeof(*in));
+                } else {
+                    in->op = IR_GOTO;
+                    in->ka = in->kb;
+                    in->a = in->b;
+                    in->kb = IR_NONE;
+                    in->b = 0;
+                }
+                stats->ssaBranches++;
+            }
+        }
+    }
+    return 0;
+}
+
+uint32_t ssa_sccp(IrUnit* unit, OptStats* stats) {
+    SsaFunc ssa;
+    OptStats local;
+    Sccp c;
+    uint32_t removed = 0;
+
+    if (ssa_build(&ssa, unit) != 0)
+        return 0;
+    memset(&c, 0, sizeof(c));
+    c.ssa = &ssa;
+    c.state = (uint8_t*)calloc(ssa.nvalues + 1, 1);
+    c.value = (int32_t*)calloc(ssa.nvalues + 1, sizeof(int32_t));
+    c.edgeExec = (uint8_t*)calloc(2 * ssa.nblocks + 1, 1);
+    c.blockExec = (uint8_t*)calloc(ssa.nblocks + 1, 1);
+    c.flow = (uint32_t*)malloc((2 * ssa.nblocks + 1) * sizeof(uint32_t));
+    c.work = (uint32_t*)malloc((2 * ssa.nvalues + 1) * sizeof(uint32_t));
+    memset(&local, 0, sizeof(local));
+    if (c.state != NULL && c.value != NULL && c.edgeExec != NULL && c.blockExec != NULL && c.flow != NULL &&
+        c.work != NULL) {
+        uint32_t v;
+        // valores de entrada (parametros e locais nao inicializadas) sao desconhecidos
+        for (v = 0; v < ssa.nvars; v++)
+            c.state[v] = LAT_BOTTOM;
+        propagate(&c);
+        if (rewrite(&c, &local) == 0) {
+            local.ssaFunctions = 1;
+            local.ssaPhis = ssa.nphis;
+            removed = ssa_destroy(&ssa);
+        }
+    }
+    free(c.state);
+    free(c.value);
+    free(c.edgeExec);
+    free(c.blockExec);
+    free(c.flow);
+    free(c.work);
+    ssa_free(&ssa);
+
+    if (stats != NULL && local.ssaFunctions != 0) {
+        __atomic_add_fetch(&stats->ssaFunctions, local.ssaFunctions, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&stats->ssaPhis, local.ssaPhis, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&stats->ssaConstants, local.ssaConstants, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&stats->ssaBranches, local.ssaBranches, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&stats->ssaDeadBlocks, local.ssaDeadBlocks, __ATOMIC_RELAXED);
+    }
+    return removed;
+}
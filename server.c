@@ -0,0 +1,406 @@
+/**
+ * @file server.c
+ * @brief Implementacao do servidor de compilacao
+ */
+
+#include "globals.h"
+#include "server.h"
+
+#ifndef _WIN32
+#include "compiler.h"
+#include "irfile.h"
+#include "lexer.h"
+#include "pool.h"
+#include "rpc.h"
+#include "unroll.h"
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+// Maior nome de arquivo aceito em uma requisicao
+#define SERVER_MAX_NAME 4096
+// Segundos sem receber (ou sem conseguir enviar) nada antes de fechar a
+// conexao: um cliente ocioso nao prende a thread que o atende
+#define SERVER_IDLE_TIMEOUT 5
+
+struct Worker;
+
+/**
+ * @brief Estado do servidor
+ */
+typedef struct {
+    int fd;                  // socket que aceita conexoes
+    struct Worker* workers;
+    int nworkers;
+    volatile sig_atomic_t stop;
+    pthread_mutex_t lock;    // protege as estatisticas
+    double* latency;         // latencia de cada requisicao (ms)
+    size_t nlatency;
+    size_t latencyCap;
+    unsigned long failures;  // compilacoes com erro
+} Server;
+
+/**
+ * @brief Estado de uma thread do servidor
+ */
+typedef struct Worker {
+    Server* server;
+    IrProgram program;       // reaproveitado entre requisicoes (ir_reset)
+    volatile int conn;       // conexao sendo atendida (-1 se nenhuma)
+    pthread_t thread;
+} Worker;
+
+/**
+ * @brief Texto acumulado em memoria por um FILE*
+ */
+typedef struct {
+    FILE* f;
+    char* data;
+    size_t size;
+} MemOut;
+
+// servidor em execucao (usado pelo tratador de sinais)
+static Server* running;
+
+/**
+ * @brief Tempo monotonico em segundos
+ * @return Segundos
+ */
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Interrompe o servidor (SIGINT e SIGTERM)
+ * @param sig Sinal recebido
+ */
+static void onSignal(int sig) {
+    int i;
+    (void)sig;
+    if (running != NULL) {
+        running->stop = TRUE;
+        // acorda as threads bloqueadas em accept e as que esperam a proxima
+        // requisicao de um cliente ocioso
+        shutdown(running->fd, SHUT_RDWR);
+        for (i = 0; i < running->nworkers; i++)
+            if (running->workers[i].conn >= 0)
+                shutdown(running->workers[i].conn, SHUT_RDWR);
+    }
+}
+
+/**
+ * @brief Compara duas latencias (qsort)
+ * @param a Primeira latencia
+ * @param b Segunda latencia
+ * @return Negativo, zero ou positivo
+ */
+static int compareDouble(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return x < y ? -1 : x > y;
+}
+
+/**
+ * @brief Escreve o numero de requisicoes e os percentis de latencia
+ * @param srv Servidor
+ * @param out Saida
+ */
+static void printStats(Server* srv, FILE* out) {
+    double* sorted;
+    size_t n;
+    pthread_mutex_lock(&srv->lock);
+    n = srv->nlatency;
+    sorted = (double*)malloc((n ? n : 1) * sizeof(double));
+    if (sorted != NULL)
+        memcpy(sorted, srv->latency, n * sizeof(double));
+    fprintf(out, "Requisicoes: %lu (com erro: %lu)\n", (unsigned long)n, srv->failures);
+    pthread_mutex_unlock(&srv->lock);
+    if (sorted != NULL && n > 0) {
+        qsort(sorted, n, sizeof(double), compareDouble);
+        fprintf(out, "Latencia (ms): p50 %.3f  p90 %.3f  p99 %.3f  max %.3f\n",
+                sorted[(n - 1) / 2], sorted[(n - 1) * 9 / 10], sorted[(n - 1) * 99 / 100], sorted[n - 1]);
+    }
+    free(sorted);
+}
+
+/**
+ * @brief Registra a latencia de uma requisicao
+ * @param srv Servidor
+ * @param ms Latencia em milissegundos
+ * @param failed TRUE se a compilacao falhou
+ */
+static void record(Server* srv, double ms, int failed) {
+    pthread_mutex_lock(&srv->lock);
+    if (srv->nlatency == srv->latencyCap) {
+        size_t cap = srv->latencyCap ? srv->latencyCap * 2 : 1024;
+        double* p = (double*)realloc(srv->latency, cap * sizeof(double));
+        if (p != NULL) {
+            srv->latency = p;
+            srv->latencyCap = cap;
+        }
+    }
+    if (srv->nlatency < srv->latencyCap)
+        srv->latency[srv->nlatency++] = ms;
+    if (failed)
+        srv->failures++;
+    pthread_mutex_unlock(&srv->lock);
+}
+
+/**
+ * @brief Abre um FILE* que acumula o texto em memoria
+ * @param m Saida em memoria
+ * @return 0 se sucesso, -1 se erro
+ */
+static int memOpen(MemOut* m) {
+    m->data = NULL;
+    m->size = 0;
+    m->f = open_memstream(&m->data, &m->size);
+    return m->f != NULL ? 0 : -1;
+}
+
+/**
+ * @brief Compila uma requisicao
+ * @param w Thread do servidor
+ * @param req Requisicao (opcoes RPC_*, nivel de otimizacao e desenrolamento)
+ * @param src Codigo fonte seguido de dois '\0'
+ * @param len Tamanho do codigo fonte
+ * @param out Listagem
+ * @param err Mensagens de erro
+ * @param cmir .cmir gerado (alocado, se pedido e sem erro)
+ * @param cmirSize Tamanho do .cmir
+ * @return 0 se compilou, 1 se erro
+ */
+static int compile(Worker* w, const RpcRequest* req, char* src, size_t len, FILE* out, FILE* err,
+                   char** cmir, size_t* cmirSize) {
+    CompilerContext ctx;
+    uint32_t flags = req->flags;
+    int status;
+    cminus_init(&ctx, out, err);
+    ctx.scanInPlace = TRUE;
+    ctx.lexer = (flags & RPC_SIMD) ? LEXER_SIMD : LEXER_FLEX;
+    ctx.prelex = (flags & RPC_PRELEX) != 0;
+    ctx.optimize = req->optimize;
+    ctx.unroll = unroll_factor(req->optimize, req->unroll);
+    ir_reset(&w->program);
+    if (flags & RPC_STREAM)
+        status = cminus_compile_stream(&ctx, src, len, &w->program);
+    else
+        status = cminus_compile(&ctx, src, len, &w->program);
+    cminus_free(&ctx);
+    if (status == 0 && (flags & RPC_CMIR)) {
+        IrView view;
+        ir_flatten(&w->program, &view);
+        *cmir = (char*)irfile_serialize(&view, cmirSize);
+        ir_view_free(&view);
+    }
+    return status;
+}
+
+/**
+ * @brief Atende as requisicoes de uma conexao ate ela ser fechada
+ * @param w Thread do servidor
+ * @param fd Conexao
+ */
+static void serveConnection(Worker* w, int fd) {
+    RpcRequest req;
+    while (!w->server->stop && rpc_read(fd, &req, sizeof(req)) == 0) {
+        RpcResponse resp;
+        MemOut out, err;
+        char* name;
+        char* src;
+        char* cmir = NULL;
+        size_t cmirSize = 0;
+        double start;
+        int ok;
+
+        if (req.magic != RPC_REQUEST_MAGIC || req.nameLen > SERVER_MAX_NAME || req.srcLen > RPC_MAX_SOURCE ||
+            (req.kind != RPC_COMPILE && req.kind != RPC_STATS) || req.optimize < 0 || req.optimize > 3)
+            return;
+        name = (char*)malloc(req.nameLen + 1);
+        // o scanner le o fonte no proprio buffer, seguido de dois '\0'
+        src = (char*)malloc((size_t)req.srcLen + 2);
+        ok = name != NULL && src != NULL && rpc_read(fd, name, req.nameLen) == 0 &&
+             rpc_read(fd, src, req.srcLen) == 0 && memOpen(&out) == 0;
+        if (ok && memOpen(&err) != 0) {
+            fclose(out.f);
+            free(out.data);
+            ok = FALSE;
+        }
+        if (!ok) {
+            free(name);
+            free(src);
+            return;
+        }
+        name[req.nameLen] = '\0';
+        src[req.srcLen] = '\0';
+        src[req.srcLen + 1] = '\0';
+
+        start = now();
+        resp.status = 0;
+        if (req.kind == RPC_STATS) {
+            printStats(w->server, out.f);
+        } else {
+            // mesmo cabecalho da listagem de cminus <arquivo>
+            fprintf(out.f, "Arquivo de entrada: %s\n\n", name);
+            resp.status = compile(w, &req, src, req.srcLen, out.f, err.f, &cmir, &cmirSize);
+        }
+        fclose(out.f);
+        fclose(err.f);
+
+        resp.magic = RPC_RESPONSE_MAGIC;
+        resp.listingLen = (uint32_t)out.size;
+        resp.errorsLen = (uint32_t)err.size;
+        resp.cmirLen = (uint32_t)cmirSize;
+        ok = rpc_write(fd, &resp, sizeof(resp)) == 0 && rpc_write(fd, out.data, out.size) == 0 &&
+             rpc_write(fd, err.data, err.size) == 0 && rpc_write(fd, cmir, cmirSize) == 0;
+        if (req.kind == RPC_COMPILE)
+            record(w->server, (now() - start) * 1e3, resp.status != 0);
+        free(out.data);
+        free(err.data);
+        free(cmir);
+        free(name);
+        free(src);
+        if (!ok)
+            return;
+    }
+}
+
+/**
+ * @brief Laco de uma thread do servidor: aceita e atende conexoes
+ * @param arg Worker
+ * @return NULL
+ */
+static void* workerMain(void* arg) {
+    Worker* w = (Worker*)arg;
+    Server* srv = w->server;
+    struct timeval idle;
+    idle.tv_sec = SERVER_IDLE_TIMEOUT;
+    idle.tv_usec = 0;
+    while (!srv->stop) {
+        int fd = accept(srv->fd, NULL, NULL);
+        if (fd < 0) {
+            if (srv->stop)
+                break;
+            if (errno == EINTR || errno == ECONNABORTED || errno == EMFILE || errno == ENFILE)
+                continue;
+            fprintf(stderr, "Erro: accept falhou (%s)\n", strerror(errno));
+            break;
+        }
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &idle, sizeof(idle));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &idle, sizeof(idle));
+        w->conn = fd;
+        if (!srv->stop)
+            serveConnection(w, fd);
+        w->conn = -1;
+        close(fd);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Cria o socket do servidor, removendo um socket abandonado
+ * @param path Caminho
+ * @return Descritor ou -1 se erro
+ */
+static int listenAt(const char* path) {
+    struct sockaddr_un addr;
+    int fd;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Erro: caminho do socket muito longo '%s'\n", path);
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) == 0) {
+        fprintf(stderr, "Erro: ja existe um servidor em '%s'\n", path);
+        close(fd);
+        return -1;
+    }
+    // ninguem atende: o arquivo sobrou de um servidor que nao terminou bem
+    if (errno == ECONNREFUSED)
+        unlink(path);
+    close(fd);
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 128) != 0) {
+        fprintf(stderr, "Erro: nao foi possivel escutar em '%s' (%s)\n", path, strerror(errno));
+        if (fd >= 0)
+            close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int server_run(const ServerOptions* opts) {
+    Server srv;
+    Worker* workers;
+    struct sigaction sa;
+    int n = opts->threads > 0 ? opts->threads : pool_cpu_count();
+    int started = 0;
+    int i;
+
+    memset(&srv, 0, sizeof(srv));
+    srv.fd = listenAt(opts->socketPath);
+    if (srv.fd < 0)
+        return 1;
+    pthread_mutex_init(&srv.lock, NULL);
+    workers = (Worker*)calloc((size_t)n, sizeof(Worker));
+    for (i = 0; workers != NULL && i < n; i++)
+        workers[i].conn = -1;
+    srv.workers = workers;
+
+    running = &srv;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = onSignal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    for (i = 0; workers != NULL && i < n; i++) {
+        workers[i].server = &srv;
+        ir_init(&workers[i].program);
+        if (pthread_create(&workers[i].thread, NULL, workerMain, &workers[i]) != 0) {
+            ir_free(&workers[i].program);
+            break;
+        }
+        srv.nworkers = ++started;
+    }
+    if (started > 0) {
+        fprintf(stderr, "Servidor de compilacao em %s (%d threads)\n", opts->socketPath, started);
+        for (i = 0; i < started; i++)
+            pthread_join(workers[i].thread, NULL);
+    } else {
+        fprintf(stderr, "Erro: nao foi possivel criar as threads do servidor\n");
+    }
+
+    running = NULL;
+    close(srv.fd);
+    unlink(opts->socketPath);
+    if (started > 0)
+        printStats(&srv, stderr);
+    for (i = 0; i < started; i++)
+        ir_free(&workers[i].program);
+    free(workers);
+    free(srv.latency);
+    pthread_mutex_destroy(&srv.lock);
+    return started > 0 ? 0 : 1;
+}
+
+#else
+
+int server_run(const ServerOptions* opts) {
+    (void)opts;
+    fprintf(stderr, "Erro: o servidor de compilacao nao esta disponivel no Windows\n");
+    return 1;
+}
+
+#endif
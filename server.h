@@ -0,0 +1,34 @@
+/**
+ * @file server.h
+ * @brief Servidor de compilacao persistente em um socket Unix (cminus --serve)
+ *
+ * Evita o custo de iniciar um processo a cada compilacao: o servidor fica
+ * no ar recebendo requisicoes (fonte e opcoes, rpc.h) e devolve a listagem,
+ * as mensagens de erro e o .cmir. Cada thread do servidor aceita conexoes e
+ * compila uma requisicao por vez, reaproveitando entre requisicoes o seu
+ * IrProgram (tabela de strings e vetores ja alocados, ir_reset) e o heap ja
+ * aquecido do processo. Uma conexao parada por SERVER_IDLE_TIMEOUT segundos
+ * e fechada, liberando a thread para os outros clientes. O servidor mede a latencia de cada requisicao e
+ * imprime os percentis ao terminar (SIGINT ou SIGTERM); o cliente tambem
+ * pode pedi-los (cminusc --stats).
+ */
+
+#ifndef _SERVER_H_
+#define _SERVER_H_
+
+/**
+ * @brief Opcoes do servidor
+ */
+typedef struct {
+    const char* socketPath;  // caminho do socket Unix
+    int threads;             // requisicoes atendidas ao mesmo tempo (0 = processadores)
+} ServerOptions;
+
+/**
+ * @brief Atende requisicoes ate receber SIGINT ou SIGTERM
+ * @param opts Opcoes
+ * @return 0 se terminou normalmente, 1 se erro
+ */
+int server_run(const ServerOptions* opts);
+
+#endif
@@ -0,0 +1,109 @@
+/**
+ * @file source.c
+ * @brief Implementacao da carga do arquivo fonte (mmap)
+ */
+
+#include "source.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief Carrega o arquivo com fread em um buffer com dois '\0' no fim
+ * @param path Caminho
+ * @param src Fonte a preencher
+ * @return 0 se sucesso, -1 se erro
+ */
+static int readSource(const char* path, SourceFile* src) {
+    FILE* f = fopen(path, "rb");
+    size_t cap = 4096, n = 0, r;
+    char* buf;
+    if (f == NULL)
+        return -1;
+    buf = (char*)malloc(cap);
+    while (buf != NULL && (r = fread(buf + n, 1, cap - n - 2, f)) > 0) {
+        n += r;
+        if (n + 2 == cap) {
+            char* nb = (char*)realloc(buf, cap * 2);
+            if (nb == NULL) {
+                free(buf);
+                buf = NULL;
+                break;
+            }
+            buf = nb;
+            cap *= 2;
+        }
+    }
+    fclose(f);
+    if (buf == NULL)
+        return -1;
+    buf[n] = '\0';
+    buf[n + 1] = '\0';
+    src->data = buf;
+    src->size = n;
+    src->mapSize = 0;
+    return 0;
+}
+
+int source_open(const char* path, SourceFile* src) {
+    memset(src, 0, sizeof(*src));
+#ifndef _WIN32
+    {
+        struct stat st;
+        size_t page = (size_t)sysconf(_SC_PAGESIZE);
+        size_t total;
+        char* base;
+        int fd = open(path, O_RDONLY);
+        if (fd < 0)
+            return -1;
+        if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0) {
+            // vazio ou nao mapeavel (pipe, dispositivo): le normalmente
+            close(fd);
+            return readSource(path, src);
+        }
+        // reserva uma pagina anonima (zerada) a mais e mapeia o arquivo por
+        // cima, garantindo os dois '\0' mesmo quando o tamanho e multiplo
+        // da pagina
+        total = ((size_t)st.st_size + 2 + page - 1) / page * page;
+        base = (char*)mmap(NULL, total, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base != MAP_FAILED &&
+            mmap(base, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+            munmap(base, total);
+            base = (char*)MAP_FAILED;
+        }
+        close(fd);
+        if (base == MAP_FAILED)
+            return readSource(path, src);
+        src->data = base;
+        src->size = (size_t)st.st_size;
+        src->mapSize = total;
+        return 0;
+    }
+#else
+    return readSource(path, src);
+#endif
+}
+
+int source_read(const char* path, SourceFile* src) {
+    memset(src, 0, sizeof(*src));
+    return readSource(path, src);
+}
+
+void source_close(SourceFile* src) {
+    if (src->data != NULL) {
+#ifndef _WIN32
+        if (src->mapSize > 0)
+            munmap(src->data, src->mapSize);
+        else
+#endif
+            free(src->data);
+    }
+    memset(src, 0, sizeof(*src));
+}
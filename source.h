@@ -0,0 +1,51 @@
+/**
+ * @file source.h
+ * @brief Carga do arquivo fonte para o scanner, sem copias (mmap)
+ *
+ * O arquivo e mapeado em modo privado (copy-on-write) e seguido de dois
+ * '\0', como o flex exige em yy_scan_buffer, de forma que o scanner le o
+ * fonte direto da memoria mapeada em vez de copia-lo para os seus buffers.
+ */
+
+#ifndef _SOURCE_H_
+#define _SOURCE_H_
+
+#include <stddef.h>
+
+/**
+ * @brief Arquivo fonte carregado
+ */
+typedef struct {
+    char* data;       // conteudo seguido de dois '\0' (alteravel, privado)
+    size_t size;      // tamanho do arquivo
+    size_t mapSize;   // tamanho da regiao mapeada (0 se lido com fread)
+} SourceFile;
+
+/**
+ * @brief Carrega um arquivo fonte (mmap quando disponivel)
+ * @param path Caminho
+ * @param src Fonte a preencher
+ * @return 0 se sucesso, -1 se erro
+ */
+int source_open(const char* path, SourceFile* src);
+
+/**
+ * @brief Carrega um arquivo fonte com fread, sem mmap
+ *
+ * Para arquivos que podem ser truncados durante a leitura (--watch): com o
+ * arquivo mapeado, ler uma pagina que deixou de existir mata o processo
+ * com SIGBUS; com fread a leitura so termina mais cedo.
+ *
+ * @param path Caminho
+ * @param src Fonte a preencher
+ * @return 0 se sucesso, -1 se erro
+ */
+int source_read(const char* path, SourceFile* src);
+
+/**
+ * @brief Libera um arquivo fonte carregado
+ * @param src Fonte
+ */
+void source_close(SourceFile* src);
+
+#endif
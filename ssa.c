@@ -0,0 +1,672 @@
+/**
+ * @file ssa.c
+ * @brief Construcao e destruicao da forma SSA
+ *
+ * Dominadores pelo algoritmo iterativo de Cooper, Harvey e Kennedy sobre a
+ * pos-ordem reversa, fronteiras de dominancia pelos predecessores de cada
+ * juncao, phis nas fronteiras iteradas das definicoes e renomeacao em
+ * pre-ordem na arvore de dominadores (com pilha explicita, sem recursao).
+ */
+
+#include "globals.h"
+#include "ssa.h"
+
+/**
+ * @brief Verifica se a operacao grava no operando d
+ * @param op Operacao
+ * @return TRUE se d e destino
+ */
+static int definesVar(int op) {
+    return op == IR_COPY || (op >= IR_ADD && op <= IR_NE) || op == IR_LOAD || op == IR_CALL;
+}
+
+/**
+ * @brief Variavel renomeada de um operando
+ * @param s Funcao
+ * @param kind Tipo do operando
+ * @param val Valor do operando
+ * @return Indice da variavel ou SSA_NONE
+ */
+static uint32_t varOf(const SsaFunc* s, uint8_t kind, int32_t val) {
+    uint32_t v;
+    if (kind == IR_TEMP)
+        v = (uint32_t)val;
+    else if (kind == IR_LOCAL)
+        v = s->ntemps + (uint32_t)val;
+    else
+        return SSA_NONE;
+    return v < s->nvars && s->tracked[v] ? v : SSA_NONE;
+}
+
+/**
+ * @brief Aloca um vetor zerado (com um elemento extra para tamanho 0)
+ */
+static void* zalloc(size_t n, size_t size) {
+    return calloc(n + 1, size);
+}
+
+/**
+ * @brief Divide o codigo em blocos basicos e liga as arestas
+ * @param s Funcao
+ * @return 0 em sucesso, -1 sem memoria ou label inexistente
+ */
+static int buildBlocks(SsaFunc* s) {
+    const IrInstr* code = s->unit->code;
+    uint32_t n = s->unit->rec.count;
+    uint32_t nlabels = s->unit->rec.nlabels;
+    uint8_t* leader = (uint8_t*)zalloc(n, 1);
+    uint32_t* labelBlock = (uint32_t*)malloc((nlabels + 1) * sizeof(uint32_t));
+    uint32_t* fill = NULL;
+    uint32_t i, b, k, npreds = 0;
+    int status = -1;
+
+    if (leader == NULL || labelBlock == NULL)
+        goto done;
+    leader[0] = 1;
+    for (i = 0; i < n; i++) {
+        if (code[i].op == IR_LABEL_DEF)
+            leader[i] = 1;
+        if ((code[i].op == IR_GOTO || code[i].op == IR_IFFALSE || code[i].op == IR_RETURN) && i + 1 < n)
+            leader[i + 1] = 1;
+    }
+    s->nblocks = 1;
+    for (i = 0; i < n; i++)
+        s->nblocks += leader[i];
+    s->blocks = (SsaBlock*)zalloc(s->nblocks, sizeof(SsaBlock));
+    s->blockOf = (uint32_t*)zalloc(n, sizeof(uint32_t));
+    if (s->blocks == NULL || s->blockOf == NULL)
+        goto done;
+
+    // bloco 0: entrada vazia
+    for (i = 0; i <= nlabels; i++)
+        labelBlock[i] = SSA_NONE;
+    for (i = 0, b = 0; i < n; i++) {
+        if (leader[i]) {
+            b++;
+            s->blocks[b].first = i;
+        }
+        s->blocks[b].end = i + 1;
+        s->blockOf[i] = b;
+        if (code[i].op == IR_LABEL_DEF && code[i].ka == IR_LABEL && (uint32_t)code[i].a < nlabels)
+            labelBlock[code[i].a] = b;
+    }
+
+    for (b = 0; b < s->nblocks; b++) {
+        SsaBlock* blk = &s->blocks[b];
+        uint32_t fall = b + 1 < s->nblocks ? b + 1 : SSA_NONE;
+        const IrInstr* last = blk->end > blk->first ? &code[blk->end - 1] : NULL;
+        blk->phiFirst = SSA_NONE;
+        blk->idom = SSA_NONE;
+        blk->succ[0] = blk->succ[1] = SSA_NONE;
+        if (last == NULL) {
+            blk->succ[0] = fall;
+            blk->nsuccs = 1;
+        } else if (last->op == IR_GOTO || last->op == IR_IFFALSE) {
+            int32_t l = last->op == IR_GOTO ? last->a : last->b;
+            uint8_t kind = last->op == IR_GOTO ? last->ka : last->kb;
+            if (kind != IR_LABEL || (uint32_t)l >= nlabels || labelBlock[l] == SSA_NONE)
+                goto done;
+            if (last->op == IR_GOTO) {
+                blk->succ[0] = labelBlock[l];
+                blk->nsuccs = 1;
+            } else {
+                blk->succ[0] = fall;
+                blk->succ[1] = labelBlock[l];
+                blk->nsuccs = 2;
+            }
+        } else if (last->op != IR_RETURN) {
+            blk->succ[0] = fall;
+            blk->nsuccs = 1;
+        }
+        for (k = 0; k < blk->nsuccs; k++)
+            if (blk->succ[k] != SSA_NONE) {
+                s->blocks[blk->succ[k]].npreds++;
+                npreds++;
+            }
+    }
+
+    // listas de predecessores
+    s->preds = (uint32_t*)zalloc(npreds, sizeof(uint32_t));
+    fill = (uint32_t*)zalloc(s->nblocks, sizeof(uint32_t));
+    if (s->preds == NULL || fill == NULL)
+        goto done;
+    for (b = 0, i = 0; b < s->nblocks; b++) {
+        s->blocks[b].predFirst = i;
+        i += s->blocks[b].npreds;
+    }
+    for (b = 0; b < s->nblocks; b++) {
+        SsaBlock* blk = &s->blocks[b];
+        for (k = 0; k < blk->nsuccs; k++) {
+            uint32_t t = blk->succ[k];
+            if (t == SSA_NONE)
+                continue;
+            blk->succPred[k] = fill[t];
+            s->preds[s->blocks[t].predFirst + fill[t]++] = b;
+        }
+    }
+    status = 0;
+done:
+    free(leader);
+    free(labelBlock);
+    free(fill);
+    return status;
+}
+
+/**
+ * @brief Sobe na arvore de dominadores ate o ancestral comum
+ */
+static uint32_t intersect(const uint32_t* idom, const uint32_t* rpo, uint32_t a, uint32_t b) {
+    while (a != b) {
+        while (rpo[a] > rpo[b])
+            a = idom[a];
+        while (rpo[b] > rpo[a])
+            b = idom[b];
+    }
+    return a;
+}
+
+/**
+ * @brief Pos-ordem reversa e dominadores imediatos
+ * @param s Funcao
+ * @param rpo Numero de cada bloco na pos-ordem reversa (SSA_NONE = inalcancavel)
+ * @return 0 em sucesso, -1 sem memoria
+ */
+static int buildDominators(SsaFunc* s, uint32_t* rpo) {
+    uint32_t* stack = (uint32_t*)zalloc(s->nblocks, sizeof(uint32_t));
+    uint8_t* next = (uint8_t*)zalloc(s->nblocks, 1);
+    uint32_t* idom = (uint32_t*)zalloc(s->nblocks, sizeof(uint32_t));
+    uint32_t sp = 0, post = 0, b, i, j;
+    int changed = TRUE;
+
+    s->order = (uint32_t*)zalloc(s->nblocks, sizeof(uint32_t));
+    if (stack == NULL || next == NULL || idom == NULL || s->order == NULL) {
+        free(stack);
+        free(next);
+        free(idom);
+        return -1;
+    }
+    for (b = 0; b < s->nblocks; b++) {
+        rpo[b] = SSA_NONE;
+        idom[b] = SSA_NONE;
+    }
+
+    // busca em profundidade a partir da entrada; rpo marca os visitados
+    rpo[0] = 0;
+    stack[sp++] = 0;
+    while (sp > 0) {
+        SsaBlock* blk = &s->blocks[stack[sp - 1]];
+        if (next[stack[sp - 1]] < blk->nsuccs) {
+            uint32_t t = blk->succ[next[stack[sp - 1]]++];
+            if (t != SSA_NONE && rpo[t] == SSA_NONE) {
+                rpo[t] = 0;
+                stack[sp++] = t;
+            }
+        } else {
+            s->order[post++] = stack[--sp];
+        }
+    }
+    s->nreach = post;
+    for (i = 0; i < post / 2; i++) {
+        uint32_t t = s->order[i];
+        s->order[i] = s->order[post - 1 - i];
+        s->order[post - 1 - i] = t;
+    }
+    for (i = 0; i < post; i++)
+        rpo[s->order[i]] = i;
+
+    idom[0] = 0;
+    while (changed) {
+        changed = FALSE;
+        for (i = 1; i < post; i++) {
+            SsaBlock* blk = &s->blocks[s->order[i]];
+            uint32_t d = SSA_NONE;
+            for (j = 0; j < blk->npreds; j++) {
+                uint32_t p = s->preds[blk->predFirst + j];
+                if (idom[p] == SSA_NONE)
+                    continue;
+                d = d == SSA_NONE ? p : intersect(idom, rpo, p, d);
+            }
+            if (d != idom[s->order[i]]) {
+                idom[s->order[i]] = d;
+                changed = TRUE;
+            }
+        }
+    }
+    for (b = 1; b < s->nblocks; b++)
+        s->blocks[b].idom = idom[b];
+    free(stack);
+    free(next);
+    free(idom);
+    return 0;
+}
+
+/**
+ * @brief Fronteiras de dominancia (duas passadas: contagem e preenchimento)
+ * @param s Funcao
+ * @param rpo Pos-ordem reversa (SSA_NONE = inalcancavel)
+ * @param dfFirst Inicio da fronteira de cada bloco em *df (nblocks + 1)
+ * @param df Fronteiras alocadas aqui
+ * @return 0 em sucesso, -1 sem memoria
+ */
+static int buildFrontiers(const SsaFunc* s, const uint32_t* rpo, uint32_t* dfFirst, uint32_t** df) {
+    uint32_t* mark = (uint32_t*)malloc((s->nblocks + 1) * sizeof(uint32_t));
+    uint32_t* fill = (uint32_t*)zalloc(s->nblocks, sizeof(uint32_t));
+    uint32_t b, j, r, pass;
+
+    *df = NULL;
+    if (mark == NULL || fill == NULL) {
+        free(mark);
+        free(fill);
+        return -1;
+    }
+    for (pass = 0; pass < 2; pass++) {
+        for (b = 0; b < s->nblocks; b++)
+            mark[b] = SSA_NONE;
+        for (b = 1; b < s->nblocks; b++) {
+            const SsaBlock* blk = &s->blocks[b];
+            if (rpo[b] == SSA_NONE || blk->npreds < 2)
+                continue;
+            for (j = 0; j < blk->npreds; j++) {
+                // a entrada domina todos os blocos; idom da entrada e SSA_NONE
+                for (r = s->preds[blk->predFirst + j]; r != SSA_NONE && r != blk->idom && rpo[r] != SSA_NONE;
+                     r = s->blocks[r].idom) {
+                    if (mark[r] == b)
+                        continue;
+                    mark[r] = b;
+                    if (pass == 0)
+                        dfFirst[r + 1]++;
+                    else
+                        (*df)[dfFirst[r] + fill[r]++] = b;
+                }
+            }
+        }
+        if (pass == 0) {
+            for (b = 0; b < s->nblocks; b++)
+                dfFirst[b + 1] += dfFirst[b];
+            *df = (uint32_t*)zalloc(dfFirst[s->nblocks], sizeof(uint32_t));
+            if (*df == NULL) {
+                free(mark);
+                free(fill);
+                return -1;
+            }
+        }
+    }
+    free(mark);
+    free(fill);
+    return 0;
+}
+
+/**
+ * @brief Insere os phis (SSA semi-podada)
+ * @param s Funcao
+ * @param rpo Pos-ordem reversa
+ * @param dfFirst Inicio das fronteiras
+ * @param df Fronteiras
+ * @return 0 em sucesso, -1 sem memoria
+ */
+static int placePhis(SsaFunc* s, const uint32_t* rpo, const uint32_t* dfFirst, const uint32_t* df) {
+    const IrInstr* code = s->unit->code;
+    uint32_t n = s->unit->rec.count;
+    uint8_t* global = (uint8_t*)zalloc(s->nvars, 1);
+    uint32_t* killed = (uint32_t*)malloc((s->nvars + 1) * sizeof(uint32_t));
+    uint32_t* defFirst = (uint32_t*)zalloc(s->nvars + 1, sizeof(uint32_t));
+    uint32_t* defBlocks = (uint32_t*)zalloc(n, sizeof(uint32_t));
+    uint32_t* work = (uint32_t*)zalloc(s->nblocks + n, sizeof(uint32_t));
+    uint32_t* inWork = (uint32_t*)malloc((s->nblocks + 1) * sizeof(uint32_t));
+    uint32_t* hasPhi = (uint32_t*)malloc((s->nblocks + 1) * sizeof(uint32_t));
+    uint32_t phiCap = 0, nargs = 0;
+    uint32_t i, v, b, j, top;
+    int status = -1;
+
+    if (global == NULL || killed == NULL || defFirst == NULL || defBlocks == NULL || work == NULL ||
+        inWork == NULL || hasPhi == NULL)
+        goto done;
+
+    // nomes globais: lidos em um bloco antes de serem definidos nele
+    for (v = 0; v < s->nvars; v++)
+        killed[v] = SSA_NONE;
+    for (i = 0; i < n; i++) {
+        const IrInstr* in = &code[i];
+        uint32_t blk = s->blockOf[i];
+        uint32_t use[3];
+        use[0] = in->op == IR_STORE ? varOf(s, in->kd, in->d) : SSA_NONE;
+        use[1] = varOf(s, in->ka, in->a);
+        use[2] = varOf(s, in->kb, in->b);
+        for (j = 0; j < 3; j++)
+            if (use[j] != SSA_NONE && killed[use[j]] != blk)
+                global[use[j]] = 1;
+        if (definesVar(in->op) && (v = varOf(s, in->kd, in->d)) != SSA_NONE) {
+            killed[v] = blk;
+            defFirst[v + 1]++;
+        }
+    }
+    for (v = 0; v < s->nvars; v++)
+        defFirst[v + 1] += defFirst[v];
+    for (v = 0; v < s->nvars; v++)
+        killed[v] = defFirst[v];
+    for (i = 0; i < n; i++)
+        if (definesVar(code[i].op) && (v = varOf(s, code[i].kd, code[i].d)) != SSA_NONE)
+            defBlocks[killed[v]++] = s->blockOf[i];
+
+    // fronteira de dominancia iterada das definicoes de cada nome global
+    for (b = 0; b < s->nblocks; b++)
+        inWork[b] = hasPhi[b] = SSA_NONE;
+    for (v = 0; v < s->nvars; v++) {
+        if (!global[v])
+            continue;
+        top = 0;
+        for (i = defFirst[v]; i < defFirst[v + 1]; i++) {
+            b = defBlocks[i];
+            if (rpo[b] != SSA_NONE && inWork[b] != v) {
+                inWork[b] = v;
+                work[top++] = b;
+            }
+        }
+        while (top > 0) {
+            b = work[--top];
+            for (j = dfFirst[b]; j < dfFirst[b + 1]; j++) {
+                uint32_t d = df[j];
+                if (hasPhi[d] == v)
+                    continue;
+                hasPhi[d] = v;
+                if (s->nphis == phiCap) {
+                    SsaPhi* grown;
+                    phiCap = phiCap ? phiCap * 2 : 16;
+                    grown = (SsaPhi*)realloc(s->phis, phiCap * sizeof(SsaPhi));
+                    if (grown == NULL)
+                        goto done;
+                    s->phis = grown;
+                }
+                s->phis[s->nphis].var = v;
+                s->phis[s->nphis].block = d;
+                s->phis[s->nphis].next = s->blocks[d].phiFirst;
+                s->blocks[d].phiFirst = s->nphis;
+                s->nphis++;
+                nargs += s->blocks[d].npreds;
+                if (inWork[d] != v) {
+                    inWork[d] = v;
+                    work[top++] = d;
+                }
+            }
+        }
+    }
+
+    s->phiArgs = (uint32_t*)zalloc(nargs, sizeof(uint32_t));
+    if (s->phiArgs == NULL)
+        goto done;
+    for (i = 0, j = 0; i < s->nphis; i++) {
+        s->phis[i].args = &s->phiArgs[j];
+        j += s->blocks[s->phis[i].block].npreds;
+    }
+    for (i = 0; i < nargs; i++)
+        s->phiArgs[i] = SSA_NONE;
+    status = 0;
+done:
+    free(global);
+    free(killed);
+    free(defFirst);
+    free(defBlocks);
+    free(work);
+    free(inWork);
+    free(hasPhi);
+    return status;
+}
+
+/**
+ * @brief Novo valor SSA
+ */
+static uint32_t newValue(SsaFunc* s, SsaDefKind kind, uint32_t at, uint32_t var) {
+    uint32_t v = s->nvalues++;
+    s->defKind[v] = (uint8_t)kind;
+    s->defAt[v] = at;
+    s->valueVar[v] = var;
+    return v;
+}
+
+/**
+ * @brief Renomeia um bloco: phis, leituras e definicoes, e os argumentos dos phis dos sucessores
+ * @param s Funcao
+ * @param b Bloco
+ * @param cur Valor atual de cada variavel
+ * @param logVar Variaveis alteradas (para desfazer ao sair do bloco)
+ * @param logOld Valor anterior de cada variavel alterada
+ * @param nlog Tamanho do log
+ */
+static void renameBlock(SsaFunc* s, uint32_t b, uint32_t* cur, uint32_t* logVar, uint32_t* logOld, uint32_t* nlog) {
+    const IrInstr* code = s->unit->code;
+    const SsaBlock* blk = &s->blocks[b];
+    uint32_t p, i, k, v;
+
+    for (p = blk->phiFirst; p != SSA_NONE; p = s->phis[p].next) {
+        v = s->phis[p].var;
+        logVar[*nlog] = v;
+        logOld[(*nlog)++] = cur[v];
+        cur[v] = s->phis[p].dest;
+    }
+    for (i = blk->first; i < blk->end; i++) {
+        const IrInstr* in = &code[i];
+        if (in->op == IR_STORE && (v = varOf(s, in->kd, in->d)) != SSA_NONE)
+            s->useVal[3 * i] = cur[v];
+        if ((v = varOf(s, in->ka, in->a)) != SSA_NONE)
+            s->useVal[3 * i + 1] = cur[v];
+        if ((v = varOf(s, in->kb, in->b)) != SSA_NONE)
+            s->useVal[3 * i + 2] = cur[v];
+        if (definesVar(in->op) && (v = varOf(s, in->kd, in->d)) != SSA_NONE) {
+            logVar[*nlog] = v;
+            logOld[(*nlog)++] = cur[v];
+            cur[v] = s->defVal[i] = newValue(s, SSA_DEF_INSTR, i, v);
+        }
+    }
+    for (k = 0; k < blk->nsuccs; k++) {
+        uint32_t t = blk->succ[k];
+        if (t == SSA_NONE)
+            continue;
+        for (p = s->blocks[t].phiFirst; p != SSA_NONE; p = s->phis[p].next)
+            s->phis[p].args[blk->succPred[k]] = cur[s->phis[p].var];
+    }
+}
+
+/**
+ * @brief Renomeia em pre-ordem na arvore de dominadores
+ * @param s Funcao
+ * @return 0 em sucesso, -1 sem memoria
+ */
+static int renameAll(SsaFunc* s) {
+    uint32_t n = s->unit->rec.count;
+    uint32_t* childFirst = (uint32_t*)zalloc(s->nblocks + 1, sizeof(uint32_t));
+    uint32_t* children = (uint32_t*)zalloc(s->nblocks, sizeof(uint32_t));
+    uint32_t* cur = (uint32_t*)zalloc(s->nvars, sizeof(uint32_t));
+    uint32_t* logVar = (uint32_t*)zalloc(s->nphis + n, sizeof(uint32_t));
+    uint32_t* logOld = (uint32_t*)zalloc(s->nphis + n, sizeof(uint32_t));
+    uint32_t* stack = (uint32_t*)zalloc(3 * s->nblocks, sizeof(uint32_t));
+    uint32_t b, v, i, sp = 0, nlog = 0;
+    int status = -1;
+
+    if (childFirst == NULL || children == NULL || cur == NULL || logVar == NULL || logOld == NULL || stack == NULL)
+        goto done;
+
+    // filhos de cada bloco na arvore de dominadores
+    for (b = 1; b < s->nblocks; b++)
+        if (s->blocks[b].idom != SSA_NONE)
+            childFirst[s->blocks[b].idom + 1]++;
+    for (b = 0; b < s->nblocks; b++)
+        childFirst[b + 1] += childFirst[b];
+    for (b = 0; b < s->nblocks; b++)
+        stack[b] = childFirst[b];
+    for (b = 1; b < s->nblocks; b++)
+        if (s->blocks[b].idom != SSA_NONE)
+            children[stack[s->blocks[b].idom]++] = b;
+
+    for (v = 0; v < s->nvars; v++)
+        cur[v] = v;
+    for (i = 0; i < s->nphis; i++)
+        s->phis[i].dest = newValue(s, SSA_DEF_PHI, i, s->phis[i].var);
+
+    // pilha de (bloco, tamanho do log na entrada, proximo filho)
+    renameBlock(s, 0, cur, logVar, logOld, &nlog);
+    stack[0] = 0;
+    stack[1] = 0;
+    stack[2] = childFirst[0];
+    sp = 1;
+    while (sp > 0) {
+        uint32_t* top = &stack[3 * (sp - 1)];
+        if (top[2] < childFirst[top[0] + 1]) {
+            uint32_t c = children[top[2]++];
+            uint32_t* push = &stack[3 * sp++];
+            push[0] = c;
+            push[1] = nlog;
+            push[2] = childFirst[c];
+            renameBlock(s, c, cur, logVar, logOld, &nlog);
+        } else {
+            while (nlog > top[1]) {
+                nlog--;
+                cur[logVar[nlog]] = logOld[nlog];
+            }
+            sp--;
+        }
+    }
+    status = 0;
+done:
+    free(childFirst);
+    free(children);
+    free(cur);
+    free(logVar);
+    free(logOld);
+    free(stack);
+    return status;
+}
+
+/**
+ * @brief Cadeias def-uso: instrucoes e phis que leem cada valor
+ * @param s Funcao
+ * @return 0 em sucesso, -1 sem memoria
+ */
+static int buildUsers(SsaFunc* s) {
+    uint32_t n = s->unit->rec.count;
+    uint32_t* fill;
+    uint32_t i, j, v, pass;
+
+    s->userFirst = (uint32_t*)zalloc(s->nvalues + 1, sizeof(uint32_t));
+    if (s->userFirst == NULL)
+        return -1;
+    for (pass = 0; pass < 2; pass++) {
+        fill = s->userFirst;
+        for (i = 0; i < 3 * n; i++)
+            if ((v = s->useVal[i]) != SSA_NONE) {
+                if (pass == 0)
+                    fill[v + 1]++;
+                else
+                    s->users[fill[v]++] = i / 3;
+            }
+        for (i = 0; i < s->nphis; i++)
+            for (j = 0; j < s->blocks[s->phis[i].block].npreds; j++)
+                if ((v = s->phis[i].args[j]) != SSA_NONE) {
+                    if (pass == 0)
+                        fill[v + 1]++;
+                    else
+                        s->users[fill[v]++] = n + i;
+                }
+        if (pass == 0) {
+            for (v = 0; v < s->nvalues; v++)
+                s->userFirst[v + 1] += s->userFirst[v];
+            s->users = (uint32_t*)zalloc(s->userFirst[s->nvalues], sizeof(uint32_t));
+            if (s->users == NULL)
+                return -1;
+        } else {
+            // o preenchimento avancou cada inicio ate o inicio do seguinte
+            for (v = s->nvalues; v > 0; v--)
+                s->userFirst[v] = s->userFirst[v - 1];
+            s->userFirst[0] = 0;
+        }
+    }
+    return 0;
+}
+
+int ssa_build(SsaFunc* ssa, IrUnit* unit) {
+    uint32_t n = unit->rec.count;
+    uint32_t* rpo = NULL;
+    uint32_t* dfFirst = NULL;
+    uint32_t* df = NULL;
+    uint32_t i, ndefs = 0;
+    int status = -1;
+
+    memset(ssa, 0, sizeof(*ssa));
+    ssa->unit = unit;
+    if (n == 0)
+        return -1;
+    ssa->ntemps = unit->rec.ntemps;
+    ssa->nvars = unit->rec.ntemps + unit->rec.nslots;
+    ssa->tracked = (uint8_t*)zalloc(ssa->nvars, 1);
+    if (ssa->tracked == NULL)
+        goto done;
+    for (i = 0; i < ssa->ntemps; i++)
+        ssa->tracked[i] = 1;
+    for (i = 0; i < unit->rec.nslots; i++)
+        ssa->tracked[ssa->ntemps + i] = unit->slots[i].size == IR_SCALAR;
+
+    if (buildBlocks(ssa) != 0)
+        goto done;
+    rpo = (uint32_t*)zalloc(ssa->nblocks, sizeof(uint32_t));
+    dfFirst = (uint32_t*)zalloc(ssa->nblocks + 1, sizeof(uint32_t));
+    if (rpo == NULL || dfFirst == NULL || buildDominators(ssa, rpo) != 0 ||
+        buildFrontiers(ssa, rpo, dfFirst, &df) != 0 || placePhis(ssa, rpo, dfFirst, df) != 0)
+        goto done;
+
+    for (i = 0; i < n; i++)
+        if (definesVar(unit->code[i].op) && varOf(ssa, unit->code[i].kd, unit->code[i].d) != SSA_NONE)
+            ndefs++;
+    ssa->defKind = (uint8_t*)zalloc(ssa->nvars + ssa->nphis + ndefs, 1);
+    ssa->defAt = (uint32_t*)zalloc(ssa->nvars + ssa->nphis + ndefs, sizeof(uint32_t));
+    ssa->valueVar = (uint32_t*)zalloc(ssa->nvars + ssa->nphis + ndefs, sizeof(uint32_t));
+    ssa->useVal = (uint32_t*)malloc((3 * (size_t)n + 1) * sizeof(uint32_t));
+    ssa->defVal = (uint32_t*)malloc(((size_t)n + 1) * sizeof(uint32_t));
+    if (ssa->defKind == NULL || ssa->defAt == NULL || ssa->valueVar == NULL || ssa->useVal == NULL ||
+        ssa->defVal == NULL)
+        goto done;
+    for (i = 0; i < 3 * n; i++)
+        ssa->useVal[i] = SSA_NONE;
+    for (i = 0; i < n; i++)
+        ssa->defVal[i] = SSA_NONE;
+    for (i = 0; i < ssa->nvars; i++)
+        newValue(ssa, SSA_DEF_ENTRY, SSA_NONE, i);
+
+    if (renameAll(ssa) != 0 || buildUsers(ssa) != 0)
+        goto done;
+    status = 0;
+done:
+    free(rpo);
+    free(dfFirst);
+    free(df);
+    if (status != 0)
+        ssa_free(ssa);
+    return status;
+}
+
+uint32_t ssa_destroy(SsaFunc* ssa) {
+    IrUnit* unit = ssa->unit;
+    uint32_t i, n;
+    for (i = 0, n = 0; i < unit->rec.count; i++)
+        if (unit->code[i].op != IR_NOP)
+            unit->code[n++] = unit->code[i];
+    i = unit->rec.count - n;
+    unit->rec.count = n;
+    return i;
+}
+
+void ssa_free(SsaFunc* ssa) {
+    free(ssa->blocks);
+    free(ssa->preds);
+    free(ssa->blockOf);
+    free(ssa->order);
+    free(ssa->tracked);
+    free(ssa->phis);
+    free(ssa->phiArgs);
+    free(ssa->defKind);
+    free(ssa->defAt);
+    free(ssa->valueVar);
+    free(ssa->useVal);
+    free(ssa->defVal);
+    free(ssa->userFirst);
+    free(ssa->users);
+    memset(ssa, 0, sizeof(*ssa));
+}
@@ -0,0 +1,135 @@
+/**
+ * @file ssa.h
+ * @brief Forma SSA de uma funcao do codigo de tres enderecos (-O2)
+ *
+ * ssa_build() divide a funcao em blocos basicos, calcula os dominadores e
+ * as fronteiras de dominancia, insere phis para os temporarios e as
+ * variaveis locais escalares (semi-podada: so para nomes lidos em um bloco
+ * antes de serem definidos nele) e renomeia cada definicao para um valor
+ * SSA proprio. As instrucoes continuam no IrUnit; a forma SSA fica ao lado,
+ * como o valor lido por cada operando e o valor definido por cada
+ * instrucao, o que permite que um passe reescreva o codigo original.
+ *
+ * Arrays, parametros int[] e globais nao sao renomeados (podem ser
+ * alterados por store ou por chamadas).
+ */
+
+#ifndef _SSA_H_
+#define _SSA_H_
+
+#include "ir.h"
+
+struct OptStats;
+
+// Valor ausente (operando que nao e variavel renomeada) e bloco ausente
+#define SSA_NONE UINT32_MAX
+
+/**
+ * @brief Bloco basico: instrucoes [first, end) sem desvios no meio
+ */
+typedef struct {
+    uint32_t first;
+    uint32_t end;
+    uint32_t succ[2];        // succ[0] = sequencia/goto, succ[1] = label do if_false (SSA_NONE = fim)
+    uint32_t succPred[2];    // posicao deste bloco entre os predecessores de cada sucessor
+    uint32_t nsuccs;
+    uint32_t predFirst;      // predecessores em SsaFunc.preds
+    uint32_t npreds;
+    uint32_t idom;           // dominador imediato (SSA_NONE na entrada e em blocos inalcancaveis)
+    uint32_t phiFirst;       // primeiro phi do bloco (SSA_NONE = nenhum)
+} SsaBlock;
+
+/**
+ * @brief phi: dest = phi(args[0], ..., args[npreds - 1]), um por predecessor
+ */
+typedef struct {
+    uint32_t var;            // variavel original
+    uint32_t dest;           // valor definido
+    uint32_t block;
+    uint32_t next;           // proximo phi do mesmo bloco
+    uint32_t* args;          // na ordem de SsaBlock.predFirst
+} SsaPhi;
+
+// Origem de um valor SSA
+typedef enum {
+    SSA_DEF_ENTRY,           // valor da variavel na entrada (parametro ou nao inicializada)
+    SSA_DEF_PHI,             // definido por um phi
+    SSA_DEF_INSTR            // definido por uma instrucao
+} SsaDefKind;
+
+/**
+ * @brief Funcao em forma SSA
+ *
+ * O bloco 0 e uma entrada vazia que segue para o bloco da primeira
+ * instrucao; assim o primeiro bloco pode ser cabeca de laco e ter phis.
+ * As variaveis sao numeradas com os temporarios primeiro ([0, ntemps)) e
+ * depois os slots locais ([ntemps, ntemps + nslots)). Os valores
+ * [0, nvars) sao os valores de entrada de cada variavel.
+ */
+typedef struct {
+    IrUnit* unit;
+    uint32_t nblocks;
+    SsaBlock* blocks;
+    uint32_t* preds;         // listas de predecessores (SsaBlock.predFirst)
+    uint32_t* blockOf;       // bloco de cada instrucao
+    uint32_t* order;         // blocos alcancaveis em pos-ordem reversa
+    uint32_t nreach;
+    uint32_t ntemps;
+    uint32_t nvars;
+    uint8_t* tracked;        // variavel renomeada (temporario ou local escalar)
+    SsaPhi* phis;
+    uint32_t nphis;
+    uint32_t* phiArgs;       // argumentos de todos os phis
+    uint32_t nvalues;
+    uint8_t* defKind;        // SsaDefKind de cada valor
+    uint32_t* defAt;         // instrucao ou phi que define cada valor
+    uint32_t* valueVar;      // variavel original de cada valor
+    uint32_t* useVal;        // 3 por instrucao: valor lido em d (store), a e b
+    uint32_t* defVal;        // valor definido por cada instrucao (SSA_NONE = nenhum)
+    uint32_t* userFirst;     // usuarios de cada valor em users[userFirst[v] .. userFirst[v + 1])
+    uint32_t* users;         // instrucao i ou phi (count + indice do phi)
+} SsaFunc;
+
+/**
+ * @brief Constroi a forma SSA de uma funcao
+ * @param ssa Estrutura preenchida; liberar com ssa_free()
+ * @param unit Funcao (o codigo nao e alterado)
+ * @return 0 em sucesso, -1 sem memoria ou funcao vazia
+ */
+int ssa_build(SsaFunc* ssa, IrUnit* unit);
+
+/**
+ * @brief Sai da forma SSA e compacta o codigo
+ *
+ * Como os passes sobre a SSA so trocam leituras por constantes e removem
+ * instrucoes (nenhum valor muda de lugar), as versoes de uma variavel nao
+ * tem vidas sobrepostas: cada valor volta a ser a variavel original e os
+ * phis sao descartados sem copias. Instrucoes marcadas como IR_NOP saem
+ * do codigo.
+ *
+ * @param ssa Funcao em forma SSA
+ * @return Numero de instrucoes removidas
+ */
+uint32_t ssa_destroy(SsaFunc* ssa);
+
+/**
+ * @brief Libera a forma SSA
+ * @param ssa Funcao
+ */
+void ssa_free(SsaFunc* ssa);
+
+/**
+ * @brief Propagacao condicional esparsa de constantes (SCCP)
+ *
+ * Constroi a SSA, propaga constantes apenas pelos caminhos executaveis,
+ * troca por constantes as leituras de valores constantes, resolve os
+ * if_false de condicao constante, remove os blocos nunca executados e
+ * volta para o codigo de tres enderecos.
+ *
+ * @param unit Funcao
+ * @param stats Contadores somados de forma atomica (NULL = nao conta)
+ * @return Numero de instrucoes removidas
+ */
+uint32_t ssa_sccp(IrUnit* unit, struct OptStats* stats);
+
+#endif
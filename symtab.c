@@ -8,9 +8,6 @@
 #include <stdlib.h>
 #include <string.h>
 
-static ScopeList scopeStack = NULL;
-static ScopeList allScopes = NULL;
-
 /**
  * @brief Funcao hash
  * @param key String que sera convertida em indice
@@ -28,45 +25,48 @@ static int hash(char* key) {
 
 /**
  * @brief Empilha um novo escopo
+ * @param ctx Contexto da compilacao
  * @param scopeName Nome do escopo (funcao ou bloco)
  * @return Ponteiro para o novo escopo criado
  */
-ScopeList st_push_scope(char* scopeName) {
+ScopeList st_push_scope(CompilerContext* ctx, char* scopeName) {
     ScopeList newScope = (ScopeList)malloc(sizeof(struct ScopeListRec));
     int i;
     if (newScope == NULL) {
-        fprintf(stderr, "Erro de alocacao de memoria para novo escopo\n");
+        fprintf(ctx->errors, "Erro de alocacao de memoria para novo escopo\n");
         return NULL;
     }
     newScope->scopeName = scopeName;
     for (i = 0; i < SIZE; i++)
         newScope->hashTable[i] = NULL;
-    newScope->parent = scopeStack;
-    newScope->nestedLevel = (scopeStack == NULL) ? 0 : scopeStack->nestedLevel + 1;
-    newScope->next = allScopes;
-    allScopes = newScope;
-    scopeStack = newScope;
+    newScope->parent = ctx->scopeStack;
+    newScope->nestedLevel = (ctx->scopeStack == NULL) ? 0 : ctx->scopeStack->nestedLevel + 1;
+    newScope->next = ctx->allScopes;
+    ctx->allScopes = newScope;
+    ctx->scopeStack = newScope;
     return newScope;
 }
 
 /**
  * @brief Desempilha o escopo atual
+ * @param ctx Contexto da compilacao
  */
-void st_pop_scope(void) {
-    if (scopeStack != NULL) {
-        scopeStack = scopeStack->parent;
+void st_pop_scope(CompilerContext* ctx) {
+    if (ctx->scopeStack != NULL) {
+        ctx->scopeStack = ctx->scopeStack->parent;
     }
 }
 
 /**
  * @brief Entra em um escopo existente sem criar novo
+ * @param ctx Contexto da compilacao
  * @param scopeName Nome do escopo a entrar
  */
-void st_enter_scope(char* scopeName) {
-    ScopeList scope = allScopes;
+void st_enter_scope(CompilerContext* ctx, char* scopeName) {
+    ScopeList scope = ctx->allScopes;
     while (scope != NULL) {
-        if (strcmp(scope->scopeName, scopeName) == 0 && scope->parent == scopeStack) {
-            scopeStack = scope;
+        if (strcmp(scope->scopeName, scopeName) == 0 && scope->parent == ctx->scopeStack) {
+            ctx->scopeStack = scope;
             return;
         }
         scope = scope->next;
@@ -75,61 +75,63 @@ void st_enter_scope(char* scopeName) {
 
 /**
  * @brief Insere um simbolo no escopo atual
+ * @param ctx Contexto da compilacao
  * @param name Nome do identificador
  * @param type Tipo do identificador
  * @param lineno Linha de declaracao
  * @param memloc Localizacao na memoria
  */
-void st_insert(char* name, ExpType type, int lineno, int memloc) {
+void st_insert(CompilerContext* ctx, char* name, ExpType type, int lineno, int memloc) {
     int h;
     BucketList l;
-    if (scopeStack == NULL) {
-        fprintf(stderr, "Erro: nenhum escopo ativo para inserir simbolo\n");
+    if (ctx->scopeStack == NULL) {
+        fprintf(ctx->errors, "Erro: nenhum escopo ativo para inserir simbolo\n");
         return;
     }
     h = hash(name);
-    l = scopeStack->hashTable[h];
+    l = ctx->scopeStack->hashTable[h];
     while ((l != NULL) && (strcmp(name, l->name) != 0))
         l = l->next;
     if (l == NULL) {
         l = (BucketList)malloc(sizeof(struct BucketListRec));
         if (l == NULL) {
-            fprintf(stderr, "Erro de alocacao de memoria na insercao de simbolo\n");
+            fprintf(ctx->errors, "Erro de alocacao de memoria na insercao de simbolo\n");
             return;
         }
         l->name = name;
         l->type = type;
         l->lines = (LineList)malloc(sizeof(struct LineListRec));
         if (l->lines == NULL) {
-            fprintf(stderr, "Erro de alocacao de memoria para linha\n");
+            fprintf(ctx->errors, "Erro de alocacao de memoria para linha\n");
             return;
         }
         l->lines->lineno = lineno;
         l->memloc = memloc;
         l->lines->next = NULL;
-        l->next = scopeStack->hashTable[h];
-        scopeStack->hashTable[h] = l;
+        l->lastLine = l->lines;
+        l->next = ctx->scopeStack->hashTable[h];
+        ctx->scopeStack->hashTable[h] = l;
     } else {
-        LineList t = l->lines;
-        while (t->next != NULL)
-            t = t->next;
+        LineList t = l->lastLine;
         t->next = (LineList)malloc(sizeof(struct LineListRec));
         if (t->next == NULL) {
-            fprintf(stderr, "Erro de alocacao de memoria para linha\n");
+            fprintf(ctx->errors, "Erro de alocacao de memoria para linha\n");
             return;
         }
         t->next->lineno = lineno;
         t->next->next = NULL;
+        l->lastLine = t->next;
     }
 }
 
 /**
  * @brief Busca um simbolo em todos os escopos (do atual ate o global)
+ * @param ctx Contexto da compilacao
  * @param name Nome do identificador
  * @return Ponteiro para o bucket ou NULL se nao encontrado
  */
-BucketList st_lookup(char* name) {
-    ScopeList scope = scopeStack;
+BucketList st_lookup(CompilerContext* ctx, char* name) {
+    ScopeList scope = ctx->scopeStack;
     int h = hash(name);
     
     // Primeiro busca na pilha de escopos ativos
@@ -144,10 +146,10 @@ BucketList st_lookup(char* name) {
     
     // Se nao encontrou, busca em todos os escopos preservados
     // Isso e necessario durante typeCheck quando escopos sao recriados
-    scope = allScopes;
+    scope = ctx->allScopes;
     while (scope != NULL) {
         // Verifica se este escopo tem o nome correspondente ao escopo atual
-        if (scopeStack != NULL && strcmp(scope->scopeName, scopeStack->scopeName) == 0) {
+        if (ctx->scopeStack != NULL && strcmp(scope->scopeName, ctx->scopeStack->scopeName) == 0) {
             BucketList l = scope->hashTable[h];
             while ((l != NULL) && (strcmp(name, l->name) != 0))
                 l = l->next;
@@ -162,16 +164,17 @@ BucketList st_lookup(char* name) {
 
 /**
  * @brief Busca um simbolo apenas no escopo atual
+ * @param ctx Contexto da compilacao
  * @param name Nome do identificador
  * @return Ponteiro para o bucket ou NULL se nao encontrado
  */
-BucketList st_lookup_top(char* name) {
+BucketList st_lookup_top(CompilerContext* ctx, char* name) {
     int h;
     BucketList l;
-    if (scopeStack == NULL)
+    if (ctx->scopeStack == NULL)
         return NULL;
     h = hash(name);
-    l = scopeStack->hashTable[h];
+    l = ctx->scopeStack->hashTable[h];
     while ((l != NULL) && (strcmp(name, l->name) != 0))
         l = l->next;
     return l;
@@ -179,14 +182,15 @@ BucketList st_lookup_top(char* name) {
 
 /**
  * @brief Imprime a tabela de simbolos completa
+ * @param ctx Contexto da compilacao
  */
-void printSymTab(void) {
-    ScopeList scope = allScopes;
+void printSymTab(CompilerContext* ctx) {
+    ScopeList scope = ctx->allScopes;
     int i;
     while (scope != NULL) {
-        printf("\nEscopo: %s (nivel %d)\n", scope->scopeName, scope->nestedLevel); // nivel pra funcs externas e shadowing
-        printf("%-15s %-10s %-10s %-15s\n", "Nome", "Tipo", "MemLoc", "Linhas");
-        printf("*******************************************************\n");
+        fprintf(ctx->listing, "\nEscopo: %s (nivel %d)\n", scope->scopeName, scope->nestedLevel); // nivel pra funcs externas e shadowing
+        fprintf(ctx->listing, "%-15s %-10s %-10s %-15s\n", "Nome", "Tipo", "MemLoc", "Linhas");
+        fprintf(ctx->listing, "*******************************************************\n");
         for (i = 0; i < SIZE; i++) {
             if (scope->hashTable[i] != NULL) {
                 BucketList l = scope->hashTable[i];
@@ -210,17 +214,92 @@ void printSymTab(void) {
                             typeStr = "unknown";
                             break;
                     }
-                    printf("%-15s %-10s %-10d ", l->name, typeStr, l->memloc);
+                    fprintf(ctx->listing, "%-15s %-10s %-10d ", l->name, typeStr, l->memloc);
                     while (t != NULL) {
-                        printf("%d ", t->lineno);
+                        fprintf(ctx->listing, "%d ", t->lineno);
                         t = t->next;
                     }
-                    printf("\n");
+                    fprintf(ctx->listing, "\n");
                     l = l->next;
                 }
             }
         }
         scope = scope->next;
     }
-    printf("\n*******************************************************\n\n");
+    fprintf(ctx->listing, "\n*******************************************************\n\n");
+}
+
+/**
+ * @brief Libera os simbolos de um escopo e o proprio escopo
+ * @param scope Escopo
+ */
+static void freeScope(ScopeList scope) {
+    int i;
+    for (i = 0; i < SIZE; i++) {
+        BucketList l = scope->hashTable[i];
+        while (l != NULL) {
+            BucketList nextBucket = l->next;
+            LineList t = l->lines;
+            while (t != NULL) {
+                LineList nextLine = t->next;
+                free(t);
+                t = nextLine;
+            }
+            free(l); // nomes pertencem a AST
+            l = nextBucket;
+        }
+    }
+    free(scope);
+}
+
+/**
+ * @brief Conta os simbolos de todos os escopos criados
+ * @param ctx Contexto da compilacao
+ * @return Numero de simbolos
+ */
+long st_count(CompilerContext* ctx) {
+    ScopeList scope;
+    long n = 0;
+    int i;
+    for (scope = ctx->allScopes; scope != NULL; scope = scope->next) {
+        for (i = 0; i < SIZE; i++) {
+            BucketList l;
+            for (l = scope->hashTable[i]; l != NULL; l = l->next)
+                n++;
+        }
+    }
+    return n;
+}
+
+/**
+ * @brief Libera um escopo que nao esta mais na pilha (modo streaming)
+ * @param ctx Contexto da compilacao
+ * @param scopeName Nome do escopo (o mais recente com esse nome e liberado)
+ */
+void st_free_scope(CompilerContext* ctx, char* scopeName) {
+    ScopeList* link = &ctx->allScopes;
+    while (*link != NULL) {
+        ScopeList scope = *link;
+        if (scope != ctx->scopeStack && strcmp(scope->scopeName, scopeName) == 0) {
+            *link = scope->next;
+            freeScope(scope);
+            return;
+        }
+        link = &scope->next;
+    }
+}
+
+/**
+ * @brief Libera todos os escopos e simbolos da compilacao
+ * @param ctx Contexto da compilacao
+ */
+void st_free(CompilerContext* ctx) {
+    ScopeList scope = ctx->allScopes;
+    while (scope != NULL) {
+        ScopeList next = scope->next;
+        freeScope(scope);
+        scope = next;
+    }
+    ctx->allScopes = NULL;
+    ctx->scopeStack = NULL;
 }
@@ -18,6 +18,7 @@ typedef struct LineListRec {
 typedef struct BucketListRec {
     char* name;
     LineList lines;
+    LineList lastLine;       // fim de 'lines' (insercao em tempo constante)
     int memloc;
     ExpType type;
     struct BucketListRec* next;
@@ -33,48 +34,75 @@ typedef struct ScopeListRec {
 
 /**
  * @brief Empilha um novo escopo
+ * @param ctx Contexto da compilacao
  * @param scopeName Nome do escopo (funcao ou bloco)
  * @return Ponteiro para o novo escopo criado
  */
-ScopeList st_push_scope(char* scopeName);
+ScopeList st_push_scope(CompilerContext* ctx, char* scopeName);
 
 /**
  * @brief Desempilha o escopo atual
+ * @param ctx Contexto da compilacao
  */
-void st_pop_scope(void);
+void st_pop_scope(CompilerContext* ctx);
 
 /**
  * @brief Insere um simbolo no escopo atual
+ * @param ctx Contexto da compilacao
  * @param name Nome do identificador
  * @param type Tipo do identificador
  * @param lineno Linha de declaracao
  * @param memloc Localizacao na memoria
  */
-void st_insert(char* name, ExpType type, int lineno, int memloc);
+void st_insert(CompilerContext* ctx, char* name, ExpType type, int lineno, int memloc);
 
 /**
  * @brief Busca um simbolo em todos os escopos (do atual ate o global)
+ * @param ctx Contexto da compilacao
  * @param name Nome do identificador
  * @return Ponteiro para o bucket ou NULL se nao encontrado
  */
-BucketList st_lookup(char* name);
+BucketList st_lookup(CompilerContext* ctx, char* name);
 
 /**
  * @brief Busca um simbolo apenas no escopo atual
+ * @param ctx Contexto da compilacao
  * @param name Nome do identificador
  * @return Ponteiro para o bucket ou NULL se nao encontrado
  */
-BucketList st_lookup_top(char* name);
+BucketList st_lookup_top(CompilerContext* ctx, char* name);
 
 /**
  * @brief Entra em um escopo existente sem criar novo
+ * @param ctx Contexto da compilacao
  * @param scopeName Nome do escopo a entrar
  */
-void st_enter_scope(char* scopeName);
+void st_enter_scope(CompilerContext* ctx, char* scopeName);
 
 /**
  * @brief Imprime a tabela de simbolos completa
+ * @param ctx Contexto da compilacao
  */
-void printSymTab(void);
+void printSymTab(CompilerContext* ctx);
+
+/**
+ * @brief Conta os simbolos de todos os escopos criados
+ * @param ctx Contexto da compilacao
+ * @return Numero de simbolos
+ */
+long st_count(CompilerContext* ctx);
+
+/**
+ * @brief Libera um escopo que nao esta mais na pilha (modo streaming)
+ * @param ctx Contexto da compilacao
+ * @param scopeName Nome do escopo (o mais recente com esse nome e liberado)
+ */
+void st_free_scope(CompilerContext* ctx, char* scopeName);
+
+/**
+ * @brief Libera todos os escopos e simbolos da compilacao
+ * @param ctx Contexto da compilacao
+ */
+void st_free(CompilerContext* ctx);
 
 #endif
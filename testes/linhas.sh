@@ -0,0 +1,53 @@
+#!/bin/sh
+# perfil por linha: --hot-lines e --stacks de um programa com recursao, em -O0
+# e em -O2, e o relatorio de uma execucao interrompida por erro
+CMINUS=${CMINUS:-./cminus}
+CMVM=${CMVM:-./cmvm}
+dir=`mktemp -d` || exit 1
+trap 'rm -rf "$dir"' EXIT
+
+cat > "$dir/p.cm" <<'FIM'
+/* recursao e chamadas em pilhas diferentes */
+int fib(int n) {
+    if (n < 2)
+        return n;
+    return fib(n - 1) + fib(n - 2);
+}
+
+int soma(int a[], int n) {
+    int i;
+    int s;
+    i = 0;
+    s = 0;
+    while (i < n) {
+        s = s + a[i] / (n - 3);
+        i = i + 1;
+    }
+    return s;
+}
+
+void main(void) {
+    int v[5];
+    int i;
+    int n;
+    n = input();
+    i = 0;
+    while (i < 5) {
+        v[i] = fib(i + 5);
+        i = i + 1;
+    }
+    output(soma(v, n));
+    output(fib(n));
+}
+FIM
+
+for O in -O0 -O2; do
+    echo "== $O"
+    $CMINUS $O -o "$dir/p.cmir" "$dir/p.cm" > /dev/null || exit 1
+    echo 5 | $CMVM --hot-lines --stacks "$dir/p.stk" "$dir/p.cmir" 2>&1 | sed "s|$dir/||"
+    cat "$dir/p.stk"
+done
+
+echo "== erro de execucao"
+echo 3 | $CMVM --hot-lines "$dir/p.cmir" 2>&1
+echo "saida: $?"
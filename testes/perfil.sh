@@ -0,0 +1,57 @@
+#!/bin/sh
+# perfil de ponta a ponta: --profile-generate, duas execucoes somadas pelo
+# cmvm --profile, --profile-use (contadores do --opt-stats) e um perfil
+# desatualizado
+CMINUS=${CMINUS:-./cminus}
+CMVM=${CMVM:-./cmvm}
+dir=`mktemp -d` || exit 1
+trap 'rm -rf "$dir"' EXIT
+
+cat > "$dir/p.cm" <<'FIM'
+/* laco quente com um ramo frio, laco curto e funcao pequena chamada no laco */
+int quad(int x) {
+    return x * x;
+}
+
+void main(void) {
+    int i;
+    int j;
+    int s;
+    int n;
+    int m;
+    n = input();
+    s = 0;
+    i = 0;
+    while (i < n) {
+        if (i > 100000)
+            s = s + 7;
+        else
+            s = s + quad(i - i / 10 * 10);
+        m = i - i / 2 * 2;
+        j = 0;
+        while (j < m) {
+            s = s + 1;
+            j = j + 1;
+        }
+        i = i + 1;
+    }
+    output(s);
+}
+FIM
+
+echo "== --profile-generate"
+$CMINUS --profile-generate -o "$dir/g.cmir" "$dir/p.cm" > /dev/null || exit 1
+echo 3000 | $CMVM --profile "$dir/p.perfil" "$dir/g.cmir" 2>&1 | sed "s|$dir/||"
+echo 3000 | $CMVM --profile "$dir/p.perfil" "$dir/g.cmir" 2>&1 | sed "s|$dir/||"
+
+echo "== --profile-use"
+$CMINUS -O2 --opt-stats --profile-use "$dir/p.perfil" -o "$dir/u.cmir" "$dir/p.cm" 2>&1 > /dev/null |
+    grep -E '^Perfil|linha'
+echo 3000 | $CMVM "$dir/u.cmir"
+
+echo "== perfil desatualizado"
+sed 's/return x \* x;/return x * x + 1;/' "$dir/p.cm" > "$dir/q.cm"
+cp "$dir/q.cm" "$dir/p.cm"
+$CMINUS -O2 --opt-stats --profile-use "$dir/p.perfil" -o "$dir/u.cmir" "$dir/p.cm" 2>&1 > /dev/null |
+    grep -E '^Perfil|^Aviso'
+echo 3000 | $CMVM "$dir/u.cmir"
@@ -0,0 +1,477 @@
+/**
+ * @file tokens.c
+ * @brief Implementacao do vetor de tokens produzido antes do parser
+ */
+
+#include "tokens.h"
+#include <stdlib.h>
+
+/**
+ * @brief Pedaco do fonte lido em paralelo
+ */
+typedef struct TokenChunk {
+    TokenStream* stream;
+    const char* start;        // inicio do pedaco (inicio de linha)
+    const char* end;          // fim do pedaco (depois de uma quebra de linha)
+    long lines;               // quebras de linha no pedaco
+    const char* open;         // comecando fora de comentario, comentario aberto no fim (ou NULL)
+    const char* close;        // comecando dentro de comentario, fim dele (NULL = nao fecha)
+    long linesBeforeClose;    // quebras de linha antes de close
+    const char* openAfterClose; // depois de close, comentario aberto no fim (ou NULL)
+    const char* lexStart;     // onde a leitura comeca
+    const char* lexEnd;       // onde a leitura termina (antes de um comentario que segue no proximo pedaco)
+    int lexLine;              // linha em lexStart
+    int last;                 // ultimo pedaco (seguido dos dois '\0' do fonte)
+    int ready;                // leitura concluida e aguardada
+    PoolGroup group;
+    TokenStream tokens;       // tokens do pedaco (lidos de uma vez)
+    FastLexer fast;
+} TokenChunk;
+
+/**
+ * @brief Aloca os vetores de tokens
+ * @param ts Vetor de tokens
+ * @param cap Capacidade
+ * @return 0 se sucesso, -1 se erro
+ */
+static int growTokens(TokenStream* ts, size_t cap) {
+    short* kind = (short*)realloc(ts->kind, cap * sizeof(short));
+    int* line;
+    YYSTYPE* value;
+    if (kind == NULL)
+        return -1;
+    ts->kind = kind;
+    line = (int*)realloc(ts->line, cap * sizeof(int));
+    if (line == NULL)
+        return -1;
+    ts->line = line;
+    value = (YYSTYPE*)realloc(ts->value, cap * sizeof(YYSTYPE));
+    if (value == NULL)
+        return -1;
+    ts->value = value;
+    ts->cap = cap;
+    return 0;
+}
+
+/**
+ * @brief Retira as mensagens de erro lexico escritas desde a ultima chamada
+ * @param ts Vetor de tokens
+ * @return Mensagens alocadas (liberar com free) ou NULL
+ */
+static char* takeErrors(TokenStream* ts) {
+    char* text;
+    size_t n;
+    fflush(ts->errFile);
+#ifdef _WIN32
+    {
+        long end = ftell(ts->errFile);
+        n = end > (long)ts->errRead ? (size_t)end - ts->errRead : 0;
+        text = (char*)malloc(n + 1);
+        if (text == NULL)
+            return NULL;
+        fseek(ts->errFile, (long)ts->errRead, SEEK_SET);
+        n = fread(text, 1, n, ts->errFile);
+        fseek(ts->errFile, 0, SEEK_END);
+    }
+#else
+    n = ts->errSize - ts->errRead;
+    text = (char*)malloc(n + 1);
+    if (text == NULL)
+        return NULL;
+    memcpy(text, ts->errData + ts->errRead, n);
+#endif
+    text[n] = '\0';
+    ts->errRead += n;
+    return text;
+}
+
+/**
+ * @brief Le um token do scanner para a posicao i do vetor
+ * @param ts Vetor de tokens
+ * @param i Posicao
+ * @return Codigo do token
+ */
+static int pushToken(TokenStream* ts, size_t i) {
+    YYSTYPE value;
+    int token = ts->scan(&value, &ts->lex);
+    if (token == ERROR)
+        value.name = takeErrors(ts);
+    ts->kind[i] = (short)token;
+    ts->line[i] = ts->lex.lineno;
+    ts->value[i] = value;
+    return token;
+}
+
+/**
+ * @brief Le todos os tokens na thread atual
+ * @param ts Vetor de tokens
+ */
+static void produceAll(TokenStream* ts) {
+    size_t n = 0;
+    int token;
+    do {
+        if (n == ts->cap && growTokens(ts, ts->cap * 2) != 0) {
+            // sem memoria: o ultimo token vira um erro e a leitura termina
+            fprintf(ts->lex.errors, "Erro: memoria insuficiente para os tokens\n");
+            if (ts->kind[n - 1] == ID || ts->kind[n - 1] == ERROR)
+                free(ts->value[n - 1].name);
+            ts->kind[n - 1] = ERROR;
+            ts->value[n - 1].name = takeErrors(ts);
+            break;
+        }
+        token = pushToken(ts, n++);
+    } while (token != 0);
+    ts->head = n;
+    ts->readHead = n;
+    ts->done = TRUE;
+}
+
+/**
+ * @brief Thread do scanner: preenche o anel em lotes
+ * @param arg Vetor de tokens
+ * @return NULL
+ */
+static void* produceRing(void* arg) {
+    TokenStream* ts = (TokenStream*)arg;
+    size_t head = 0;
+    size_t tail = 0;
+    int stop = FALSE;
+    int token;
+    do {
+        if (head - tail == ts->cap) {
+            // anel cheio: publica o que ja leu e espera o parser
+            pthread_mutex_lock(&ts->lock);
+            ts->head = head;
+            pthread_cond_broadcast(&ts->cond);
+            while (ts->tail + ts->cap == head && !ts->stop)
+                pthread_cond_wait(&ts->cond, &ts->lock);
+            tail = ts->tail;
+            stop = ts->stop;
+            pthread_mutex_unlock(&ts->lock);
+            if (stop)
+                break;
+        }
+        token = pushToken(ts, head & ts->mask);
+        head++;
+        if (head % TOKENS_BATCH == 0 && token != 0) {
+            pthread_mutex_lock(&ts->lock);
+            ts->head = head;
+            tail = ts->tail;
+            stop = ts->stop;
+            pthread_cond_broadcast(&ts->cond);
+            pthread_mutex_unlock(&ts->lock);
+        }
+    } while (token != 0 && !stop);
+    pthread_mutex_lock(&ts->lock);
+    ts->head = head;
+    ts->done = TRUE;
+    pthread_cond_broadcast(&ts->cond);
+    pthread_mutex_unlock(&ts->lock);
+    return NULL;
+}
+
+/**
+ * @brief Conta as quebras de linha de um trecho
+ * @param p Inicio
+ * @param end Fim
+ * @return Numero de quebras de linha
+ */
+static long countLines(const char* p, const char* end) {
+    long n = 0;
+    while ((p = (const char*)memchr(p, '\n', (size_t)(end - p))) != NULL) {
+        n++;
+        p++;
+    }
+    return n;
+}
+
+/**
+ * @brief Procura o fim de um comentario
+ * @param p Primeiro byte dentro do comentario
+ * @param end Fim do trecho
+ * @return Byte depois do fechamento ou NULL se nao fecha no trecho
+ */
+static const char* commentEnd(const char* p, const char* end) {
+    while ((p = (const char*)memchr(p, '*', (size_t)(end - p))) != NULL) {
+        if (p + 1 < end && p[1] == '/')
+            return p + 2;
+        p++;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Procura um comentario que fica aberto no fim de um trecho
+ *
+ * Fora de comentario, toda "/" seguida de "*" abre um comentario: nenhum
+ * outro token contem esses caracteres.
+ *
+ * @param p Inicio (fora de comentario)
+ * @param end Fim do trecho
+ * @return Abertura do comentario que nao fecha no trecho ou NULL
+ */
+static const char* openComment(const char* p, const char* end) {
+    while ((p = (const char*)memchr(p, '/', (size_t)(end - p))) != NULL) {
+        if (p + 1 < end && p[1] == '*') {
+            const char* q = commentEnd(p + 2, end);
+            if (q == NULL)
+                return p;
+            p = q;
+        } else {
+            p++;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Tarefa da passada previa: linhas e comentarios de um pedaco
+ * @param arg Pedaco
+ */
+static void scanChunk(void* arg) {
+    TokenChunk* c = (TokenChunk*)arg;
+    c->lines = countLines(c->start, c->end);
+    c->open = openComment(c->start, c->end);
+    c->close = commentEnd(c->start, c->end);
+    if (c->close != NULL) {
+        c->linesBeforeClose = countLines(c->start, c->close);
+        c->openAfterClose = openComment(c->close, c->end);
+    }
+}
+
+/**
+ * @brief Tarefa de leitura dos tokens de um pedaco
+ * @param arg Pedaco
+ */
+static void lexChunk(void* arg) {
+    TokenChunk* c = (TokenChunk*)arg;
+    TokenStream* ts = c->stream;
+    CompilerContext base = ts->lex;
+    if (tokens_init(&c->tokens, &base) != 0)
+        return;
+    c->tokens.lex.lineno = c->lexLine;
+    // so o ultimo pedaco termina com os dois '\0' da leitura sem copia
+    c->tokens.lex.scanInPlace = c->last && c->lexEnd == c->end && base.scanInPlace;
+    if (ts->scanner->open(&c->tokens.lex, c->lexStart, (size_t)(c->lexEnd - c->lexStart), &c->fast) != 0)
+        return;
+    tokens_start(&c->tokens, ts->scanner->scan, FALSE);
+    ts->scanner->close(&c->tokens.lex);
+}
+
+/**
+ * @brief Envia a tarefa de um pedaco ao pool (ou executa, se nao couber)
+ * @param ts Vetor de tokens
+ * @param group Grupo da tarefa
+ * @param fn Tarefa
+ * @param c Pedaco
+ */
+static void submitChunk(TokenStream* ts, PoolGroup* group, PoolFn fn, TokenChunk* c) {
+    if (pool_submit(ts->pool, group, fn, c) != 0)
+        fn(c);
+}
+
+/**
+ * @brief Entrega o proximo token da leitura em pedacos
+ * @param ts Vetor de tokens
+ * @param lval Valor semantico do token
+ * @param ctx Contexto da compilacao
+ * @return Codigo do token (0 no fim da entrada)
+ */
+static int nextChunked(TokenStream* ts, YYSTYPE* lval, CompilerContext* ctx) {
+    for (;;) {
+        TokenChunk* c = &ts->chunks[ts->current];
+        int token;
+        if (!c->ready) {
+            pool_wait(ts->pool, &c->group);
+            c->ready = TRUE;
+        }
+        token = tokens_next(&c->tokens, lval, ctx);
+        if (token != 0 || ts->current == ts->nchunks - 1)
+            return token;
+        // fim do pedaco: libera e pede a leitura de mais um
+        tokens_free(&c->tokens);
+        ts->current++;
+        if (ts->submitted < ts->nchunks) {
+            TokenChunk* next = &ts->chunks[ts->submitted++];
+            submitChunk(ts, &next->group, lexChunk, next);
+        }
+    }
+}
+
+int tokens_init(TokenStream* ts, CompilerContext* ctx) {
+    memset(ts, 0, sizeof(*ts));
+    ts->lex = *ctx;
+    ts->lex.tokens = NULL;
+#ifdef _WIN32
+    ts->errFile = tmpfile();
+#else
+    ts->errFile = open_memstream(&ts->errData, &ts->errSize);
+#endif
+    if (ts->errFile == NULL) {
+        fprintf(ctx->errors, "Erro: nao foi possivel criar o vetor de tokens\n");
+        ctx->error = TRUE;
+        return -1;
+    }
+    return 0;
+}
+
+void tokens_start(TokenStream* ts, TokenScanFn scan, int threaded) {
+    ts->scan = scan;
+    ts->lex.errors = ts->errFile;
+    if (threaded && growTokens(ts, TOKENS_RING) == 0) {
+        ts->mask = ts->cap - 1;
+        pthread_mutex_init(&ts->lock, NULL);
+        pthread_cond_init(&ts->cond, NULL);
+        if (pthread_create(&ts->thread, NULL, produceRing, ts) == 0) {
+            ts->threaded = TRUE;
+            return;
+        }
+        pthread_mutex_destroy(&ts->lock);
+        pthread_cond_destroy(&ts->cond);
+    }
+    ts->mask = (size_t)-1;
+    if (ts->cap == 0 && growTokens(ts, 1024) != 0) {
+        // nem o vetor inicial: o parser ve uma entrada vazia
+        ts->done = TRUE;
+        return;
+    }
+    produceAll(ts);
+}
+
+int tokens_start_chunks(TokenStream* ts, const TokenScanner* scanner, const char* src, size_t len, Pool* pool) {
+    const char* end = src + len;
+    const char* p = src;
+    TokenChunk* chunks = (TokenChunk*)calloc(len / TOKENS_CHUNK + 1, sizeof(TokenChunk));
+    PoolGroup group;
+    const char* open = NULL;
+    int line = ts->lex.lineno;
+    int n = 0;
+    int k;
+    if (chunks == NULL)
+        return -1;
+    ts->pool = pool;
+    ts->scanner = scanner;
+    // cada pedaco tem ao menos TOKENS_CHUNK bytes e termina em uma quebra de linha
+    while (p < end) {
+        const char* q = NULL;
+        if ((size_t)(end - p) > TOKENS_CHUNK)
+            q = (const char*)memchr(p + TOKENS_CHUNK, '\n', (size_t)(end - p) - TOKENS_CHUNK);
+        chunks[n].stream = ts;
+        chunks[n].start = p;
+        chunks[n].end = q != NULL ? q + 1 : end;
+        p = chunks[n++].end;
+    }
+    memset(&group, 0, sizeof(group));
+    for (k = 0; k < n; k++)
+        submitChunk(ts, &group, scanChunk, &chunks[k]);
+    pool_wait(pool, &group);
+
+    // linha inicial de cada pedaco e comentarios que cruzam os limites
+    for (k = 0; k < n; k++) {
+        TokenChunk* c = &chunks[k];
+        c->lexStart = c->start;
+        c->lexLine = line;
+        if (open != NULL) {
+            if (c->close == NULL) {
+                c->lexStart = c->end;   // o pedaco inteiro esta no comentario
+            } else {
+                c->lexStart = c->close;
+                c->lexLine = line + (int)c->linesBeforeClose;
+                open = c->openAfterClose;
+            }
+        } else {
+            open = c->open;
+        }
+        // o comentario aberto no fim e pulado pelo proximo pedaco
+        c->lexEnd = open != NULL && open >= c->lexStart ? open : c->end;
+        line += (int)c->lines;
+    }
+    if (open != NULL || n == 0) {
+        // comentario sem fim: o erro depende da leitura sequencial
+        free(chunks);
+        ts->chunks = NULL;
+        return -1;
+    }
+    chunks[n - 1].last = TRUE;
+    ts->chunks = chunks;
+    ts->nchunks = n;
+    ts->window = 2 * pool->nthreads;
+    for (k = 0; k < n && k < ts->window; k++) {
+        ts->submitted++;
+        submitChunk(ts, &chunks[k].group, lexChunk, &chunks[k]);
+    }
+    return 0;
+}
+
+int tokens_next(TokenStream* ts, YYSTYPE* lval, CompilerContext* ctx) {
+    size_t i;
+    int token;
+    if (ts->chunks != NULL)
+        return nextChunked(ts, lval, ctx);
+    if (ts->readTail == ts->readHead) {
+        if (!ts->threaded)
+            return 0;
+        // devolve o espaco consumido e espera o proximo lote
+        pthread_mutex_lock(&ts->lock);
+        ts->tail = ts->readTail;
+        pthread_cond_broadcast(&ts->cond);
+        while (ts->head == ts->readTail && !ts->done)
+            pthread_cond_wait(&ts->cond, &ts->lock);
+        ts->readHead = ts->head;
+        pthread_mutex_unlock(&ts->lock);
+        if (ts->readTail == ts->readHead)
+            return 0;
+    }
+    i = ts->readTail++ & ts->mask;
+    token = ts->kind[i];
+    ctx->lineno = ts->line[i];
+    if (token == ERROR) {
+        if (ts->value[i].name != NULL) {
+            fputs(ts->value[i].name, ctx->errors);
+            free(ts->value[i].name);
+        }
+    } else {
+        *lval = ts->value[i];
+    }
+    return token;
+}
+
+void tokens_free(TokenStream* ts) {
+    size_t k;
+    if (ts->chunks != NULL) {
+        int c;
+        for (c = ts->current; c < ts->submitted; c++) {
+            pool_wait(ts->pool, &ts->chunks[c].group);
+            tokens_free(&ts->chunks[c].tokens);
+        }
+        free(ts->chunks);
+        ts->chunks = NULL;
+    }
+    if (ts->threaded) {
+        pthread_mutex_lock(&ts->lock);
+        ts->stop = TRUE;
+        ts->tail = ts->readTail;
+        pthread_cond_broadcast(&ts->cond);
+        pthread_mutex_unlock(&ts->lock);
+        pthread_join(ts->thread, NULL);
+        pthread_mutex_destroy(&ts->lock);
+        pthread_cond_destroy(&ts->cond);
+    }
+    // nomes e mensagens dos tokens que o parser nao chegou a ler
+    for (k = ts->readTail; k < ts->head; k++) {
+        size_t i = k & ts->mask;
+        if (ts->kind[i] == ID || ts->kind[i] == ERROR)
+            free(ts->value[i].name);
+    }
+    if (ts->errFile != NULL)
+        fclose(ts->errFile);
+    free(ts->errData);
+    free(ts->kind);
+    free(ts->line);
+    free(ts->value);
+    ts->kind = NULL;
+    ts->line = NULL;
+    ts->value = NULL;
+    ts->errData = NULL;
+    ts->errFile = NULL;
+}
@@ -0,0 +1,164 @@
+/**
+ * @file tokens.h
+ * @brief Vetor de tokens produzido antes do parser (scanner e parser separados)
+ *
+ * O scanner preenche um vetor compacto em forma de estrutura de vetores
+ * (codigo, linha e valor de cada token) e o parser consome os tokens dele,
+ * em vez de chamar o scanner a cada token. Arquivos pequenos sao lidos em
+ * uma unica passada antes da analise sintatica; nos grandes o scanner roda
+ * em uma thread propria e o vetor funciona como um anel (pequeno o bastante
+ * para ficar na cache L2), de forma que a leitura do fonte, a analise
+ * lexica e a sintatica se sobrepoem.
+ *
+ * Fontes muito grandes sao divididos em pedacos em inicios de linha, lidos
+ * em paralelo pelo pool de threads. Uma passada previa (tambem paralela)
+ * conta as linhas de cada pedaco e acompanha os comentarios, de forma que
+ * cada pedaco comeca na linha certa e, se comecar dentro de um comentario,
+ * depois do fechamento dele. O parser consome os pedacos em ordem enquanto
+ * os proximos sao lidos.
+ *
+ * As mensagens de erro lexico sao guardadas junto do token ERROR e so sao
+ * impressas quando o parser chega nele, na mesma ordem da analise sob
+ * demanda.
+ */
+
+#ifndef _TOKENS_H_
+#define _TOKENS_H_
+
+#include "globals.h"
+#include "cminus.tab.h"
+#include "lexer.h"
+#include "pool.h"
+#include <pthread.h>
+
+// Fontes a partir deste tamanho sao lidos por uma thread separada (com -j
+// maior que 1; sem threads eles sao lidos sob demanda)
+#define TOKENS_THREAD_MIN (1 << 20)
+
+// Capacidade do anel e tamanho dos lotes publicados pela thread do scanner
+#define TOKENS_RING (1 << 14)
+#define TOKENS_BATCH 1024
+
+// Fontes a partir deste tamanho sao lidos em pedacos paralelos
+#define TOKENS_CHUNKED_MIN (8 << 20)
+#define TOKENS_CHUNK (2 << 20)
+
+/**
+ * @brief Funcao que le o proximo token do scanner
+ */
+typedef int (*TokenScanFn)(YYSTYPE* lval, CompilerContext* ctx);
+
+/**
+ * @brief Scanner usado na leitura em pedacos (um por pedaco)
+ */
+typedef struct {
+    int (*open)(CompilerContext* ctx, const char* src, size_t len, FastLexer* fast);
+    TokenScanFn scan;
+    void (*close)(CompilerContext* ctx);
+} TokenScanner;
+
+struct TokenChunk;
+
+/**
+ * @brief Tokens lidos e ainda nao consumidos pelo parser
+ */
+typedef struct TokenStream {
+    short* kind;              // codigo do token
+    int* line;                // linha do scanner depois do token
+    YYSTYPE* value;           // NUM: val, ID: name, ERROR: mensagem de erro
+    size_t cap;               // capacidade (potencia de 2 com thread)
+    size_t mask;              // indice no anel (todos os bits sem thread)
+    int threaded;             // TRUE se o scanner roda em outra thread
+
+    // leitura em pedacos (NULL nos outros modos)
+    struct TokenChunk* chunks;
+    int nchunks;
+    int current;              // pedaco sendo consumido pelo parser
+    int submitted;            // pedacos ja enviados ao pool
+    int window;               // pedacos lidos a frente do parser
+    Pool* pool;
+    const TokenScanner* scanner;
+
+    // usado so pelo parser (em linha de cache propria)
+    char padRead[64];
+    size_t readHead;          // copia local de head
+    size_t readTail;          // proximo token a entregar
+
+    // compartilhado entre as threads (protegido por lock)
+    char padShared[64];
+    size_t head;              // tokens publicados pelo scanner
+    size_t tail;              // tokens liberados pelo parser
+    int done;                 // o scanner chegou ao fim da entrada
+    int stop;                 // o parser terminou antes do fim
+    pthread_mutex_t lock;
+    pthread_cond_t cond;      // novos tokens ou espaco livre
+    pthread_t thread;
+
+    // usado so pelo scanner
+    char padLex[64];
+    CompilerContext lex;      // contexto do scanner (linha e erros proprios)
+    TokenScanFn scan;
+    FILE* errFile;            // mensagens de erro lexico ainda nao repassadas
+    char* errData;
+    size_t errSize;
+    size_t errRead;
+} TokenStream;
+
+/**
+ * @brief Prepara o vetor de tokens a partir do contexto da compilacao
+ *
+ * Depois desta chamada o scanner deve ser criado sobre ts->lex, e nao sobre
+ * o contexto da compilacao.
+ *
+ * @param ts Vetor de tokens
+ * @param ctx Contexto da compilacao
+ * @return 0 se sucesso, -1 se erro
+ */
+int tokens_init(TokenStream* ts, CompilerContext* ctx);
+
+/**
+ * @brief Comeca a leitura dos tokens
+ *
+ * Sem thread, le todos os tokens antes de retornar.
+ *
+ * @param ts Vetor de tokens
+ * @param scan Funcao do scanner (chamada com ts->lex)
+ * @param threaded TRUE para ler em uma thread separada
+ */
+void tokens_start(TokenStream* ts, TokenScanFn scan, int threaded);
+
+/**
+ * @brief Le o fonte em pedacos paralelos, consumidos em ordem pelo parser
+ *
+ * Usado no lugar de tokens_start; cada pedaco tem o seu proprio scanner e
+ * ts->lex nao e usado. Se um comentario nao termina ate o fim do arquivo,
+ * nada e lido e o chamador deve usar outro modo.
+ *
+ * @param ts Vetor de tokens (preparado com tokens_init)
+ * @param scanner Scanner usado nos pedacos
+ * @param src Codigo fonte
+ * @param len Tamanho do codigo fonte
+ * @param pool Threads da leitura
+ * @return 0 se sucesso, -1 se o fonte deve ser lido sequencialmente
+ */
+int tokens_start_chunks(TokenStream* ts, const TokenScanner* scanner, const char* src, size_t len, Pool* pool);
+
+/**
+ * @brief Entrega o proximo token ao parser
+ * @param ts Vetor de tokens
+ * @param lval Valor semantico do token
+ * @param ctx Contexto da compilacao (recebe a linha e os erros lexicos)
+ * @return Codigo do token (0 no fim da entrada)
+ */
+int tokens_next(TokenStream* ts, YYSTYPE* lval, CompilerContext* ctx);
+
+/**
+ * @brief Para o scanner e libera os tokens nao consumidos
+ *
+ * O scanner criado sobre ts->lex continua valido e deve ser liberado depois.
+ *
+ * @param ts Vetor de tokens
+ */
+void tokens_free(TokenStream* ts);
+
+#endif
@@ -0,0 +1,231 @@
+/**
+ * @file unroll.c
+ * @brief Reconhecimento de lacos com contador (while (i < n) { ...; i = i + 1; })
+ */
+
+#include "unroll.h"
+#include "cminus.tab.h"
+
+/**
+ * @brief Estado da verificacao do corpo
+ */
+typedef struct {
+    const char* counter;
+    const char* limit;       // NULL se o limite e constante
+    int hasCalls;
+    int nodes;
+    int ok;
+} BodyCheck;
+
+/**
+ * @brief Testa se um no e uma variavel escalar (IdK sem indice)
+ */
+static int isScalarId(TreeNode* t) {
+    return t != NULL && t->nodekind == ExpK && t->kind.exp == IdK && t->child[0] == NULL;
+}
+
+/**
+ * @brief Testa se um no e i = i + 1 (ou i = 1 + i)
+ */
+static int isIncrement(TreeNode* t, const char* counter) {
+    TreeNode* value;
+    TreeNode* other;
+    if (t == NULL || t->nodekind != StmtK || t->kind.stmt != AssignK)
+        return FALSE;
+    if (!isScalarId(t->child[0]) || strcmp(t->child[0]->attr.name, counter) != 0)
+        return FALSE;
+    value = t->child[1];
+    if (value == NULL || value->nodekind != ExpK || value->kind.exp != OpK || value->attr.op != MAIS)
+        return FALSE;
+    if (isScalarId(value->child[0]) && strcmp(value->child[0]->attr.name, counter) == 0)
+        other = value->child[1];
+    else if (isScalarId(value->child[1]) && strcmp(value->child[1]->attr.name, counter) == 0)
+        other = value->child[0];
+    else
+        return FALSE;
+    return other != NULL && other->nodekind == ExpK && other->kind.exp == ConstK && other->attr.val == 1;
+}
+
+static void checkList(BodyCheck* bc, TreeNode* t);
+
+/**
+ * @brief Verifica um no do corpo e os seus filhos, contando os nos
+ *
+ * Rejeita declaracoes (cada copia do corpo criaria slots novos e um nome
+ * local poderia esconder o contador) e atribuicoes ao contador ou ao limite.
+ */
+static void checkNode(BodyCheck* bc, TreeNode* t) {
+    int i;
+    bc->nodes++;
+    if (t->nodekind == DeclK) {
+        bc->ok = FALSE;
+        return;
+    }
+    if (t->nodekind == StmtK && t->kind.stmt == AssignK && isScalarId(t->child[0])) {
+        const char* name = t->child[0]->attr.name;
+        if (strcmp(name, bc->counter) == 0 || (bc->limit != NULL && strcmp(name, bc->limit) == 0)) {
+            bc->ok = FALSE;
+            return;
+        }
+    }
+    if (t->nodekind == ExpK && t->kind.exp == CallK)
+        bc->hasCalls = TRUE;
+    for (i = 0; i < MAXCHILDREN; i++)
+        checkList(bc, t->child[i]);
+}
+
+/**
+ * @brief Verifica uma lista de irmaos
+ */
+static void checkList(BodyCheck* bc, TreeNode* t) {
+    for (; t != NULL && bc->ok; t = t->sibling)
+        checkNode(bc, t);
+}
+
+/**
+ * @brief Testa se i = constante
+ */
+static int isConstAssign(TreeNode* t, const char* counter) {
+    return t->nodekind == StmtK && t->kind.stmt == AssignK && isScalarId(t->child[0]) &&
+           strcmp(t->child[0]->attr.name, counter) == 0 && t->child[1] != NULL &&
+           t->child[1]->nodekind == ExpK && t->child[1]->kind.exp == ConstK;
+}
+
+/**
+ * @brief Testa se um statement (ou algum filho) atribui a uma variavel escalar
+ */
+static int assigns(TreeNode* t, const char* name) {
+    TreeNode* c;
+    int i;
+    if (t->nodekind == StmtK && t->kind.stmt == AssignK && isScalarId(t->child[0]) &&
+        strcmp(t->child[0]->attr.name, name) == 0)
+        return TRUE;
+    for (i = 0; i < MAXCHILDREN; i++)
+        for (c = t->child[i]; c != NULL; c = c->sibling)
+            if (assigns(c, name))
+                return TRUE;
+    return FALSE;
+}
+
+/**
+ * @brief Testa se um no e uma folha de uma operacao vetorial: a[i], escalar (exceto i) ou constante
+ */
+static int isVectorLeaf(TreeNode* t, const char* counter) {
+    if (t == NULL || t->nodekind != ExpK)
+        return FALSE;
+    if (t->kind.exp == ConstK)
+        return TRUE;
+    if (t->kind.exp != IdK)
+        return FALSE;
+    if (t->child[0] == NULL)
+        return strcmp(t->attr.name, counter) != 0;
+    return t->child[0]->sibling == NULL && isScalarId(t->child[0]) && strcmp(t->child[0]->attr.name, counter) == 0;
+}
+
+int unroll_factor(int optimize, int requested) {
+    if (requested < 0)
+        return optimize >= 2 ? UNROLL_DEFAULT : 1;
+    if (requested > UNROLL_MAX)
+        return UNROLL_MAX;
+    return requested > 1 ? requested : 1;
+}
+
+int unroll_match(TreeNode* loop, TreeNode* first, UnrollLoop* out) {
+    TreeNode* cond;
+    TreeNode* body;
+    TreeNode* last;
+    TreeNode* stmt;
+    BodyCheck bc;
+    if (loop == NULL || loop->nodekind != StmtK || loop->kind.stmt != WhileK)
+        return FALSE;
+    // condicao: i < n, com n constante ou escalar diferente de i
+    cond = loop->child[0];
+    if (cond == NULL || cond->nodekind != ExpK || cond->kind.exp != OpK || cond->attr.op != MENOR)
+        return FALSE;
+    if (!isScalarId(cond->child[0]) || cond->child[1] == NULL || cond->child[1]->nodekind != ExpK)
+        return FALSE;
+    if (cond->child[1]->kind.exp == IdK) {
+        if (!isScalarId(cond->child[1]) || strcmp(cond->child[1]->attr.name, cond->child[0]->attr.name) == 0)
+            return FALSE;
+    } else if (cond->child[1]->kind.exp != ConstK) {
+        return FALSE;
+    }
+    // corpo: bloco sem declaracoes terminado pelo incremento
+    body = loop->child[1];
+    if (body == NULL || body->nodekind != StmtK || body->kind.stmt != CompoundK ||
+        body->child[0] != NULL || body->child[1] == NULL)
+        return FALSE;
+    for (last = body->child[1]; last->sibling != NULL; last = last->sibling)
+        ;
+    if (!isIncrement(last, cond->child[0]->attr.name))
+        return FALSE;
+    bc.counter = cond->child[0]->attr.name;
+    bc.limit = cond->child[1]->kind.exp == IdK ? cond->child[1]->attr.name : NULL;
+    bc.hasCalls = FALSE;
+    bc.nodes = 0;
+    bc.ok = TRUE;
+    for (stmt = body->child[1]; stmt != last && bc.ok; stmt = stmt->sibling)
+        checkNode(&bc, stmt);
+    if (!bc.ok)
+        return FALSE;
+    bc.nodes += 5; // i = i + 1
+    out->counter = cond->child[0];
+    out->limit = cond->child[1];
+    out->body = body;
+    out->hasCalls = bc.hasCalls;
+    out->nodes = bc.nodes;
+    out->trips = -1;
+    // i = c antes do laco no mesmo bloco, sem outra atribuicao a i ate ele:
+    // numero de iteracoes conhecido
+    if (bc.limit == NULL) {
+        long long init = 0;
+        int known = FALSE;
+        for (stmt = first; stmt != NULL && stmt != loop; stmt = stmt->sibling) {
+            if (isConstAssign(stmt, bc.counter)) {
+                init = stmt->child[1]->attr.val;
+                known = TRUE;
+            } else if (assigns(stmt, bc.counter)) {
+                known = FALSE;
+            }
+        }
+        if (known && stmt == loop)
+            out->trips = out->limit->attr.val > init ? out->limit->attr.val - init : 0;
+    }
+    return TRUE;
+}
+
+int unroll_vector_match(const UnrollLoop* loop, UnrollVector* out) {
+    const char* counter = loop->counter->attr.name;
+    TreeNode* store = loop->body->child[1];
+    TreeNode* value;
+    // exatamente dois statements: a gravacao e o incremento
+    if (store->sibling == NULL || store->sibling->sibling != NULL)
+        return FALSE;
+    if (store->nodekind != StmtK || store->kind.stmt != AssignK || store->child[0] == NULL ||
+        store->child[0]->child[0] == NULL || !isVectorLeaf(store->child[0], counter))
+        return FALSE;
+    value = store->child[1];
+    out->dest = store->child[0];
+    if (isVectorLeaf(value, counter)) {
+        out->src[0] = value;
+        out->src[1] = NULL;
+        out->op = 0;
+        return TRUE;
+    }
+    if (value == NULL || value->nodekind != ExpK || value->kind.exp != OpK)
+        return FALSE;
+    switch (value->attr.op) {
+        case MAIS: case MENOS: case VEZES:
+        case MENOR: case MENORIGUAL: case MAIOR: case MAIORIGUAL: case IGUAL: case DIFERENTE:
+            break;
+        default:
+            // a divisao pode falhar no meio do laco
+            return FALSE;
+    }
+    if (!isVectorLeaf(value->child[0], counter) || !isVectorLeaf(value->child[1], counter))
+        return FALSE;
+    out->src[0] = value->child[0];
+    out->src[1] = value->child[1];
+    out->op = value->attr.op;
+    return TRUE;
+}
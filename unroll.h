@@ -0,0 +1,91 @@
+/**
+ * @file unroll.h
+ * @brief Reconhecimento de lacos com contador para o desenrolamento e a vetorizacao
+ *
+ * Um while e um laco com contador quando tem a forma
+ *
+ *     while (i < n) { ...; i = i + 1; }
+ *
+ * com n constante ou variavel escalar, nenhuma declaracao no corpo e
+ * nenhuma outra atribuicao a i ou a n. A geracao de codigo (cgen.c) emite
+ * o corpo varias vezes por teste da condicao, seguido de um laco de resto
+ * para as iteracoes que sobram, ou o corpo repetido sem teste nenhum
+ * quando o numero de iteracoes e conhecido e pequeno.
+ *
+ * Em -O3, um laco com contador cujo corpo e so c[i] = x op y (x e y sao
+ * a[i], um escalar ou uma constante) vira uma operacao vetorial do
+ * codigo intermediario (IR_VSPAN seguido de IR_VCOPY a IR_VNE).
+ */
+
+#ifndef _UNROLL_H_
+#define _UNROLL_H_
+
+#include "globals.h"
+
+// Fator padrao em -O2 (--unroll muda)
+#define UNROLL_DEFAULT 4
+// Maior fator aceito por --unroll
+#define UNROLL_MAX 16
+// Nos da AST no corpo depois do desenrolamento (limita o crescimento do codigo)
+#define UNROLL_MAX_NODES 256
+// Iteracoes de um laco desenrolado por completo
+#define UNROLL_FULL_TRIPS 16
+
+/**
+ * @brief Laco com contador reconhecido
+ */
+typedef struct {
+    TreeNode* counter;       // IdK do contador na condicao
+    TreeNode* limit;         // ConstK ou IdK do limite na condicao
+    TreeNode* body;          // CompoundK (o incremento e o ultimo statement)
+    int hasCalls;            // o corpo chama funcoes (um limite global pode mudar)
+    int nodes;               // nos da AST no corpo
+    long long trips;         // iteracoes, se o valor inicial e o limite sao constantes (-1 = desconhecido)
+} UnrollLoop;
+
+/**
+ * @brief Corpo de um laco elemento a elemento: d[i] = x op y
+ */
+typedef struct {
+    TreeNode* dest;          // IdK do array gravado
+    TreeNode* src[2];        // a[i], escalar ou constante (src[1] NULL na copia)
+    int op;                  // token do operador (0 = copia)
+} UnrollVector;
+
+/**
+ * @brief Fator de desenrolamento efetivo
+ * @param optimize Nivel de otimizacao
+ * @param requested Fator de --unroll (negativo = padrao do nivel)
+ * @return Fator (1 = nao desenrola)
+ */
+int unroll_factor(int optimize, int requested);
+
+/**
+ * @brief Reconhece um laco com contador
+ *
+ * So olha a forma da AST; quem chama confere se o contador e o limite sao
+ * escalares locais (ou um limite global, quando o corpo nao chama funcoes).
+ *
+ * @param loop No WhileK
+ * @param first Primeiro statement do bloco que contem o laco (NULL = nenhum);
+ *              se o contador recebe uma constante antes do laco e nao muda
+ *              ate ele, o numero de iteracoes fica conhecido
+ * @param out Laco reconhecido
+ * @return TRUE se o laco tem a forma de um laco com contador
+ */
+int unroll_match(TreeNode* loop, TreeNode* first, UnrollLoop* out);
+
+/**
+ * @brief Reconhece um laco com contador que so grava um array elemento a elemento
+ *
+ * Todos os arrays sao indexados pelo proprio contador, entao cada iteracao
+ * le e grava apenas o elemento i e nao ha dependencia entre iteracoes. Quem
+ * chama confere se os nomes indexados sao arrays e os demais, escalares.
+ *
+ * @param loop Laco reconhecido por unroll_match
+ * @param out Corpo reconhecido
+ * @return TRUE se o corpo e d[i] = x, d[i] = x op y (op aritmetico sem divisao ou relacional)
+ */
+int unroll_vector_match(const UnrollLoop* loop, UnrollVector* out);
+
+#endif
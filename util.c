@@ -9,21 +9,22 @@
 
 /**
  * @brief Cria um novo no de statement na AST
+ * @param ctx Contexto da compilacao
  * @param kind Tipo do statement
  * @return Ponteiro para o novo no criado
  */
-TreeNode* newStmtNode(StmtKind kind) {
+TreeNode* newStmtNode(CompilerContext* ctx, StmtKind kind) {
     TreeNode* t = (TreeNode*)malloc(sizeof(TreeNode));
     int i;
     if (t == NULL) {
-        fprintf(stderr, "Erro de alocacao de memoria na linha %d\n", lineno);
+        fprintf(ctx->errors, "Erro de alocacao de memoria na linha %d\n", ctx->lineno);
     } else {
         for (i = 0; i < MAXCHILDREN; i++)
             t->child[i] = NULL;
         t->sibling = NULL;
         t->nodekind = StmtK;
         t->kind.stmt = kind;
-        t->lineno = lineno;
+        t->lineno = ctx->lineno;
         t->type = Void;
     }
     return t;
@@ -31,21 +32,22 @@ TreeNode* newStmtNode(StmtKind kind) {
 
 /**
  * @brief Cria um novo no de expressao na AST
+ * @param ctx Contexto da compilacao
  * @param kind Tipo da expressao
  * @return Ponteiro para o novo no criado
  */
-TreeNode* newExpNode(ExpKind kind) {
+TreeNode* newExpNode(CompilerContext* ctx, ExpKind kind) {
     TreeNode* t = (TreeNode*)malloc(sizeof(TreeNode));
     int i;
     if (t == NULL) {
-        fprintf(stderr, "Erro de alocacao de memoria na linha %d\n", lineno);
+        fprintf(ctx->errors, "Erro de alocacao de memoria na linha %d\n", ctx->lineno);
     } else {
         for (i = 0; i < MAXCHILDREN; i++)
             t->child[i] = NULL;
         t->sibling = NULL;
         t->nodekind = ExpK;
         t->kind.exp = kind;
-        t->lineno = lineno;
+        t->lineno = ctx->lineno;
         t->type = Void;
     }
     return t;
@@ -53,21 +55,22 @@ TreeNode* newExpNode(ExpKind kind) {
 
 /**
  * @brief Cria um novo no de declaracao na AST
+ * @param ctx Contexto da compilacao
  * @param kind Tipo da declaracao
  * @return Ponteiro para o novo no criado
  */
-TreeNode* newDeclNode(DeclKind kind) {
+TreeNode* newDeclNode(CompilerContext* ctx, DeclKind kind) {
     TreeNode* t = (TreeNode*)malloc(sizeof(TreeNode));
     int i;
     if (t == NULL) {
-        fprintf(stderr, "Erro de alocacao de memoria na linha %d\n", lineno);
+        fprintf(ctx->errors, "Erro de alocacao de memoria na linha %d\n", ctx->lineno);
     } else {
         for (i = 0; i < MAXCHILDREN; i++)
             t->child[i] = NULL;
         t->sibling = NULL;
         t->nodekind = DeclK;
         t->kind.decl = kind;
-        t->lineno = lineno;
+        t->lineno = ctx->lineno;
         t->type = Void;
     }
     return t;
@@ -86,157 +89,175 @@ char* copyString(char* s) {
     n = strlen(s) + 1; // +1 para caractere nulo
     t = (char*)malloc(n);
     if (t == NULL) {
-        fprintf(stderr, "Erro de alocacao de memoria na linha %d\n", lineno);
+        fprintf(stderr, "Erro de alocacao de memoria\n");
     } else {
         strcpy(t, s);
     }
     return t;
 }
 
-static int indentno = 0;
+/**
+ * @brief Libera uma AST (nos, irmaos e nomes)
+ * @param tree Raiz da arvore
+ */
+void freeTree(TreeNode* tree) {
+    while (tree != NULL) {
+        TreeNode* next = tree->sibling;
+        int i;
+        for (i = 0; i < MAXCHILDREN; i++)
+            freeTree(tree->child[i]);
+        if (tree->nodekind == DeclK ||
+            (tree->nodekind == ExpK && (tree->kind.exp == IdK || tree->kind.exp == CallK)))
+            free(tree->attr.name);
+        free(tree);
+        tree = next;
+    }
+}
 
-#define INDENT indentno += 4
-#define UNINDENT indentno -= 4
+#define INDENT ctx->indentno += 4
+#define UNINDENT ctx->indentno -= 4
 
 /**
  * @brief Printa espacos para indentacao
+ * @param ctx Contexto da compilacao
  */
-static void printSpaces(void) {
+static void printSpaces(CompilerContext* ctx) {
     int i;
-    for (i = 0; i < indentno; i++)
-        printf(" ");
+    for (i = 0; i < ctx->indentno; i++)
+        fprintf(ctx->listing, " ");
 }
 
 /**
  * @brief Printa a AST indentada
+ * @param ctx Contexto da compilacao
  * @param tree Raiz da arvore a ser impressa
  */
-void printTree(TreeNode* tree) {
+void printTree(CompilerContext* ctx, TreeNode* tree) {
     int i;
     INDENT;
     while (tree != NULL) {
-        printSpaces();
+        printSpaces(ctx);
         if (tree->nodekind == StmtK) {
             switch (tree->kind.stmt) {
                 case IfK:
-                    printf("If\n");
+                    fprintf(ctx->listing, "If\n");
                     break;
                 case WhileK:
-                    printf("While\n");
+                    fprintf(ctx->listing, "While\n");
                     break;
                 case AssignK:
-                    printf("Assign\n");
+                    fprintf(ctx->listing, "Assign\n");
                     break;
                 case ReturnK:
-                    printf("Return\n");
+                    fprintf(ctx->listing, "Return\n");
                     break;
                 case CompoundK:
-                    printf("Compound Statement\n");
+                    fprintf(ctx->listing, "Compound Statement\n");
                     break;
                 default:
-                    printf("Erro: no de statement desconhecido\n");
+                    fprintf(ctx->listing, "Erro: no de statement desconhecido\n");
                     break;
             }
         } else if (tree->nodekind == ExpK) {
             switch (tree->kind.exp) {
                 case OpK:
-                    printf("Op: ");
+                    fprintf(ctx->listing, "Op: ");
                     switch (tree->attr.op) {
                         case MAIS:
-                            printf("+");
+                            fprintf(ctx->listing, "+");
                             break;
                         case MENOS:
-                            printf("-");
+                            fprintf(ctx->listing, "-");
                             break;
                         case VEZES:
-                            printf("*");
+                            fprintf(ctx->listing, "*");
                             break;
                         case SOBRE:
-                            printf("/");
+                            fprintf(ctx->listing, "/");
                             break;
                         case MENOR:
-                            printf("<");
+                            fprintf(ctx->listing, "<");
                             break;
                         case MENORIGUAL:
-                            printf("<=");
+                            fprintf(ctx->listing, "<=");
                             break;
                         case MAIOR:
-                            printf(">");
+                            fprintf(ctx->listing, ">");
                             break;
                         case MAIORIGUAL:
-                            printf(">=");
+                            fprintf(ctx->listing, ">=");
                             break;
                         case IGUAL:
-                            printf("==");
+                            fprintf(ctx->listing, "==");
                             break;
                         case DIFERENTE:
-                            printf("!=");
+                            fprintf(ctx->listing, "!=");
                             break;
                         default:
-                            printf("?");
+                            fprintf(ctx->listing, "?");
                             break;
                     }
-                    printf("\n");
+                    fprintf(ctx->listing, "\n");
                     break;
                 case ConstK:
-                    printf("Const: %d\n", tree->attr.val);
+                    fprintf(ctx->listing, "Const: %d\n", tree->attr.val);
                     break;
                 case IdK:
-                    printf("Id: %s\n", tree->attr.name);
+                    fprintf(ctx->listing, "Id: %s\n", tree->attr.name);
                     break;
                 case CallK:
-                    printf("Call: %s\n", tree->attr.name);
+                    fprintf(ctx->listing, "Call: %s\n", tree->attr.name);
                     break;
                 default:
-                    printf("Erro: no de expressao desconhecido\n");
+                    fprintf(ctx->listing, "Erro: no de expressao desconhecido\n");
                     break;
             }
         } else if (tree->nodekind == DeclK) {
             switch (tree->kind.decl) {
                 case VarK:
-                    printf("Var Declaration: %s", tree->attr.name);
+                    fprintf(ctx->listing, "Var Declaration: %s", tree->attr.name);
                     if (tree->type == Integer)
-                        printf(" (int)\n");
+                        fprintf(ctx->listing, " (int)\n");
                     else if (tree->type == Void)
-                        printf(" (void)\n");
+                        fprintf(ctx->listing, " (void)\n");
                     else
-                        printf("\n");
+                        fprintf(ctx->listing, "\n");
                     break;
                 case ArrayK:
-                    printf("Array Declaration: %s", tree->attr.name);
+                    fprintf(ctx->listing, "Array Declaration: %s", tree->attr.name);
                     if (tree->child[0] != NULL)
-                        printf("[%d]", tree->child[0]->attr.val);
-                    printf("\n");
+                        fprintf(ctx->listing, "[%d]", tree->child[0]->attr.val);
+                    fprintf(ctx->listing, "\n");
                     break;
                 case FunK:
-                    printf("Function Declaration: %s", tree->attr.name);
+                    fprintf(ctx->listing, "Function Declaration: %s", tree->attr.name);
                     if (tree->type == Integer)
-                        printf(" returns int\n");
+                        fprintf(ctx->listing, " returns int\n");
                     else if (tree->type == Void)
-                        printf(" returns void\n");
+                        fprintf(ctx->listing, " returns void\n");
                     else
-                        printf("\n");
+                        fprintf(ctx->listing, "\n");
                     break;
                 case ParamK:
-                    printf("Parameter: %s", tree->attr.name);
+                    fprintf(ctx->listing, "Parameter: %s", tree->attr.name);
                     if (tree->type == Integer)
-                        printf(" (int)\n");
+                        fprintf(ctx->listing, " (int)\n");
                     else if (tree->type == IntegerArray)
-                        printf(" (int[])\n");
+                        fprintf(ctx->listing, " (int[])\n");
                     else if (tree->type == Void)
-                        printf(" (void)\n");
+                        fprintf(ctx->listing, " (void)\n");
                     else
-                        printf("\n");
+                        fprintf(ctx->listing, "\n");
                     break;
                 default:
-                    printf("Erro: no de declaracao desconhecido\n");
+                    fprintf(ctx->listing, "Erro: no de declaracao desconhecido\n");
                     break;
             }
         } else {
-            printf("Erro: tipo de no desconhecido\n");
+            fprintf(ctx->listing, "Erro: tipo de no desconhecido\n");
         }
         for (i = 0; i < MAXCHILDREN; i++)
-            printTree(tree->child[i]); // Recursao pros filhos
+            printTree(ctx, tree->child[i]); // Recursao pros filhos
         tree = tree->sibling;
     }
     UNINDENT;
@@ -10,24 +10,27 @@
 
 /**
  * @brief Cria um novo no de statement na AST
+ * @param ctx Contexto da compilacao
  * @param kind Tipo do statement
  * @return Ponteiro para o novo no criado
  */
-TreeNode* newStmtNode(StmtKind kind);
+TreeNode* newStmtNode(CompilerContext* ctx, StmtKind kind);
 
 /**
  * @brief Cria um novo no de expressao na AST
+ * @param ctx Contexto da compilacao
  * @param kind Tipo da expressao
  * @return Ponteiro para o novo no criado
  */
-TreeNode* newExpNode(ExpKind kind);
+TreeNode* newExpNode(CompilerContext* ctx, ExpKind kind);
 
 /**
  * @brief Cria um novo no de declaracao na AST
+ * @param ctx Contexto da compilacao
  * @param kind Tipo da declaracao
  * @return Ponteiro para o novo no criado
  */
-TreeNode* newDeclNode(DeclKind kind);
+TreeNode* newDeclNode(CompilerContext* ctx, DeclKind kind);
 
 /**
  * @brief Copia uma string para memoria alocada dinamicamente
@@ -36,10 +39,17 @@ TreeNode* newDeclNode(DeclKind kind);
  */
 char* copyString(char* s);
 
+/**
+ * @brief Libera uma AST (nos, irmaos e nomes)
+ * @param tree Raiz da arvore
+ */
+void freeTree(TreeNode* tree);
+
 /**
  * @brief Imprime a AST de forma identada
+ * @param ctx Contexto da compilacao
  * @param tree Raiz da arvore a ser impressa
  */
-void printTree(TreeNode* tree);
+void printTree(CompilerContext* ctx, TreeNode* tree);
 
 #endif
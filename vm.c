@@ -0,0 +1,983 @@
+/**
+ * @file vm.c
+ * @brief Implementacao da maquina virtual do codigo intermediario
+ */
+
+#include "vm.h"
+#include "profile.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define VM_INITIAL_MEM (1u << 16)
+#define VM_DEFAULT_LIMIT (1u << 26)
+// Contextos de chamada contados (os mais fundos contam no contexto de quem chama)
+#define VM_STACK_NODES_MAX (1u << 20)
+
+// operacoes vetoriais: VM_LANES inteiros por instrucao SIMD
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define VM_LANES 8
+typedef __m256i VmVec;
+#define vload(p)      _mm256_loadu_si256((const __m256i*)(p))
+#define vstore(p, v)  _mm256_storeu_si256((__m256i*)(p), v)
+#define vset(x)       _mm256_set1_epi32(x)
+#define vadd(a, b)    _mm256_add_epi32(a, b)
+#define vsub(a, b)    _mm256_sub_epi32(a, b)
+#define vmul(a, b)    _mm256_mullo_epi32(a, b)
+#define veq(a, b)     _mm256_cmpeq_epi32(a, b)
+#define vgt(a, b)     _mm256_cmpgt_epi32(a, b)
+#define vand(a, b)    _mm256_and_si256(a, b)
+#define vandnot(a, b) _mm256_andnot_si256(a, b)
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define VM_LANES 4
+typedef __m128i VmVec;
+#define vload(p)      _mm_loadu_si128((const __m128i*)(p))
+#define vstore(p, v)  _mm_storeu_si128((__m128i*)(p), v)
+#define vset(x)       _mm_set1_epi32(x)
+#define vadd(a, b)    _mm_add_epi32(a, b)
+#define vsub(a, b)    _mm_sub_epi32(a, b)
+#define vmul(a, b)    mullo32(a, b)
+#define veq(a, b)     _mm_cmpeq_epi32(a, b)
+#define vgt(a, b)     _mm_cmpgt_epi32(a, b)
+#define vand(a, b)    _mm_and_si128(a, b)
+#define vandnot(a, b) _mm_andnot_si128(a, b)
+
+/**
+ * @brief Produto de 32 bits (os 32 bits baixos) sem o _mm_mullo_epi32 do SSE4.1
+ */
+static __m128i mullo32(__m128i a, __m128i b) {
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+#endif
+
+/**
+ * @brief Reporta um erro de execucao
+ * @param vm Estado da maquina
+ * @param msg Mensagem
+ * @return -1 sempre
+ */
+static int vmError(Vm* vm, const char* msg) {
+    const IrView* view = vm->view;
+    if (vm->quiet) {
+        vm->error = 1;
+        return -1;
+    }
+    if (vm->nframes > 0) {
+        const IrUnitRec* u = &view->units[vm->frames[vm->nframes - 1].unit];
+        fprintf(stderr, "ERRO DE EXECUCAO: %s (funcao %s)\n", msg, view->strs + u->name);
+    } else {
+        fprintf(stderr, "ERRO DE EXECUCAO: %s\n", msg);
+    }
+    vm->error = 1;
+    return -1;
+}
+
+/**
+ * @brief Garante memoria ate o endereco pedido
+ * @param vm Estado da maquina
+ * @param top Primeiro endereco que nao precisa existir
+ * @return 0 se sucesso, -1 se excede o limite
+ */
+static int vmReserve(Vm* vm, uint32_t top) {
+    uint32_t n = vm->memSize ? vm->memSize : VM_INITIAL_MEM;
+    int32_t* mem;
+    if (top <= vm->memSize)
+        return 0;
+    if (top > vm->memLimit)
+        return -1;
+    while (n < top)
+        n = (n > vm->memLimit / 2) ? vm->memLimit : n * 2;
+    mem = (int32_t*)realloc(vm->mem, (size_t)n * sizeof(int32_t));
+    if (mem == NULL)
+        return -1;
+    memset(mem + vm->memSize, 0, (size_t)(n - vm->memSize) * sizeof(int32_t));
+    vm->mem = mem;
+    vm->memSize = n;
+    return 0;
+}
+
+int vm_find_unit(const IrView* view, const char* name) {
+    uint32_t i;
+    for (i = 0; i < view->nunits; i++)
+        if (strcmp(view->strs + view->units[i].name, name) == 0)
+            return (int)i;
+    return -1;
+}
+
+int vm_init(Vm* vm, const IrView* view) {
+    uint32_t i, addr = 0;
+    memset(vm, 0, sizeof(*vm));
+    vm->view = view;
+    vm->in = stdin;
+    vm->out = stdout;
+    vm->memLimit = VM_DEFAULT_LIMIT;
+    vm->globalAddr = (uint32_t*)malloc((view->nglobals + 1) * sizeof(uint32_t));
+    vm->info = (VmUnitInfo*)calloc(view->nunits + 1, sizeof(VmUnitInfo));
+    if (vm->globalAddr == NULL || vm->info == NULL)
+        return vmError(vm, "falta de memoria");
+    // o endereco 0 fica reservado para que nenhum array comece em 0
+    addr = 1;
+    for (i = 0; i < view->nglobals; i++) {
+        vm->globalAddr[i] = addr;
+        addr += view->globals[i].size > 0 ? (uint32_t)view->globals[i].size : 1;
+    }
+    if (vmReserve(vm, addr < VM_INITIAL_MEM ? VM_INITIAL_MEM : addr) != 0)
+        return vmError(vm, "memoria insuficiente para as globais");
+    vm->sp = addr;
+    return 0;
+}
+
+void vm_free(Vm* vm) {
+    uint32_t i;
+    if (vm->info != NULL && vm->view != NULL) {
+        for (i = 0; i < vm->view->nunits; i++) {
+            free(vm->info[i].slotOff);
+            free(vm->info[i].labelPc);
+            free(vm->info[i].counts);
+            free(vm->info[i].calls);
+        }
+    }
+    free(vm->info);
+    free(vm->globalAddr);
+    free(vm->mem);
+    free(vm->frames);
+    free(vm->args);
+    free(vm->lineCounts);
+    free(vm->stack);
+    memset(vm, 0, sizeof(*vm));
+}
+
+/**
+ * @brief Calcula o layout do registro e a tabela de labels de uma funcao
+ * @param vm Estado da maquina
+ * @param unit Indice da funcao
+ * @return Informacoes da funcao ou NULL se erro
+ */
+static VmUnitInfo* unitInfo(Vm* vm, uint32_t unit) {
+    VmUnitInfo* inf = &vm->info[unit];
+    const IrUnitRec* u = &vm->view->units[unit];
+    uint32_t k;
+    if (inf->slotOff != NULL)
+        return inf;
+    inf->slotOff = (int32_t*)malloc((u->nslots + 1) * sizeof(int32_t));
+    inf->labelPc = (int32_t*)malloc((u->nlabels + 1) * sizeof(int32_t));
+    if (inf->slotOff == NULL || inf->labelPc == NULL)
+        return NULL;
+    for (k = 0; k < u->nslots; k++)
+        inf->slotOff[k] = vm->view->slots[u->slotFirst + k].offset;
+    inf->tempOff = ir_frame_slots(vm->view->slots + u->slotFirst, u->nslots);
+    inf->frameSize = inf->tempOff + u->ntemps;
+    for (k = 0; k < u->nlabels; k++)
+        inf->labelPc[k] = -1;
+    for (k = 0; k < u->count; k++) {
+        const IrInstr* in = &vm->view->code[u->first + k];
+        if (in->op == IR_LABEL_DEF && in->ka == IR_LABEL && (uint32_t)in->a < u->nlabels)
+            inf->labelPc[in->a] = (int32_t)k;
+        if (in->op == IR_COUNT && in->ka == IR_CONST && in->a >= 0 && (uint32_t)in->a >= inf->ncounts) {
+            inf->ncounts = (uint32_t)in->a + 1;
+            inf->checksum = (uint32_t)in->b;
+        }
+    }
+    if (vm->profile && inf->ncounts > 0) {
+        inf->counts = (uint64_t*)calloc(inf->ncounts, sizeof(uint64_t));
+        if (inf->counts == NULL) {
+            inf->ncounts = 0;
+            return NULL;
+        }
+    }
+    return inf;
+}
+
+/**
+ * @brief Conta uma chamada entre duas funcoes (perfil)
+ * @param vm Estado da maquina
+ * @param caller Funcao que chama (ja executando)
+ * @param callee Funcao chamada
+ * @return 0 se sucesso, -1 sem memoria
+ */
+static int countCall(Vm* vm, uint32_t caller, uint32_t callee) {
+    VmUnitInfo* inf = &vm->info[caller];
+    uint32_t k;
+    // poucas funcoes chamadas por funcao: busca linear
+    for (k = 0; k < inf->ncalls; k++) {
+        if (inf->calls[k].callee == callee) {
+            inf->calls[k].count++;
+            return 0;
+        }
+    }
+    if (inf->ncalls == inf->callCap) {
+        uint32_t cap = inf->callCap ? inf->callCap * 2 : 4;
+        VmCallCount* grown = (VmCallCount*)realloc(inf->calls, cap * sizeof(VmCallCount));
+        if (grown == NULL)
+            return -1;
+        inf->calls = grown;
+        inf->callCap = cap;
+    }
+    inf->calls[inf->ncalls].callee = callee;
+    inf->calls[inf->ncalls].count = 1;
+    inf->ncalls++;
+    return 0;
+}
+
+/**
+ * @brief Contexto de chamada de uma funcao chamada a partir de outro contexto
+ * @param vm Estado da maquina
+ * @param parent Contexto de quem chama
+ * @param unit Funcao chamada
+ * @return Contexto (o de quem chama se passou de VM_STACK_NODES_MAX ou falta memoria)
+ */
+static uint32_t stackNode(Vm* vm, uint32_t parent, uint32_t unit) {
+    VmStackNode* n;
+    uint32_t k;
+    for (k = vm->stack[parent].child; k != 0; k = vm->stack[k].sibling)
+        if (vm->stack[k].unit == unit)
+            return k;
+    if (vm->nstack == VM_STACK_NODES_MAX)
+        return parent;
+    if (vm->nstack == vm->stackCap) {
+        uint32_t cap = vm->stackCap * 2;
+        VmStackNode* grown = (VmStackNode*)realloc(vm->stack, cap * sizeof(VmStackNode));
+        if (grown == NULL)
+            return parent;
+        vm->stack = grown;
+        vm->stackCap = cap;
+    }
+    k = vm->nstack++;
+    n = &vm->stack[k];
+    memset(n, 0, sizeof(*n));
+    n->unit = unit;
+    n->parent = parent;
+    n->sibling = vm->stack[parent].child;
+    vm->stack[parent].child = k;
+    return k;
+}
+
+/**
+ * @brief Empilha um registro de ativacao
+ * @param vm Estado da maquina
+ * @param unit Funcao chamada
+ * @param nargs Numero de parametros pendentes consumidos
+ * @param retKind Tipo do destino do retorno no chamador
+ * @param retVal Destino do retorno no chamador
+ * @return 0 se sucesso, -1 se erro
+ */
+static int pushFrame(Vm* vm, uint32_t unit, uint32_t nargs, uint8_t retKind, int32_t retVal) {
+    const IrUnitRec* u;
+    VmUnitInfo* inf;
+    VmFrame* f;
+    uint32_t k;
+    if (unit >= vm->view->nunits)
+        return vmError(vm, "chamada para funcao inexistente");
+    u = &vm->view->units[unit];
+    if (nargs != u->nparams || nargs > vm->nargs)
+        return vmError(vm, "numero de argumentos incorreto");
+    inf = unitInfo(vm, unit);
+    if (inf == NULL)
+        return vmError(vm, "falta de memoria");
+    if (vmReserve(vm, vm->sp + inf->frameSize) != 0)
+        return vmError(vm, "estouro da pilha");
+    if (vm->nframes == vm->frameCap) {
+        vm->frameCap = vm->frameCap ? vm->frameCap * 2 : 64;
+        vm->frames = (VmFrame*)realloc(vm->frames, vm->frameCap * sizeof(VmFrame));
+        if (vm->frames == NULL)
+            return vmError(vm, "falta de memoria");
+    }
+    f = &vm->frames[vm->nframes++];
+    f->node = 0;
+    if (vm->lineCounts != NULL) {
+        f->node = stackNode(vm, vm->nframes > 1 ? vm->frames[vm->nframes - 2].node : 0, unit);
+        inf->entries++;
+    }
+    f->unit = unit;
+    f->pc = 0;
+    f->fp = vm->sp;
+    f->retKind = retKind;
+    f->retVal = retVal;
+    memset(vm->mem + f->fp, 0, inf->frameSize * sizeof(int32_t));
+    for (k = 0; k < nargs; k++)
+        vm->mem[f->fp + inf->slotOff[k]] = vm->args[vm->nargs - nargs + k];
+    vm->nargs -= nargs;
+    vm->sp += inf->frameSize;
+    return 0;
+}
+
+/**
+ * @brief Endereco de memoria de um operando variavel (temp, local ou global)
+ * @param vm Estado da maquina
+ * @param f Registro atual
+ * @param kind Tipo do operando
+ * @param val Valor do operando
+ * @param isArray Recebe TRUE se o operando e um array armazenado no endereco
+ * @return Endereco ou 0 se o operando nao e uma variavel
+ */
+static uint32_t opndAddr(Vm* vm, const VmFrame* f, int kind, int32_t val, int* isArray) {
+    const IrView* view = vm->view;
+    const IrUnitRec* u = &view->units[f->unit];
+    VmUnitInfo* inf = &vm->info[f->unit];
+    *isArray = 0;
+    switch (kind) {
+        case IR_TEMP:
+            if ((uint32_t)val >= u->ntemps)
+                return 0;
+            return f->fp + inf->tempOff + (uint32_t)val;
+        case IR_LOCAL:
+            if ((uint32_t)val >= u->nslots)
+                return 0;
+            *isArray = view->slots[u->slotFirst + val].size > 0;
+            return f->fp + (uint32_t)inf->slotOff[val];
+        case IR_GLOBAL:
+            if ((uint32_t)val >= view->nglobals)
+                return 0;
+            *isArray = view->globals[val].size > 0;
+            return vm->globalAddr[val];
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief Valor de um operando (arrays valem o endereco do primeiro elemento)
+ * @param vm Estado da maquina
+ * @param f Registro atual
+ * @param kind Tipo do operando
+ * @param val Valor do operando
+ * @param out Valor lido
+ * @return 0 se sucesso, -1 se operando invalido
+ */
+static int readOpnd(Vm* vm, const VmFrame* f, int kind, int32_t val, int32_t* out) {
+    int isArray;
+    uint32_t addr;
+    if (kind == IR_CONST) {
+        *out = val;
+        return 0;
+    }
+    addr = opndAddr(vm, f, kind, val, &isArray);
+    if (addr == 0)
+        return vmError(vm, "operando invalido");
+    *out = isArray ? (int32_t)addr : vm->mem[addr];
+    return 0;
+}
+
+/**
+ * @brief Escreve em um operando variavel
+ * @param vm Estado da maquina
+ * @param f Registro atual
+ * @param kind Tipo do operando
+ * @param val Valor do operando
+ * @param v Valor a escrever
+ * @return 0 se sucesso, -1 se operando invalido
+ */
+static int writeOpnd(Vm* vm, const VmFrame* f, int kind, int32_t val, int32_t v) {
+    int isArray;
+    uint32_t addr = opndAddr(vm, f, kind, val, &isArray);
+    if (addr == 0 || isArray)
+        return vmError(vm, "destino invalido");
+    vm->mem[addr] = v;
+    return 0;
+}
+
+/**
+ * @brief Tamanho de um array usado diretamente como operando
+ *
+ * Arrays locais e globais tem o tamanho declarado; um parametro array (ou
+ * um endereco em um temporario) so e conferido contra a memoria em uso.
+ *
+ * @param vm Estado da maquina
+ * @param f Registro atual
+ * @param kind Tipo do operando
+ * @param val Valor do operando
+ * @return Numero de elementos ou -1 se desconhecido
+ */
+static int32_t arraySize(const Vm* vm, const VmFrame* f, int kind, int32_t val) {
+    const IrView* view = vm->view;
+    const IrUnitRec* u = &view->units[f->unit];
+    if (kind == IR_LOCAL && (uint32_t)val < u->nslots && view->slots[u->slotFirst + val].size > 0)
+        return view->slots[u->slotFirst + val].size;
+    if (kind == IR_GLOBAL && (uint32_t)val < view->nglobals && view->globals[val].size > 0)
+        return view->globals[val].size;
+    return -1;
+}
+
+/**
+ * @brief Confere um acesso a array
+ *
+ * Com o tamanho conhecido, um indice fora do array e erro mesmo que o
+ * endereco caia em outra variavel: o resultado nao depende da disposicao
+ * do registro de ativacao, que muda com o nivel de otimizacao.
+ *
+ * @param vm Estado da maquina
+ * @param base Endereco do primeiro elemento
+ * @param index Indice
+ * @param size Numero de elementos (arraySize; -1 = desconhecido)
+ * @return Endereco do elemento ou 0 se fora do array ou da memoria
+ */
+static uint32_t elemAddr(Vm* vm, int32_t base, int32_t index, int32_t size) {
+    int64_t addr = (int64_t)base + index;
+    if (size >= 0 && (index < 0 || index >= size))
+        return 0;
+    if (base <= 0 || addr <= 0 || addr >= (int64_t)vm->sp)
+        return 0;
+    return (uint32_t)addr;
+}
+
+/**
+ * @brief Operacao binaria sem erro possivel (todas menos a divisao), com a aritmetica de 32 bits
+ * @param op IR_ADD a IR_NE (exceto IR_DIV)
+ * @param a Operando esquerdo
+ * @param b Operando direito
+ * @return Resultado
+ */
+static int32_t arith(int op, int32_t a, int32_t b) {
+    switch (op) {
+        case IR_ADD: return (int32_t)((uint32_t)a + (uint32_t)b);
+        case IR_SUB: return (int32_t)((uint32_t)a - (uint32_t)b);
+        case IR_MUL: return (int32_t)((uint32_t)a * (uint32_t)b);
+        case IR_LT:  return a < b;
+        case IR_LE:  return a <= b;
+        case IR_GT:  return a > b;
+        case IR_GE:  return a >= b;
+        case IR_EQ:  return a == b;
+        default:     return a != b;
+    }
+}
+
+#ifdef VM_LANES
+/**
+ * @brief Operacao binaria em VM_LANES inteiros (comparacoes dao 0 ou 1)
+ */
+static VmVec vecOp(int op, VmVec x, VmVec y) {
+    VmVec one = vset(1);
+    switch (op) {
+        case IR_ADD: return vadd(x, y);
+        case IR_SUB: return vsub(x, y);
+        case IR_MUL: return vmul(x, y);
+        case IR_LT:  return vand(vgt(y, x), one);
+        case IR_LE:  return vandnot(vgt(x, y), one);
+        case IR_GT:  return vand(vgt(x, y), one);
+        case IR_GE:  return vandnot(vgt(y, x), one);
+        case IR_EQ:  return vand(veq(x, y), one);
+        default:     return vandnot(veq(x, y), one);
+    }
+}
+#endif
+
+/**
+ * @brief Aplica uma operacao a n elementos
+ *
+ * Blocos de VM_LANES elementos com leituras e escritas nao alinhadas (sem
+ * prologo); os elementos que sobram no fim sao calculados um a um. d pode
+ * ser igual a a ou b (mesmo indice), mas nao sobreposto com deslocamento.
+ *
+ * @param op IR_COPY ou IR_ADD a IR_NE (exceto IR_DIV)
+ * @param d Destino
+ * @param a Elementos do operando esquerdo (NULL = sa em todos)
+ * @param sa Operando esquerdo escalar
+ * @param b Elementos do operando direito (NULL = sb em todos)
+ * @param sb Operando direito escalar
+ * @param n Numero de elementos
+ */
+static void vecKernel(int op, int32_t* d, const int32_t* a, int32_t sa, const int32_t* b, int32_t sb, uint32_t n) {
+    uint32_t k = 0;
+    if (op == IR_COPY) {
+        if (a != NULL) {
+            memmove(d, a, (size_t)n * sizeof(int32_t));
+        } else {
+            for (k = 0; k < n; k++)
+                d[k] = sa;
+        }
+        return;
+    }
+#ifdef VM_LANES
+    {
+        VmVec va = vset(sa);
+        VmVec vb = vset(sb);
+        for (; k + VM_LANES <= n; k += VM_LANES) {
+            VmVec x = a != NULL ? vload(a + k) : va;
+            VmVec y = b != NULL ? vload(b + k) : vb;
+            vstore(d + k, vecOp(op, x, y));
+        }
+    }
+#endif
+    for (; k < n; k++)
+        d[k] = arith(op, a != NULL ? a[k] : sa, b != NULL ? b[k] : sb);
+}
+
+/**
+ * @brief Le um operando de uma operacao vetorial
+ * @param vm Estado da maquina
+ * @param f Registro atual
+ * @param kind Tipo do operando
+ * @param val Valor do operando
+ * @param out Endereco do array ou valor escalar
+ * @param isArray Recebe TRUE se o operando e um array (local, parametro int[] ou global)
+ * @return 0 se sucesso, -1 se operando invalido
+ */
+static int vecOpnd(Vm* vm, const VmFrame* f, int kind, int32_t val, int32_t* out, int* isArray) {
+    const IrView* view = vm->view;
+    const IrUnitRec* u = &view->units[f->unit];
+    *isArray = (kind == IR_LOCAL && (uint32_t)val < u->nslots && view->slots[u->slotFirst + val].size != IR_SCALAR) ||
+               (kind == IR_GLOBAL && (uint32_t)val < view->nglobals && view->globals[val].size > 0);
+    return readOpnd(vm, f, kind, val, out);
+}
+
+/**
+ * @brief Executa uma operacao vetorial sobre os elementos do ultimo vspan
+ *
+ * Se todos os elementos estao na memoria e o destino nao se sobrepoe com
+ * deslocamento a um array lido (teste de alias em tempo de execucao), usa
+ * vecKernel. Senao repete o laco original elemento a elemento, com o mesmo
+ * erro no mesmo elemento.
+ *
+ * @param vm Estado da maquina
+ * @param f Registro atual
+ * @param in Instrucao (IR_VCOPY a IR_VNE)
+ * @return 0 se sucesso, -1 se erro
+ */
+static int execVector(Vm* vm, const VmFrame* f, const IrInstr* in) {
+    int op = ir_scalar_op((IrOp)in->op);
+    int32_t first = vm->vecFirst;
+    int32_t end = vm->vecEnd;
+    int32_t base[3] = {0, 0, 0};
+    int32_t size[3] = {-1, -1, -1};
+    int isArray[3] = {0, 0, 0};
+    int fast = 1;
+    uint32_t n, k;
+    int j;
+    // o intervalo vale para uma unica operacao
+    vm->vecEnd = vm->vecFirst;
+    if (end <= first)
+        return 0;
+    n = (uint32_t)((int64_t)end - first);
+    if (vecOpnd(vm, f, in->kd, in->d, &base[0], &isArray[0]) != 0 ||
+        vecOpnd(vm, f, in->ka, in->a, &base[1], &isArray[1]) != 0 ||
+        (op != IR_COPY && vecOpnd(vm, f, in->kb, in->b, &base[2], &isArray[2]) != 0))
+        return -1;
+    if (!isArray[0])
+        return vmError(vm, "destino invalido");
+    size[0] = arraySize(vm, f, in->kd, in->d);
+    size[1] = arraySize(vm, f, in->ka, in->a);
+    if (op != IR_COPY)
+        size[2] = arraySize(vm, f, in->kb, in->b);
+    vm->steps += n;
+    if (vm->lineCounts != NULL) {
+        // a instrucao ja contou 1 no laco principal
+        vm->lineCounts[vm->view->units[f->unit].first + f->pc - 1] += n - 1;
+        vm->stack[f->node].self += n - 1;
+    }
+    for (j = 0; j < 3; j++) {
+        if (!isArray[j])
+            continue;
+        if (elemAddr(vm, base[j], first, size[j]) == 0 || elemAddr(vm, base[j], end - 1, size[j]) == 0)
+            fast = 0;
+        if (j > 0 && base[j] != base[0] && llabs((long long)base[j] - base[0]) < (long long)n)
+            fast = 0;
+    }
+    if (fast) {
+        vecKernel(op, vm->mem + base[0] + first,
+                  isArray[1] ? vm->mem + base[1] + first : NULL, base[1],
+                  isArray[2] ? vm->mem + base[2] + first : NULL, base[2], n);
+        return 0;
+    }
+    for (k = 0; k < n; k++) {
+        int32_t index = first + (int32_t)k;
+        int32_t x = base[1], y = base[2];
+        uint32_t addr;
+        if (isArray[1]) {
+            if ((addr = elemAddr(vm, base[1], index, size[1])) == 0)
+                return vmError(vm, "acesso fora dos limites do array");
+            x = vm->mem[addr];
+        }
+        if (isArray[2]) {
+            if ((addr = elemAddr(vm, base[2], index, size[2])) == 0)
+                return vmError(vm, "acesso fora dos limites do array");
+            y = vm->mem[addr];
+        }
+        if ((addr = elemAddr(vm, base[0], index, size[0])) == 0)
+            return vmError(vm, "acesso fora dos limites do array");
+        vm->mem[addr] = op == IR_COPY ? x : arith(op, x, y);
+    }
+    return 0;
+}
+
+/**
+ * @brief Empilha um parametro pendente
+ * @param vm Estado da maquina
+ * @param v Valor
+ * @return 0 se sucesso, -1 se erro
+ */
+static int pushArg(Vm* vm, int32_t v) {
+    if (vm->nargs == vm->argCap) {
+        vm->argCap = vm->argCap ? vm->argCap * 2 : 32;
+        vm->args = (int32_t*)realloc(vm->args, vm->argCap * sizeof(int32_t));
+        if (vm->args == NULL)
+            return vmError(vm, "falta de memoria");
+    }
+    vm->args[vm->nargs++] = v;
+    return 0;
+}
+
+/**
+ * @brief Laco principal: executa ate o registro 'base' retornar
+ * @param vm Estado da maquina
+ * @param base Numero de registros abaixo da chamada inicial
+ * @param result Valor retornado pela chamada inicial
+ * @return 0 se sucesso, -1 se erro
+ */
+static int execute(Vm* vm, uint32_t base, int32_t* result) {
+    const IrView* view = vm->view;
+    while (vm->nframes > base) {
+        VmFrame* f = &vm->frames[vm->nframes - 1];
+        const IrUnitRec* u = &view->units[f->unit];
+        const IrInstr* in;
+        int32_t a, b, v;
+        uint32_t addr;
+        if (f->pc >= u->count) {
+            // fim da funcao sem return
+            in = NULL;
+            a = 0;
+            goto do_return;
+        }
+        in = &view->code[u->first + f->pc++];
+        vm->steps++;
+        if (vm->lineCounts != NULL) {
+            vm->lineCounts[u->first + f->pc - 1]++;
+            vm->stack[f->node].self++;
+        }
+        if (vm->stepLimit != 0 && vm->steps > vm->stepLimit) {
+            vm->error = 1;
+            return -1;
+        }
+        switch (in->op) {
+            case IR_NOP:
+            case IR_LABEL_DEF:
+                break;
+            case IR_COPY:
+                if (readOpnd(vm, f, in->ka, in->a, &a) != 0 ||
+                    writeOpnd(vm, f, in->kd, in->d, a) != 0)
+                    return -1;
+                break;
+            case IR_ADD: case IR_SUB: case IR_MUL: case IR_DIV:
+            case IR_LT: case IR_LE: case IR_GT: case IR_GE: case IR_EQ: case IR_NE:
+                if (readOpnd(vm, f, in->ka, in->a, &a) != 0 ||
+                    readOpnd(vm, f, in->kb, in->b, &b) != 0)
+                    return -1;
+                if (in->op == IR_DIV) {
+                    if (b == 0 || (a == INT32_MIN && b == -1))
+                        return vmError(vm, "divisao por zero");
+                    v = a / b;
+                } else {
+                    v = arith(in->op, a, b);
+                }
+                if (writeOpnd(vm, f, in->kd, in->d, v) != 0)
+                    return -1;
+                break;
+            case IR_LOAD:
+                if (readOpnd(vm, f, in->ka, in->a, &a) != 0 ||
+                    readOpnd(vm, f, in->kb, in->b, &b) != 0)
+                    return -1;
+                addr = elemAddr(vm, a, b, arraySize(vm, f, in->ka, in->a));
+                if (addr == 0)
+                    return vmError(vm, "acesso fora dos limites do array");
+                if (writeOpnd(vm, f, in->kd, in->d, vm->mem[addr]) != 0)
+                    return -1;
+                break;
+            case IR_STORE:
+                if (readOpnd(vm, f, in->kd, in->d, &v) != 0 ||
+                    readOpnd(vm, f, in->ka, in->a, &a) != 0 ||
+                    readOpnd(vm, f, in->kb, in->b, &b) != 0)
+                    return -1;
+                addr = elemAddr(vm, v, a, arraySize(vm, f, in->kd, in->d));
+                if (addr == 0)
+                    return vmError(vm, "acesso fora dos limites do array");
+                vm->mem[addr] = b;
+                break;
+            case IR_PARAM:
+                if (readOpnd(vm, f, in->ka, in->a, &a) != 0 || pushArg(vm, a) != 0)
+                    return -1;
+                break;
+            case IR_CALL:
+                if (in->ka != IR_FUNC || (uint32_t)vm->nargs < (uint32_t)in->b)
+                    return vmError(vm, "chamada invalida");
+                if (in->a == IR_BUILTIN_INPUT) {
+                    v = 0;
+                    if (fscanf(vm->in, "%d", &v) != 1)
+                        v = 0;
+                    if (in->kd != IR_NONE && writeOpnd(vm, f, in->kd, in->d, v) != 0)
+                        return -1;
+                } else if (in->a == IR_BUILTIN_OUTPUT) {
+                    if (in->b < 1)
+                        return vmError(vm, "output sem argumento");
+                    fprintf(vm->out, "%d\n", vm->args[vm->nargs - 1]);
+                    vm->nargs -= (uint32_t)in->b;
+                    if (in->kd != IR_NONE && writeOpnd(vm, f, in->kd, in->d, 0) != 0)
+                        return -1;
+                } else {
+                    if (vm->profile && (uint32_t)in->a < view->nunits && countCall(vm, f->unit, (uint32_t)in->a) != 0)
+                        return vmError(vm, "falta de memoria");
+                    if (pushFrame(vm, (uint32_t)in->a, (uint32_t)in->b, in->kd, in->d) != 0)
+                        return -1;
+                }
+                break;
+            case IR_IFFALSE:
+                if (readOpnd(vm, f, in->ka, in->a, &a) != 0)
+                    return -1;
+                if (a == 0) {
+                    if (in->kb != IR_LABEL || (uint32_t)in->b >= u->nlabels ||
+                        vm->info[f->unit].labelPc[in->b] < 0)
+                        return vmError(vm, "label invalido");
+                    f->pc = (uint32_t)vm->info[f->unit].labelPc[in->b];
+                }
+                break;
+            case IR_GOTO:
+                if (in->ka != IR_LABEL || (uint32_t)in->a >= u->nlabels ||
+                    vm->info[f->unit].labelPc[in->a] < 0)
+                    return vmError(vm, "label invalido");
+                f->pc = (uint32_t)vm->info[f->unit].labelPc[in->a];
+                break;
+            case IR_RETURN:
+                a = 0;
+                if (in->ka != IR_NONE && readOpnd(vm, f, in->ka, in->a, &a) != 0)
+                    return -1;
+            do_return:
+                {
+                    VmFrame done = *f;
+                    vm->sp = done.fp;
+                    vm->nframes--;
+                    if (vm->nframes == base) {
+                        if (result != NULL)
+                            *result = a;
+                    } else if (done.retKind != IR_NONE) {
+                        if (writeOpnd(vm, &vm->frames[vm->nframes - 1], done.retKind, done.retVal, a) != 0)
+                            return -1;
+                    }
+                }
+                break;
+            case IR_VSPAN:
+                if (readOpnd(vm, f, in->ka, in->a, &a) != 0 ||
+                    readOpnd(vm, f, in->kb, in->b, &b) != 0)
+                    return -1;
+                vm->vecFirst = a;
+                vm->vecEnd = b;
+                break;
+            case IR_COUNT:
+                if (vm->profile && (uint32_t)in->a < vm->info[f->unit].ncounts)
+                    vm->info[f->unit].counts[in->a]++;
+                break;
+            default:
+                if (IR_IS_VECTOR(in->op)) {
+                    if (execVector(vm, f, in) != 0)
+                        return -1;
+                    break;
+                }
+                return vmError(vm, "instrucao desconhecida");
+        }
+    }
+    return 0;
+}
+
+int vm_call(Vm* vm, int unit, const int32_t* args, int nargs, int32_t* result) {
+    uint32_t base = vm->nframes;
+    int i;
+    for (i = 0; i < nargs; i++)
+        if (pushArg(vm, args[i]) != 0)
+            return -1;
+    if (pushFrame(vm, (uint32_t)unit, (uint32_t)nargs, IR_NONE, 0) != 0)
+        return -1;
+    if (execute(vm, base, result) != 0) {
+        // descarta a pilha da chamada interrompida
+        if (vm->nframes > base) {
+            vm->sp = vm->frames[base].fp;
+            vm->nframes = base;
+        }
+        vm->nargs = 0;
+        return -1;
+    }
+    return 0;
+}
+
+int vm_run_main(Vm* vm) {
+    int unit = vm_find_unit(vm->view, "main");
+    if (unit < 0)
+        return vmError(vm, "funcao main nao encontrada");
+    return vm_call(vm, unit, NULL, 0, NULL);
+}
+
+int vm_profile_collect(Vm* vm, Profile* prof) {
+    const IrView* view = vm->view;
+    uint32_t u, k;
+    for (u = 0; u < view->nunits; u++) {
+        VmUnitInfo* inf = unitInfo(vm, u);
+        ProfFunc* fn;
+        if (inf == NULL)
+            return -1;
+        if (inf->ncounts == 0)
+            continue;
+        fn = profile_add_func(prof, view->strs + view->units[u].name, inf->checksum, inf->ncounts);
+        if (fn == NULL)
+            return -1;
+        if (inf->counts != NULL)
+            for (k = 0; k < inf->ncounts; k++)
+                fn->counts[k] += inf->counts[k];
+    }
+    for (u = 0; u < view->nunits; u++) {
+        const VmUnitInfo* inf = &vm->info[u];
+        for (k = 0; k < inf->ncalls; k++)
+            if (profile_add_edge(prof, view->strs + view->units[u].name,
+                                 view->strs + view->units[inf->calls[k].callee].name, inf->calls[k].count) != 0)
+                return -1;
+    }
+    return 0;
+}
+
+int vm_lines_enable(Vm* vm) {
+    vm->lineCounts = (uint64_t*)calloc(vm->view->ncode + 1, sizeof(uint64_t));
+    vm->stack = (VmStackNode*)calloc(64, sizeof(VmStackNode));
+    if (vm->lineCounts == NULL || vm->stack == NULL) {
+        free(vm->lineCounts);
+        free(vm->stack);
+        vm->lineCounts = NULL;
+        vm->stack = NULL;
+        return -1;
+    }
+    vm->stack[0].unit = UINT32_MAX;
+    vm->nstack = 1;
+    vm->stackCap = 64;
+    return 0;
+}
+
+// Instrucoes executadas de uma linha de uma funcao (relatorio)
+typedef struct {
+    uint32_t unit;
+    int32_t line;
+    uint64_t count;
+} VmLineCount;
+
+/**
+ * @brief Ordem por funcao e linha (junta as instrucoes da mesma linha)
+ */
+static int compareLinePos(const void* x, const void* y) {
+    const VmLineCount* a = (const VmLineCount*)x;
+    const VmLineCount* b = (const VmLineCount*)y;
+    if (a->unit != b->unit)
+        return a->unit < b->unit ? -1 : 1;
+    return a->line < b->line ? -1 : a->line > b->line;
+}
+
+/**
+ * @brief Ordem decrescente de instrucoes (empate: funcao e linha)
+ */
+static int compareLineCount(const void* x, const void* y) {
+    const VmLineCount* a = (const VmLineCount*)x;
+    const VmLineCount* b = (const VmLineCount*)y;
+    if (a->count != b->count)
+        return a->count > b->count ? -1 : 1;
+    return compareLinePos(x, y);
+}
+
+/**
+ * @brief Ordem decrescente de instrucoes das funcoes
+ */
+static int compareFuncCount(const void* x, const void* y) {
+    const VmLineCount* a = (const VmLineCount*)x;
+    const VmLineCount* b = (const VmLineCount*)y;
+    if (a->count != b->count)
+        return a->count > b->count ? -1 : 1;
+    return a->unit < b->unit ? -1 : a->unit > b->unit;
+}
+
+void vm_lines_report(const Vm* vm, FILE* out, int top) {
+    const IrView* view = vm->view;
+    VmLineCount* lines;
+    VmLineCount* funcs;
+    uint64_t total = 0;
+    uint32_t nlines = 0, nfuncs = 0, u, k;
+    if (vm->lineCounts == NULL)
+        return;
+    lines = (VmLineCount*)malloc((view->ncode + 1) * sizeof(VmLineCount));
+    funcs = (VmLineCount*)malloc((view->nunits + 1) * sizeof(VmLineCount));
+    if (lines == NULL || funcs == NULL) {
+        free(lines);
+        free(funcs);
+        fprintf(stderr, "Erro: falta de memoria no relatorio de linhas\n");
+        return;
+    }
+    for (u = 0; u < view->nunits; u++) {
+        const IrUnitRec* rec = &view->units[u];
+        funcs[nfuncs].unit = u;
+        funcs[nfuncs].line = 0;
+        funcs[nfuncs].count = 0;
+        for (k = 0; k < rec->count; k++) {
+            uint64_t c = vm->lineCounts[rec->first + k];
+            if (c == 0)
+                continue;
+            lines[nlines].unit = u;
+            lines[nlines].line = view->code[rec->first + k].line;
+            lines[nlines].count = c;
+            nlines++;
+            funcs[nfuncs].count += c;
+        }
+        total += funcs[nfuncs].count;
+        if (funcs[nfuncs].count > 0)
+            nfuncs++;
+    }
+    // uma entrada por linha de cada funcao
+    qsort(lines, nlines, sizeof(VmLineCount), compareLinePos);
+    for (u = 0, k = 0; u < nlines; u++) {
+        if (k > 0 && lines[k - 1].unit == lines[u].unit && lines[k - 1].line == lines[u].line)
+            lines[k - 1].count += lines[u].count;
+        else
+            lines[k++] = lines[u];
+    }
+    nlines = k;
+    qsort(lines, nlines, sizeof(VmLineCount), compareLineCount);
+    qsort(funcs, nfuncs, sizeof(VmLineCount), compareFuncCount);
+    fprintf(out, "Linhas mais executadas (instrucoes da VM):\n");
+    fprintf(out, "  %-20s %6s %14s %7s\n", "funcao", "linha", "instrucoes", "%");
+    for (k = 0; k < nlines && (int)k < top; k++) {
+        char line[16];
+        if (lines[k].line > 0)
+            snprintf(line, sizeof(line), "%d", lines[k].line);
+        else
+            snprintf(line, sizeof(line), "-");
+        fprintf(out, "  %-20s %6s %14llu %6.1f%%\n", view->strs + view->units[lines[k].unit].name, line,
+                (unsigned long long)lines[k].count, 100.0 * (double)lines[k].count / (double)total);
+    }
+    fprintf(out, "Funcoes:\n");
+    fprintf(out, "  %-20s %10s %14s %7s\n", "funcao", "chamadas", "instrucoes", "%");
+    for (k = 0; k < nfuncs; k++)
+        fprintf(out, "  %-20s %10llu %14llu %6.1f%%\n", view->strs + view->units[funcs[k].unit].name,
+                (unsigned long long)vm->info[funcs[k].unit].entries, (unsigned long long)funcs[k].count,
+                100.0 * (double)funcs[k].count / (double)total);
+    fprintf(out, "Total: %llu instrucoes\n", (unsigned long long)total);
+    free(lines);
+    free(funcs);
+}
+
+int vm_lines_stacks(const Vm* vm, FILE* out) {
+    const IrView* view = vm->view;
+    uint32_t* path;
+    uint32_t k;
+    if (vm->lineCounts == NULL)
+        return 0;
+    path = (uint32_t*)malloc((vm->nstack + 1) * sizeof(uint32_t));
+    if (path == NULL)
+        return -1;
+    for (k = 1; k < vm->nstack; k++) {
+        uint32_t depth = 0, n;
+        if (vm->stack[k].self == 0)
+            continue;
+        for (n = k; n != 0; n = vm->stack[n].parent)
+            path[depth++] = vm->stack[n].unit;
+        while (depth > 0) {
+            fputs(view->strs + view->units[path[--depth]].name, out);
+            fputc(depth > 0 ? ';' : ' ', out);
+        }
+        fprintf(out, "%llu\n", (unsigned long long)vm->stack[k].self);
+    }
+    free(path);
+    return 0;
+}
@@ -0,0 +1,184 @@
+/**
+ * @file vm.h
+ * @brief Maquina virtual que executa o codigo intermediario
+ *
+ * Executa um IrView diretamente, seja ele construido em memoria pelo
+ * compilador (ir_flatten) ou mapeado de um arquivo .cmir (irfile_open).
+ */
+
+#ifndef _VM_H_
+#define _VM_H_
+
+#include "ir.h"
+#include <stdio.h>
+
+struct Profile;
+
+/**
+ * @brief Registro de ativacao de uma funcao em execucao
+ */
+typedef struct {
+    uint32_t unit;      // funcao em execucao
+    uint32_t pc;        // proxima instrucao (relativa ao inicio da funcao)
+    uint32_t fp;        // inicio do registro na memoria
+    uint8_t retKind;    // destino do valor de retorno no chamador
+    int32_t retVal;
+    uint32_t node;      // contexto de chamada (so com vm->lineCounts)
+} VmFrame;
+
+/**
+ * @brief Contexto de chamada: caminho de funcoes desde a primeira chamada
+ *
+ * Os nos formam uma arvore (filho e irmao); o no 0 e a raiz, acima da
+ * funcao chamada por vm_call.
+ */
+typedef struct {
+    uint32_t unit;
+    uint32_t parent;
+    uint32_t child;     // primeiro filho (0 = nenhum)
+    uint32_t sibling;   // proximo irmao (0 = nenhum)
+    uint64_t self;      // instrucoes executadas no proprio contexto
+} VmStackNode;
+
+/**
+ * @brief Chamadas de uma funcao para outra (perfil)
+ */
+typedef struct {
+    uint32_t callee;
+    uint64_t count;
+} VmCallCount;
+
+/**
+ * @brief Informacoes de uma funcao calculadas na primeira chamada
+ */
+typedef struct {
+    int32_t* slotOff;   // deslocamento de cada slot no registro
+    int32_t* labelPc;   // instrucao de cada label
+    uint32_t tempOff;   // deslocamento do primeiro temporario
+    uint32_t frameSize; // tamanho total do registro (slots + temporarios)
+    uint64_t* counts;   // contadores das instrucoes IR_COUNT (so com vm->profile)
+    uint32_t ncounts;
+    uint32_t checksum;  // checksum da AST gravado nas instrucoes IR_COUNT
+    VmCallCount* calls; // chamadas feitas pela funcao (so com vm->profile)
+    uint32_t ncalls;
+    uint32_t callCap;
+    uint64_t entries;   // vezes que a funcao foi chamada (so com vm->lineCounts)
+} VmUnitInfo;
+
+/**
+ * @brief Estado da maquina virtual
+ */
+typedef struct {
+    const IrView* view;
+    int32_t* mem;           // memoria de inteiros (globais + pilha)
+    uint32_t memSize;
+    uint32_t memLimit;
+    uint32_t sp;            // topo da pilha de registros
+    uint32_t* globalAddr;   // endereco de cada global
+    VmUnitInfo* info;       // por funcao, NULL ate a primeira chamada
+    VmFrame* frames;
+    uint32_t nframes;
+    uint32_t frameCap;
+    int32_t* args;          // parametros pendentes (instrucoes param)
+    uint32_t nargs;
+    uint32_t argCap;
+    int32_t vecFirst;       // elementos [vecFirst, vecEnd) da proxima operacao vetorial (vspan)
+    int32_t vecEnd;
+    FILE* in;
+    FILE* out;
+    unsigned long long steps;      // instrucoes executadas (cada elemento de uma operacao vetorial conta)
+    unsigned long long stepLimit;  // 0 = sem limite
+    int error;
+    int quiet;              // nao imprime os erros (avaliacao durante a compilacao)
+    int profile;            // conta as instrucoes IR_COUNT e as chamadas (vm_profile_collect)
+    uint64_t* lineCounts;   // execucoes de cada instrucao do programa (vm_lines_enable; NULL = nao conta)
+    VmStackNode* stack;     // contextos de chamada (com lineCounts)
+    uint32_t nstack;
+    uint32_t stackCap;
+} Vm;
+
+/**
+ * @brief Prepara a maquina virtual para executar um programa
+ * @param vm Estado da maquina
+ * @param view Programa
+ * @return 0 se sucesso, -1 se erro
+ */
+int vm_init(Vm* vm, const IrView* view);
+
+/**
+ * @brief Libera o estado da maquina virtual
+ * @param vm Estado da maquina
+ */
+void vm_free(Vm* vm);
+
+/**
+ * @brief Procura uma funcao pelo nome
+ * @param view Programa
+ * @param name Nome da funcao
+ * @return Indice da funcao ou -1 se ausente
+ */
+int vm_find_unit(const IrView* view, const char* name);
+
+/**
+ * @brief Executa uma funcao ate o retorno
+ * @param vm Estado da maquina
+ * @param unit Indice da funcao
+ * @param args Argumentos (inteiros ou enderecos de arrays)
+ * @param nargs Numero de argumentos
+ * @param result Valor de retorno (pode ser NULL)
+ * @return 0 se sucesso, -1 se erro de execucao ou limite de passos
+ */
+int vm_call(Vm* vm, int unit, const int32_t* args, int nargs, int32_t* result);
+
+/**
+ * @brief Executa a funcao main do programa
+ * @param vm Estado da maquina
+ * @return 0 se sucesso, -1 se erro de execucao
+ */
+int vm_run_main(Vm* vm);
+
+/**
+ * @brief Soma os contadores da execucao em um perfil (requer vm->profile)
+ *
+ * Cada funcao com instrucoes IR_COUNT entra no perfil, mesmo que nunca
+ * tenha sido chamada (contadores zerados: o bloco e frio).
+ *
+ * @param vm Estado da maquina
+ * @param prof Perfil (profile.h)
+ * @return 0 se sucesso, -1 sem memoria
+ */
+int vm_profile_collect(Vm* vm, struct Profile* prof);
+
+/**
+ * @brief Passa a contar as instrucoes executadas por linha do fonte e por contexto de chamada
+ *
+ * Cada instrucao executada soma 1 no contador dela (uma operacao vetorial
+ * soma o numero de elementos, como vm->steps) e no contexto de chamada do
+ * registro atual. Chamar antes de vm_call ou vm_run_main.
+ *
+ * @param vm Estado da maquina
+ * @return 0 se sucesso, -1 sem memoria
+ */
+int vm_lines_enable(Vm* vm);
+
+/**
+ * @brief Imprime as linhas mais executadas e as instrucoes de cada funcao
+ *
+ * As instrucoes de uma funcao expandida no chamador (--profile-use)
+ * contam na funcao que chama, com as linhas da funcao expandida.
+ *
+ * @param vm Estado da maquina (depois da execucao)
+ * @param out Saida
+ * @param top Numero de linhas
+ */
+void vm_lines_report(const Vm* vm, FILE* out, int top);
+
+/**
+ * @brief Grava as pilhas de chamada no formato do flamegraph.pl ("main;f;g 1234")
+ * @param vm Estado da maquina (depois da execucao)
+ * @param out Saida
+ * @return 0 se sucesso, -1 sem memoria
+ */
+int vm_lines_stacks(const Vm* vm, FILE* out);
+
+#endif
@@ -0,0 +1,350 @@
+/**
+ * @file watch.c
+ * @brief Implementacao do modo watch
+ */
+
+#include "globals.h"
+#include "watch.h"
+
+#ifdef __linux__
+#include "compiler.h"
+#include "cache.h"
+#include "incr.h"
+#include "irfile.h"
+#include "pool.h"
+#include "source.h"
+#include "util.h"
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @brief Arquivo observado e o estado guardado da ultima compilacao
+ */
+typedef struct {
+    const char* path;
+    char* dir;               // diretorio observado
+    const char* base;        // nome dentro do diretorio (comparado com os eventos)
+    int wd;                  // watch do diretorio
+    int dirty;               // alterado desde a ultima compilacao
+    int compiled;            // TRUE depois da primeira compilacao
+    int status;              // resultado da ultima compilacao
+    CacheKey last;           // hash do ultimo fonte compilado
+    Cache functions;         // codigo de cada funcao da ultima compilacao
+} WatchFile;
+
+// TRUE depois de SIGINT ou SIGTERM
+static volatile sig_atomic_t stopped;
+
+/**
+ * @brief Encerra o modo watch (SIGINT e SIGTERM)
+ * @param sig Sinal recebido
+ */
+static void onSignal(int sig) {
+    (void)sig;
+    stopped = 1;
+}
+
+/**
+ * @brief Tempo monotonico em segundos
+ * @return Segundos
+ */
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Tempo decorrido desde a ultima gravacao de um arquivo
+ * @param st Estado do arquivo lido antes da compilacao
+ * @return Segundos
+ */
+static double sinceSaved(const struct stat* st) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (double)(ts.tv_sec - st->st_mtim.tv_sec) + (double)(ts.tv_nsec - st->st_mtim.tv_nsec) * 1e-9;
+}
+
+/**
+ * @brief Grava um arquivo binario a partir de um buffer
+ * @param path Caminho
+ * @param data Conteudo
+ * @param size Tamanho
+ * @return 0 se sucesso, -1 se erro
+ */
+static int writeBytes(const char* path, const void* data, size_t size) {
+    FILE* f = fopen(path, "wb");
+    int ok;
+    if (f == NULL) {
+        fprintf(stderr, "Erro: nao foi possivel criar o arquivo '%s'\n", path);
+        return -1;
+    }
+    ok = fwrite(data, 1, size, f) == size;
+    if (fclose(f) != 0 || !ok) {
+        fprintf(stderr, "Erro: falha ao gravar o arquivo '%s'\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Compila um arquivo reaproveitando as funcoes inalteradas
+ * @param opts Opcoes
+ * @param f Arquivo
+ * @param pool Threads da geracao de codigo (ou NULL)
+ * @param listing Saida das listagens
+ * @param saved TRUE se a compilacao foi disparada por uma gravacao
+ * @return 0 se sucesso, 1 se erro
+ */
+static int compileFile(const WatchOptions* opts, WatchFile* f, Pool* pool, FILE* listing, int saved) {
+    SourceFile source;
+    struct stat st;
+    CompilerContext ctx;
+    IncrState incr;
+    IrProgram program;
+    CacheKey key;
+    char options[32];
+    char* cmir = NULL;
+    size_t cmirSize = 0;
+    double t0 = now();
+    int status;
+
+    // sem mmap: o editor pode truncar o arquivo enquanto ele e lido (SIGBUS);
+    // um conteudo pela metade e recompilado no proximo evento
+    if (stat(f->path, &st) != 0 || source_read(f->path, &source) != 0) {
+        fprintf(stderr, "Erro: nao foi possivel abrir o arquivo '%s'\n", f->path);
+        return 1;
+    }
+    // gravado sem mudar o conteudo: a saida anterior continua valida
+    cache_key(&key, source.data, source.size, cminus_cache_options(options, sizeof(options), opts->stream, opts->optimize, opts->unroll));
+    if (f->compiled && key.h[0] == f->last.h[0] && key.h[1] == f->last.h[1]) {
+        source_close(&source);
+        fprintf(stderr, "[watch] %s: sem alteracoes\n", f->path);
+        return f->status;
+    }
+
+    fprintf(listing, "Arquivo de entrada: %s\n\n", f->path);
+    cminus_init(&ctx, listing, stderr);
+    ctx.scanInPlace = TRUE;
+    ctx.lexer = opts->lexer;
+    ctx.prelex = opts->prelex;
+    ctx.pool = pool;
+    ctx.optimize = opts->optimize;
+    ctx.unroll = opts->unroll;
+    incr_init(&incr, &f->functions);
+    ctx.incr = &incr;
+    ir_init(&program);
+    if (opts->stream)
+        status = cminus_compile_stream(&ctx, source.data, source.size, &program);
+    else
+        status = cminus_compile(&ctx, source.data, source.size, &program);
+    cminus_free(&ctx);
+    source_close(&source);
+    if (status == 0) {
+        IrView view;
+        ir_flatten(&program, &view);
+        cmir = (char*)irfile_serialize(&view, &cmirSize);
+        ir_view_free(&view);
+    }
+    ir_free(&program);
+    if (status == 0 && opts->binName != NULL) {
+        if (cmir == NULL || writeBytes(opts->binName, cmir, cmirSize) != 0)
+            status = 1;
+        else
+            fprintf(listing, "Codigo binario gravado em: %s\n", opts->binName);
+    }
+    free(cmir);
+    if (status == 0) {
+        fprintf(listing, "\nCompilacao concluida com sucesso!\n\n");
+        // so as funcoes deste programa continuam guardadas
+        cache_sweep(&f->functions);
+    }
+    fflush(listing);
+
+    fprintf(stderr, "[watch] %s: %s em %.1f ms", f->path, status == 0 ? "compilado" : "erro",
+            (now() - t0) * 1e3);
+    if (saved)
+        fprintf(stderr, ", gravacao -> saida %.1f ms", sinceSaved(&st) * 1e3);
+    if (status == 0)
+        fprintf(stderr, " (funcoes reutilizadas: %d, regeneradas: %d)", incr.reused, incr.rebuilt);
+    fprintf(stderr, "\n");
+    incr_free(&incr);
+
+    f->last = key;
+    f->compiled = TRUE;
+    f->status = status;
+    return status;
+}
+
+/**
+ * @brief Le as notificacoes pendentes e marca os arquivos alterados
+ * @param fd Descritor do inotify
+ * @param files Arquivos observados
+ * @param n Numero de arquivos
+ * @return Numero de notificacoes sobre os arquivos observados
+ */
+static int readEvents(int fd, WatchFile* files, int n) {
+    char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    const struct inotify_event* ev;
+    ssize_t len;
+    char* p;
+    int hits = 0;
+    int i;
+    while ((len = read(fd, buf, sizeof(buf))) > 0) {
+        for (p = buf; p < buf + len; p += sizeof(struct inotify_event) + ev->len) {
+            ev = (const struct inotify_event*)p;
+            for (i = 0; i < n; i++) {
+                // fila cheia: eventos perdidos, recompila tudo
+                if ((ev->mask & IN_Q_OVERFLOW) ||
+                    (ev->wd == files[i].wd && ev->len > 0 && strcmp(ev->name, files[i].base) == 0)) {
+                    files[i].dirty = TRUE;
+                    hits++;
+                }
+            }
+        }
+    }
+    return hits;
+}
+
+int watch_run(const WatchOptions* opts) {
+    WatchFile* files;
+    Pool pool;
+    Pool* pp = NULL;
+    FILE* listing = stdout;
+    struct sigaction sa;
+    double deadline = 0;
+    int debounce = opts->debounceMs > 0 ? opts->debounceMs : WATCH_DEBOUNCE_MS;
+    int threads = opts->threads > 0 ? opts->threads : pool_cpu_count();
+    int pending = FALSE;
+    int status = 0;
+    int fd;
+    int i;
+
+    fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) {
+        fprintf(stderr, "Erro: inotify indisponivel (%s)\n", strerror(errno));
+        return 1;
+    }
+    files = (WatchFile*)calloc((size_t)opts->ninputs, sizeof(WatchFile));
+    if (files == NULL) {
+        close(fd);
+        return 1;
+    }
+    for (i = 0; i < opts->ninputs; i++) {
+        WatchFile* f = &files[i];
+        struct stat st;
+        char* slash;
+        f->path = opts->inputs[i];
+        f->wd = -1;
+        if (stat(f->path, &st) != 0 || !S_ISREG(st.st_mode)) {
+            fprintf(stderr, "Erro: --watch observa arquivos ('%s' nao e um arquivo)\n", f->path);
+            status = 1;
+            break;
+        }
+        // observa o diretorio: editores costumam salvar em um temporario e renomear
+        f->dir = copyString((char*)f->path);
+        slash = f->dir != NULL ? strrchr(f->dir, '/') : NULL;
+        if (slash == NULL) {
+            f->base = f->path;
+            free(f->dir);
+            f->dir = copyString(".");
+        } else {
+            f->base = f->path + (slash - f->dir) + 1;
+            slash[slash == f->dir ? 1 : 0] = '\0';
+        }
+        if (f->dir != NULL)
+            f->wd = inotify_add_watch(fd, f->dir, IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (f->wd < 0 || cache_open_memory(&f->functions) != 0) {
+            fprintf(stderr, "Erro: nao foi possivel observar '%s' (%s)\n", f->path, strerror(errno));
+            status = 1;
+            break;
+        }
+        f->dirty = TRUE;
+    }
+    if (status == 0 && opts->quiet) {
+        listing = fopen("/dev/null", "w");
+        if (listing == NULL)
+            status = 1;
+    }
+    if (status == 0 && threads > 1 && pool_create(&pool, threads) == 0)
+        pp = &pool;
+
+    if (status == 0) {
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_handler = onSignal;
+        sigaction(SIGINT, &sa, NULL);
+        sigaction(SIGTERM, &sa, NULL);
+        for (i = 0; i < opts->ninputs; i++) {
+            compileFile(opts, &files[i], pp, listing, FALSE);
+            files[i].dirty = FALSE;
+        }
+        fprintf(stderr, "[watch] observando %d arquivo(s); Ctrl+C termina\n", opts->ninputs);
+    }
+
+    while (status == 0 && !stopped) {
+        struct pollfd pfd;
+        int timeout = -1;
+        int r;
+        if (pending) {
+            timeout = (int)((deadline - now()) * 1e3 + 0.5);
+            if (timeout < 0)
+                timeout = 0;
+        }
+        pfd.fd = fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        r = poll(&pfd, 1, timeout);
+        if (r < 0) {
+            if (errno == EINTR)
+                continue;
+            fprintf(stderr, "Erro: falha ao esperar por alteracoes (%s)\n", strerror(errno));
+            status = 1;
+            break;
+        }
+        if (r > 0) {
+            // cada gravacao reinicia o intervalo de silencio
+            if (readEvents(fd, files, opts->ninputs) > 0) {
+                pending = TRUE;
+                deadline = now() + debounce * 1e-3;
+            }
+            continue;
+        }
+        if (!pending || now() < deadline)
+            continue;
+        pending = FALSE;
+        for (i = 0; i < opts->ninputs && !stopped; i++) {
+            if (files[i].dirty) {
+                files[i].dirty = FALSE;
+                compileFile(opts, &files[i], pp, listing, TRUE);
+            }
+        }
+    }
+
+    if (pp != NULL)
+        pool_destroy(pp);
+    if (listing != stdout && listing != NULL)
+        fclose(listing);
+    for (i = 0; i < opts->ninputs; i++) {
+        if (files[i].functions.memory)
+            cache_close(&files[i].functions);
+        free(files[i].dir);
+    }
+    free(files);
+    close(fd);
+    return status;
+}
+
+#else
+
+int watch_run(const WatchOptions* opts) {
+    (void)opts;
+    fprintf(stderr, "Erro: --watch requer inotify (disponivel so no Linux)\n");
+    return 1;
+}
+
+#endif
@@ -0,0 +1,46 @@
+/**
+ * @file watch.h
+ * @brief Recompilacao automatica ao salvar (cminus --watch)
+ *
+ * Os diretorios dos arquivos de entrada sao observados com inotify (o que
+ * tambem pega editores que salvam gravando um temporario e renomeando). As
+ * notificacoes sao agrupadas ate ficarem quietas por um intervalo
+ * (debounce) e so os arquivos alterados sao recompilados. Cada arquivo
+ * guarda em memoria, entre as compilacoes, o hash do fonte (salvar sem
+ * mudar nada nao recompila) e o codigo intermediario de cada funcao
+ * (cache_open_memory), de forma que so as funcoes alteradas e as que
+ * dependem delas sao geradas de novo. Depois de cada compilacao e
+ * impresso em stderr o tempo entre a gravacao do arquivo e a saida pronta.
+ */
+
+#ifndef _WATCH_H_
+#define _WATCH_H_
+
+/**
+ * @brief Opcoes do modo watch
+ */
+typedef struct {
+    char** inputs;           // arquivos .cm observados
+    int ninputs;
+    int threads;             // 0 = numero de processadores
+    int quiet;               // TRUE para nao imprimir as listagens
+    const char* binName;     // .cmir gravado a cada compilacao (so com um arquivo)
+    int stream;              // compila declaracao por declaracao (cminus_compile_stream)
+    int lexer;               // scanner (LEXER_FLEX ou LEXER_SIMD)
+    int prelex;              // le os tokens para um vetor antes do parser
+    int optimize;            // nivel de otimizacao (opt.h)
+    int unroll;              // fator de desenrolamento dos lacos (unroll.h)
+    int debounceMs;          // silencio exigido antes de recompilar (0 = padrao)
+} WatchOptions;
+
+// Debounce padrao (ms)
+#define WATCH_DEBOUNCE_MS 50
+
+/**
+ * @brief Compila os arquivos e os recompila a cada gravacao ate SIGINT ou SIGTERM
+ * @param opts Opcoes
+ * @return 0 se terminou normalmente, 1 se erro
+ */
+int watch_run(const WatchOptions* opts);
+
+#endif